@@ -0,0 +1,176 @@
+#include "alloc_counter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    std::atomic<uint64_t> sAllocations(0);
+    std::atomic<uint64_t> sAllocatedBytes(0);
+
+    thread_local uint64_t tAllocations = 0;
+    thread_local uint64_t tAllocatedBytes = 0;
+}
+
+#ifdef EDS_COUNT_ALLOCATIONS
+
+void* operator new(std::size_t size)
+{
+    sAllocations.fetch_add(1, std::memory_order_relaxed);
+    sAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    ++tAllocations;
+    tAllocatedBytes += size;
+
+    void* ptr_ = std::malloc(size ? size : 1);
+
+    if (NULL == ptr_)
+    {
+        throw std::bad_alloc();
+    }
+
+    return ptr_;
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    sAllocations.fetch_add(1, std::memory_order_relaxed);
+    sAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    ++tAllocations;
+    tAllocatedBytes += size;
+
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept
+{
+    return operator new(size, tag);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+    std::free(ptr);
+}
+
+#endif
+
+namespace eds
+{
+    bool AllocationCounter::isEnabled()
+    {
+#ifdef EDS_COUNT_ALLOCATIONS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    uint64_t AllocationCounter::getCount()
+    {
+        return sAllocations.load(std::memory_order_relaxed);
+    }
+
+    uint64_t AllocationCounter::getBytes()
+    {
+        return sAllocatedBytes.load(std::memory_order_relaxed);
+    }
+
+    uint64_t AllocationCounter::getThreadCount()
+    {
+        return tAllocations;
+    }
+
+    uint64_t AllocationCounter::getThreadBytes()
+    {
+        return tAllocatedBytes;
+    }
+
+    AllocationProbe::AllocationProbe(unsigned int warmUpFrames)
+    : mWarmUpFrames(warmUpFrames)
+    , mFrames(0)
+    , mStart(0)
+    , bOpen(false)
+    , mFirstFrameWithAllocations(-1)
+    , mFramesWithAllocations(0)
+    , mAllocationsAfterWarmUp(0)
+    {
+    }
+
+    void AllocationProbe::begin()
+    {
+        mStart = AllocationCounter::getThreadCount();
+        bOpen = true;
+    }
+
+    uint64_t AllocationProbe::end()
+    {
+        if (!bOpen)
+        {
+            return 0;
+        }
+
+        bOpen = false;
+
+        auto allocations_ = AllocationCounter::getThreadCount() - mStart;
+
+        if (isWarmedUp() && 0 < allocations_)
+        {
+            if (0 == mFramesWithAllocations)
+            {
+                mFirstFrameWithAllocations = mFrames;
+            }
+
+            ++mFramesWithAllocations;
+            mAllocationsAfterWarmUp += allocations_;
+        }
+
+        ++mFrames;
+
+        return allocations_;
+    }
+
+    bool AllocationProbe::isWarmedUp() const
+    {
+        return mWarmUpFrames <= mFrames;
+    }
+
+    uint64_t AllocationProbe::getFrameCount() const
+    {
+        return mFrames;
+    }
+
+    uint64_t AllocationProbe::getFramesWithAllocations() const
+    {
+        return mFramesWithAllocations;
+    }
+
+    uint64_t AllocationProbe::getAllocationsAfterWarmUp() const
+    {
+        return mAllocationsAfterWarmUp;
+    }
+
+    int64_t AllocationProbe::getFirstFrameWithAllocations() const
+    {
+        return mFirstFrameWithAllocations;
+    }
+}
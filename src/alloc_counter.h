@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace eds
+{
+    // Counts calls to the global operator new, across all threads and per
+    // calling thread. Counting is only compiled in when EDS_COUNT_ALLOCATIONS
+    // is defined (add it to PROJECT_DEFINES in config.make or to the Xcode
+    // preprocessor macros), otherwise isEnabled() is false and the counts stay 0.
+    class AllocationCounter
+    {
+    public:
+        static bool isEnabled();
+        static uint64_t getCount();
+        static uint64_t getBytes();
+
+        // Only the allocations made by the calling thread
+        static uint64_t getThreadCount();
+        static uint64_t getThreadBytes();
+    };
+
+    // Checks that a repeated section (one liveview frame) stops allocating
+    // once the first warmUpFrames have gone through. Only allocations of the
+    // thread calling begin() and end() are counted, so decoder workers or SDK
+    // threads allocating at the same time don't show up as frame allocations.
+    class AllocationProbe
+    {
+    public:
+        AllocationProbe(unsigned int warmUpFrames = 60);
+
+        // begin() and end() must be called in pairs on the same thread, a
+        // begin() without end() restarts the window and an end() without
+        // begin() is ignored.
+        void begin();
+        // Returns the number of allocations since begin()
+        uint64_t end();
+
+        bool isWarmedUp() const;
+        uint64_t getFrameCount() const;
+        uint64_t getFramesWithAllocations() const;
+        uint64_t getAllocationsAfterWarmUp() const;
+        // Index of the first frame that allocated after warm-up, -1 if none did
+        int64_t getFirstFrameWithAllocations() const;
+
+    private:
+        unsigned int mWarmUpFrames;
+        uint64_t mFrames;
+        uint64_t mStart;
+        bool bOpen;
+        int64_t mFirstFrameWithAllocations;
+        uint64_t mFramesWithAllocations;
+        uint64_t mAllocationsAfterWarmUp;
+    };
+}
@@ -1,7 +1,35 @@
 #include "buffer.h"
+#include "line_reader.h"
+#include "mapped_file.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+namespace
+{
+    std::atomic<uint64_t> sCopies(0);
+    std::atomic<uint64_t> sCopiedBytes(0);
+}
 
 namespace eds
 {
+    void CopyStats::record(size_t bytes)
+    {
+        sCopies.fetch_add(1, std::memory_order_relaxed);
+        sCopiedBytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+    
+    uint64_t CopyStats::getCount()
+    {
+        return sCopies.load(std::memory_order_relaxed);
+    }
+    
+    uint64_t CopyStats::getBytes()
+    {
+        return sCopiedBytes.load(std::memory_order_relaxed);
+    }
+    
     Buffer::Buffer()
     {
         mNextLinePos = 0;
@@ -10,23 +38,84 @@ namespace eds
     
     Buffer::Buffer(const char* buffer, unsigned int size)
     {
+        mNextLinePos = 0;
         set(buffer, size);
     }
     
     Buffer::Buffer(const std::string& text)
     {
+        mNextLinePos = 0;
         set(text);
     }
     
     Buffer::Buffer(std::istream& stream)
     {
+        mNextLinePos = 0;
         set(stream);
     }
     
     Buffer::Buffer(const Buffer& buffer)
     {
-        mBuffer = buffer.mBuffer;
+        if(buffer.isMapped())
+        {
+            // copies of a mapped buffer live on the heap
+            mBuffer.assign(buffer.getBinaryBuffer(), buffer.getBinaryBuffer() + buffer.size());
+            mBuffer.push_back(0);
+        }
+        else
+        {
+            mBuffer = buffer.mBuffer;
+        }
+        
         mNextLinePos = buffer.mNextLinePos;
+        CopyStats::record(buffer.size());
+    }
+    
+    Buffer::Buffer(Buffer&& buffer)
+    : mBuffer(std::move(buffer.mBuffer))
+    , mMapping(std::move(buffer.mMapping))
+    , mNextLinePos(buffer.mNextLinePos)
+    {
+        // leave the source as a valid empty buffer
+        buffer.mBuffer.assign(1, 0);
+        buffer.mNextLinePos = 0;
+    }
+    
+    Buffer& Buffer::operator=(const Buffer& buffer)
+    {
+        if (this != &buffer)
+        {
+            mMapping.reset();
+            
+            // assign() reuses our storage when it is large enough
+            if(buffer.isMapped())
+            {
+                mBuffer.assign(buffer.getBinaryBuffer(), buffer.getBinaryBuffer() + buffer.size());
+                mBuffer.push_back(0);
+            }
+            else
+            {
+                mBuffer.assign(buffer.mBuffer.begin(), buffer.mBuffer.end());
+            }
+            
+            mNextLinePos = buffer.mNextLinePos;
+            CopyStats::record(buffer.size());
+        }
+        
+        return *this;
+    }
+    
+    Buffer& Buffer::operator=(Buffer&& buffer)
+    {
+        if (this != &buffer)
+        {
+            mBuffer.swap(buffer.mBuffer);
+            mMapping.swap(buffer.mMapping);
+            mNextLinePos = buffer.mNextLinePos;
+            buffer.clear();
+        }
+        
+        return *this;
     }
     
     Buffer& Buffer::operator=(const std::string & text)
@@ -49,31 +138,71 @@ namespace eds
             return false;
         }
         
-        char temp_[1024];
+        // Seekable stream (files, string streams): read straight into the final storage with one large read
+        auto start_ = stream.tellg();
         
-        auto size = 0;
-        stream.read(temp_, 1024);
+        if(std::streampos(-1) != start_ && stream.seekg(0, std::ios::end))
+        {
+            auto end_ = stream.tellg();
+            stream.seekg(start_);
+            
+            if(std::streampos(-1) != end_ && start_ <= end_ && stream)
+            {
+                size_t expected_ = end_ - start_;
+                
+                mBuffer.resize(expected_ + 1);
+                stream.read(&mBuffer[0], expected_);
+                
+                size_t size_ = stream.gcount();
+                
+                // the stream may have been shorter than it claimed
+                mBuffer.resize(size_ + 1);
+                mBuffer.back() = 0;
+                
+                return true;
+            }
+        }
+        
+        stream.clear(stream.rdstate() & ~(std::ios::failbit | std::ios::eofbit));
+        
+        // Unsized stream (pipes, sockets): fill chunks that double in size, so nothing read so far
+        // is ever moved, then assemble them once the total is known
+        const size_t kFirstChunkSize = 64 * 1024;
+        const size_t kMaxChunkSize = 16 * 1024 * 1024;
         
-        auto n = stream.gcount();
+        std::vector< std::vector<char> > chunks_;
+        size_t size_ = 0;
+        size_t chunkSize_ = kFirstChunkSize;
         
-        while (n > 0)
+        while(stream)
         {
-            // we resize to size+1 initialized to 0 to have a 0 at the end for strings
-            mBuffer.resize(size + n + 1, 0);
-            memcpy(&(mBuffer[0]) + size, temp_, n);
+            chunks_.push_back(std::vector<char>());
+            std::vector<char>& chunk_ = chunks_.back();
+            chunk_.resize(chunkSize_);
             
-            size += n;
+            stream.read(&chunk_[0], chunkSize_);
+            chunk_.resize(stream.gcount());
+            size_ += chunk_.size();
             
-            if (stream)
-            {
-                stream.read(temp_, 1024);
-                n = stream.gcount();
-            }
-            else
+            chunkSize_ = std::min(chunkSize_ * 2, kMaxChunkSize);
+        }
+        
+        mBuffer.resize(size_ + 1);
+        
+        size_t offset_ = 0;
+        
+        for (size_t i = 0; i < chunks_.size(); ++i)
+        {
+            if(!chunks_[i].empty())
             {
-                n = 0;
+                memcpy(&mBuffer[offset_], &chunks_[i][0], chunks_[i].size());
+                offset_ += chunks_[i].size();
             }
         }
+        
+        // we always keep a 0 at the end to have a valid string
+        mBuffer.back() = 0;
+        
         return true;
     }
     
@@ -84,13 +213,15 @@ namespace eds
             return false;
         }
         
-        stream.write(&(mBuffer[0]), mBuffer.size() - 1);
+        stream.write(getBinaryBuffer(), size());
         
         return true;
     }
     
     void Buffer::set(const char* buffer, unsigned int size)
     {
+        CopyStats::record(size);
+        mMapping.reset();
         mBuffer.assign(buffer, buffer + size);
         mBuffer.resize(mBuffer.size() + 1);
         mBuffer.back() = 0;
@@ -108,12 +239,15 @@ namespace eds
     
     void Buffer::append(const char * buffer, unsigned int size)
     {
+        CopyStats::record(size);
+        detachMapping();
         mBuffer.insert(mBuffer.end() - 1, buffer, buffer + size);
         mBuffer.back() = 0;
     }
     
     void Buffer::clear()
     {
+        mMapping.reset();
         mBuffer.resize(1);
         mNextLinePos = 0;
     }
@@ -124,8 +258,104 @@ namespace eds
         mBuffer.resize(size);
     }
     
+    void Buffer::reserve(long size)
+    {
+        detachMapping();
+        
+        // +1 for the terminating 0
+        mBuffer.reserve(size + 1);
+    }
+    
+    long Buffer::capacity() const
+    {
+        if(isMapped())
+        {
+            return size();
+        }
+        
+        return mBuffer.capacity() - 1;
+    }
+    
+    void Buffer::swap(Buffer& buffer)
+    {
+        mBuffer.swap(buffer.mBuffer);
+        mMapping.swap(buffer.mMapping);
+        std::swap(mNextLinePos, buffer.mNextLinePos);
+    }
+    
+    SharedBuffer Buffer::share()
+    {
+        return SharedBuffer(new Buffer(std::move(*this)));
+    }
+    
+    bool Buffer::map(const std::string& path, bool writable)
+    {
+        clear();
+        
+        std::unique_ptr<MappedFile> mapping_(new MappedFile());
+        
+        if(!mapping_->open(path, writable ? MappedFile::kMode_ReadWrite : MappedFile::kMode_ReadOnly))
+        {
+            return false;
+        }
+        
+        mapping_->adviseSequential();
+        
+        // release the heap storage, the mapping replaces it
+        std::vector<char>(1, 0).swap(mBuffer);
+        mMapping = std::move(mapping_);
+        
+        return true;
+    }
+    
+    bool Buffer::mapAnonymous(size_t size)
+    {
+        clear();
+        
+        std::unique_ptr<MappedFile> mapping_(new MappedFile());
+        
+        if(!mapping_->createAnonymous(size))
+        {
+            return false;
+        }
+        
+        std::vector<char>(1, 0).swap(mBuffer);
+        mMapping = std::move(mapping_);
+        
+        return true;
+    }
+    
+    bool Buffer::isMapped() const
+    {
+        return NULL != mMapping.get();
+    }
+    
+    bool Buffer::sync()
+    {
+        return isMapped() ? mMapping->sync() : true;
+    }
+    
+    void Buffer::detachMapping()
+    {
+        if(!isMapped())
+        {
+            return;
+        }
+        
+        std::vector<char> storage_(mMapping->data(), mMapping->data() + mMapping->size());
+        storage_.push_back(0);
+        
+        mBuffer.swap(storage_);
+        mMapping.reset();
+    }
+    
     char* Buffer::getBinaryBuffer()
     {
+        if(isMapped())
+        {
+            return mMapping->data();
+        }
+        
         if(mBuffer.empty())
         {
             return NULL;
@@ -136,6 +366,11 @@ namespace eds
     
     const char* Buffer::getBinaryBuffer() const
     {
+        if(isMapped())
+        {
+            return mMapping->data() ? mMapping->data() : "";
+        }
+        
         if(mBuffer.empty())
         {
             return "";
@@ -144,13 +379,26 @@ namespace eds
         return &mBuffer[0];
     }
     
+    BufferView Buffer::view() const
+    {
+        return BufferView(getBinaryBuffer(), size());
+    }
+    
     std::string Buffer::getText() const
     {
+        if(isMapped())
+        {
+            // no terminating 0 in a mapping
+            CopyStats::record(size());
+            return std::string(getBinaryBuffer(), size());
+        }
+        
         if(mBuffer.empty())
         {
             return "";
         }
         
+        CopyStats::record(size());
         return &mBuffer[0];
     }
     
@@ -161,6 +409,11 @@ namespace eds
     
     long Buffer::size() const
     {
+        if(isMapped())
+        {
+            return mMapping->size();
+        }
+        
         if(mBuffer.empty())
         {
             return 0;
@@ -170,43 +423,24 @@ namespace eds
         return mBuffer.size() - 1;
     }
     
+    LineRange Buffer::lines() const
+    {
+        return LineRange(view());
+    }
+    
     std::string Buffer::getNextLine()
     {
-        if(mBuffer.empty() || (int)(mBuffer.size() - 1) == mNextLinePos)
+        if(isLastLine())
         {
             return "";
         }
         
-        auto currentLinePos_ = mNextLinePos;
-        auto lineEndWasCR_ = false;
-        
-        while(mNextLinePos < (int)mBuffer.size() - 1 && mBuffer[mNextLinePos] != '\n')
-        {
-            if(mBuffer[mNextLinePos] != '\r')
-            {
-                mNextLinePos++;
-            }
-            else
-            {
-                lineEndWasCR_ = true;
-                break;
-            }
-        }
-        
-        std::string line(getBinaryBuffer() + currentLinePos_, mNextLinePos - currentLinePos_);
-        
-        if(mNextLinePos < (int)(mBuffer.size() - 1))
-        {
-            mNextLinePos++;
-        }
-        
-        // if lineEndWasCR check for CRLF
-        if(lineEndWasCR_ && mNextLinePos < (int)(mBuffer.size() - 1) && mBuffer[mNextLinePos] == '\n')
-        {
-            mNextLinePos++;
-        }
+        const char* begin_ = getBinaryBuffer();
+        LineIterator line_(begin_ + mNextLinePos, begin_ + size());
+        mNextLinePos = line_.getNextLinePosition() - begin_;
         
-        return line;
+        CopyStats::record(line_->size);
+        return std::string(line_->data, line_->size);
     }
     
     std::string Buffer::getFirstLine()
@@ -217,7 +451,7 @@ namespace eds
     
     bool Buffer::isLastLine()
     {
-        return (int)(mBuffer.size() - 1) == mNextLinePos;
+        return size() == (long)mNextLinePos;
     }
     
     void Buffer::resetLineReader()
@@ -1,10 +1,41 @@
 #pragma once
 
 #include <iostream>
+#include <memory>
+#include <stdint.h>
 #include <vector>
 
 namespace eds
 {
+    // Non-owning view over bytes that live somewhere else (a Buffer, an SDK stream...)
+    struct BufferView
+    {
+        BufferView() : data(NULL), size(0) {}
+        BufferView(const char* data_, size_t size_) : data(data_), size(size_) {}
+        
+        bool empty() const { return 0 == size; }
+        
+        const char* data;
+        size_t size;
+    };
+    
+    class Buffer;
+    class LineRange;
+    class MappedFile;
+    
+    // Immutable, reference-counted frame bytes, see Buffer::share() and BufferSlice
+    typedef std::shared_ptr<const Buffer> SharedBuffer;
+    
+    // Process-wide count of frame byte copies (Buffer::set, copies, getText...),
+    // so the effect of sharing instead of copying can be measured
+    class CopyStats
+    {
+    public:
+        static void record(size_t bytes);
+        static uint64_t getCount();
+        static uint64_t getBytes();
+    };
+    
     class Buffer
     {
     public:
@@ -13,6 +44,9 @@ namespace eds
         Buffer(const std::string& text);
         Buffer(std::istream& stream);
         Buffer(const Buffer& buffer);
+        Buffer(Buffer&& buffer);
+        Buffer& operator=(const Buffer& buffer);
+        Buffer& operator=(Buffer&& buffer);
         Buffer& operator=(const std::string& text);
         ~Buffer();
         
@@ -28,13 +62,38 @@ namespace eds
         
         void allocate(long _size);
         
+        // Grows the storage without touching the contents, clear() keeps it
+        void reserve(long size);
+        long capacity() const;
+        
+        void swap(Buffer& buffer);
+        
+        // Moves the contents into an immutable shared buffer without copying, this buffer is left empty
+        SharedBuffer share();
+        
+        // Backs the buffer with a memory mapping instead of heap storage. getBinaryBuffer(), size(),
+        // view() and the line readers work the same; a mapped buffer has no terminating 0 though, and
+        // writing through a read-only mapping crashes. set(), clear() and allocate() drop the mapping,
+        // append() and reserve() copy it to the heap first.
+        bool map(const std::string& path, bool writable = false);
+        // Anonymous read-write mapping (memfd) for large scratch buffers
+        bool mapAnonymous(size_t size);
+        bool isMapped() const;
+        // Flushes a writable file mapping
+        bool sync();
+        
         char * getBinaryBuffer();
         const char * getBinaryBuffer() const;
+        BufferView view() const;
         
         std::string getText() const;
         operator std::string() const;  // cast to string, to use a buffer as a string
         
         long size() const;
+        
+        // Zero-copy line iteration, see line_reader.h
+        LineRange lines() const;
+        
         std::string getNextLine();
         std::string getFirstLine();
         bool isLastLine();
@@ -44,7 +103,10 @@ namespace eds
         friend std::istream& operator>>(std::istream& istr, Buffer& buffer);
         
     private:
+        void detachMapping();
+        
         std::vector<char> mBuffer;
-        long mNextLinePos;
+        std::unique_ptr<MappedFile> mMapping;
+        size_t mNextLinePos;
     };
 }
\ No newline at end of file
@@ -0,0 +1,222 @@
+#include "buffer_pool.h"
+
+namespace eds
+{
+    BufferPool::Storage::Storage(unsigned int maxIdlePerClass)
+    : maxIdlePerClass(maxIdlePerClass)
+    , hits(0)
+    , misses(0)
+    {
+        for (auto i = 0; i < kFrameClass_Count; ++i)
+        {
+            idle[i].reserve(maxIdlePerClass);
+        }
+    }
+
+    void BufferPool::Storage::recycle(FrameClass frameClass, std::unique_ptr<Buffer> buffer)
+    {
+        // clear() keeps the capacity, only the contents are dropped
+        buffer->clear();
+
+        std::lock_guard<std::mutex> lock_(mutex);
+
+        if (idle[frameClass].size() < maxIdlePerClass)
+        {
+            idle[frameClass].push_back(std::move(buffer));
+        }
+    }
+
+    BufferPool::Handle::Handle()
+    : mFrameClass(kFrameClass_Evf)
+    {
+    }
+
+    BufferPool::Handle::Handle(const std::shared_ptr<Storage>& storage, FrameClass frameClass, std::unique_ptr<Buffer> buffer)
+    : mStorage(storage)
+    , mFrameClass(frameClass)
+    , mBuffer(std::move(buffer))
+    {
+    }
+
+    BufferPool::Handle::Handle(Handle&& handle)
+    : mStorage(std::move(handle.mStorage))
+    , mFrameClass(handle.mFrameClass)
+    , mBuffer(std::move(handle.mBuffer))
+    {
+    }
+
+    BufferPool::Handle& BufferPool::Handle::operator=(Handle&& handle)
+    {
+        if (this != &handle)
+        {
+            reset();
+
+            mStorage = std::move(handle.mStorage);
+            mFrameClass = handle.mFrameClass;
+            mBuffer = std::move(handle.mBuffer);
+        }
+
+        return *this;
+    }
+
+    BufferPool::Handle::~Handle()
+    {
+        reset();
+    }
+
+    Buffer& BufferPool::Handle::operator*() const
+    {
+        return *mBuffer;
+    }
+
+    Buffer* BufferPool::Handle::operator->() const
+    {
+        return mBuffer.get();
+    }
+
+    Buffer* BufferPool::Handle::get() const
+    {
+        return mBuffer.get();
+    }
+
+    BufferPool::Handle::operator bool() const
+    {
+        return NULL != mBuffer.get();
+    }
+
+    FrameClass BufferPool::Handle::getFrameClass() const
+    {
+        return mFrameClass;
+    }
+
+    void BufferPool::Handle::reset()
+    {
+        if (NULL != mBuffer.get())
+        {
+            // the pool is gone, the buffer is freed below
+            std::shared_ptr<Storage> storage_ = mStorage.lock();
+
+            if (storage_)
+            {
+                storage_->recycle(mFrameClass, std::move(mBuffer));
+            }
+        }
+
+        mBuffer.reset();
+        mStorage.reset();
+    }
+
+    SharedBuffer BufferPool::Handle::share()
+    {
+        if (NULL == mBuffer.get())
+        {
+            return SharedBuffer();
+        }
+
+        // the moved handle owns the buffer, the shared pointer aliases it
+        std::shared_ptr<Handle> owner_(new Handle(std::move(*this)));
+        return SharedBuffer(owner_, owner_->get());
+    }
+
+    BufferPool::BufferPool(unsigned int maxIdlePerClass)
+    : mStorage(new Storage(maxIdlePerClass))
+    {
+    }
+
+    BufferPool::~BufferPool()
+    {
+    }
+
+    BufferPool::Handle BufferPool::acquire(FrameClass frameClass)
+    {
+        std::unique_ptr<Buffer> buffer_;
+
+        {
+            std::lock_guard<std::mutex> lock_(mStorage->mutex);
+
+            if (!mStorage->idle[frameClass].empty())
+            {
+                buffer_ = std::move(mStorage->idle[frameClass].back());
+                mStorage->idle[frameClass].pop_back();
+                ++mStorage->hits;
+            }
+            else
+            {
+                ++mStorage->misses;
+            }
+        }
+
+        // allocate outside the lock, a RAW sized reserve takes a while
+        if (NULL == buffer_.get())
+        {
+            buffer_.reset(new Buffer());
+            buffer_->reserve(getCapacity(frameClass));
+        }
+
+        return Handle(mStorage, frameClass, std::move(buffer_));
+    }
+
+    BufferPool::Handle BufferPool::acquire(long size)
+    {
+        return acquire(getFrameClass(size));
+    }
+
+    void BufferPool::preallocate(FrameClass frameClass, unsigned int count)
+    {
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            std::unique_ptr<Buffer> buffer_(new Buffer());
+            buffer_->reserve(getCapacity(frameClass));
+            mStorage->recycle(frameClass, std::move(buffer_));
+        }
+    }
+
+    long BufferPool::getCapacity(FrameClass frameClass)
+    {
+        switch (frameClass)
+        {
+            case kFrameClass_Evf:
+                return 256 * 1024;
+
+            case kFrameClass_Jpeg:
+                return 16 * 1024 * 1024;
+
+            case kFrameClass_Raw:
+            default:
+                return 64 * 1024 * 1024;
+        }
+    }
+
+    FrameClass BufferPool::getFrameClass(long size)
+    {
+        if (size <= getCapacity(kFrameClass_Evf))
+        {
+            return kFrameClass_Evf;
+        }
+
+        if (size <= getCapacity(kFrameClass_Jpeg))
+        {
+            return kFrameClass_Jpeg;
+        }
+
+        return kFrameClass_Raw;
+    }
+
+    uint64_t BufferPool::getHitCount() const
+    {
+        std::lock_guard<std::mutex> lock_(mStorage->mutex);
+        return mStorage->hits;
+    }
+
+    uint64_t BufferPool::getMissCount() const
+    {
+        std::lock_guard<std::mutex> lock_(mStorage->mutex);
+        return mStorage->misses;
+    }
+
+    unsigned int BufferPool::getIdleCount(FrameClass frameClass) const
+    {
+        std::lock_guard<std::mutex> lock_(mStorage->mutex);
+        return mStorage->idle[frameClass].size();
+    }
+}
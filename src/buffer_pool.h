@@ -0,0 +1,101 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "buffer.h"
+
+namespace eds
+{
+    // Size classes for the frames we move around, a buffer is reserved at the
+    // class capacity the first time it is created and keeps it from then on.
+    enum FrameClass
+    {
+        kFrameClass_Evf,    // liveview jpeg, ~100 KB
+        kFrameClass_Jpeg,   // full size jpeg, ~10 MB
+        kFrameClass_Raw,    // CR2/CR3, ~40 MB
+        kFrameClass_Count
+    };
+
+    // Hands out capacity-retaining buffers and takes them back when their
+    // Handle goes out of scope, so steady-state downloads reuse the same
+    // storage instead of reallocating it for every shot.
+    // Handles and shared buffers may outlive the pool, their storage is
+    // freed instead of returned once the pool is gone.
+    class BufferPool
+    {
+        // What the handles give their buffers back to, owned by the pool
+        struct Storage
+        {
+            explicit Storage(unsigned int maxIdlePerClass);
+
+            void recycle(FrameClass frameClass, std::unique_ptr<Buffer> buffer);
+
+            unsigned int maxIdlePerClass;
+            std::mutex mutex;
+            std::vector< std::unique_ptr<Buffer> > idle[kFrameClass_Count];
+            uint64_t hits;
+            uint64_t misses;
+        };
+
+    public:
+        class Handle
+        {
+        public:
+            Handle();
+            Handle(Handle&& handle);
+            Handle& operator=(Handle&& handle);
+            ~Handle();
+
+            Buffer& operator*() const;
+            Buffer* operator->() const;
+            Buffer* get() const;
+            explicit operator bool() const;
+
+            FrameClass getFrameClass() const;
+
+            // Returns the buffer to the pool early
+            void reset();
+
+            // Turns the handle into an immutable shared buffer without copying,
+            // the buffer returns to the pool when the last reference goes away
+            SharedBuffer share();
+
+        private:
+            friend class BufferPool;
+
+            Handle(const std::shared_ptr<Storage>& storage, FrameClass frameClass, std::unique_ptr<Buffer> buffer);
+            Handle(const Handle&);
+            Handle& operator=(const Handle&);
+
+            std::weak_ptr<Storage> mStorage;
+            FrameClass mFrameClass;
+            std::unique_ptr<Buffer> mBuffer;
+        };
+
+        // maxIdlePerClass bounds how many returned buffers are kept around
+        BufferPool(unsigned int maxIdlePerClass = 4);
+        ~BufferPool();
+
+        Handle acquire(FrameClass frameClass);
+        // Picks the smallest class whose capacity fits size
+        Handle acquire(long size);
+
+        // Creates buffers ahead of time, so the first frames don't pay for it
+        void preallocate(FrameClass frameClass, unsigned int count);
+
+        static long getCapacity(FrameClass frameClass);
+        static FrameClass getFrameClass(long size);
+
+        uint64_t getHitCount() const;
+        uint64_t getMissCount() const;
+        unsigned int getIdleCount(FrameClass frameClass) const;
+
+    private:
+        BufferPool(const BufferPool&);
+        BufferPool& operator=(const BufferPool&);
+
+        std::shared_ptr<Storage> mStorage;
+    };
+}
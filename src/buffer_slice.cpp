@@ -0,0 +1,78 @@
+#include "buffer_slice.h"
+
+#include <algorithm>
+
+namespace eds
+{
+    BufferSlice::BufferSlice()
+    : mOffset(0)
+    , mLength(0)
+    {
+    }
+
+    BufferSlice::BufferSlice(const SharedBuffer& storage)
+    : mStorage(storage)
+    , mOffset(0)
+    , mLength(storage ? storage->size() : 0)
+    {
+    }
+
+    BufferSlice::BufferSlice(const SharedBuffer& storage, size_t offset, size_t length)
+    : mStorage(storage)
+    , mOffset(0)
+    , mLength(0)
+    {
+        size_t size_ = storage ? storage->size() : 0;
+
+        mOffset = std::min(offset, size_);
+        mLength = std::min(length, size_ - mOffset);
+    }
+
+    const char* BufferSlice::data() const
+    {
+        if (!mStorage)
+        {
+            return NULL;
+        }
+
+        return mStorage->getBinaryBuffer() + mOffset;
+    }
+
+    size_t BufferSlice::size() const
+    {
+        return mLength;
+    }
+
+    bool BufferSlice::empty() const
+    {
+        return 0 == mLength;
+    }
+
+    BufferSlice BufferSlice::slice(size_t offset, size_t length) const
+    {
+        offset = std::min(offset, mLength);
+        length = std::min(length, mLength - offset);
+
+        return BufferSlice(mStorage, mOffset + offset, length);
+    }
+
+    BufferView BufferSlice::view() const
+    {
+        return BufferView(data(), size());
+    }
+
+    const SharedBuffer& BufferSlice::getStorage() const
+    {
+        return mStorage;
+    }
+
+    long BufferSlice::getReferenceCount() const
+    {
+        return mStorage.use_count();
+    }
+
+    Buffer BufferSlice::copy() const
+    {
+        return Buffer(data(), size());
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "buffer.h"
+
+namespace eds
+{
+    // Offset and length over a SharedBuffer. Slices are cheap to copy: they
+    // only bump the reference count, so the decoder, the recorder and the
+    // network fan-out can all hold on to the same frame without copying it.
+    // The bytes are released when the last slice goes away.
+    class BufferSlice
+    {
+    public:
+        BufferSlice();
+        BufferSlice(const SharedBuffer& storage);
+        BufferSlice(const SharedBuffer& storage, size_t offset, size_t length);
+
+        const char* data() const;
+        size_t size() const;
+        bool empty() const;
+
+        // Sub-range relative to this slice, clamped to its bounds
+        BufferSlice slice(size_t offset, size_t length) const;
+        BufferView view() const;
+
+        const SharedBuffer& getStorage() const;
+        long getReferenceCount() const;
+
+        // Explicit, counted copy for consumers that need to own the bytes
+        Buffer copy() const;
+
+    private:
+        SharedBuffer mStorage;
+        size_t mOffset;
+        size_t mLength;
+    };
+}
@@ -0,0 +1,260 @@
+#include "bulb_controller.h"
+
+#include <algorithm>
+#include <cmath>
+#include <pthread.h>
+#include <sched.h>
+
+#include "ofMain.h"
+
+#include "monotonic_clock.h"
+
+namespace
+{
+    // slept in slices down to the last one, so cancel() gets through
+    const uint64_t kSliceNanos = 10000000;
+
+    // Without the privileges for it this stays a normal thread, the deadline is still absolute
+    bool setRealtimePriority(int& policy, sched_param& param)
+    {
+        if (0 != pthread_getschedparam(pthread_self(), &policy, &param))
+        {
+            return false;
+        }
+
+        sched_param realtime_ = param;
+        realtime_.sched_priority = sched_get_priority_max(SCHED_FIFO);
+        return 0 == pthread_setschedparam(pthread_self(), SCHED_FIFO, &realtime_);
+    }
+}
+
+namespace eds
+{
+    BulbController::BulbController(CameraManager& cameras)
+    : mCameras(cameras)
+    , mRunning(0)
+    , bCancel(false)
+    , mExposures(0)
+    , mLastRequested(0.0)
+    , mLastAchieved(0.0)
+    , mErrorSum(0.0)
+    , mErrorMax(0.0)
+    {
+    }
+
+    BulbController::~BulbController()
+    {
+        cancel();
+        wait();
+    }
+
+    size_t BulbController::expose(double millis)
+    {
+        if (isExposing() || millis <= 0.0)
+        {
+            return 0;
+        }
+
+        bCancel = false;
+
+        uint64_t duration_ = (uint64_t)(millis * 1000000.0);
+        size_t posted_ = 0;
+
+        for (unsigned int i = 0; i < mCameras.getSessionCount(); ++i)
+        {
+            CameraSession* session_ = mCameras.getSession(i);
+
+            if (!session_->isOpen())
+            {
+                continue;
+            }
+
+            ++mRunning;
+
+            if (session_->getCommandExecutor().post(kCommandClass_Shutter, [this, session_, duration_]() { return run(session_, duration_); }))
+            {
+                ++posted_;
+            }
+            else
+            {
+                --mRunning;
+            }
+        }
+
+        return posted_;
+    }
+
+    void BulbController::cancel()
+    {
+        bCancel = true;
+    }
+
+    bool BulbController::isExposing() const
+    {
+        return 0 < mRunning;
+    }
+
+    uint64_t BulbController::getExposureCount() const
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+        return mExposures;
+    }
+
+    double BulbController::getLastRequestedMillis() const
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+        return mLastRequested;
+    }
+
+    double BulbController::getLastAchievedMillis() const
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+        return mLastAchieved;
+    }
+
+    double BulbController::getErrorMicrosAverage() const
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+        return 0 == mExposures ? 0.0 : mErrorSum / mExposures;
+    }
+
+    double BulbController::getErrorMicrosMax() const
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+        return mErrorMax;
+    }
+
+    EdsError BulbController::run(CameraSession* session, uint64_t durationNanos)
+    {
+        // cancelled while it waited behind other commands
+        if (bCancel)
+        {
+            finish(false, SCHED_OTHER, sched_param());
+            return EDS_ERR_OK;
+        }
+
+        int policy_ = SCHED_OTHER;
+        sched_param param_;
+        bool realtime_ = setRealtimePriority(policy_, param_);
+        EdsCameraRef camera_ = session->getCamera();
+        unsigned int index_ = session->getIndex();
+
+        uint64_t pressSent_ = MonotonicClock::nowNanos();
+        EdsError error_ = EdsSendCommand(camera_, kEdsCameraCommand_PressShutterButton, kEdsCameraCommand_ShutterButton_Completely_NonAF);
+        uint64_t pressReturned_ = MonotonicClock::nowNanos();
+
+        if (EDS_ERR_OK != error_)
+        {
+            ofLogError("eds::BulbController") << session->getName() << ": shutter press failed: " << std::hex << error_;
+            finish(realtime_, policy_, param_);
+            return error_;
+        }
+
+        uint64_t opened_ = pressSent_ + (pressReturned_ - pressSent_) / 2;
+        uint64_t lead_ = (pressReturned_ - pressSent_) / 2;
+
+        {
+            std::lock_guard<std::mutex> lock_(mMutex);
+
+            // the press round trip stands in until this camera has released once
+            std::map<unsigned int, uint64_t>::const_iterator it_ = mReleaseNanos.find(index_);
+
+            if (mReleaseNanos.end() != it_)
+            {
+                lead_ = it_->second;
+            }
+        }
+
+        uint64_t deadline_ = opened_ + durationNanos - std::min(lead_, durationNanos);
+
+        while (!bCancel && MonotonicClock::nowNanos() + kSliceNanos < deadline_)
+        {
+            MonotonicClock::sleepUntil(MonotonicClock::nowNanos() + kSliceNanos);
+        }
+
+        if (!bCancel)
+        {
+            MonotonicClock::sleepUntil(deadline_);
+        }
+
+        uint64_t releaseSent_ = MonotonicClock::nowNanos();
+        error_ = EdsSendCommand(camera_, kEdsCameraCommand_PressShutterButton, kEdsCameraCommand_ShutterButton_OFF);
+        uint64_t releaseReturned_ = MonotonicClock::nowNanos();
+
+        uint64_t latency_ = (releaseReturned_ - releaseSent_) / 2;
+        uint64_t closed_ = releaseSent_ + latency_;
+
+        double requested_ = durationNanos / 1000000.0;
+        double achieved_ = (closed_ - opened_) / 1000000.0;
+        double errorMicros_ = (achieved_ - requested_) * 1000.0;
+
+        if (EDS_ERR_OK != error_)
+        {
+            ofLogError("eds::BulbController") << session->getName() << ": shutter release failed: " << std::hex << error_;
+        }
+        else if (bCancel)
+        {
+            ofLogNotice("eds::BulbController") << session->getName() << ": bulb cancelled after " << achieved_ << " of " << requested_ << " ms";
+        }
+        else
+        {
+            ofLogNotice("eds::BulbController") << session->getName() << ": bulb requested " << requested_ << " ms, achieved " << achieved_ << " ms"
+                                               << " (" << errorMicros_ << " us), press round trip " << (pressReturned_ - pressSent_) / 1000000.0 << " ms"
+                                               << ", release " << (releaseReturned_ - releaseSent_) / 1000000.0 << " ms"
+                                               << (realtime_ ? "" : ", no real-time priority");
+        }
+
+        if (EDS_ERR_OK == error_)
+        {
+            std::lock_guard<std::mutex> lock_(mMutex);
+
+            // smoothed, a single slow round trip shouldn't throw the next exposure off
+            std::map<unsigned int, uint64_t>::iterator it_ = mReleaseNanos.find(index_);
+
+            if (mReleaseNanos.end() == it_)
+            {
+                mReleaseNanos[index_] = latency_;
+            }
+            else
+            {
+                it_->second = (it_->second * 3 + latency_) / 4;
+            }
+
+            if (!bCancel)
+            {
+                ++mExposures;
+                mLastRequested = requested_;
+                mLastAchieved = achieved_;
+                mErrorSum += errorMicros_;
+                mErrorMax = std::max(mErrorMax, std::fabs(errorMicros_));
+            }
+        }
+
+        finish(realtime_, policy_, param_);
+        return error_;
+    }
+
+    void BulbController::finish(bool realtime, int policy, const sched_param& param)
+    {
+        // the executor thread goes back to sending ordinary commands
+        if (realtime)
+        {
+            pthread_setschedparam(pthread_self(), policy, &param);
+        }
+
+        // notified under the lock, the destructor's wait() may return and free mDone right after
+        std::lock_guard<std::mutex> lock_(mMutex);
+        --mRunning;
+        mDone.notify_all();
+    }
+
+    void BulbController::wait()
+    {
+        std::unique_lock<std::mutex> lock_(mMutex);
+
+        while (0 < mRunning)
+        {
+            mDone.wait(lock_);
+        }
+    }
+}
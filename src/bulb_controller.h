@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <sched.h>
+#include <stdint.h>
+
+#include "EDSDK.h"
+#include "EDSDKErrors.h"
+#include "EDSDKTypes.h"
+
+#include "camera_manager.h"
+
+namespace eds
+{
+    // Timed bulb exposures for every open camera of the rig. Each exposure
+    // is one shutter command on the camera's command executor, so it keeps
+    // its order with everything else sent to that camera, and holds the
+    // executor until the shutter closes. For that time the executor thread
+    // is raised to real-time priority where the OS lets us. It presses the
+    // shutter, sleeps to an absolute deadline on the monotonic clock
+    // (clock_nanosleep on Linux, mach_wait_until on OS X) and releases it.
+    //
+    // The camera is taken to act on a command halfway through the
+    // EdsSendCommand round trip. The release goes out early by half the
+    // release latency measured on that camera so far, so the exposure ends
+    // on target instead of one USB round trip late. Exposures shorter than
+    // that lead come out long, the miss shows up in the error stats.
+    //
+    // The press doesn't autofocus, focus beforehand with a half-press.
+    class BulbController
+    {
+    public:
+        explicit BulbController(CameraManager& cameras);
+        ~BulbController();
+
+        // Returns the number of cameras exposing, 0 if the last exposure is still running.
+        // A camera starts once the commands queued before it are done.
+        size_t expose(double millis);
+        // Tells every exposure to close its shutter now and returns without
+        // waiting for the release, isExposing() turns false once it went out
+        void cancel();
+        bool isExposing() const;
+
+        uint64_t getExposureCount() const;
+        double getLastRequestedMillis() const;
+        double getLastAchievedMillis() const;
+        // Average of achieved - requested over every camera and exposure, and the largest miss either way
+        double getErrorMicrosAverage() const;
+        double getErrorMicrosMax() const;
+
+    private:
+        BulbController(const BulbController&);
+        BulbController& operator=(const BulbController&);
+
+        // On the session's command executor
+        EdsError run(CameraSession* session, uint64_t durationNanos);
+        // Restores the executor thread's scheduling
+        void finish(bool realtime, int policy, const sched_param& param);
+        // Blocks until every shutter is closed, only the destructor waits
+        void wait();
+
+        CameraManager& mCameras;
+        std::atomic<unsigned int> mRunning;
+        std::atomic<bool> bCancel;
+
+        mutable std::mutex mMutex;
+        std::condition_variable mDone;
+        // by session index, half round trip of the last releases
+        std::map<unsigned int, uint64_t> mReleaseNanos;
+        uint64_t mExposures;
+        double mLastRequested;
+        double mLastAchieved;
+        double mErrorSum;
+        double mErrorMax;
+    };
+}
@@ -0,0 +1,238 @@
+#include "camera_manager.h"
+
+#include <thread>
+
+namespace eds
+{
+    CameraManager::CameraManager(EventBus& bus)
+    : mBus(bus)
+    , mOpenMillis(0.0)
+    {
+    }
+
+    CameraManager::~CameraManager()
+    {
+        close();
+    }
+
+    EdsError CameraManager::open(const CameraSession::Settings& settings)
+    {
+        close();
+        mSessions.clear();
+        mSettings = settings;
+
+        auto start_ = std::chrono::steady_clock::now();
+
+        EdsCameraListRef cameraList_ = NULL;
+        EdsUInt32 count_ = 0;
+        EdsError error_ = EdsGetCameraList(&cameraList_);
+
+        if (EDS_ERR_OK == error_)
+        {
+            error_ = EdsGetChildCount(cameraList_, &count_);
+        }
+
+        for (EdsUInt32 i = 0; i < count_ && EDS_ERR_OK == error_; ++i)
+        {
+            EdsCameraRef camera_ = NULL;
+
+            if (EDS_ERR_OK == EdsGetChildAtIndex(cameraList_, i, &camera_))
+            {
+                mSessions.push_back(std::unique_ptr<CameraSession>(new CameraSession(camera_, (unsigned int)mSessions.size(), mBus)));
+            }
+        }
+
+        if (NULL != cameraList_)
+        {
+            EdsRelease(cameraList_);
+        }
+
+        // every session opens on its own thread, they share nothing but the bus
+        std::vector<std::thread> threads_;
+
+        for (size_t i = 0; i < mSessions.size(); ++i)
+        {
+            CameraSession* session_ = mSessions[i].get();
+            threads_.push_back(std::thread([this, session_]() { session_->open(mSettings); }));
+        }
+
+        for (size_t i = 0; i < threads_.size(); ++i)
+        {
+            threads_[i].join();
+        }
+
+        mOpened = std::chrono::steady_clock::now();
+        mOpenMillis = std::chrono::duration_cast<std::chrono::microseconds>(mOpened - start_).count() / 1000.0;
+
+        if (EDS_ERR_OK != error_)
+        {
+            return error_;
+        }
+
+        return 0 == getOpenCount() ? EDS_ERR_DEVICE_NOT_FOUND : EDS_ERR_OK;
+    }
+
+    void CameraManager::close()
+    {
+        std::vector<std::thread> threads_;
+
+        for (size_t i = 0; i < mSessions.size(); ++i)
+        {
+            CameraSession* session_ = mSessions[i].get();
+
+            if (session_->isOpen())
+            {
+                threads_.push_back(std::thread([session_]() { session_->close(); }));
+            }
+        }
+
+        for (size_t i = 0; i < threads_.size(); ++i)
+        {
+            threads_[i].join();
+        }
+    }
+
+    void CameraManager::close(unsigned int index)
+    {
+        CameraSession* session_ = getSession(index);
+
+        if (session_)
+        {
+            session_->close();
+        }
+    }
+
+    const CameraSession::Settings& CameraManager::getSettings() const
+    {
+        return mSettings;
+    }
+
+    size_t CameraManager::getSessionCount() const
+    {
+        return mSessions.size();
+    }
+
+    size_t CameraManager::getOpenCount() const
+    {
+        size_t count_ = 0;
+
+        for (size_t i = 0; i < mSessions.size(); ++i)
+        {
+            if (mSessions[i]->isOpen())
+            {
+                ++count_;
+            }
+        }
+
+        return count_;
+    }
+
+    CameraSession* CameraManager::getSession(unsigned int index) const
+    {
+        return index < mSessions.size() ? mSessions[index].get() : NULL;
+    }
+
+    double CameraManager::getOpenMillis() const
+    {
+        return mOpenMillis;
+    }
+
+    double CameraManager::getSlowestOpenMillis() const
+    {
+        double slowest_ = 0.0;
+
+        for (size_t i = 0; i < mSessions.size(); ++i)
+        {
+            if (slowest_ < mSessions[i]->getOpenMillis())
+            {
+                slowest_ = mSessions[i]->getOpenMillis();
+            }
+        }
+
+        return slowest_;
+    }
+
+    uint64_t CameraManager::getInFlightCount() const
+    {
+        uint64_t count_ = 0;
+
+        for (size_t i = 0; i < mSessions.size(); ++i)
+        {
+            count_ += mSessions[i]->getDownloadManager().getInFlightCount();
+        }
+
+        return count_;
+    }
+
+    uint64_t CameraManager::getCompletedCount() const
+    {
+        uint64_t count_ = 0;
+
+        for (size_t i = 0; i < mSessions.size(); ++i)
+        {
+            count_ += mSessions[i]->getDownloadManager().getCompletedCount();
+        }
+
+        return count_;
+    }
+
+    uint64_t CameraManager::getFailedCount() const
+    {
+        uint64_t count_ = 0;
+
+        for (size_t i = 0; i < mSessions.size(); ++i)
+        {
+            count_ += mSessions[i]->getDownloadManager().getFailedCount();
+        }
+
+        return count_;
+    }
+
+    uint64_t CameraManager::getTransferredBytes() const
+    {
+        uint64_t bytes_ = 0;
+
+        for (size_t i = 0; i < mSessions.size(); ++i)
+        {
+            bytes_ += mSessions[i]->getDownloadManager().getTransferredBytes();
+        }
+
+        return bytes_;
+    }
+
+    uint64_t CameraManager::getCommandCount() const
+    {
+        uint64_t count_ = 0;
+
+        for (size_t i = 0; i < mSessions.size(); ++i)
+        {
+            for (auto j = 0; j < kCommandClass_Count; ++j)
+            {
+                count_ += mSessions[i]->getCommandExecutor().getExecutedCount((CommandClass)j);
+            }
+        }
+
+        return count_;
+    }
+
+    double CameraManager::getEvfFramesPerSecond() const
+    {
+        double fps_ = 0.0;
+
+        for (size_t i = 0; i < mSessions.size(); ++i)
+        {
+            if (mSessions[i]->isLiveviewStarted())
+            {
+                fps_ += mSessions[i]->getEvfCapture().getFramesPerSecond();
+            }
+        }
+
+        return fps_;
+    }
+
+    double CameraManager::getMegabytesPerSecond() const
+    {
+        double seconds_ = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - mOpened).count() / 1000000.0;
+        return 0.0 < seconds_ ? getTransferredBytes() / (seconds_ * 1024.0 * 1024.0) : 0.0;
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "EDSDK.h"
+#include "EDSDKErrors.h"
+#include "EDSDKTypes.h"
+
+#include "camera_session.h"
+#include "event_bus.h"
+
+namespace eds
+{
+    // Opens a session on every connected camera, one thread per camera so a
+    // rig of 24 bodies takes about as long as the slowest one instead of the
+    // sum. Session indices follow EdsGetCameraList and stay stable until the
+    // next open(), a session that closed keeps its slot.
+    class CameraManager
+    {
+    public:
+        explicit CameraManager(EventBus& bus);
+        ~CameraManager();
+
+        // EDS_ERR_DEVICE_NOT_FOUND if nothing is connected or nothing could be opened
+        EdsError open(const CameraSession::Settings& settings);
+        // Closes every session in parallel
+        void close();
+        void close(unsigned int index);
+        // What the sessions were opened with, reused to reopen a replugged body
+        const CameraSession::Settings& getSettings() const;
+
+        size_t getSessionCount() const;
+        size_t getOpenCount() const;
+        // NULL for an index that was never opened
+        CameraSession* getSession(unsigned int index) const;
+
+        // Wall clock time of the parallel open, and the slowest single session
+        double getOpenMillis() const;
+        double getSlowestOpenMillis() const;
+
+        // Summed over all sessions
+        uint64_t getInFlightCount() const;
+        uint64_t getCompletedCount() const;
+        uint64_t getFailedCount() const;
+        uint64_t getTransferredBytes() const;
+        uint64_t getCommandCount() const;
+        double getEvfFramesPerSecond() const;
+        // Everything downloaded since open() over the time since open()
+        double getMegabytesPerSecond() const;
+
+    private:
+        CameraManager(const CameraManager&);
+        CameraManager& operator=(const CameraManager&);
+
+        EventBus& mBus;
+        std::vector<std::unique_ptr<CameraSession> > mSessions;
+        CameraSession::Settings mSettings;
+        std::chrono::steady_clock::time_point mOpened;
+        double mOpenMillis;
+    };
+}
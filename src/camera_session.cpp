@@ -0,0 +1,336 @@
+#include "camera_session.h"
+
+#include <chrono>
+#include <sstream>
+
+#include "ofMain.h"
+
+namespace eds
+{
+    CameraSession::Settings::Settings()
+    : writer(NULL)
+    , progress(NULL)
+    , progressContext(NULL)
+    , downloadThreads(2)
+    {
+    }
+
+    CameraSession::CameraSession(EdsCameraRef camera, unsigned int index, EventBus& bus)
+    : mCamera(camera)
+    , mIndex(index)
+    , mBus(bus)
+    , mOpenMillis(0.0)
+    , bOpen(false)
+    , bLiveviewStarted(false)
+    , mDownloadManager(mBufferPool)
+    {
+        std::ostringstream name_;
+        name_ << "camera #" << index;
+        mName = name_.str();
+    }
+
+    CameraSession::~CameraSession()
+    {
+        close();
+
+        if (NULL != mCamera)
+        {
+            EdsRelease(mCamera);
+            mCamera = NULL;
+        }
+    }
+
+    EdsError CameraSession::open(const Settings& settings)
+    {
+        if (bOpen)
+        {
+            return EDS_ERR_OK;
+        }
+
+        auto start_ = std::chrono::steady_clock::now();
+
+        EdsError error_ = EdsSetObjectEventHandler(mCamera, kEdsObjectEvent_All, onObjectEvent, this);
+
+        if (EDS_ERR_OK == error_)
+        {
+            error_ = EdsSetPropertyEventHandler(mCamera, kEdsPropertyEvent_All, onPropertyEvent, this);
+        }
+
+        if (EDS_ERR_OK == error_)
+        {
+            error_ = EdsSetCameraStateEventHandler(mCamera, kEdsStateEvent_All, onStateEvent, this);
+        }
+
+        if (EDS_ERR_OK == error_)
+        {
+            error_ = EdsOpenSession(mCamera);
+        }
+
+        if (EDS_ERR_OK != error_)
+        {
+            EdsSetObjectEventHandler(mCamera, kEdsObjectEvent_All, NULL, this);
+            EdsSetPropertyEventHandler(mCamera, kEdsPropertyEvent_All, NULL, this);
+            EdsSetCameraStateEventHandler(mCamera, kEdsStateEvent_All, NULL, this);
+
+            ofLogError("eds::CameraSession") << mName << " could not be opened: " << std::hex << error_;
+            return error_;
+        }
+
+        EdsDeviceInfo info_;
+
+        if (EDS_ERR_OK == EdsGetDeviceInfo(mCamera, &info_))
+        {
+            info_.szPortName[EDS_MAX_NAME - 1] = '\0';
+            mPortName = info_.szPortName;
+        }
+
+        std::string product_ = getStringProperty(kEdsPropID_ProductName);
+        mSerialNumber = getStringProperty(kEdsPropID_BodyIDEx);
+
+        if (!product_.empty())
+        {
+            std::ostringstream name_;
+            name_ << product_ << " #" << mIndex;
+            mName = name_.str();
+        }
+
+        mPropertyCache.attach(mCamera);
+
+        std::string name_ = mName;
+
+        mCommandExecutor.setErrorHandler([name_](CommandClass class_, EdsError error_)
+        {
+            ofLogError("eds::CameraSession") << name_ << ": " << CommandExecutor::getClassName(class_) << " command failed: " << std::hex << error_;
+        });
+        mCommandExecutor.start();
+
+        // the session is usable before the reads are done, liveview can negotiate meanwhile
+        if (!settings.prefetch.empty())
+        {
+            PropertyCache* cache_ = &mPropertyCache;
+            std::vector<EdsPropertyID> prefetch_ = settings.prefetch;
+            mCommandExecutor.post(kCommandClass_Property, [cache_, prefetch_]() { cache_->prefetch(&prefetch_[0], prefetch_.size()); return EDS_ERR_OK; });
+        }
+
+        if (settings.writer && settings.path)
+        {
+            PathHandler path_ = settings.path;
+            mDownloadManager.setStreaming(settings.writer, [this, path_](const EdsDirectoryItemInfo& info_) { return path_(*this, info_); });
+        }
+
+        if (settings.progress)
+        {
+            mDownloadManager.setProgressCallback(settings.progress, settings.progressContext);
+        }
+
+        PersistHandler persist_ = settings.persist;
+        mDownloadManager.start([this, persist_](const Download& download_) { return !persist_ || persist_(*this, download_); }, settings.downloadThreads);
+
+        mOpenMillis = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_).count() / 1000.0;
+        bOpen = true;
+
+        return EDS_ERR_OK;
+    }
+
+    EdsError CameraSession::reopen(EdsCameraRef camera, const Settings& settings)
+    {
+        if (bOpen)
+        {
+            EdsRelease(camera);
+            return EDS_ERR_SESSION_ALREADY_OPEN;
+        }
+
+        if (NULL != mCamera)
+        {
+            EdsRelease(mCamera);
+        }
+
+        mCamera = camera;
+        return open(settings);
+    }
+
+    void CameraSession::close()
+    {
+        if (!bOpen)
+        {
+            return;
+        }
+
+        EdsSetObjectEventHandler(mCamera, kEdsObjectEvent_All, NULL, this);
+        EdsSetPropertyEventHandler(mCamera, kEdsPropertyEvent_All, NULL, this);
+        EdsSetCameraStateEventHandler(mCamera, kEdsStateEvent_All, NULL, this);
+
+        // a queued shutter release still has to reach the camera
+        mCommandExecutor.stop();
+
+        if (bLiveviewStarted)
+        {
+            endLiveview();
+        }
+
+        // downloads still in the queue need the session
+        mDownloadManager.stop();
+        mPropertyCache.detach();
+
+        EdsCloseSession(mCamera);
+        bOpen = false;
+    }
+
+    bool CameraSession::isOpen() const
+    {
+        return bOpen;
+    }
+
+    EdsError CameraSession::startLiveview()
+    {
+        if (!bOpen)
+        {
+            return EDS_ERR_SESSION_NOT_OPEN;
+        }
+
+        if (bLiveviewStarted)
+        {
+            return EDS_ERR_OK;
+        }
+
+        EdsUInt32 device_ = 0;
+        EdsError error_ = mPropertyCache.get<kEdsPropID_Evf_OutputDevice>(device_);
+
+        if (EDS_ERR_OK == error_)
+        {
+            device_ |= kEdsEvfOutputDevice_PC;
+            error_ = mPropertyCache.set<kEdsPropID_Evf_OutputDevice>(device_);
+        }
+
+        if (EDS_ERR_OK == error_)
+        {
+            error_ = mEvfCapture.start(mCamera);
+            bLiveviewStarted = (EDS_ERR_OK == error_);
+        }
+
+        return error_;
+    }
+
+    EdsError CameraSession::endLiveview()
+    {
+        // the acquisition thread stops before the output device goes away
+        mEvfCapture.stop();
+        bLiveviewStarted = false;
+
+        EdsUInt32 device_ = 0;
+        EdsError error_ = mPropertyCache.get<kEdsPropID_Evf_OutputDevice>(device_);
+
+        // PC live view ends if the PC is disconnected from the live view image output device
+        if (EDS_ERR_OK == error_)
+        {
+            device_ &= ~kEdsEvfOutputDevice_PC;
+            error_ = mPropertyCache.set<kEdsPropID_Evf_OutputDevice>(device_);
+        }
+
+        return error_;
+    }
+
+    bool CameraSession::isLiveviewStarted() const
+    {
+        return bLiveviewStarted;
+    }
+
+    bool CameraSession::sendCommand(CommandClass commandClass, EdsCameraCommand command, EdsInt32 param, uint32_t coalesceKey)
+    {
+        EdsCameraRef camera_ = mCamera;
+        return mCommandExecutor.post(commandClass, [camera_, command, param]() { return EdsSendCommand(camera_, command, param); }, coalesceKey);
+    }
+
+    EdsCameraRef CameraSession::getCamera() const
+    {
+        return mCamera;
+    }
+
+    unsigned int CameraSession::getIndex() const
+    {
+        return mIndex;
+    }
+
+    const std::string& CameraSession::getName() const
+    {
+        return mName;
+    }
+
+    const std::string& CameraSession::getSerialNumber() const
+    {
+        return mSerialNumber;
+    }
+
+    const std::string& CameraSession::getPortName() const
+    {
+        return mPortName;
+    }
+
+    double CameraSession::getOpenMillis() const
+    {
+        return mOpenMillis;
+    }
+
+    PropertyCache& CameraSession::getPropertyCache()
+    {
+        return mPropertyCache;
+    }
+
+    CommandExecutor& CameraSession::getCommandExecutor()
+    {
+        return mCommandExecutor;
+    }
+
+    DownloadManager& CameraSession::getDownloadManager()
+    {
+        return mDownloadManager;
+    }
+
+    EvfCapture& CameraSession::getEvfCapture()
+    {
+        return mEvfCapture;
+    }
+
+    CaptureGrouper& CameraSession::getCaptureGrouper()
+    {
+        return mCaptureGrouper;
+    }
+
+    std::string CameraSession::getStringProperty(EdsPropertyID property)
+    {
+        char value_[EDS_MAX_NAME] = { 0 };
+
+        if (EDS_ERR_OK != EdsGetPropertyData(mCamera, property, 0, sizeof(value_), value_))
+        {
+            return std::string();
+        }
+
+        value_[EDS_MAX_NAME - 1] = '\0';
+        return value_;
+    }
+
+    EdsError EDSCALLBACK CameraSession::onObjectEvent(EdsObjectEvent event, EdsBaseRef object, EdsVoid* context)
+    {
+        CameraSession* session_ = (CameraSession*)context;
+
+        // the bus releases the object once the subscribers ran
+        session_->mBus.postObject(event, object, session_->mIndex);
+        return EDS_ERR_OK;
+    }
+
+    EdsError EDSCALLBACK CameraSession::onPropertyEvent(EdsPropertyEvent event, EdsPropertyID property, EdsUInt32 param, EdsVoid* context)
+    {
+        CameraSession* session_ = (CameraSession*)context;
+
+        session_->mBus.postProperty(event, property, param, session_->mIndex);
+        return EDS_ERR_OK;
+    }
+
+    EdsError EDSCALLBACK CameraSession::onStateEvent(EdsStateEvent event, EdsUInt32 param, EdsVoid* context)
+    {
+        CameraSession* session_ = (CameraSession*)context;
+
+        session_->mBus.postState(event, param, session_->mIndex);
+        return EDS_ERR_OK;
+    }
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "EDSDK.h"
+#include "EDSDKErrors.h"
+#include "EDSDKTypes.h"
+
+#include "buffer_pool.h"
+#include "capture_grouper.h"
+#include "command_executor.h"
+#include "download_manager.h"
+#include "event_bus.h"
+#include "evf_capture.h"
+#include "persist_writer.h"
+#include "property_cache.h"
+
+namespace eds
+{
+    // Everything that belongs to one connected body: its SDK session, the
+    // property cache, the command thread, download workers and buffers, the
+    // liveview acquisition thread and the grouper that names its captures.
+    // SDK events are posted to the shared EventBus tagged with the session's
+    // index, so subscribers know which camera they came from.
+    class CameraSession
+    {
+    public:
+        typedef std::function<std::string(CameraSession&, const EdsDirectoryItemInfo&)> PathHandler;
+        typedef std::function<bool(CameraSession&, const Download&)> PersistHandler;
+
+        struct Settings
+        {
+            Settings();
+
+            // Downloads stream into their files when a writer is given
+            PersistWriter* writer;
+            PathHandler path;
+            PersistHandler persist;
+            EdsProgressCallback progress;
+            EdsVoid* progressContext;
+            unsigned int downloadThreads;
+            // Read into the property cache by the command thread, before any
+            // property write posted after open(). open() doesn't wait for it.
+            std::vector<EdsPropertyID> prefetch;
+        };
+
+        // Takes over the camera reference
+        CameraSession(EdsCameraRef camera, unsigned int index, EventBus& bus);
+        ~CameraSession();
+
+        EdsError open(const Settings& settings);
+        // A replugged body comes back with a new camera reference, the
+        // session has to be closed. Cache, buffers and index stay as they were.
+        EdsError reopen(EdsCameraRef camera, const Settings& settings);
+        // Finishes queued commands and downloads, then closes the session
+        void close();
+        bool isOpen() const;
+
+        // Routes the PC output device and starts the acquisition thread
+        EdsError startLiveview();
+        EdsError endLiveview();
+        bool isLiveviewStarted() const;
+
+        // Queued on this camera's command thread
+        bool sendCommand(CommandClass commandClass, EdsCameraCommand command, EdsInt32 param, uint32_t coalesceKey = 0);
+
+        template<EdsPropertyID Property>
+        bool setProperty(const typename PropertyTraits<Property>::Type& value)
+        {
+            PropertyCache* cache_ = &mPropertyCache;
+            return mCommandExecutor.post(kCommandClass_Property, [cache_, value]() { return cache_->set<Property>(value); }, Property);
+        }
+
+        EdsCameraRef getCamera() const;
+        unsigned int getIndex() const;
+        // "Canon EOS 5D Mark IV #2", and the body serial number if the camera reports one
+        const std::string& getName() const;
+        const std::string& getSerialNumber() const;
+        // USB port the body was on when the session opened
+        const std::string& getPortName() const;
+        double getOpenMillis() const;
+
+        PropertyCache& getPropertyCache();
+        CommandExecutor& getCommandExecutor();
+        DownloadManager& getDownloadManager();
+        EvfCapture& getEvfCapture();
+        CaptureGrouper& getCaptureGrouper();
+
+    private:
+        CameraSession(const CameraSession&);
+        CameraSession& operator=(const CameraSession&);
+
+        std::string getStringProperty(EdsPropertyID property);
+
+        static EdsError EDSCALLBACK onObjectEvent(EdsObjectEvent event, EdsBaseRef object, EdsVoid* context);
+        static EdsError EDSCALLBACK onPropertyEvent(EdsPropertyEvent event, EdsPropertyID property, EdsUInt32 param, EdsVoid* context);
+        static EdsError EDSCALLBACK onStateEvent(EdsStateEvent event, EdsUInt32 param, EdsVoid* context);
+
+        EdsCameraRef mCamera;
+        unsigned int mIndex;
+        EventBus& mBus;
+        std::string mName;
+        std::string mSerialNumber;
+        std::string mPortName;
+        double mOpenMillis;
+        // set last in open(), a session reopened in the background isn't used half way
+        std::atomic<bool> bOpen;
+        bool bLiveviewStarted;
+
+        PropertyCache mPropertyCache;
+        CommandExecutor mCommandExecutor;
+        BufferPool mBufferPool;
+        DownloadManager mDownloadManager;
+        EvfCapture mEvfCapture;
+        CaptureGrouper mCaptureGrouper;
+    };
+}
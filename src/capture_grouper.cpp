@@ -0,0 +1,71 @@
+#include "capture_grouper.h"
+
+#include <algorithm>
+#include <sstream>
+
+namespace eds
+{
+    CaptureGrouper::CaptureGrouper(unsigned int history)
+    : mHistory(std::max(1u, history))
+    {
+        mRecent.reserve(mHistory);
+    }
+
+    std::string CaptureGrouper::group(const EdsDirectoryItemInfo& info, const std::string& name, bool* paired)
+    {
+        std::ostringstream key_;
+
+        if (0 != info.groupID)
+        {
+            key_ << "group:" << info.groupID;
+        }
+        else
+        {
+            key_ << "name:" << getBaseName(info.szFileName);
+        }
+
+        std::lock_guard<std::mutex> lock_(mMutex);
+
+        for (size_t i = 0; i < mRecent.size(); ++i)
+        {
+            if (key_.str() == mRecent[i].key)
+            {
+                if (NULL != paired)
+                {
+                    *paired = true;
+                }
+
+                return mRecent[i].name;
+            }
+        }
+
+        if (mHistory <= mRecent.size())
+        {
+            mRecent.erase(mRecent.begin());
+        }
+
+        Capture capture_;
+        capture_.key = key_.str();
+        capture_.name = name;
+        mRecent.push_back(capture_);
+
+        if (NULL != paired)
+        {
+            *paired = false;
+        }
+
+        return name;
+    }
+
+    std::string CaptureGrouper::getBaseName(const std::string& fileName)
+    {
+        size_t dot_ = fileName.rfind('.');
+        return std::string::npos == dot_ ? fileName : fileName.substr(0, dot_);
+    }
+
+    std::string CaptureGrouper::getExtension(const std::string& fileName)
+    {
+        size_t dot_ = fileName.rfind('.');
+        return std::string::npos == dot_ ? "" : fileName.substr(dot_);
+    }
+}
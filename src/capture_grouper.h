@@ -0,0 +1,43 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "EDSDK.h"
+#include "EDSDKTypes.h"
+
+namespace eds
+{
+    // RAW+JPEG shots arrive as separate directory items. They share a groupID
+    // or, on bodies that leave it at 0, the file name without extension. The
+    // grouper hands every item of one shot the same capture name, so the pair
+    // is saved side by side under one prefix.
+    class CaptureGrouper
+    {
+    public:
+        CaptureGrouper(unsigned int history = 16);
+
+        // Name already given to this item's shot, or name if the shot is new.
+        // paired is set when another item of the same shot came first.
+        std::string group(const EdsDirectoryItemInfo& info, const std::string& name, bool* paired = NULL);
+
+        static std::string getBaseName(const std::string& fileName);
+        static std::string getExtension(const std::string& fileName);
+
+    private:
+        struct Capture
+        {
+            std::string key;
+            std::string name;
+        };
+
+        CaptureGrouper(const CaptureGrouper&);
+        CaptureGrouper& operator=(const CaptureGrouper&);
+
+        // the last few shots, newest at the back
+        std::vector<Capture> mRecent;
+        unsigned int mHistory;
+        std::mutex mMutex;
+    };
+}
@@ -0,0 +1,118 @@
+#include "capture_manifest.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <ctime>
+#include <fcntl.h>
+#include <sstream>
+#include <unistd.h>
+
+#include "xxhash64.h"
+
+namespace
+{
+    std::string escape(const std::string& text)
+    {
+        std::string escaped_;
+        escaped_.reserve(text.size());
+
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            char c_ = text[i];
+
+            if ('"' == c_ || '\\' == c_)
+            {
+                escaped_ += '\\';
+                escaped_ += c_;
+            }
+            else if ((unsigned char)c_ < 0x20)
+            {
+                char code_[8];
+                snprintf(code_, sizeof(code_), "\\u%04x", c_);
+                escaped_ += code_;
+            }
+            else
+            {
+                escaped_ += c_;
+            }
+        }
+
+        return escaped_;
+    }
+}
+
+namespace eds
+{
+    CaptureManifest::CaptureManifest()
+    : mFd(-1)
+    {
+    }
+
+    CaptureManifest::~CaptureManifest()
+    {
+        close();
+    }
+
+    bool CaptureManifest::open(const std::string& path)
+    {
+        close();
+
+        std::lock_guard<std::mutex> lock_(mMutex);
+
+        // O_APPEND: every entry lands at the end, whatever else has the file open
+        mFd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+
+        return 0 <= mFd;
+    }
+
+    void CaptureManifest::close()
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+
+        if (0 <= mFd)
+        {
+            fsync(mFd);
+            ::close(mFd);
+            mFd = -1;
+        }
+    }
+
+    bool CaptureManifest::isOpen() const
+    {
+        return 0 <= mFd;
+    }
+
+    bool CaptureManifest::append(const std::string& path, const EdsDirectoryItemInfo& info, uint64_t hash)
+    {
+        std::ostringstream line_;
+
+        line_ << "{\"time\":" << time(NULL)
+              << ",\"path\":\"" << escape(path) << "\""
+              << ",\"name\":\"" << escape(info.szFileName) << "\""
+              << ",\"size\":" << info.size
+              << ",\"format\":" << info.format
+              << ",\"groupID\":" << info.groupID
+              << ",\"option\":" << info.option
+              << ",\"xxh64\":\"" << XXHash64::toHex(hash) << "\"}\n";
+
+        std::string text_ = line_.str();
+
+        std::lock_guard<std::mutex> lock_(mMutex);
+
+        if (mFd < 0)
+        {
+            return false;
+        }
+
+        // one write() per entry, so lines never interleave
+        ssize_t result_ = -1;
+
+        do
+        {
+            result_ = ::write(mFd, text_.data(), text_.size());
+        }
+        while (result_ < 0 && EINTR == errno);
+
+        return (ssize_t)text_.size() == result_;
+    }
+}
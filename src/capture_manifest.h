@@ -0,0 +1,34 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+
+#include "EDSDK.h"
+#include "EDSDKTypes.h"
+
+namespace eds
+{
+    // Append-only record of every saved capture, one JSON object per line:
+    // where it went, its hash and the camera's directory item info. Entries
+    // are never rewritten, a crash can at most cut off the last line.
+    class CaptureManifest
+    {
+    public:
+        CaptureManifest();
+        ~CaptureManifest();
+
+        bool open(const std::string& path);
+        void close();
+        bool isOpen() const;
+
+        // Safe to call from several download workers
+        bool append(const std::string& path, const EdsDirectoryItemInfo& info, uint64_t hash);
+
+    private:
+        CaptureManifest(const CaptureManifest&);
+        CaptureManifest& operator=(const CaptureManifest&);
+
+        int mFd;
+        std::mutex mMutex;
+    };
+}
@@ -0,0 +1,233 @@
+#include "command_executor.h"
+
+namespace eds
+{
+    const char* CommandExecutor::getClassName(CommandClass commandClass)
+    {
+        switch (commandClass)
+        {
+            case kCommandClass_Shutter:
+                return "shutter";
+
+            case kCommandClass_Lens:
+                return "lens";
+
+            case kCommandClass_Property:
+                return "property";
+
+            default:
+                return "unknown";
+        }
+    }
+
+    CommandExecutor::CommandExecutor()
+    : bRunning(false)
+    {
+        for (auto i = 0; i < kCommandClass_Count; ++i)
+        {
+            mStats[i].executed = 0;
+            mStats[i].failed = 0;
+            mStats[i].coalesced = 0;
+            mStats[i].latencyMicros = 0;
+            mStats[i].latencyMicrosMax = 0;
+        }
+    }
+
+    CommandExecutor::~CommandExecutor()
+    {
+        stop();
+    }
+
+    void CommandExecutor::setErrorHandler(const ErrorHandler& handler)
+    {
+        mErrorHandler = handler;
+    }
+
+    void CommandExecutor::start()
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+
+        if (bRunning)
+        {
+            return;
+        }
+
+        bRunning = true;
+        mThread = std::thread(&CommandExecutor::threadedFunction, this);
+    }
+
+    void CommandExecutor::stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock_(mMutex);
+            bRunning = false;
+        }
+
+        mNotEmpty.notify_all();
+
+        if (mThread.joinable())
+        {
+            mThread.join();
+        }
+    }
+
+    bool CommandExecutor::isRunning() const
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+        return bRunning;
+    }
+
+    bool CommandExecutor::post(CommandClass commandClass, const Command& command, uint32_t coalesceKey)
+    {
+        {
+            std::lock_guard<std::mutex> lock_(mMutex);
+
+            if (!bRunning)
+            {
+                return false;
+            }
+
+            std::deque<Pending>& queue_ = mQueues[commandClass];
+
+            // the superseded command keeps its place and post time, only what it does changes
+            if (0 != coalesceKey)
+            {
+                for (std::deque<Pending>::iterator it_ = queue_.begin(); it_ != queue_.end(); ++it_)
+                {
+                    if (coalesceKey == it_->coalesceKey)
+                    {
+                        it_->command = command;
+                        ++mStats[commandClass].coalesced;
+                        return true;
+                    }
+                }
+            }
+
+            Pending pending_;
+            pending_.command = command;
+            pending_.coalesceKey = coalesceKey;
+            pending_.posted = std::chrono::steady_clock::now();
+            queue_.push_back(pending_);
+        }
+
+        mNotEmpty.notify_one();
+        return true;
+    }
+
+    EdsError CommandExecutor::execute(CommandClass commandClass, const Command& command)
+    {
+        std::shared_ptr<std::promise<EdsError> > result_(new std::promise<EdsError>());
+
+        if (!post(commandClass, [command, result_]() { EdsError error_ = command(); result_->set_value(error_); return error_; }))
+        {
+            return EDS_ERR_SESSION_NOT_OPEN;
+        }
+
+        return result_->get_future().get();
+    }
+
+    size_t CommandExecutor::getQueueSize() const
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+
+        size_t size_ = 0;
+
+        for (auto i = 0; i < kCommandClass_Count; ++i)
+        {
+            size_ += mQueues[i].size();
+        }
+
+        return size_;
+    }
+
+    uint64_t CommandExecutor::getExecutedCount(CommandClass commandClass) const
+    {
+        return mStats[commandClass].executed;
+    }
+
+    uint64_t CommandExecutor::getFailedCount(CommandClass commandClass) const
+    {
+        return mStats[commandClass].failed;
+    }
+
+    uint64_t CommandExecutor::getCoalescedCount(CommandClass commandClass) const
+    {
+        return mStats[commandClass].coalesced;
+    }
+
+    double CommandExecutor::getLatencyMillisAverage(CommandClass commandClass) const
+    {
+        uint64_t executed_ = mStats[commandClass].executed;
+        return 0 == executed_ ? 0.0 : mStats[commandClass].latencyMicros / (executed_ * 1000.0);
+    }
+
+    double CommandExecutor::getLatencyMillisMax(CommandClass commandClass) const
+    {
+        return mStats[commandClass].latencyMicrosMax / 1000.0;
+    }
+
+    void CommandExecutor::threadedFunction()
+    {
+        while (true)
+        {
+            Pending pending_;
+            CommandClass class_ = kCommandClass_Count;
+
+            {
+                std::unique_lock<std::mutex> lock_(mMutex);
+
+                while (kCommandClass_Count == class_)
+                {
+                    for (auto i = 0; i < kCommandClass_Count; ++i)
+                    {
+                        if (!mQueues[i].empty())
+                        {
+                            class_ = (CommandClass)i;
+                            break;
+                        }
+                    }
+
+                    if (kCommandClass_Count != class_)
+                    {
+                        break;
+                    }
+
+                    // stop() lets the queues run empty first
+                    if (!bRunning)
+                    {
+                        return;
+                    }
+
+                    mNotEmpty.wait(lock_);
+                }
+
+                pending_ = mQueues[class_].front();
+                mQueues[class_].pop_front();
+            }
+
+            Stats& stats_ = mStats[class_];
+            uint64_t latency_ = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - pending_.posted).count();
+
+            stats_.latencyMicros += latency_;
+
+            // only this thread writes the maximum
+            if (stats_.latencyMicrosMax < latency_)
+            {
+                stats_.latencyMicrosMax = latency_;
+            }
+
+            EdsError error_ = pending_.command();
+            ++stats_.executed;
+
+            if (EDS_ERR_OK != error_)
+            {
+                ++stats_.failed;
+
+                if (mErrorHandler)
+                {
+                    mErrorHandler(class_, error_);
+                }
+            }
+        }
+    }
+}
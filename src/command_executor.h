@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "EDSDK.h"
+#include "EDSDKErrors.h"
+#include "EDSDKTypes.h"
+
+namespace eds
+{
+    // Highest priority first
+    enum CommandClass
+    {
+        kCommandClass_Shutter,  // take picture, press/release
+        kCommandClass_Lens,     // drive lens, AF
+        kCommandClass_Property, // property writes, profiles
+        kCommandClass_Count
+    };
+
+    // The one thread that sends commands and property writes to the camera,
+    // so the UI thread never waits on USB. Queued commands run by class, a
+    // shutter press overtakes any lens or property work still waiting, and
+    // keep their order within a class (press before release).
+    //
+    // A command posted with a coalesce key replaces a queued, not yet
+    // running command with the same key: five zoom position clicks in a row
+    // become one write of the last position.
+    class CommandExecutor
+    {
+    public:
+        typedef std::function<EdsError()> Command;
+        typedef std::function<void(CommandClass, EdsError)> ErrorHandler;
+
+        static const char* getClassName(CommandClass commandClass);
+
+        CommandExecutor();
+        ~CommandExecutor();
+
+        // Called on the executor thread for every command that didn't return EDS_ERR_OK
+        void setErrorHandler(const ErrorHandler& handler);
+
+        void start();
+        // Runs everything already queued before returning
+        void stop();
+        bool isRunning() const;
+
+        // Returns false if the executor isn't running. 0 doesn't coalesce.
+        bool post(CommandClass commandClass, const Command& command, uint32_t coalesceKey = 0);
+        // Posts the command and waits for its result, in order with everything
+        // queued before it. Never from a command, the thread would wait on itself.
+        // EDS_ERR_SESSION_NOT_OPEN if the executor isn't running.
+        EdsError execute(CommandClass commandClass, const Command& command);
+
+        size_t getQueueSize() const;
+        uint64_t getExecutedCount(CommandClass commandClass) const;
+        uint64_t getFailedCount(CommandClass commandClass) const;
+        uint64_t getCoalescedCount(CommandClass commandClass) const;
+        // post -> start of execution
+        double getLatencyMillisAverage(CommandClass commandClass) const;
+        double getLatencyMillisMax(CommandClass commandClass) const;
+
+    private:
+        struct Pending
+        {
+            Command command;
+            uint32_t coalesceKey;
+            std::chrono::steady_clock::time_point posted;
+        };
+
+        struct Stats
+        {
+            std::atomic<uint64_t> executed;
+            std::atomic<uint64_t> failed;
+            std::atomic<uint64_t> coalesced;
+            std::atomic<uint64_t> latencyMicros;
+            std::atomic<uint64_t> latencyMicrosMax;
+        };
+
+        CommandExecutor(const CommandExecutor&);
+        CommandExecutor& operator=(const CommandExecutor&);
+
+        void threadedFunction();
+
+        ErrorHandler mErrorHandler;
+
+        std::deque<Pending> mQueues[kCommandClass_Count];
+        Stats mStats[kCommandClass_Count];
+
+        std::thread mThread;
+        mutable std::mutex mMutex;
+        std::condition_variable mNotEmpty;
+        bool bRunning;
+    };
+}
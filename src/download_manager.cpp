@@ -0,0 +1,575 @@
+#include "download_manager.h"
+
+#include <algorithm>
+
+#include "ofMain.h"
+
+#include "xxhash64.h"
+
+namespace
+{
+    double millisSince(std::chrono::steady_clock::time_point start, uint64_t& micros)
+    {
+        micros = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        return micros / 1000.0;
+    }
+}
+
+namespace eds
+{
+    DownloadManager::DownloadManager(BufferPool& pool, unsigned int capacity)
+    : mPool(pool)
+    , mCapacity(std::max(1u, capacity))
+    , mWriter(NULL)
+    , mChunkSize(kDefaultChunkSize)
+    , mProgress(NULL)
+    , mProgressContext(NULL)
+    , mHighWaterMark(0)
+    , bRunning(false)
+    , mEnqueued(0)
+    , mCompleted(0)
+    , mFailed(0)
+    , mCancelled(0)
+    , mBlocked(0)
+    , mBytes(0)
+    , mQueuedMicros(0)
+    , mTransferMicros(0)
+    , mPersistMicros(0)
+    , mHashMicros(0)
+    {
+        mQueue.reserve(mCapacity);
+    }
+
+    DownloadManager::~DownloadManager()
+    {
+        stop();
+    }
+
+    void DownloadManager::setStreaming(PersistWriter* writer, const PathHandler& path, size_t chunkSize)
+    {
+        mWriter = writer;
+        mPath = path;
+        mChunkSize = std::max((size_t)64 * 1024, chunkSize);
+    }
+
+    void DownloadManager::setProgressCallback(EdsProgressCallback callback, EdsVoid* context)
+    {
+        mProgress = callback;
+        mProgressContext = context;
+    }
+
+    void DownloadManager::start(const PersistHandler& persist, unsigned int threadCount)
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+
+        if (bRunning)
+        {
+            return;
+        }
+
+        mPersist = persist;
+        bRunning = true;
+
+        for (unsigned int i = 0; i < std::max(1u, threadCount); ++i)
+        {
+            mWorkers.push_back(std::unique_ptr<Worker>(new Worker(*this)));
+            mThreads.push_back(std::thread(&DownloadManager::threadedFunction, this, mWorkers.back().get()));
+        }
+    }
+
+    void DownloadManager::stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock_(mMutex);
+
+            if (!bRunning)
+            {
+                return;
+            }
+
+            bRunning = false;
+        }
+
+        mNotEmpty.notify_all();
+        mNotFull.notify_all();
+
+        // workers drain the queue before they exit
+        for (size_t i = 0; i < mThreads.size(); ++i)
+        {
+            mThreads[i].join();
+        }
+
+        mThreads.clear();
+
+        std::lock_guard<std::mutex> lock_(mMutex);
+        mWorkers.clear();
+    }
+
+    bool DownloadManager::isRunning() const
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+        return bRunning;
+    }
+
+    bool DownloadManager::enqueue(EdsDirectoryItemRef itemRef)
+    {
+        std::unique_lock<std::mutex> lock_(mMutex);
+
+        if (bRunning && mCapacity <= mQueue.size())
+        {
+            // backpressure: hold the SDK callback until a worker catches up
+            ++mBlocked;
+
+            while (bRunning && mCapacity <= mQueue.size())
+            {
+                mNotFull.wait(lock_);
+            }
+        }
+
+        if (!bRunning)
+        {
+            return false;
+        }
+
+        push(itemRef);
+
+        lock_.unlock();
+        mNotEmpty.notify_one();
+
+        return true;
+    }
+
+    bool DownloadManager::tryEnqueue(EdsDirectoryItemRef itemRef)
+    {
+        std::unique_lock<std::mutex> lock_(mMutex);
+
+        if (!bRunning || mCapacity <= mQueue.size())
+        {
+            return false;
+        }
+
+        push(itemRef);
+
+        lock_.unlock();
+        mNotEmpty.notify_one();
+
+        return true;
+    }
+
+    unsigned int DownloadManager::cancel()
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+        unsigned int cancelled_ = 0;
+
+        for (size_t i = 0; i < mWorkers.size(); ++i)
+        {
+            // a worker clears its flag when it picks up the next item
+            if (mWorkers[i]->bBusy)
+            {
+                mWorkers[i]->bCancel = true;
+                ++cancelled_;
+            }
+        }
+
+        return cancelled_;
+    }
+
+    std::vector<EdsUInt32> DownloadManager::getProgress() const
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+        std::vector<EdsUInt32> progress_;
+
+        for (size_t i = 0; i < mWorkers.size(); ++i)
+        {
+            if (mWorkers[i]->bBusy)
+            {
+                progress_.push_back(mWorkers[i]->percent);
+            }
+        }
+
+        return progress_;
+    }
+
+    void DownloadManager::push(EdsDirectoryItemRef itemRef)
+    {
+        // the caller gives its reference back when the callback or the bus event is done
+        EdsRetain(itemRef);
+
+        Pending pending_;
+        pending_.itemRef = itemRef;
+        pending_.enqueued = std::chrono::steady_clock::now();
+
+        mQueue.push_back(pending_);
+        mHighWaterMark = std::max(mHighWaterMark, (unsigned int)mQueue.size());
+        ++mEnqueued;
+    }
+
+    unsigned int DownloadManager::getCapacity() const
+    {
+        return mCapacity;
+    }
+
+    unsigned int DownloadManager::getQueueSize() const
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+        return mQueue.size();
+    }
+
+    unsigned int DownloadManager::getQueueHighWaterMark() const
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+        return mHighWaterMark;
+    }
+
+    uint64_t DownloadManager::getInFlightCount() const
+    {
+        // processed first, the enqueued count read after it can only be larger
+        uint64_t processed_ = mCompleted + mFailed + mCancelled;
+        return mEnqueued - processed_;
+    }
+
+    uint64_t DownloadManager::getEnqueuedCount() const
+    {
+        return mEnqueued;
+    }
+
+    uint64_t DownloadManager::getCompletedCount() const
+    {
+        return mCompleted;
+    }
+
+    uint64_t DownloadManager::getFailedCount() const
+    {
+        return mFailed;
+    }
+
+    uint64_t DownloadManager::getCancelledCount() const
+    {
+        return mCancelled;
+    }
+
+    uint64_t DownloadManager::getBlockedCount() const
+    {
+        return mBlocked;
+    }
+
+    uint64_t DownloadManager::getTransferredBytes() const
+    {
+        return mBytes;
+    }
+
+    double DownloadManager::getQueuedMillisAverage() const
+    {
+        uint64_t processed_ = mCompleted + mFailed + mCancelled;
+        return 0 < processed_ ? mQueuedMicros / 1000.0 / processed_ : 0.0;
+    }
+
+    double DownloadManager::getTransferMillisAverage() const
+    {
+        uint64_t processed_ = mCompleted + mFailed + mCancelled;
+        return 0 < processed_ ? mTransferMicros / 1000.0 / processed_ : 0.0;
+    }
+
+    double DownloadManager::getPersistMillisAverage() const
+    {
+        uint64_t completed_ = mCompleted;
+        return 0 < completed_ ? mPersistMicros / 1000.0 / completed_ : 0.0;
+    }
+
+    double DownloadManager::getHashMillisAverage() const
+    {
+        uint64_t completed_ = mCompleted;
+        return 0 < completed_ ? mHashMicros / 1000.0 / completed_ : 0.0;
+    }
+
+    double DownloadManager::getHashOverhead() const
+    {
+        uint64_t micros_ = mTransferMicros;
+        return 0 < micros_ ? (double)mHashMicros / micros_ : 0.0;
+    }
+
+    double DownloadManager::getTransferMegabytesPerSecond() const
+    {
+        uint64_t micros_ = mTransferMicros;
+        return 0 < micros_ ? (mBytes / (1024.0 * 1024.0)) / (micros_ / 1000000.0) : 0.0;
+    }
+
+    void DownloadManager::threadedFunction(Worker* worker)
+    {
+        // the only buffer a streaming worker ever needs
+        std::vector<char> chunk_;
+
+        if (NULL != mWriter)
+        {
+            chunk_.resize(mChunkSize);
+        }
+
+        while (true)
+        {
+            Pending pending_;
+
+            {
+                std::unique_lock<std::mutex> lock_(mMutex);
+
+                while (bRunning && mQueue.empty())
+                {
+                    mNotEmpty.wait(lock_);
+                }
+
+                if (mQueue.empty())
+                {
+                    return;
+                }
+
+                pending_ = mQueue.front();
+                mQueue.erase(mQueue.begin());
+
+                // under the lock, a cancel() of the previous item can't reach this one
+                worker->bCancel = false;
+                worker->percent = 0;
+                worker->bBusy = true;
+            }
+
+            mNotFull.notify_one();
+
+            process(pending_, *worker, chunk_);
+            EdsRelease(pending_.itemRef);
+        }
+    }
+
+    void DownloadManager::process(const Pending& pending, Worker& worker, std::vector<char>& chunk)
+    {
+        Download download_;
+        download_.itemRef = pending.itemRef;
+
+        uint64_t micros_ = 0;
+
+        download_.queuedMillis = millisSince(pending.enqueued, micros_);
+        mQueuedMicros += micros_;
+
+        auto start_ = std::chrono::steady_clock::now();
+        download_.error = (NULL != mWriter) ? transferToFile(download_, worker, chunk) : transfer(download_, worker);
+        worker.bBusy = false;
+        download_.transferMillis = millisSince(start_, micros_);
+        mTransferMicros += micros_;
+
+        if (EDS_ERR_OPERATION_CANCELLED == download_.error)
+        {
+            // the item stays on the card
+            ++mCancelled;
+            ofLogNotice("eds::DownloadManager") << "download of " << download_.info.szFileName << " cancelled";
+            return;
+        }
+
+        if (EDS_ERR_OK != download_.error)
+        {
+            ++mFailed;
+            ofLogError("eds::DownloadManager") << "download failed: " << std::hex << download_.error;
+            return;
+        }
+
+        mBytes += download_.path.empty() ? download_.data.size() : download_.info.size;
+
+        start_ = std::chrono::steady_clock::now();
+        bool persisted_ = !mPersist || mPersist(download_);
+        download_.persistMillis = millisSince(start_, micros_);
+
+        if (!persisted_)
+        {
+            ++mFailed;
+            ofLogError("eds::DownloadManager") << "persisting " << download_.info.szFileName << " failed";
+            return;
+        }
+
+        mPersistMicros += micros_;
+        ++mCompleted;
+
+        // the shot is safe on our side, free the camera's card
+        EdsDeleteDirectoryItem(download_.itemRef);
+
+        ofLogVerbose("eds::DownloadManager") << download_.info.szFileName << ": " << (int)(download_.info.size / 1024) << " KB"
+                                             << ", queued " << download_.queuedMillis << " ms"
+                                             << ", transfer " << download_.transferMillis << " ms"
+                                             << ", persist " << download_.persistMillis << " ms"
+                                             << ", xxh64 " << XXHash64::toHex(download_.hash);
+    }
+
+    EdsError DownloadManager::transfer(Download& download, Worker& worker)
+    {
+        EdsError error_ = EDS_ERR_OK;
+        EdsStreamRef stream_ = NULL;
+
+        error_ = EdsGetDirectoryItemInfo(download.itemRef, &download.info);
+
+        if (EDS_ERR_OK == error_)
+        {
+            error_ = EdsCreateMemoryStream(0, &stream_);
+        }
+
+        // always set, cancel() goes through it
+        if (EDS_ERR_OK == error_)
+        {
+            error_ = EdsSetProgressCallback(stream_, &DownloadManager::onProgress, kEdsProgressOption_Periodically, &worker);
+        }
+
+        if (EDS_ERR_OK == error_)
+        {
+            error_ = EdsDownload(download.itemRef, download.info.size, stream_);
+        }
+
+        if (EDS_ERR_OK == error_)
+        {
+            error_ = EdsDownloadComplete(download.itemRef);
+        }
+
+        if (EDS_ERR_OK == error_)
+        {
+            EdsUInt32 length_ = 0;
+            char* streamPtr_ = NULL;
+
+            EdsGetLength(stream_, &length_);
+            error_ = EdsGetPointer(stream_, (EdsVoid**)&streamPtr_);
+
+            if (EDS_ERR_OK == error_)
+            {
+                // one copy out of the SDK stream into a pooled buffer, every consumer after that shares it
+                BufferPool::Handle buffer_ = mPool.acquire((long)length_);
+                buffer_->set(streamPtr_, length_);
+                download.data = BufferSlice(buffer_.share());
+
+                // hash the copy while it is still hot in the cache
+                auto start_ = std::chrono::steady_clock::now();
+                download.hash = XXHash64::hash(download.data.data(), download.data.size());
+                mHashMicros += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_).count();
+            }
+        }
+
+        if (NULL != stream_)
+        {
+            EdsRelease(stream_);
+        }
+
+        return error_;
+    }
+
+    EdsError DownloadManager::transferToFile(Download& download, Worker& worker, std::vector<char>& chunk)
+    {
+        EdsError error_ = EDS_ERR_OK;
+        EdsStreamRef stream_ = NULL;
+        PersistWriter::File file_;
+
+        error_ = EdsGetDirectoryItemInfo(download.itemRef, &download.info);
+
+        if (EDS_ERR_OK == error_)
+        {
+            download.path = mPath ? mPath(download.info) : std::string(download.info.szFileName);
+
+            if (!mWriter->open(file_, download.path, download.info.size))
+            {
+                error_ = EDS_ERR_FILE_WRITE_ERROR;
+            }
+        }
+
+        // every chunk lands in the same worker owned memory
+        if (EDS_ERR_OK == error_)
+        {
+            error_ = EdsCreateMemoryStreamFromPointer(&chunk[0], chunk.size(), &stream_);
+        }
+
+        EdsUInt32 transferred_ = 0;
+        XXHash64 hasher_;
+        uint64_t hashMicros_ = 0;
+
+        while (EDS_ERR_OK == error_ && transferred_ < download.info.size)
+        {
+            EdsUInt32 size_ = std::min((EdsUInt32)chunk.size(), download.info.size - transferred_);
+
+            error_ = EdsSeek(stream_, 0, kEdsSeek_Begin);
+
+            if (EDS_ERR_OK == error_)
+            {
+                // successive EdsDownload calls continue where the previous one stopped
+                error_ = EdsDownload(download.itemRef, size_, stream_);
+            }
+
+            if (EDS_ERR_OK == error_)
+            {
+                auto start_ = std::chrono::steady_clock::now();
+                hasher_.update(&chunk[0], size_);
+                hashMicros_ += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_).count();
+
+                if (!mWriter->append(file_, BufferView(&chunk[0], size_)))
+                {
+                    error_ = EDS_ERR_FILE_WRITE_ERROR;
+                }
+            }
+
+            if (EDS_ERR_OK != error_)
+            {
+                break;
+            }
+
+            transferred_ += size_;
+
+            EdsBool cancel_ = false;
+            onProgress((EdsUInt32)(100.0 * transferred_ / download.info.size), &worker, &cancel_);
+
+            if (cancel_)
+            {
+                error_ = EDS_ERR_OPERATION_CANCELLED;
+            }
+        }
+
+        if (EDS_ERR_OK == error_)
+        {
+            error_ = EdsDownloadComplete(download.itemRef);
+        }
+        else if (0 < transferred_ || EDS_ERR_OPERATION_CANCELLED == error_)
+        {
+            EdsDownloadCancel(download.itemRef);
+        }
+
+        if (EDS_ERR_OK == error_ && !mWriter->commit(file_))
+        {
+            error_ = EDS_ERR_FILE_WRITE_ERROR;
+        }
+
+        if (EDS_ERR_OK == error_)
+        {
+            download.hash = hasher_.digest();
+            download.writeMillis = file_.micros / 1000.0;
+            mHashMicros += hashMicros_;
+        }
+        else
+        {
+            mWriter->discard(file_);
+            download.path.clear();
+        }
+
+        if (NULL != stream_)
+        {
+            EdsRelease(stream_);
+        }
+
+        return error_;
+    }
+
+    EdsError EDSCALLBACK DownloadManager::onProgress(EdsUInt32 percent, EdsVoid* context, EdsBool* cancel)
+    {
+        // called on the worker doing the transfer
+        Worker* worker_ = (Worker*)context;
+        worker_->percent = percent;
+
+        if (NULL != worker_->owner.mProgress)
+        {
+            worker_->owner.mProgress(percent, worker_->owner.mProgressContext, cancel);
+        }
+
+        if (worker_->bCancel)
+        {
+            *cancel = true;
+        }
+
+        return EDS_ERR_OK;
+    }
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "EDSDK.h"
+#include "EDSDKErrors.h"
+#include "EDSDKTypes.h"
+
+#include "buffer_pool.h"
+#include "buffer_slice.h"
+#include "persist_writer.h"
+
+namespace eds
+{
+    // One finished transfer, handed to the persist handler on a worker thread
+    struct Download
+    {
+        Download() : itemRef(NULL), error(EDS_ERR_OK), hash(0), queuedMillis(0.0), transferMillis(0.0), persistMillis(0.0), writeMillis(0.0) {}
+
+        EdsDirectoryItemRef itemRef;
+        EdsDirectoryItemInfo info;
+        // in memory, or already on disk at path when streaming
+        BufferSlice data;
+        std::string path;
+        EdsError error;
+        // XXH64 of the file, computed while the chunks arrive
+        uint64_t hash;
+
+        // enqueue -> picked up by a worker, EdsDownload, persist handler
+        double queuedMillis;
+        double transferMillis;
+        double persistMillis;
+        // PersistWriter time of a streamed file, part of transferMillis
+        double writeMillis;
+    };
+
+    // Takes kEdsObjectEvent_DirItemCreated items off the SDK callback thread.
+    // enqueue() retains the item and returns right away; a pool of workers
+    // downloads it into a pooled buffer and passes it to the persist handler.
+    //
+    // The queue is bounded: when it is full enqueue() blocks the callback
+    // until a worker frees a slot, which holds the camera back instead of
+    // dropping shots.
+    //
+    // In streaming mode items are pulled in fixed-size chunks and appended to
+    // their file as they arrive, so each worker only ever holds one chunk no
+    // matter how large the file is.
+    class DownloadManager
+    {
+    public:
+        typedef std::function<bool(const Download&)> PersistHandler;
+        typedef std::function<std::string(const EdsDirectoryItemInfo&)> PathHandler;
+
+        static const size_t kDefaultChunkSize = 1024 * 1024;
+
+        DownloadManager(BufferPool& pool, unsigned int capacity = 8);
+        ~DownloadManager();
+
+        // Both need to be set before start(). A NULL writer turns streaming off.
+        void setStreaming(PersistWriter* writer, const PathHandler& path, size_t chunkSize = kDefaultChunkSize);
+        // Reports progress of every transfer, setting the cancel flag aborts it
+        void setProgressCallback(EdsProgressCallback callback, EdsVoid* context);
+
+        void start(const PersistHandler& persist, unsigned int threadCount = 2);
+        // Finishes everything already queued before returning
+        void stop();
+        bool isRunning() const;
+
+        // Returns false if the manager isn't running. Blocks while the queue is full, meant for the SDK callback thread.
+        bool enqueue(EdsDirectoryItemRef itemRef);
+        // Never blocks, returns false if the queue is full or the manager isn't running
+        bool tryEnqueue(EdsDirectoryItemRef itemRef);
+
+        // Aborts the transfers running right now, their items stay on the card.
+        // Queued items aren't touched and nothing carries over to a later
+        // transfer. Returns how many were running.
+        unsigned int cancel();
+        // Percent done of every running transfer, one entry per busy worker
+        std::vector<EdsUInt32> getProgress() const;
+
+        unsigned int getCapacity() const;
+        unsigned int getQueueSize() const;
+        unsigned int getQueueHighWaterMark() const;
+        // Queued or being transferred
+        uint64_t getInFlightCount() const;
+        uint64_t getEnqueuedCount() const;
+        uint64_t getCompletedCount() const;
+        uint64_t getFailedCount() const;
+        uint64_t getCancelledCount() const;
+        uint64_t getBlockedCount() const;
+        uint64_t getTransferredBytes() const;
+        double getQueuedMillisAverage() const;
+        double getTransferMillisAverage() const;
+        double getPersistMillisAverage() const;
+        // Time spent hashing, also as a fraction of the transfer time it is part of
+        double getHashMillisAverage() const;
+        double getHashOverhead() const;
+        // Bytes over the time workers spent in EdsDownload
+        double getTransferMegabytesPerSecond() const;
+
+    private:
+        struct Pending
+        {
+            EdsDirectoryItemRef itemRef;
+            std::chrono::steady_clock::time_point enqueued;
+        };
+
+        // The transfer one worker has running, the context of its progress callback
+        struct Worker
+        {
+            Worker(DownloadManager& owner) : owner(owner), bBusy(false), bCancel(false), percent(0) {}
+
+            DownloadManager& owner;
+            std::atomic<bool> bBusy;
+            std::atomic<bool> bCancel;
+            std::atomic<EdsUInt32> percent;
+        };
+
+        DownloadManager(const DownloadManager&);
+        DownloadManager& operator=(const DownloadManager&);
+
+        // mMutex held, the queue has room
+        void push(EdsDirectoryItemRef itemRef);
+        void threadedFunction(Worker* worker);
+        void process(const Pending& pending, Worker& worker, std::vector<char>& chunk);
+        EdsError transfer(Download& download, Worker& worker);
+        EdsError transferToFile(Download& download, Worker& worker, std::vector<char>& chunk);
+
+        static EdsError EDSCALLBACK onProgress(EdsUInt32 percent, EdsVoid* context, EdsBool* cancel);
+
+        BufferPool& mPool;
+        PersistHandler mPersist;
+        unsigned int mCapacity;
+
+        PersistWriter* mWriter;
+        PathHandler mPath;
+        size_t mChunkSize;
+        EdsProgressCallback mProgress;
+        EdsVoid* mProgressContext;
+
+        std::vector<Pending> mQueue;
+        unsigned int mHighWaterMark;
+
+        std::vector<std::thread> mThreads;
+        std::vector< std::unique_ptr<Worker> > mWorkers;
+        mutable std::mutex mMutex;
+        std::condition_variable mNotEmpty;
+        std::condition_variable mNotFull;
+        bool bRunning;
+
+        std::atomic<uint64_t> mEnqueued;
+        std::atomic<uint64_t> mCompleted;
+        std::atomic<uint64_t> mFailed;
+        std::atomic<uint64_t> mCancelled;
+        std::atomic<uint64_t> mBlocked;
+        std::atomic<uint64_t> mBytes;
+        std::atomic<uint64_t> mQueuedMicros;
+        std::atomic<uint64_t> mTransferMicros;
+        std::atomic<uint64_t> mPersistMicros;
+        std::atomic<uint64_t> mHashMicros;
+    };
+}
@@ -0,0 +1,238 @@
+#include "event_bus.h"
+
+#include <chrono>
+
+namespace
+{
+    uint64_t nowNanos()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+namespace eds
+{
+    EventBus::EventBus(size_t capacity)
+    : mQueue(capacity)
+    , bOverflowing(false)
+    , mPosted(0)
+    , mDropped(0)
+    , mOverflowed(0)
+    , mPostNanos(0)
+    , mPostNanosMax(0)
+    , mDispatched(0)
+    , mDeliveryMicros(0)
+    {
+    }
+
+    EventBus::~EventBus()
+    {
+        clear();
+    }
+
+    void EventBus::subscribe(EventType type, const Handler& handler)
+    {
+        subscribe(type, kAnyCode, handler);
+    }
+
+    void EventBus::subscribe(EventType type, uint32_t code, const Handler& handler)
+    {
+        Subscription subscription_;
+        subscription_.type = type;
+        subscription_.code = code;
+        subscription_.handler = handler;
+        mSubscriptions.push_back(subscription_);
+    }
+
+    bool EventBus::postCameraAdded()
+    {
+        Event event_ = { kEventType_CameraAdded, 0, 0, 0, 0, NULL, 0 };
+        return post(event_);
+    }
+
+    bool EventBus::postObject(EdsObjectEvent event, EdsBaseRef object, unsigned int camera)
+    {
+        Event event_ = { kEventType_Object, camera, (uint32_t)event, 0, 0, object, 0 };
+        return post(event_);
+    }
+
+    bool EventBus::postProperty(EdsPropertyEvent event, EdsPropertyID property, EdsUInt32 param, unsigned int camera)
+    {
+        Event event_ = { kEventType_Property, camera, (uint32_t)property, (uint32_t)event, param, NULL, 0 };
+        return post(event_);
+    }
+
+    bool EventBus::postState(EdsStateEvent event, EdsUInt32 param, unsigned int camera)
+    {
+        Event event_ = { kEventType_State, camera, (uint32_t)event, 0, param, NULL, 0 };
+        return post(event_);
+    }
+
+    size_t EventBus::dispatch()
+    {
+        Event event_;
+        size_t count_ = 0;
+
+        while (mQueue.pop(event_))
+        {
+            deliver(event_);
+            ++count_;
+        }
+
+        if (bOverflowing)
+        {
+            {
+                std::lock_guard<std::mutex> lock_(mOverflowMutex);
+                mOverflowSwap.swap(mOverflow);
+                bOverflowing = false;
+            }
+
+            for (size_t i = 0; i < mOverflowSwap.size(); ++i)
+            {
+                deliver(mOverflowSwap[i]);
+            }
+
+            count_ += mOverflowSwap.size();
+            mOverflowSwap.clear();
+        }
+
+        mDispatched += count_;
+        return count_;
+    }
+
+    void EventBus::clear()
+    {
+        // whatever is left still holds object references
+        Event event_;
+
+        while (mQueue.pop(event_))
+        {
+            if (event_.object)
+            {
+                EdsRelease(event_.object);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock_(mOverflowMutex);
+
+        for (size_t i = 0; i < mOverflow.size(); ++i)
+        {
+            if (mOverflow[i].object)
+            {
+                EdsRelease(mOverflow[i].object);
+            }
+        }
+
+        mOverflow.clear();
+        bOverflowing = false;
+    }
+
+    uint64_t EventBus::getPostedCount() const
+    {
+        return mPosted;
+    }
+
+    uint64_t EventBus::getDroppedCount() const
+    {
+        return mDropped;
+    }
+
+    uint64_t EventBus::getOverflowCount() const
+    {
+        return mOverflowed;
+    }
+
+    uint64_t EventBus::getDispatchedCount() const
+    {
+        return mDispatched;
+    }
+
+    double EventBus::getPostMicrosAverage() const
+    {
+        uint64_t count_ = mPosted + mDropped;
+        return 0 == count_ ? 0.0 : mPostNanos / (count_ * 1000.0);
+    }
+
+    double EventBus::getPostMicrosMax() const
+    {
+        return mPostNanosMax / 1000.0;
+    }
+
+    double EventBus::getDeliveryMillisAverage() const
+    {
+        return 0 == mDispatched ? 0.0 : mDeliveryMicros / (mDispatched * 1000.0);
+    }
+
+    bool EventBus::isLossless(const Event& event)
+    {
+        switch (event.type)
+        {
+            case kEventType_Property:
+                return false;
+            case kEventType_State:
+                return kEdsStateEvent_Shutdown == event.code;
+            default:
+                return true;
+        }
+    }
+
+    bool EventBus::post(Event& event)
+    {
+        uint64_t start_ = nowNanos();
+        event.postedMicros = start_ / 1000;
+
+        bool lossless_ = isLossless(event);
+        bool pushed_ = !(lossless_ && bOverflowing) && mQueue.push(event);
+
+        if (pushed_)
+        {
+            mPosted.fetch_add(1, std::memory_order_relaxed);
+        }
+        else if (lossless_)
+        {
+            std::lock_guard<std::mutex> lock_(mOverflowMutex);
+
+            mOverflow.push_back(event);
+            bOverflowing = true;
+            pushed_ = true;
+
+            mPosted.fetch_add(1, std::memory_order_relaxed);
+            mOverflowed.fetch_add(1, std::memory_order_relaxed);
+        }
+        else
+        {
+            mDropped.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        uint64_t nanos_ = nowNanos() - start_;
+        uint64_t max_ = mPostNanosMax.load(std::memory_order_relaxed);
+
+        mPostNanos.fetch_add(nanos_, std::memory_order_relaxed);
+
+        while (max_ < nanos_ && !mPostNanosMax.compare_exchange_weak(max_, nanos_, std::memory_order_relaxed))
+        {
+        }
+
+        return pushed_;
+    }
+
+    void EventBus::deliver(const Event& event)
+    {
+        for (size_t i = 0; i < mSubscriptions.size(); ++i)
+        {
+            const Subscription& subscription_ = mSubscriptions[i];
+
+            if (event.type == subscription_.type && (kAnyCode == subscription_.code || event.code == subscription_.code))
+            {
+                subscription_.handler(event);
+            }
+        }
+
+        if (event.object)
+        {
+            EdsRelease(event.object);
+        }
+
+        mDeliveryMicros += nowNanos() / 1000 - event.postedMicros;
+    }
+}
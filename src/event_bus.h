@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <stdint.h>
+#include <vector>
+
+#include "EDSDK.h"
+#include "EDSDKErrors.h"
+#include "EDSDKTypes.h"
+
+#include "mpsc_queue.h"
+
+namespace eds
+{
+    enum EventType
+    {
+        kEventType_CameraAdded,
+        kEventType_Object,      // code: EdsObjectEvent
+        kEventType_Property,    // code: EdsPropertyID
+        kEventType_State,       // code: EdsStateEvent
+        kEventType_Count
+    };
+
+    // What an SDK callback saw, small enough to copy into the queue
+    struct Event
+    {
+        EventType type;
+        // index of the CameraSession that saw it
+        uint32_t camera;
+        uint32_t code;
+        // EdsPropertyEvent for property events, unused otherwise
+        uint32_t event;
+        uint32_t param;
+        // Object events only. The bus owns the reference and releases it
+        // after the subscribers ran, retain it to keep it.
+        EdsBaseRef object;
+        uint64_t postedMicros;
+    };
+
+    // Takes SDK events off the callback thread. The callbacks only post(),
+    // which copies the record into a lock-free queue and returns; dispatch()
+    // hands the events to their subscribers on the thread that drains the
+    // queue (update()). Subscribe from that same thread.
+    //
+    // A full queue drops property and state events and counts them, a
+    // callback is never held for those. A lost property change only costs a
+    // cache refresh, a lost object event is a capture that is never
+    // downloaded: object events, camera added and shutdown go to an
+    // unbounded overflow list instead, behind a short lock, and are
+    // delivered after the queue in the order they came.
+    class EventBus
+    {
+    public:
+        typedef std::function<void(const Event&)> Handler;
+
+        static const uint32_t kAnyCode = 0xFFFFFFFF;
+
+        explicit EventBus(size_t capacity = 1024);
+        ~EventBus();
+
+        void subscribe(EventType type, const Handler& handler);
+        void subscribe(EventType type, uint32_t code, const Handler& handler);
+
+        // Any thread
+        bool postCameraAdded();
+        bool postObject(EdsObjectEvent event, EdsBaseRef object, unsigned int camera = 0);
+        bool postProperty(EdsPropertyEvent event, EdsPropertyID property, EdsUInt32 param, unsigned int camera = 0);
+        bool postState(EdsStateEvent event, EdsUInt32 param, unsigned int camera = 0);
+
+        // Delivers everything queued so far, returns the number of events
+        size_t dispatch();
+        // Drops queued events without delivering them, before the SDK is terminated
+        void clear();
+
+        uint64_t getPostedCount() const;
+        uint64_t getDroppedCount() const;
+        // Events that found the queue full and took the overflow list
+        uint64_t getOverflowCount() const;
+        uint64_t getDispatchedCount() const;
+        // Time a callback spends in post()
+        double getPostMicrosAverage() const;
+        double getPostMicrosMax() const;
+        // post -> subscribers called
+        double getDeliveryMillisAverage() const;
+
+    private:
+        struct Subscription
+        {
+            EventType type;
+            uint32_t code;
+            Handler handler;
+        };
+
+        EventBus(const EventBus&);
+        EventBus& operator=(const EventBus&);
+
+        static bool isLossless(const Event& event);
+
+        bool post(Event& event);
+        void deliver(const Event& event);
+
+        MpscQueue<Event> mQueue;
+        std::vector<Subscription> mSubscriptions;
+
+        // once it holds anything, lossless events queue behind it to stay in order
+        std::mutex mOverflowMutex;
+        std::vector<Event> mOverflow;
+        std::vector<Event> mOverflowSwap;
+        std::atomic<bool> bOverflowing;
+
+        std::atomic<uint64_t> mPosted;
+        std::atomic<uint64_t> mDropped;
+        std::atomic<uint64_t> mOverflowed;
+        std::atomic<uint64_t> mPostNanos;
+        std::atomic<uint64_t> mPostNanosMax;
+        uint64_t mDispatched;
+        uint64_t mDeliveryMicros;
+    };
+}
@@ -0,0 +1,164 @@
+#include "evf_capture.h"
+
+#include <chrono>
+
+namespace eds
+{
+    EvfCapture::EvfCapture()
+    : mCamera(NULL)
+    , mRunning(false)
+    , mSequence(0)
+    , mErrors(0)
+    , mFramesPerSecond(0.0)
+    {
+    }
+
+    EvfCapture::~EvfCapture()
+    {
+        stop();
+    }
+
+    EdsError EvfCapture::start(EdsCameraRef camera)
+    {
+        if (mRunning)
+        {
+            return EDS_ERR_OK;
+        }
+
+        EdsError error_ = EDS_ERR_OK;
+
+        for (unsigned int i = 0; i < mRing.size() && EDS_ERR_OK == error_; ++i)
+        {
+            error_ = mRing.at(i).session.open(camera);
+        }
+
+        if (EDS_ERR_OK != error_)
+        {
+            for (unsigned int i = 0; i < mRing.size(); ++i)
+            {
+                mRing.at(i).session.close();
+            }
+
+            return error_;
+        }
+
+        mCamera = camera;
+        mRunning = true;
+        mThread = std::thread(&EvfCapture::threadedFunction, this);
+
+        return error_;
+    }
+
+    void EvfCapture::stop()
+    {
+        mRunning = false;
+
+        if (mThread.joinable())
+        {
+            mThread.join();
+        }
+
+        for (unsigned int i = 0; i < mRing.size(); ++i)
+        {
+            mRing.at(i).session.close();
+            mRing.at(i).jpeg = BufferView();
+        }
+
+        mCamera = NULL;
+    }
+
+    bool EvfCapture::isRunning() const
+    {
+        return mRunning;
+    }
+
+    bool EvfCapture::acquire()
+    {
+        return mRing.acquire();
+    }
+
+    const EvfFrame& EvfCapture::front() const
+    {
+        return mRing.front();
+    }
+
+    uint64_t EvfCapture::getPublishedCount() const
+    {
+        return mRing.getPublishedCount();
+    }
+
+    uint64_t EvfCapture::getAcquiredCount() const
+    {
+        return mRing.getAcquiredCount();
+    }
+
+    uint64_t EvfCapture::getDroppedCount() const
+    {
+        return mRing.getDroppedCount();
+    }
+
+    uint64_t EvfCapture::getErrorCount() const
+    {
+        return mErrors;
+    }
+
+    double EvfCapture::getFramesPerSecond() const
+    {
+        return mFramesPerSecond;
+    }
+
+    uint64_t EvfCapture::getAllocationCount() const
+    {
+        uint64_t count_ = 0;
+
+        for (unsigned int i = 0; i < mRing.size(); ++i)
+        {
+            count_ += mRing.at(i).session.getAllocationCount();
+        }
+
+        return count_;
+    }
+
+    void EvfCapture::threadedFunction()
+    {
+        typedef std::chrono::steady_clock clock_;
+
+        auto windowStart_ = clock_::now();
+        auto windowFrames_ = 0;
+
+        while (mRunning)
+        {
+            EvfFrame& frame_ = mRing.back();
+            EdsError error_ = frame_.session.download();
+
+            if (EDS_ERR_OK == error_)
+            {
+                frame_.jpeg = frame_.session.getJpeg();
+                frame_.coordinateSystem = frame_.session.getCoordinateSystem();
+                frame_.zoomRect = frame_.session.getZoomRect();
+                frame_.sequence = ++mSequence;
+                mRing.publish();
+                ++windowFrames_;
+            }
+            else
+            {
+                // EDS_ERR_OBJECT_NOTREADY is expected until the camera has the first frame ready
+                if (EDS_ERR_OBJECT_NOTREADY != error_)
+                {
+                    ++mErrors;
+                }
+
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+
+            auto elapsed_ = std::chrono::duration<double>(clock_::now() - windowStart_).count();
+
+            if (1.0 <= elapsed_)
+            {
+                mFramesPerSecond = windowFrames_ / elapsed_;
+                windowStart_ = clock_::now();
+                windowFrames_ = 0;
+            }
+        }
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+
+#include "EDSDK.h"
+#include "EDSDKErrors.h"
+#include "EDSDKTypes.h"
+
+#include "buffer.h"
+#include "evf_session.h"
+#include "frame_ring.h"
+
+namespace eds
+{
+    // Every slot owns its own EVF session, the SDK downloads straight into the
+    // slot and jpeg points into that session's stream memory.
+    struct EvfFrame
+    {
+        EvfFrame() : sequence(0) {}
+        
+        EvfSession session;
+        BufferView jpeg;
+        EdsSize coordinateSystem;
+        EdsRect zoomRect;
+        uint64_t sequence;
+    };
+
+    // Owns EdsDownloadEvfImage on a dedicated thread and publishes every
+    // downloaded liveview frame into a FrameRing, so the render thread only
+    // ever picks up the newest frame and never waits on USB.
+    class EvfCapture
+    {
+    public:
+        EvfCapture();
+        ~EvfCapture();
+
+        EdsError start(EdsCameraRef camera);
+        void stop();
+        bool isRunning() const;
+
+        // Render thread side
+        bool acquire();
+        const EvfFrame& front() const;
+
+        uint64_t getPublishedCount() const;
+        uint64_t getAcquiredCount() const;
+        uint64_t getDroppedCount() const;
+        uint64_t getErrorCount() const;
+        double getFramesPerSecond() const;
+        
+        // SDK allocations across all slots, stays flat once every slot has been opened
+        uint64_t getAllocationCount() const;
+
+    private:
+        EvfCapture(const EvfCapture&);
+        EvfCapture& operator=(const EvfCapture&);
+
+        void threadedFunction();
+
+        EdsCameraRef mCamera;
+        std::thread mThread;
+        std::atomic<bool> mRunning;
+        FrameRing<EvfFrame> mRing;
+        uint64_t mSequence;
+
+        std::atomic<uint64_t> mErrors;
+        std::atomic<double> mFramesPerSecond;
+    };
+}
@@ -0,0 +1,430 @@
+#include "evf_decoder.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "FreeImage.h"
+
+namespace
+{
+    // Reads the frame size from the first SOF marker, without decoding anything
+    bool readJpegSize(const unsigned char* data, size_t size, int& width, int& height)
+    {
+        if (size < 4 || 0xFF != data[0] || 0xD8 != data[1])
+        {
+            return false;
+        }
+
+        size_t pos_ = 2;
+
+        while (pos_ + 4 <= size)
+        {
+            if (0xFF != data[pos_])
+            {
+                return false;
+            }
+
+            unsigned char marker_ = data[pos_ + 1];
+
+            // fill bytes
+            if (0xFF == marker_)
+            {
+                ++pos_;
+                continue;
+            }
+
+            size_t length_ = (data[pos_ + 2] << 8) | data[pos_ + 3];
+
+            // SOF0..SOF15, except DHT (C4), JPG (C8) and DAC (CC)
+            if (0xC0 <= marker_ && marker_ <= 0xCF && 0xC4 != marker_ && 0xC8 != marker_ && 0xCC != marker_)
+            {
+                if (pos_ + 9 > size)
+                {
+                    return false;
+                }
+
+                height = (data[pos_ + 5] << 8) | data[pos_ + 6];
+                width = (data[pos_ + 7] << 8) | data[pos_ + 8];
+                return true;
+            }
+
+            if (0xDA == marker_)
+            {
+                return false;
+            }
+
+            pos_ += 2 + length_;
+        }
+
+        return false;
+    }
+}
+
+namespace eds
+{
+    EvfDecoder::EvfDecoder()
+    : mReadyJob(NULL)
+    , mLastDelivered(0)
+    , mThreadCount(0)
+    , bRunning(false)
+    , mRequestedSize(0)
+    , mSubmitted(0)
+    , mDecoded(0)
+    , mDelivered(0)
+    , mDropped(0)
+    , mDiscarded(0)
+    , mFailed(0)
+    , mDecodeMicros(0)
+    {
+    }
+
+    EvfDecoder::~EvfDecoder()
+    {
+        stop();
+    }
+
+    void EvfDecoder::start(unsigned int threadCount)
+    {
+        if (bRunning)
+        {
+            return;
+        }
+
+        if (0 == threadCount)
+        {
+            // leave a core for the render thread and one for the capture thread
+            auto cores_ = std::thread::hardware_concurrency();
+            threadCount = std::max(1, std::min(4, (int)cores_ - 2));
+        }
+
+        FreeImage_Initialise();
+
+        // one job per worker, plus one waiting and one ready for the render thread
+        mJobs.resize(threadCount + 2);
+        mFreeJobs.clear();
+        mPendingJobs.clear();
+        mReadyJob = NULL;
+        mLastDelivered = 0;
+
+        // reserved up front, so moving jobs between the lists never allocates
+        mFreeJobs.reserve(mJobs.size());
+        mPendingJobs.reserve(mJobs.size());
+
+        for (size_t i = 0; i < mJobs.size(); ++i)
+        {
+            mFreeJobs.push_back(&mJobs[i]);
+        }
+
+        bRunning = true;
+        mThreadCount = threadCount;
+
+        for (unsigned int i = 0; i < threadCount; ++i)
+        {
+            mThreads.push_back(std::thread(&EvfDecoder::threadedFunction, this));
+        }
+    }
+
+    void EvfDecoder::stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock_(mMutex);
+
+            if (!bRunning)
+            {
+                return;
+            }
+
+            bRunning = false;
+        }
+
+        mCondition.notify_all();
+
+        for (size_t i = 0; i < mThreads.size(); ++i)
+        {
+            mThreads[i].join();
+        }
+
+        mThreads.clear();
+        mFreeJobs.clear();
+        mPendingJobs.clear();
+        mReadyJob = NULL;
+        mJobs.clear();
+
+        FreeImage_DeInitialise();
+    }
+
+    bool EvfDecoder::isRunning() const
+    {
+        return bRunning;
+    }
+
+    void EvfDecoder::setTargetSize(int width, int height)
+    {
+        // packed into one word, so workers always read a consistent pair
+        mRequestedSize = (0 < width && 0 < height) ? ((width & 0xFFFF) << 16 | (height & 0xFFFF)) : 0;
+    }
+
+    void EvfDecoder::submit(const EvfFrame& frame)
+    {
+        std::unique_lock<std::mutex> lock_(mMutex);
+
+        if (!bRunning || frame.jpeg.empty())
+        {
+            return;
+        }
+
+        Job* job_ = NULL;
+
+        if (!mFreeJobs.empty())
+        {
+            job_ = mFreeJobs.back();
+            mFreeJobs.pop_back();
+        }
+        else if (!mPendingJobs.empty())
+        {
+            // every worker is busy, the oldest waiting frame is stale anyway
+            job_ = mPendingJobs.front();
+            mPendingJobs.erase(mPendingJobs.begin());
+            ++mDropped;
+        }
+        else
+        {
+            ++mDropped;
+            return;
+        }
+
+        job_->jpeg.set(frame.jpeg.data, frame.jpeg.size);
+        job_->frame.coordinateSystem = frame.coordinateSystem;
+        job_->frame.zoomRect = frame.zoomRect;
+        job_->frame.sequence = frame.sequence;
+
+        mPendingJobs.push_back(job_);
+        ++mSubmitted;
+
+        lock_.unlock();
+        mCondition.notify_one();
+    }
+
+    bool EvfDecoder::popLatest(DecodedFrame& frame)
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+
+        if (NULL == mReadyJob)
+        {
+            return false;
+        }
+
+        // swap, so both sides keep their pixel storage and nothing is reallocated
+        frame.pixels.swap(mReadyJob->frame.pixels);
+        frame.coordinateSystem = mReadyJob->frame.coordinateSystem;
+        frame.zoomRect = mReadyJob->frame.zoomRect;
+        frame.sequence = mReadyJob->frame.sequence;
+        frame.scaleDenominator = mReadyJob->frame.scaleDenominator;
+
+        mLastDelivered = frame.sequence;
+        mFreeJobs.push_back(mReadyJob);
+        mReadyJob = NULL;
+        ++mDelivered;
+
+        return true;
+    }
+
+    unsigned int EvfDecoder::update(EvfCapture& capture, DecodedFrame& frame)
+    {
+        unsigned int updated_ = 0;
+
+        if (capture.acquire())
+        {
+            submit(capture.front());
+            updated_ |= kUpdate_Submitted;
+        }
+
+        if (popLatest(frame))
+        {
+            updated_ |= kUpdate_Decoded;
+        }
+
+        return updated_;
+    }
+
+    unsigned int EvfDecoder::getThreadCount() const
+    {
+        return mThreadCount;
+    }
+
+    uint64_t EvfDecoder::getSubmittedCount() const
+    {
+        return mSubmitted;
+    }
+
+    uint64_t EvfDecoder::getDecodedCount() const
+    {
+        return mDecoded;
+    }
+
+    uint64_t EvfDecoder::getDeliveredCount() const
+    {
+        return mDelivered;
+    }
+
+    uint64_t EvfDecoder::getDroppedCount() const
+    {
+        return mDropped;
+    }
+
+    uint64_t EvfDecoder::getDiscardedCount() const
+    {
+        return mDiscarded;
+    }
+
+    uint64_t EvfDecoder::getFailedCount() const
+    {
+        return mFailed;
+    }
+
+    double EvfDecoder::getDecodeMillisAverage() const
+    {
+        uint64_t decoded_ = mDecoded;
+        return 0 < decoded_ ? mDecodeMicros / 1000.0 / decoded_ : 0.0;
+    }
+
+    void EvfDecoder::threadedFunction()
+    {
+        while (true)
+        {
+            Job* job_ = NULL;
+
+            {
+                std::unique_lock<std::mutex> lock_(mMutex);
+
+                while (bRunning && mPendingJobs.empty())
+                {
+                    mCondition.wait(lock_);
+                }
+
+                if (!bRunning)
+                {
+                    return;
+                }
+
+                job_ = mPendingJobs.front();
+                mPendingJobs.erase(mPendingJobs.begin());
+            }
+
+            auto start_ = std::chrono::steady_clock::now();
+            bool decoded_ = decode(*job_, mRequestedSize);
+            auto micros_ = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_).count();
+
+            std::lock_guard<std::mutex> lock_(mMutex);
+
+            if (!decoded_)
+            {
+                ++mFailed;
+                mFreeJobs.push_back(job_);
+                continue;
+            }
+
+            ++mDecoded;
+            mDecodeMicros += micros_;
+
+            // reorder: only keep the frame if it is newer than anything delivered or ready
+            auto sequence_ = job_->frame.sequence;
+
+            if (sequence_ <= mLastDelivered || (NULL != mReadyJob && sequence_ <= mReadyJob->frame.sequence))
+            {
+                ++mDiscarded;
+                mFreeJobs.push_back(job_);
+                continue;
+            }
+
+            if (NULL != mReadyJob)
+            {
+                ++mDiscarded;
+                mFreeJobs.push_back(mReadyJob);
+            }
+
+            mReadyJob = job_;
+        }
+    }
+
+    bool EvfDecoder::decode(Job& job, int requestedSize)
+    {
+        auto data_ = (const unsigned char*)job.jpeg.getBinaryBuffer();
+        auto size_ = job.jpeg.size();
+
+        // pick the largest DCT scale that still covers the target size
+        int flags_ = JPEG_FAST;
+        job.frame.scaleDenominator = 1;
+
+        int width_ = 0;
+        int height_ = 0;
+        int targetWidth_ = (requestedSize >> 16) & 0xFFFF;
+        int targetHeight_ = requestedSize & 0xFFFF;
+
+        if (0 < requestedSize && readJpegSize(data_, size_, width_, height_))
+        {
+            auto denominator_ = 1;
+
+            while (denominator_ < 8 && targetWidth_ <= width_ / (denominator_ * 2) && targetHeight_ <= height_ / (denominator_ * 2))
+            {
+                denominator_ *= 2;
+            }
+
+            if (1 < denominator_)
+            {
+                // FreeImage picks the scale_denom whose output is closest to, but not below, this size
+                flags_ |= (std::max(width_, height_) / denominator_) << 16;
+                job.frame.scaleDenominator = denominator_;
+            }
+        }
+
+        FIMEMORY* memory_ = FreeImage_OpenMemory((BYTE*)data_, size_);
+        FIBITMAP* bitmap_ = FreeImage_LoadFromMemory(FIF_JPEG, memory_, flags_);
+        FreeImage_CloseMemory(memory_);
+
+        if (NULL == bitmap_)
+        {
+            return false;
+        }
+
+        if (24 != FreeImage_GetBPP(bitmap_))
+        {
+            FIBITMAP* converted_ = FreeImage_ConvertTo24Bits(bitmap_);
+            FreeImage_Unload(bitmap_);
+            bitmap_ = converted_;
+
+            if (NULL == bitmap_)
+            {
+                return false;
+            }
+        }
+
+        auto outWidth_ = FreeImage_GetWidth(bitmap_);
+        auto outHeight_ = FreeImage_GetHeight(bitmap_);
+
+        ofPixels& pixels_ = job.frame.pixels;
+
+        // allocate() keeps the storage when the size doesn't change
+        pixels_.allocate(outWidth_, outHeight_, OF_IMAGE_COLOR);
+
+        unsigned char* dst_ = pixels_.getPixels();
+
+        // FreeImage stores rows bottom-up, in BGR order on little-endian machines
+        for (unsigned int y = 0; y < outHeight_; ++y)
+        {
+            const BYTE* src_ = FreeImage_GetScanLine(bitmap_, outHeight_ - 1 - y);
+            unsigned char* row_ = dst_ + y * outWidth_ * 3;
+
+            for (unsigned int x = 0; x < outWidth_; ++x)
+            {
+                row_[x * 3 + 0] = src_[x * 3 + FI_RGBA_RED];
+                row_[x * 3 + 1] = src_[x * 3 + FI_RGBA_GREEN];
+                row_[x * 3 + 2] = src_[x * 3 + FI_RGBA_BLUE];
+            }
+        }
+
+        FreeImage_Unload(bitmap_);
+
+        return true;
+    }
+}
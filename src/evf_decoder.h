@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ofMain.h"
+
+#include "buffer.h"
+#include "evf_capture.h"
+
+namespace eds
+{
+    struct DecodedFrame
+    {
+        DecodedFrame() : sequence(0), scaleDenominator(1) {}
+
+        ofPixels pixels;
+        EdsSize coordinateSystem;
+        EdsRect zoomRect;
+        uint64_t sequence;
+        int scaleDenominator;
+    };
+
+    // Decode stage between EvfCapture and the render thread. Jpegs are decoded
+    // by a pool of workers, possibly out of order, and only ever handed out in
+    // increasing sequence order: a frame that finishes after a newer one has
+    // already been delivered is discarded.
+    //
+    // When the target size is smaller than the source, the decoder asks
+    // libjpeg (through FreeImage) for 1/2, 1/4 or 1/8 DCT scaling, which skips
+    // most of the IDCT work instead of decoding at full size and downscaling.
+    class EvfDecoder
+    {
+    public:
+        EvfDecoder();
+        ~EvfDecoder();
+
+        void start(unsigned int threadCount = 0);
+        void stop();
+        bool isRunning() const;
+
+        // 0 disables scaled decoding
+        void setTargetSize(int width, int height);
+
+        // Copies the jpeg out of the frame, the frame may be recycled right after.
+        // If every job is busy the oldest pending frame is replaced.
+        void submit(const EvfFrame& frame);
+
+        // Swaps the newest decoded frame into frame, returns false if there is none
+        bool popLatest(DecodedFrame& frame);
+
+        enum
+        {
+            kUpdate_Submitted = 1 << 0,
+            kUpdate_Decoded = 1 << 1
+        };
+
+        // The liveview pass ofApp::update() makes every UI frame: the newest
+        // captured frame goes in, the newest decoded one is swapped into frame.
+        // Returns kUpdate_ flags; with kUpdate_Submitted, capture.front() is
+        // the frame that went in.
+        unsigned int update(EvfCapture& capture, DecodedFrame& frame);
+
+        unsigned int getThreadCount() const;
+        uint64_t getSubmittedCount() const;
+        uint64_t getDecodedCount() const;
+        uint64_t getDeliveredCount() const;
+        uint64_t getDroppedCount() const;
+        uint64_t getDiscardedCount() const;
+        uint64_t getFailedCount() const;
+        double getDecodeMillisAverage() const;
+
+    private:
+        struct Job
+        {
+            Buffer jpeg;
+            DecodedFrame frame;
+        };
+
+        EvfDecoder(const EvfDecoder&);
+        EvfDecoder& operator=(const EvfDecoder&);
+
+        void threadedFunction();
+        bool decode(Job& job, int requestedSize);
+
+        std::vector<Job> mJobs;
+        std::vector<Job*> mFreeJobs;
+        std::vector<Job*> mPendingJobs;
+        Job* mReadyJob;
+        uint64_t mLastDelivered;
+
+        std::vector<std::thread> mThreads;
+        unsigned int mThreadCount;
+        std::mutex mMutex;
+        std::condition_variable mCondition;
+        bool bRunning;
+
+        std::atomic<int> mRequestedSize;
+
+        std::atomic<uint64_t> mSubmitted;
+        std::atomic<uint64_t> mDecoded;
+        std::atomic<uint64_t> mDelivered;
+        std::atomic<uint64_t> mDropped;
+        std::atomic<uint64_t> mDiscarded;
+        std::atomic<uint64_t> mFailed;
+        std::atomic<uint64_t> mDecodeMicros;
+    };
+}
@@ -0,0 +1,153 @@
+#include "evf_session.h"
+
+namespace eds
+{
+    EvfSession::EvfSession()
+    : mCamera(NULL)
+    , mStream(NULL)
+    , mImage(NULL)
+    , mCapacity(0)
+    , mFrames(0)
+    , mAllocations(0)
+    {
+        mCoordinateSystem.width = 0;
+        mCoordinateSystem.height = 0;
+        mZoomRect.point.x = 0;
+        mZoomRect.point.y = 0;
+        mZoomRect.size.width = 0;
+        mZoomRect.size.height = 0;
+    }
+
+    EvfSession::~EvfSession()
+    {
+        close();
+    }
+
+    EdsError EvfSession::open(EdsCameraRef camera, EdsUInt32 reserveSize)
+    {
+        close();
+
+        EdsError error_ = EDS_ERR_OK;
+
+        // Create a pre-sized memory stream, so the SDK doesn't have to grow it on the first frames
+        error_ = EdsCreateMemoryStream(reserveSize, &mStream);
+
+        if (EDS_ERR_OK == error_)
+        {
+            ++mAllocations;
+            mCapacity = reserveSize;
+            error_ = EdsCreateEvfImageRef(mStream, &mImage);
+        }
+
+        if (EDS_ERR_OK == error_)
+        {
+            ++mAllocations;
+            mCamera = camera;
+        }
+        else
+        {
+            close();
+        }
+
+        return error_;
+    }
+
+    void EvfSession::close()
+    {
+        if (NULL != mImage)
+        {
+            EdsRelease(mImage);
+            mImage = NULL;
+        }
+
+        if (NULL != mStream)
+        {
+            EdsRelease(mStream);
+            mStream = NULL;
+        }
+
+        mCamera = NULL;
+        mCapacity = 0;
+        mJpeg = BufferView();
+    }
+
+    bool EvfSession::isOpen() const
+    {
+        return NULL != mImage;
+    }
+
+    EdsError EvfSession::download()
+    {
+        if (!isOpen())
+        {
+            return EDS_ERR_INVALID_HANDLE;
+        }
+
+        EdsError error_ = EDS_ERR_OK;
+
+        // Rewind, the SDK writes the new frame over the previous one
+        error_ = EdsSeek(mStream, 0, kEdsSeek_Begin);
+
+        if (EDS_ERR_OK == error_)
+        {
+            error_ = EdsDownloadEvfImage(mCamera, mImage);
+        }
+
+        if (EDS_ERR_OK != error_)
+        {
+            mJpeg = BufferView();
+            return error_;
+        }
+
+        EdsGetPropertyData(mImage, kEdsPropID_Evf_CoordinateSystem, 0, sizeof(mCoordinateSystem), &mCoordinateSystem);
+        EdsGetPropertyData(mImage, kEdsPropID_Evf_ZoomRect, 0, sizeof(mZoomRect), &mZoomRect);
+
+        // The stream length keeps the high-water mark, the position is what this frame wrote
+        EdsUInt32 position_ = 0;
+        EdsGetPosition(mStream, &position_);
+
+        EdsUInt32 length_ = 0;
+        EdsGetLength(mStream, &length_);
+
+        if (mCapacity < length_)
+        {
+            // The SDK had to grow the stream, count it so the steady state can be checked
+            ++mAllocations;
+            mCapacity = length_;
+        }
+
+        // Fetch the pointer every frame, it moves when the stream grows
+        char* streamPtr_ = NULL;
+        EdsGetPointer(mStream, (EdsVoid **)&streamPtr_);
+
+        mJpeg = BufferView(streamPtr_, position_);
+        ++mFrames;
+
+        return error_;
+    }
+
+    BufferView EvfSession::getJpeg() const
+    {
+        return mJpeg;
+    }
+
+    const EdsSize& EvfSession::getCoordinateSystem() const
+    {
+        return mCoordinateSystem;
+    }
+
+    const EdsRect& EvfSession::getZoomRect() const
+    {
+        return mZoomRect;
+    }
+
+    uint64_t EvfSession::getFrameCount() const
+    {
+        return mFrames;
+    }
+
+    uint64_t EvfSession::getAllocationCount() const
+    {
+        return mAllocations;
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+
+#include "EDSDK.h"
+#include "EDSDKErrors.h"
+#include "EDSDKTypes.h"
+
+#include "buffer.h"
+
+namespace eds
+{
+    // Keeps one EVF memory stream and image ref alive for the whole liveview
+    // session. Each download rewinds the stream and lets the SDK overwrite it
+    // in place, and the jpeg is handed out as a view into the stream memory, so
+    // the steady state needs neither SDK allocations nor a copy.
+    class EvfSession
+    {
+    public:
+        // A liveview jpeg is usually well under 200 KB
+        static const EdsUInt32 kDefaultReserveSize = 512 * 1024;
+
+        EvfSession();
+        ~EvfSession();
+
+        EdsError open(EdsCameraRef camera, EdsUInt32 reserveSize = kDefaultReserveSize);
+        void close();
+        bool isOpen() const;
+
+        EdsError download();
+
+        // Valid until the next download() or close()
+        BufferView getJpeg() const;
+        const EdsSize& getCoordinateSystem() const;
+        const EdsRect& getZoomRect() const;
+
+        uint64_t getFrameCount() const;
+        uint64_t getAllocationCount() const;
+
+    private:
+        EvfSession(const EvfSession&);
+        EvfSession& operator=(const EvfSession&);
+
+        EdsCameraRef mCamera;
+        EdsStreamRef mStream;
+        EdsEvfImageRef mImage;
+        EdsUInt32 mCapacity;
+
+        BufferView mJpeg;
+        EdsSize mCoordinateSystem;
+        EdsRect mZoomRect;
+
+        std::atomic<uint64_t> mFrames;
+        std::atomic<uint64_t> mAllocations;
+    };
+}
@@ -0,0 +1,318 @@
+#include "exif_reader.h"
+
+#include <cstring>
+#include <sstream>
+
+#include "image_container.h"
+
+namespace
+{
+    const uint16_t kTagMake = 0x010F;
+    const uint16_t kTagModel = 0x0110;
+    const uint16_t kTagOrientation = 0x0112;
+    const uint16_t kTagExifIfd = 0x8769;
+    const uint16_t kTagExposureTime = 0x829A;
+    const uint16_t kTagFNumber = 0x829D;
+    const uint16_t kTagIsoSpeed = 0x8827;
+    const uint16_t kTagRecommendedExposureIndex = 0x8832;
+    const uint16_t kTagDateTimeOriginal = 0x9003;
+    const uint16_t kTagFocalLength = 0x920A;
+    const uint16_t kTagMakerNote = 0x927C;
+    const uint16_t kTagBodySerialNumber = 0xA431;
+    const uint16_t kTagCanonSerialNumber = 0x000C;
+
+    // TIFF header of the APP1 Exif segment, 0 if there is none
+    size_t findJpegExif(const eds::BufferView& data)
+    {
+        const unsigned char* p_ = (const unsigned char*)data.data;
+        size_t pos_ = 2;
+
+        while (pos_ + 4 <= data.size && 0xFF == p_[pos_])
+        {
+            unsigned char marker_ = p_[pos_ + 1];
+            size_t length_ = (p_[pos_ + 2] << 8) | p_[pos_ + 3];
+
+            // start of scan, metadata is always before it
+            if (0xDA == marker_ || length_ < 2)
+            {
+                return 0;
+            }
+
+            if (0xE1 == marker_ && 8 <= length_ && pos_ + 10 <= data.size && 0 == memcmp(p_ + pos_ + 4, "Exif\0\0", 6))
+            {
+                return pos_ + 10;
+            }
+
+            pos_ += 2 + length_;
+        }
+
+        return 0;
+    }
+}
+
+namespace eds
+{
+    ExifReader::ExifReader()
+    : mLookups(0)
+    , bCr3(false)
+    {
+        for (auto i = 0; i < kExifIfd_Count; ++i)
+        {
+            mIfds[i] = 0;
+            bLocated[i] = false;
+        }
+    }
+
+    bool ExifReader::open(const BufferView& data)
+    {
+        for (auto i = 0; i < kExifIfd_Count; ++i)
+        {
+            mReaders[i] = TiffReader();
+            mIfds[i] = 0;
+            bLocated[i] = false;
+        }
+
+        mLookups = 0;
+        bCr3 = false;
+
+        switch (detectImageFormat(data))
+        {
+            case kImageFormat_Jpeg:
+            {
+                size_t header_ = findJpegExif(data);
+
+                if (0 == header_ || !mReaders[kExifIfd_Primary].open(data, header_))
+                {
+                    return false;
+                }
+            }
+                break;
+
+            case kImageFormat_Cr2:
+                if (!mReaders[kExifIfd_Primary].open(data))
+                {
+                    return false;
+                }
+                break;
+
+            case kImageFormat_Cr3:
+            {
+                // one TIFF structure per IFD, IFD0 is required, the others are found lazily
+                size_t offset_ = 0;
+                size_t length_ = 0;
+
+                if (!findCr3MetadataBox(data, "CMT1", offset_, length_) || !mReaders[kExifIfd_Primary].open(BufferView(data.data + offset_, length_)))
+                {
+                    return false;
+                }
+
+                bCr3 = true;
+                mReaders[kExifIfd_Exif] = mReaders[kExifIfd_Primary];
+                mReaders[kExifIfd_MakerNote] = mReaders[kExifIfd_Primary];
+
+                // the CMT boxes are tiny, finding them now keeps the reader free of the container
+                if (findCr3MetadataBox(data, "CMT2", offset_, length_))
+                {
+                    mReaders[kExifIfd_Exif].open(BufferView(data.data + offset_, length_));
+                }
+
+                if (findCr3MetadataBox(data, "CMT3", offset_, length_))
+                {
+                    mReaders[kExifIfd_MakerNote].open(BufferView(data.data + offset_, length_));
+                }
+            }
+                break;
+
+            default:
+                return false;
+        }
+
+        mIfds[kExifIfd_Primary] = mReaders[kExifIfd_Primary].getFirstIfd();
+        bLocated[kExifIfd_Primary] = true;
+
+        if (!bCr3)
+        {
+            mReaders[kExifIfd_Exif] = mReaders[kExifIfd_Primary];
+            mReaders[kExifIfd_MakerNote] = mReaders[kExifIfd_Primary];
+        }
+
+        return true;
+    }
+
+    bool ExifReader::isOpen() const
+    {
+        return mReaders[kExifIfd_Primary].isOpen();
+    }
+
+    bool ExifReader::findTag(ExifIfd ifd, uint16_t tag, TiffEntry& entry) const
+    {
+        if (!locate(ifd))
+        {
+            return false;
+        }
+
+        ++mLookups;
+        return mReaders[ifd].findEntry(mIfds[ifd], tag, entry);
+    }
+
+    const TiffReader& ExifReader::getReader(ExifIfd ifd) const
+    {
+        return mReaders[ifd];
+    }
+
+    bool ExifReader::getMake(std::string& make) const
+    {
+        return getString(kExifIfd_Primary, kTagMake, make);
+    }
+
+    bool ExifReader::getModel(std::string& model) const
+    {
+        return getString(kExifIfd_Primary, kTagModel, model);
+    }
+
+    bool ExifReader::getDateTimeOriginal(std::string& dateTime) const
+    {
+        return getString(kExifIfd_Exif, kTagDateTimeOriginal, dateTime);
+    }
+
+    bool ExifReader::getSerialNumber(std::string& serial) const
+    {
+        if (getString(kExifIfd_Exif, kTagBodySerialNumber, serial) && !serial.empty())
+        {
+            return true;
+        }
+
+        // older bodies only have it in the maker note, as a number
+        uint32_t number_ = 0;
+
+        if (!getUInt(kExifIfd_MakerNote, kTagCanonSerialNumber, number_))
+        {
+            return false;
+        }
+
+        std::ostringstream text_;
+        text_ << number_;
+        serial = text_.str();
+
+        return true;
+    }
+
+    bool ExifReader::getOrientation(uint32_t& orientation) const
+    {
+        return getUInt(kExifIfd_Primary, kTagOrientation, orientation);
+    }
+
+    bool ExifReader::getIso(uint32_t& iso) const
+    {
+        // ISOSpeedRatings tops out at 65535, higher settings are only in the exposure index
+        if (getUInt(kExifIfd_Exif, kTagIsoSpeed, iso) && iso < 65535)
+        {
+            return true;
+        }
+
+        return getUInt(kExifIfd_Exif, kTagRecommendedExposureIndex, iso);
+    }
+
+    bool ExifReader::getExposureTime(double& seconds) const
+    {
+        return getRational(kExifIfd_Exif, kTagExposureTime, seconds);
+    }
+
+    bool ExifReader::getFNumber(double& fNumber) const
+    {
+        return getRational(kExifIfd_Exif, kTagFNumber, fNumber);
+    }
+
+    bool ExifReader::getFocalLength(double& millimeters) const
+    {
+        return getRational(kExifIfd_Exif, kTagFocalLength, millimeters);
+    }
+
+    uint64_t ExifReader::getLookupCount() const
+    {
+        return mLookups;
+    }
+
+    bool ExifReader::locate(ExifIfd ifd) const
+    {
+        if (bLocated[ifd])
+        {
+            return 0 != mIfds[ifd];
+        }
+
+        bLocated[ifd] = true;
+
+        if (!mReaders[ifd].isOpen())
+        {
+            return false;
+        }
+
+        if (bCr3)
+        {
+            // CMT2 and CMT3 are TIFF structures of their own
+            mIfds[ifd] = mReaders[ifd].getFirstIfd();
+            return 0 != mIfds[ifd];
+        }
+
+        TiffEntry entry_;
+        uint32_t offset_ = 0;
+
+        if (kExifIfd_Exif == ifd)
+        {
+            if (mReaders[ifd].findEntry(mIfds[kExifIfd_Primary], kTagExifIfd, entry_) && mReaders[ifd].getUInt(entry_, offset_))
+            {
+                mIfds[ifd] = offset_;
+            }
+        }
+        else if (kExifIfd_MakerNote == ifd && locate(kExifIfd_Exif))
+        {
+            // Canon's maker note is a bare IFD, its offsets are relative to the TIFF header like everything else
+            if (mReaders[ifd].findEntry(mIfds[kExifIfd_Exif], kTagMakerNote, entry_))
+            {
+                mIfds[ifd] = entry_.valueOffset;
+            }
+        }
+
+        return 0 != mIfds[ifd];
+    }
+
+    bool ExifReader::getString(ExifIfd ifd, uint16_t tag, std::string& value) const
+    {
+        TiffEntry entry_;
+        BufferView text_;
+
+        if (!findTag(ifd, tag, entry_) || !mReaders[ifd].getString(entry_, text_))
+        {
+            return false;
+        }
+
+        value.assign(text_.data, text_.size);
+
+        // trailing spaces pad fixed size fields
+        size_t end_ = value.find_last_not_of(' ');
+        value.erase(std::string::npos == end_ ? 0 : end_ + 1);
+
+        return true;
+    }
+
+    bool ExifReader::getUInt(ExifIfd ifd, uint16_t tag, uint32_t& value) const
+    {
+        TiffEntry entry_;
+        return findTag(ifd, tag, entry_) && mReaders[ifd].getUInt(entry_, value);
+    }
+
+    bool ExifReader::getRational(ExifIfd ifd, uint16_t tag, double& value) const
+    {
+        TiffEntry entry_;
+        int64_t numerator_ = 0;
+        int64_t denominator_ = 0;
+
+        if (!findTag(ifd, tag, entry_) || !mReaders[ifd].getRational(entry_, numerator_, denominator_, 0) || 0 == denominator_)
+        {
+            return false;
+        }
+
+        value = (double)numerator_ / denominator_;
+        return true;
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+
+#include "buffer.h"
+#include "tiff_reader.h"
+
+namespace eds
+{
+    enum ExifIfd
+    {
+        kExifIfd_Primary,
+        kExifIfd_Exif,
+        kExifIfd_MakerNote,
+        kExifIfd_Count
+    };
+
+    // EXIF and Canon maker note tags, read in place from a JPEG, CR2 or CR3
+    // download. open() only finds the TIFF header(s); the EXIF and maker note
+    // IFDs are located the first time they're asked for and every accessor
+    // looks its tag up directly in the file bytes, so reading a handful of
+    // tags per shot costs microseconds and copies nothing but the results.
+    // The data has to outlive the reader.
+    class ExifReader
+    {
+    public:
+        ExifReader();
+
+        bool open(const BufferView& data);
+        bool isOpen() const;
+
+        bool findTag(ExifIfd ifd, uint16_t tag, TiffEntry& entry) const;
+        const TiffReader& getReader(ExifIfd ifd) const;
+
+        bool getMake(std::string& make) const;
+        bool getModel(std::string& model) const;
+        bool getDateTimeOriginal(std::string& dateTime) const;
+        bool getSerialNumber(std::string& serial) const;
+        bool getOrientation(uint32_t& orientation) const;
+        bool getIso(uint32_t& iso) const;
+        // Tv in seconds, Av as f-number, focal length in mm
+        bool getExposureTime(double& seconds) const;
+        bool getFNumber(double& fNumber) const;
+        bool getFocalLength(double& millimeters) const;
+
+        // Tags looked up so far, for throughput numbers
+        uint64_t getLookupCount() const;
+
+    private:
+        bool locate(ExifIfd ifd) const;
+        bool getString(ExifIfd ifd, uint16_t tag, std::string& value) const;
+        bool getUInt(ExifIfd ifd, uint16_t tag, uint32_t& value) const;
+        bool getRational(ExifIfd ifd, uint16_t tag, double& value) const;
+
+        TiffReader mReaders[kExifIfd_Count];
+        mutable uint32_t mIfds[kExifIfd_Count];
+        mutable bool bLocated[kExifIfd_Count];
+        mutable uint64_t mLookups;
+        bool bCr3;
+    };
+}
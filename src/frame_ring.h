@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+namespace eds
+{
+    // Single-producer/single-consumer frame exchange with a latest-frame-wins
+    // policy. The producer fills back() and publishes it, the consumer acquires
+    // the newest published slot into front(). Neither side ever blocks: if the
+    // producer publishes twice before the consumer acquires, the older frame is
+    // overwritten and counted as dropped.
+    //
+    // Three slots are enough for this policy: one owned by each side and one
+    // in flight. Ownership of the in-flight slot is passed with a single atomic
+    // exchange, so slot contents never need a lock.
+    template <typename T>
+    class FrameRing
+    {
+    public:
+        FrameRing()
+        : mBackIndex(0)
+        , mFrontIndex(1)
+        , mMiddleIndex(2)
+        , mPublished(0)
+        , mAcquired(0)
+        , mDropped(0)
+        {
+        }
+
+        // Producer side
+        T& back()
+        {
+            return mSlots[mBackIndex];
+        }
+
+        void publish()
+        {
+            auto previous_ = mMiddleIndex.exchange(mBackIndex | kFreshFlag, std::memory_order_acq_rel);
+
+            if (previous_ & kFreshFlag)
+            {
+                mDropped.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            mBackIndex = previous_ & kIndexMask;
+            mPublished.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // Consumer side, returns false if nothing new was published since the last call
+        bool acquire()
+        {
+            if (!(mMiddleIndex.load(std::memory_order_relaxed) & kFreshFlag))
+            {
+                return false;
+            }
+
+            auto previous_ = mMiddleIndex.exchange(mFrontIndex, std::memory_order_acq_rel);
+            mFrontIndex = previous_ & kIndexMask;
+            mAcquired.fetch_add(1, std::memory_order_relaxed);
+
+            return true;
+        }
+
+        T& front()
+        {
+            return mSlots[mFrontIndex];
+        }
+
+        const T& front() const
+        {
+            return mSlots[mFrontIndex];
+        }
+
+        // Direct slot access, only for setup and teardown while neither side is running
+        T& at(unsigned int index)
+        {
+            return mSlots[index];
+        }
+
+        const T& at(unsigned int index) const
+        {
+            return mSlots[index];
+        }
+
+        unsigned int size() const
+        {
+            return kSlotCount;
+        }
+
+        uint64_t getPublishedCount() const { return mPublished.load(std::memory_order_relaxed); }
+        uint64_t getAcquiredCount() const { return mAcquired.load(std::memory_order_relaxed); }
+        uint64_t getDroppedCount() const { return mDropped.load(std::memory_order_relaxed); }
+
+    private:
+        enum
+        {
+            kSlotCount = 3,
+            kIndexMask = 0x3,
+            kFreshFlag = 0x4
+        };
+
+        FrameRing(const FrameRing&);
+        FrameRing& operator=(const FrameRing&);
+
+        T mSlots[kSlotCount];
+        unsigned int mBackIndex;
+        unsigned int mFrontIndex;
+        std::atomic<unsigned int> mMiddleIndex;
+
+        std::atomic<uint64_t> mPublished;
+        std::atomic<uint64_t> mAcquired;
+        std::atomic<uint64_t> mDropped;
+    };
+}
@@ -0,0 +1,254 @@
+#include "image_container.h"
+
+#include <cstring>
+
+#include "tiff_reader.h"
+
+namespace
+{
+    // ISOBMFF box, [begin, end) is the payload after the header
+    struct Box
+    {
+        const unsigned char* begin;
+        const unsigned char* end;
+    };
+
+    uint32_t readBig32(const unsigned char* p)
+    {
+        return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | (uint32_t)p[3];
+    }
+
+    uint64_t readBig64(const unsigned char* p)
+    {
+        return (uint64_t)readBig32(p) << 32 | readBig32(p + 4);
+    }
+
+    // first box of the given type among the siblings in [begin, end)
+    bool findBox(const unsigned char* begin, const unsigned char* end, const char* type, Box& box)
+    {
+        while (begin + 8 <= end)
+        {
+            uint64_t size_ = readBig32(begin);
+            size_t header_ = 8;
+
+            if (1 == size_)
+            {
+                if (begin + 16 > end)
+                {
+                    return false;
+                }
+
+                size_ = readBig64(begin + 8);
+                header_ = 16;
+            }
+            else if (0 == size_)
+            {
+                // runs to the end of the enclosing box
+                size_ = end - begin;
+            }
+
+            if (size_ < header_ || (uint64_t)(end - begin) < size_)
+            {
+                return false;
+            }
+
+            if (0 == memcmp(begin + 4, type, 4))
+            {
+                box.begin = begin + header_;
+                box.end = begin + size_;
+                return true;
+            }
+
+            begin += size_;
+        }
+
+        return false;
+    }
+
+    // Canon's uuid box at the start of moov that holds CNCV, CCTP, CMT1..4 and THMB
+    const unsigned char kCanonUuid[16] = { 0x85, 0xC0, 0xB6, 0x87, 0x82, 0x0F, 0x11, 0xE0, 0x81, 0x11, 0xF4, 0xCE, 0x46, 0x2B, 0x6A, 0x48 };
+
+    bool isJpegAt(const eds::BufferView& data, size_t offset, size_t length)
+    {
+        return 2 <= length && offset <= data.size && length <= data.size - offset
+            && (char)0xFF == data.data[offset] && (char)0xD8 == data.data[offset + 1];
+    }
+
+    bool findCr2Preview(const eds::BufferView& data, size_t& offset, size_t& length)
+    {
+        eds::TiffReader reader_;
+
+        if (!reader_.open(data))
+        {
+            return false;
+        }
+
+        // IFD0 carries the full size JPEG as a single strip
+        eds::TiffEntry offsets_;
+        eds::TiffEntry lengths_;
+        uint32_t offset_ = 0;
+        uint32_t length_ = 0;
+
+        if (!reader_.findEntry(reader_.getFirstIfd(), 0x0111, offsets_) || !reader_.findEntry(reader_.getFirstIfd(), 0x0117, lengths_)
+            || !reader_.getUInt(offsets_, offset_) || !reader_.getUInt(lengths_, length_))
+        {
+            return false;
+        }
+
+        if (!isJpegAt(data, offset_, length_))
+        {
+            return false;
+        }
+
+        offset = offset_;
+        length = length_;
+
+        return true;
+    }
+
+    bool findCr3Preview(const eds::BufferView& data, size_t& offset, size_t& length)
+    {
+        const unsigned char* begin_ = (const unsigned char*)data.data;
+        const unsigned char* end_ = begin_ + data.size;
+
+        // trak 1 is the full size JPEG, its one sample is located by stsz and co64
+        Box moov_, trak_, mdia_, minf_, stbl_, stsz_, co64_;
+
+        if (!findBox(begin_, end_, "moov", moov_) || !findBox(moov_.begin, moov_.end, "trak", trak_)
+            || !findBox(trak_.begin, trak_.end, "mdia", mdia_) || !findBox(mdia_.begin, mdia_.end, "minf", minf_)
+            || !findBox(minf_.begin, minf_.end, "stbl", stbl_) || !findBox(stbl_.begin, stbl_.end, "stsz", stsz_)
+            || !findBox(stbl_.begin, stbl_.end, "co64", co64_))
+        {
+            return false;
+        }
+
+        // stsz: version/flags, sample size, sample count, then per sample sizes if the size is 0
+        if (stsz_.end - stsz_.begin < 12)
+        {
+            return false;
+        }
+
+        uint64_t length_ = readBig32(stsz_.begin + 4);
+
+        if (0 == length_)
+        {
+            if (stsz_.end - stsz_.begin < 16 || 0 == readBig32(stsz_.begin + 8))
+            {
+                return false;
+            }
+
+            length_ = readBig32(stsz_.begin + 12);
+        }
+
+        // co64: version/flags, entry count, 64 bit chunk offsets
+        if (co64_.end - co64_.begin < 16 || 0 == readBig32(co64_.begin + 4))
+        {
+            return false;
+        }
+
+        uint64_t offset_ = readBig64(co64_.begin + 8);
+
+        if (data.size < offset_ || !isJpegAt(data, (size_t)offset_, (size_t)length_))
+        {
+            return false;
+        }
+
+        offset = (size_t)offset_;
+        length = (size_t)length_;
+
+        return true;
+    }
+}
+
+namespace eds
+{
+    ImageFormat detectImageFormat(const BufferView& data)
+    {
+        const unsigned char* p_ = (const unsigned char*)data.data;
+
+        if (3 <= data.size && 0xFF == p_[0] && 0xD8 == p_[1] && 0xFF == p_[2])
+        {
+            return kImageFormat_Jpeg;
+        }
+
+        // TIFF header, then "CR" and the major version at offset 8
+        if (10 <= data.size && (0 == memcmp(p_, "II*\0", 4) || 0 == memcmp(p_, "MM\0*", 4)) && 'C' == p_[8] && 'R' == p_[9])
+        {
+            return kImageFormat_Cr2;
+        }
+
+        // ISOBMFF with the "crx " brand
+        if (12 <= data.size && 0 == memcmp(p_ + 4, "ftyp", 4) && 0 == memcmp(p_ + 8, "crx ", 4))
+        {
+            return kImageFormat_Cr3;
+        }
+
+        return kImageFormat_Unknown;
+    }
+
+    const char* getImageFormatName(ImageFormat format)
+    {
+        switch (format)
+        {
+            case kImageFormat_Jpeg:
+                return "JPEG";
+
+            case kImageFormat_Cr2:
+                return "CR2";
+
+            case kImageFormat_Cr3:
+                return "CR3";
+
+            default:
+                return "unknown";
+        }
+    }
+
+    bool isRawFormat(ImageFormat format)
+    {
+        return kImageFormat_Cr2 == format || kImageFormat_Cr3 == format;
+    }
+
+    bool findEmbeddedJpeg(const BufferView& data, size_t& offset, size_t& length)
+    {
+        switch (detectImageFormat(data))
+        {
+            case kImageFormat_Jpeg:
+                offset = 0;
+                length = data.size;
+                return true;
+
+            case kImageFormat_Cr2:
+                return findCr2Preview(data, offset, length);
+
+            case kImageFormat_Cr3:
+                return findCr3Preview(data, offset, length);
+
+            default:
+                return false;
+        }
+    }
+
+    bool findCr3MetadataBox(const BufferView& data, const char* type, size_t& offset, size_t& length)
+    {
+        if (kImageFormat_Cr3 != detectImageFormat(data))
+        {
+            return false;
+        }
+
+        const unsigned char* begin_ = (const unsigned char*)data.data;
+        Box moov_, uuid_, box_;
+
+        if (!findBox(begin_, begin_ + data.size, "moov", moov_) || !findBox(moov_.begin, moov_.end, "uuid", uuid_)
+            || uuid_.end - uuid_.begin < 16 || 0 != memcmp(uuid_.begin, kCanonUuid, 16)
+            || !findBox(uuid_.begin + 16, uuid_.end, type, box_))
+        {
+            return false;
+        }
+
+        offset = box_.begin - begin_;
+        length = box_.end - box_.begin;
+
+        return true;
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "buffer.h"
+
+namespace eds
+{
+    enum ImageFormat
+    {
+        kImageFormat_Unknown,
+        kImageFormat_Jpeg,
+        kImageFormat_Cr2,
+        kImageFormat_Cr3
+    };
+
+    // Tells the container apart from its first bytes, EdsDirectoryItemInfo::format
+    // isn't reliable across bodies and SDK versions
+    ImageFormat detectImageFormat(const BufferView& data);
+    const char* getImageFormatName(ImageFormat format);
+    bool isRawFormat(ImageFormat format);
+
+    // Finds the largest JPEG embedded in the file without decoding anything:
+    // IFD0 strips in a CR2, the first track's sample in a CR3, the file itself
+    // for a JPEG. offset and length are relative to data, so the preview can be
+    // handed out as a slice of the downloaded buffer.
+    bool findEmbeddedJpeg(const BufferView& data, size_t& offset, size_t& length);
+
+    // Canon's metadata boxes in a CR3 (CMT1 = IFD0, CMT2 = EXIF, CMT3 = maker
+    // note), each a complete TIFF structure
+    bool findCr3MetadataBox(const BufferView& data, const char* type, size_t& offset, size_t& length);
+}
@@ -0,0 +1,299 @@
+#include "intervalometer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // the longest stop() waits for the thread to notice
+    const uint64_t kSliceNanos = 100000000;
+}
+
+namespace eds
+{
+    Intervalometer::Clock::Clock()
+    : now(&MonotonicClock::nowNanos)
+    , sleepUntil(&MonotonicClock::sleepUntil)
+    {
+    }
+
+    Intervalometer::Settings::Settings()
+    : intervalMillis(10000.0)
+    , frameCount(0)
+    , policy(kIntervalPolicy_Skip)
+    , keepAliveMillis(60000.0)
+    {
+    }
+
+    Intervalometer::Intervalometer()
+    : bRunning(false)
+    , bStop(false)
+    , mFired(0)
+    , mSkipped(0)
+    , mQueued(0)
+    , mKeepAlives(0)
+    , mOnTime(0)
+    , mJitterSum(0.0)
+    , mJitterSquareSum(0.0)
+    , mJitterMax(0.0)
+    , mLastJitter(0.0)
+    {
+    }
+
+    Intervalometer::Intervalometer(const Clock& clock)
+    : mClock(clock)
+    , bRunning(false)
+    , bStop(false)
+    , mFired(0)
+    , mSkipped(0)
+    , mQueued(0)
+    , mKeepAlives(0)
+    , mOnTime(0)
+    , mJitterSum(0.0)
+    , mJitterSquareSum(0.0)
+    , mJitterMax(0.0)
+    , mLastJitter(0.0)
+    {
+    }
+
+    Intervalometer::~Intervalometer()
+    {
+        stop();
+    }
+
+    bool Intervalometer::start(const Settings& settings)
+    {
+        if (bRunning || !settings.fire || settings.intervalMillis <= 0.0)
+        {
+            return false;
+        }
+
+        // the thread of a schedule that ran out of frames
+        if (mThread.joinable())
+        {
+            mThread.join();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock_(mMutex);
+
+            mFired = 0;
+            mSkipped = 0;
+            mQueued = 0;
+            mKeepAlives = 0;
+            mOnTime = 0;
+            mJitterSum = 0.0;
+            mJitterSquareSum = 0.0;
+            mJitterMax = 0.0;
+            mLastJitter = 0.0;
+        }
+
+        mSettings = settings;
+        bStop = false;
+        bRunning = true;
+        mThread = std::thread(&Intervalometer::threadedFunction, this);
+
+        return true;
+    }
+
+    void Intervalometer::stop()
+    {
+        bStop = true;
+
+        if (mThread.joinable())
+        {
+            mThread.join();
+        }
+    }
+
+    bool Intervalometer::isRunning() const
+    {
+        return bRunning;
+    }
+
+    uint64_t Intervalometer::getFiredCount() const
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+        return mFired;
+    }
+
+    uint64_t Intervalometer::getSkippedCount() const
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+        return mSkipped;
+    }
+
+    uint64_t Intervalometer::getQueuedCount() const
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+        return mQueued;
+    }
+
+    uint64_t Intervalometer::getKeepAliveCount() const
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+        return mKeepAlives;
+    }
+
+    double Intervalometer::getJitterMicrosAverage() const
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+        return 0 == mOnTime ? 0.0 : mJitterSum / mOnTime;
+    }
+
+    double Intervalometer::getJitterMicrosStdDev() const
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+
+        if (0 == mOnTime)
+        {
+            return 0.0;
+        }
+
+        double average_ = mJitterSum / mOnTime;
+        return std::sqrt(std::max(0.0, mJitterSquareSum / mOnTime - average_ * average_));
+    }
+
+    double Intervalometer::getJitterMicrosMax() const
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+        return mJitterMax;
+    }
+
+    double Intervalometer::getLastJitterMicros() const
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+        return mLastJitter;
+    }
+
+    void Intervalometer::threadedFunction()
+    {
+        uint64_t interval_ = std::max<uint64_t>(1, (uint64_t)(mSettings.intervalMillis * 1000000.0));
+        uint64_t start_ = mClock.now();
+        uint64_t lastKeepAlive_ = start_;
+        uint64_t frame_ = 0;
+
+        while (!bStop && (0 == mSettings.frameCount || frame_ < mSettings.frameCount))
+        {
+            // from the start every time, how late the last frame woke up doesn't carry over
+            uint64_t deadline_ = start_ + frame_ * interval_;
+
+            if (!waitUntil(deadline_, lastKeepAlive_))
+            {
+                break;
+            }
+
+            bool queued_ = false;
+
+            if (mSettings.busy && mSettings.busy())
+            {
+                if (kIntervalPolicy_Skip == mSettings.policy)
+                {
+                    std::lock_guard<std::mutex> lock_(mMutex);
+                    ++mSkipped;
+                    ++frame_;
+                    continue;
+                }
+
+                if (!waitWhileBusy(lastKeepAlive_))
+                {
+                    break;
+                }
+
+                queued_ = true;
+            }
+
+            uint64_t fired_ = mClock.now();
+            mSettings.fire();
+            lastKeepAlive_ = fired_;
+
+            // the next deadline still ahead, the ones a late frame ran past are skipped
+            uint64_t next_ = std::max(frame_ + 1, (mClock.now() - start_) / interval_ + 1);
+
+            if (0 < mSettings.frameCount)
+            {
+                next_ = std::min(next_, mSettings.frameCount);
+            }
+
+            std::lock_guard<std::mutex> lock_(mMutex);
+
+            ++mFired;
+            mSkipped += next_ - frame_ - 1;
+
+            if (queued_)
+            {
+                ++mQueued;
+            }
+            else
+            {
+                mLastJitter = (fired_ - deadline_) / 1000.0;
+                mJitterSum += mLastJitter;
+                mJitterSquareSum += mLastJitter * mLastJitter;
+                mJitterMax = std::max(mJitterMax, mLastJitter);
+                ++mOnTime;
+            }
+
+            frame_ = next_;
+        }
+
+        bRunning = false;
+    }
+
+    bool Intervalometer::waitUntil(uint64_t deadline, uint64_t& lastKeepAlive)
+    {
+        uint64_t keepAlive_ = (uint64_t)(mSettings.keepAliveMillis * 1000000.0);
+
+        while (!bStop)
+        {
+            uint64_t now_ = mClock.now();
+
+            if (deadline <= now_)
+            {
+                return true;
+            }
+
+            keepAlive(now_, lastKeepAlive);
+
+            // the last slice ends exactly on the deadline
+            uint64_t wake_ = std::min(deadline, now_ + kSliceNanos);
+
+            if (0 < keepAlive_)
+            {
+                wake_ = std::min(wake_, lastKeepAlive + keepAlive_);
+            }
+
+            mClock.sleepUntil(wake_);
+        }
+
+        return false;
+    }
+
+    bool Intervalometer::waitWhileBusy(uint64_t& lastKeepAlive)
+    {
+        while (!bStop && mSettings.busy())
+        {
+            uint64_t now_ = mClock.now();
+
+            keepAlive(now_, lastKeepAlive);
+            mClock.sleepUntil(now_ + kSliceNanos / 10);
+        }
+
+        return !bStop;
+    }
+
+    void Intervalometer::keepAlive(uint64_t now, uint64_t& lastKeepAlive)
+    {
+        uint64_t keepAlive_ = (uint64_t)(mSettings.keepAliveMillis * 1000000.0);
+
+        if (0 == keepAlive_ || !mSettings.keepAlive || now < lastKeepAlive + keepAlive_)
+        {
+            return;
+        }
+
+        mSettings.keepAlive();
+        lastKeepAlive = now;
+
+        std::lock_guard<std::mutex> lock_(mMutex);
+        ++mKeepAlives;
+    }
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+
+#include "monotonic_clock.h"
+
+namespace eds
+{
+    enum IntervalPolicy
+    {
+        kIntervalPolicy_Skip,   // a frame due while a download is in flight is left out
+        kIntervalPolicy_Queue   // it waits for the download and is taken late
+    };
+
+    // Timelapse scheduler. Frame n is due at start + n * interval, every
+    // deadline is computed from the start and slept to as an absolute time,
+    // so sleep error never accumulates over a multi-day run. Deadlines that
+    // already passed (a queued frame that waited, the machine was asleep)
+    // are counted as skipped, never fired in a burst.
+    //
+    // The handlers run on the scheduler thread. keepAlive runs whenever no
+    // frame was taken for keepAliveMillis, so the cameras don't power off
+    // between long intervals.
+    //
+    // The clock is injectable, a simulated one runs days of schedule in
+    // milliseconds.
+    class Intervalometer
+    {
+    public:
+        struct Clock
+        {
+            // The monotonic clock of the system
+            Clock();
+
+            std::function<uint64_t()> now;
+            std::function<void(uint64_t)> sleepUntil;
+        };
+
+        struct Settings
+        {
+            Settings();
+
+            double intervalMillis;
+            // 0 runs until stop()
+            uint64_t frameCount;
+            IntervalPolicy policy;
+            // 0 never sends it
+            double keepAliveMillis;
+
+            std::function<void()> fire;
+            // True while a download is still in flight
+            std::function<bool()> busy;
+            std::function<void()> keepAlive;
+        };
+
+        Intervalometer();
+        explicit Intervalometer(const Clock& clock);
+        ~Intervalometer();
+
+        // The first frame is taken right away. Returns false if it's already running.
+        bool start(const Settings& settings);
+        void stop();
+        bool isRunning() const;
+
+        uint64_t getFiredCount() const;
+        uint64_t getSkippedCount() const;
+        uint64_t getQueuedCount() const;
+        uint64_t getKeepAliveCount() const;
+        // Lateness of the frames taken on schedule, queued frames aren't part of it
+        double getJitterMicrosAverage() const;
+        double getJitterMicrosStdDev() const;
+        double getJitterMicrosMax() const;
+        double getLastJitterMicros() const;
+
+    private:
+        Intervalometer(const Intervalometer&);
+        Intervalometer& operator=(const Intervalometer&);
+
+        void threadedFunction();
+        // Returns false if stopped on the way
+        bool waitUntil(uint64_t deadline, uint64_t& lastKeepAlive);
+        bool waitWhileBusy(uint64_t& lastKeepAlive);
+        void keepAlive(uint64_t now, uint64_t& lastKeepAlive);
+
+        Clock mClock;
+        Settings mSettings;
+        std::thread mThread;
+        std::atomic<bool> bRunning;
+        std::atomic<bool> bStop;
+
+        mutable std::mutex mMutex;
+        uint64_t mFired;
+        uint64_t mSkipped;
+        uint64_t mQueued;
+        uint64_t mKeepAlives;
+        uint64_t mOnTime;
+        double mJitterSum;
+        double mJitterSquareSum;
+        double mJitterMax;
+        double mLastJitter;
+    };
+}
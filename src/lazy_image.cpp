@@ -0,0 +1,44 @@
+#include "lazy_image.h"
+
+namespace eds
+{
+    LazyImage::LazyImage(const BufferSlice& encoded)
+    : mEncoded(encoded)
+    , bDecoded(false)
+    , bFailed(false)
+    {
+    }
+
+    const BufferSlice& LazyImage::getEncoded() const
+    {
+        return mEncoded;
+    }
+
+    bool LazyImage::isDecoded() const
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+        return bDecoded;
+    }
+
+    bool LazyImage::getPixels(ofPixels& pixels)
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+
+        if (!bDecoded && !bFailed)
+        {
+            ofBuffer buffer_;
+            buffer_.set(mEncoded.data(), mEncoded.size());
+            CopyStats::record(mEncoded.size());
+
+            bDecoded = ofLoadImage(mPixels, buffer_);
+            bFailed = !bDecoded;
+        }
+
+        if (bDecoded)
+        {
+            pixels = mPixels;
+        }
+
+        return bDecoded;
+    }
+}
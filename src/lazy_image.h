@@ -0,0 +1,35 @@
+#pragma once
+
+#include <mutex>
+
+#include "ofMain.h"
+
+#include "buffer_slice.h"
+
+namespace eds
+{
+    // A downloaded capture that is only decoded the first time someone asks
+    // for its pixels. Holding on to one costs a reference to the download
+    // buffer, nothing more.
+    class LazyImage
+    {
+    public:
+        LazyImage(const BufferSlice& encoded);
+
+        const BufferSlice& getEncoded() const;
+        bool isDecoded() const;
+
+        // Decodes on the first call, false if the bytes aren't a readable image
+        bool getPixels(ofPixels& pixels);
+
+    private:
+        LazyImage(const LazyImage&);
+        LazyImage& operator=(const LazyImage&);
+
+        BufferSlice mEncoded;
+        ofPixels mPixels;
+        bool bDecoded;
+        bool bFailed;
+        mutable std::mutex mMutex;
+    };
+}
@@ -0,0 +1,159 @@
+#include "line_reader.h"
+
+#if defined(__GNUC__) && defined(__AVX2__)
+#include <immintrin.h>
+#define EDS_LINE_READER_AVX2
+#elif defined(__GNUC__) && defined(__SSE2__)
+#include <emmintrin.h>
+#define EDS_LINE_READER_SSE2
+#endif
+
+namespace eds
+{
+    const char* findLineEnd(const char* begin, const char* end)
+    {
+        const char* pos_ = begin;
+
+#if defined(EDS_LINE_READER_AVX2)
+        const __m256i lf_ = _mm256_set1_epi8('\n');
+        const __m256i cr_ = _mm256_set1_epi8('\r');
+
+        while (32 <= end - pos_)
+        {
+            __m256i chunk_ = _mm256_loadu_si256((const __m256i*)pos_);
+            unsigned int mask_ = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(chunk_, lf_), _mm256_cmpeq_epi8(chunk_, cr_)));
+
+            if (0 != mask_)
+            {
+                return pos_ + __builtin_ctz(mask_);
+            }
+
+            pos_ += 32;
+        }
+#elif defined(EDS_LINE_READER_SSE2)
+        const __m128i lf_ = _mm_set1_epi8('\n');
+        const __m128i cr_ = _mm_set1_epi8('\r');
+
+        while (16 <= end - pos_)
+        {
+            __m128i chunk_ = _mm_loadu_si128((const __m128i*)pos_);
+            unsigned int mask_ = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk_, lf_), _mm_cmpeq_epi8(chunk_, cr_)));
+
+            if (0 != mask_)
+            {
+                return pos_ + __builtin_ctz(mask_);
+            }
+
+            pos_ += 16;
+        }
+#endif
+
+        // scalar fallback, and the tail of the vector loops
+        while (pos_ < end && '\n' != *pos_ && '\r' != *pos_)
+        {
+            ++pos_;
+        }
+
+        return pos_;
+    }
+
+    LineIterator::LineIterator()
+    : mNext(NULL)
+    , mEnd(NULL)
+    , bAtEnd(true)
+    {
+    }
+
+    LineIterator::LineIterator(const char* begin, const char* end)
+    : mNext(begin)
+    , mEnd(end)
+    , bAtEnd(false)
+    {
+        readLine();
+    }
+
+    const BufferView& LineIterator::operator*() const
+    {
+        return mLine;
+    }
+
+    const BufferView* LineIterator::operator->() const
+    {
+        return &mLine;
+    }
+
+    LineIterator& LineIterator::operator++()
+    {
+        readLine();
+        return *this;
+    }
+
+    LineIterator LineIterator::operator++(int)
+    {
+        LineIterator previous_(*this);
+        readLine();
+        return previous_;
+    }
+
+    bool LineIterator::operator==(const LineIterator& other) const
+    {
+        if (bAtEnd || other.bAtEnd)
+        {
+            return bAtEnd == other.bAtEnd;
+        }
+
+        return mLine.data == other.mLine.data;
+    }
+
+    bool LineIterator::operator!=(const LineIterator& other) const
+    {
+        return !(*this == other);
+    }
+
+    const char* LineIterator::getNextLinePosition() const
+    {
+        return mNext;
+    }
+
+    void LineIterator::readLine()
+    {
+        if (NULL == mNext || mNext == mEnd)
+        {
+            bAtEnd = true;
+            mLine = BufferView();
+            return;
+        }
+
+        const char* lineEnd_ = findLineEnd(mNext, mEnd);
+        mLine = BufferView(mNext, lineEnd_ - mNext);
+
+        if (lineEnd_ == mEnd)
+        {
+            mNext = mEnd;
+        }
+        else if ('\r' == *lineEnd_ && lineEnd_ + 1 < mEnd && '\n' == lineEnd_[1])
+        {
+            // CRLF
+            mNext = lineEnd_ + 2;
+        }
+        else
+        {
+            mNext = lineEnd_ + 1;
+        }
+    }
+
+    LineRange::LineRange(const BufferView& view)
+    : mView(view)
+    {
+    }
+
+    LineIterator LineRange::begin() const
+    {
+        return LineIterator(mView.data, mView.data + mView.size);
+    }
+
+    LineIterator LineRange::end() const
+    {
+        return LineIterator();
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <iterator>
+
+#include "buffer.h"
+
+namespace eds
+{
+    // Returns the first '\n' or '\r' in [begin, end), or end. Uses AVX2 or SSE2
+    // when the build enables them, a scalar loop otherwise.
+    const char* findLineEnd(const char* begin, const char* end);
+
+    // Forward iterator over the lines of a byte range. Lines are views into the
+    // range, nothing is copied. Line endings are handled like
+    // Buffer::getNextLine(): LF, CR and CRLF each end a line, and a trailing
+    // line ending doesn't produce an extra empty line.
+    //
+    // Lines are BufferViews rather than std::string_view since the project
+    // still builds as C++11, they carry the same pointer and length.
+    class LineIterator : public std::iterator<std::forward_iterator_tag, BufferView>
+    {
+    public:
+        LineIterator();
+        LineIterator(const char* begin, const char* end);
+
+        const BufferView& operator*() const;
+        const BufferView* operator->() const;
+
+        LineIterator& operator++();
+        LineIterator operator++(int);
+
+        bool operator==(const LineIterator& other) const;
+        bool operator!=(const LineIterator& other) const;
+
+        // Where the line after the current one starts
+        const char* getNextLinePosition() const;
+
+    private:
+        void readLine();
+
+        const char* mNext;
+        const char* mEnd;
+        BufferView mLine;
+        bool bAtEnd;
+    };
+
+    class LineRange
+    {
+    public:
+        LineRange(const BufferView& view);
+
+        LineIterator begin() const;
+        LineIterator end() const;
+
+    private:
+        BufferView mView;
+    };
+}
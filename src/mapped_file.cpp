@@ -0,0 +1,180 @@
+#include "mapped_file.h"
+
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace eds
+{
+    MappedFile::MappedFile()
+    : mFd(-1)
+    , mData(NULL)
+    , mSize(0)
+    , mMode(kMode_ReadOnly)
+    {
+    }
+
+    MappedFile::~MappedFile()
+    {
+        close();
+    }
+
+    bool MappedFile::open(const std::string& path, Mode mode, size_t size)
+    {
+        close();
+
+        int flags_ = (kMode_ReadWrite == mode) ? (O_RDWR | O_CREAT) : O_RDONLY;
+        int fd_ = ::open(path.c_str(), flags_, 0644);
+
+        if (fd_ < 0)
+        {
+            return false;
+        }
+
+        if (kMode_ReadWrite == mode && 0 < size)
+        {
+            if (0 != ftruncate(fd_, size))
+            {
+                ::close(fd_);
+                return false;
+            }
+        }
+        else
+        {
+            struct stat stat_;
+
+            if (0 != fstat(fd_, &stat_))
+            {
+                ::close(fd_);
+                return false;
+            }
+
+            size = stat_.st_size;
+        }
+
+        return map(fd_, mode, size);
+    }
+
+    bool MappedFile::createAnonymous(size_t size)
+    {
+        close();
+
+        int fd_ = -1;
+
+#if defined(__linux__)
+        fd_ = memfd_create("eds::Buffer", MFD_CLOEXEC);
+#else
+        // no memfd, use a temporary file that is unlinked right away
+        const char* tmp_ = getenv("TMPDIR");
+        std::string template_ = std::string(tmp_ ? tmp_ : "/tmp") + "/eds-buffer-XXXXXX";
+
+        fd_ = mkstemp(&template_[0]);
+
+        if (0 <= fd_)
+        {
+            unlink(template_.c_str());
+        }
+#endif
+
+        if (fd_ < 0)
+        {
+            return false;
+        }
+
+        if (0 != ftruncate(fd_, size))
+        {
+            ::close(fd_);
+            return false;
+        }
+
+        return map(fd_, kMode_ReadWrite, size);
+    }
+
+    void MappedFile::close()
+    {
+        if (NULL != mData)
+        {
+            munmap(mData, mSize);
+            mData = NULL;
+        }
+
+        if (0 <= mFd)
+        {
+            ::close(mFd);
+            mFd = -1;
+        }
+
+        mSize = 0;
+    }
+
+    bool MappedFile::sync()
+    {
+        if (NULL == mData || kMode_ReadWrite != mMode)
+        {
+            return true;
+        }
+
+        return 0 == msync(mData, mSize, MS_SYNC);
+    }
+
+    void MappedFile::adviseSequential()
+    {
+        if (NULL != mData)
+        {
+            madvise(mData, mSize, MADV_SEQUENTIAL);
+        }
+    }
+
+    bool MappedFile::isOpen() const
+    {
+        return 0 <= mFd;
+    }
+
+    MappedFile::Mode MappedFile::getMode() const
+    {
+        return mMode;
+    }
+
+    char* MappedFile::data()
+    {
+        return mData;
+    }
+
+    const char* MappedFile::data() const
+    {
+        return mData;
+    }
+
+    size_t MappedFile::size() const
+    {
+        return mSize;
+    }
+
+    bool MappedFile::map(int fd, Mode mode, size_t size)
+    {
+        mFd = fd;
+        mMode = mode;
+        mSize = size;
+
+        // an empty file can't be mapped, it is still a valid (empty) mapping for us
+        if (0 == size)
+        {
+            return true;
+        }
+
+        int protection_ = (kMode_ReadWrite == mode) ? (PROT_READ | PROT_WRITE) : PROT_READ;
+        void* data_ = mmap(NULL, size, protection_, MAP_SHARED, fd, 0);
+
+        if (MAP_FAILED == data_)
+        {
+            close();
+            return false;
+        }
+
+        mData = (char*)data_;
+
+        return true;
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+
+namespace eds
+{
+    // POSIX memory mapping of a file, or of an anonymous memfd (a temporary,
+    // already unlinked file on platforms without memfd). Pages are only
+    // resident while they are being touched, so multi-GB captures can be
+    // processed without pulling them all into memory.
+    class MappedFile
+    {
+    public:
+        enum Mode
+        {
+            kMode_ReadOnly,
+            kMode_ReadWrite
+        };
+
+        MappedFile();
+        ~MappedFile();
+
+        // With kMode_ReadWrite and a non-zero size the file is created or resized to size
+        bool open(const std::string& path, Mode mode = kMode_ReadOnly, size_t size = 0);
+        bool createAnonymous(size_t size);
+        void close();
+
+        // Flushes a read-write mapping to its file
+        bool sync();
+
+        // Hint that the mapping will be read front to back, so the kernel reads ahead
+        void adviseSequential();
+
+        bool isOpen() const;
+        Mode getMode() const;
+        char* data();
+        const char* data() const;
+        size_t size() const;
+
+    private:
+        MappedFile(const MappedFile&);
+        MappedFile& operator=(const MappedFile&);
+
+        bool map(int fd, Mode mode, size_t size);
+
+        int mFd;
+        char* mData;
+        size_t mSize;
+        Mode mMode;
+    };
+}
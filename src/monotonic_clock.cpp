@@ -0,0 +1,56 @@
+#include "monotonic_clock.h"
+
+#include <cerrno>
+#include <time.h>
+
+#if defined(__APPLE__)
+#include <mach/mach_time.h>
+#endif
+
+namespace
+{
+#if defined(__APPLE__)
+    mach_timebase_info_data_t getTimebase()
+    {
+        mach_timebase_info_data_t timebase_;
+        mach_timebase_info(&timebase_);
+        return timebase_;
+    }
+
+    const mach_timebase_info_data_t kTimebase = getTimebase();
+#endif
+}
+
+namespace eds
+{
+#if defined(__APPLE__)
+    uint64_t MonotonicClock::nowNanos()
+    {
+        return mach_absolute_time() * kTimebase.numer / kTimebase.denom;
+    }
+
+    void MonotonicClock::sleepUntil(uint64_t nanos)
+    {
+        mach_wait_until(nanos * kTimebase.denom / kTimebase.numer);
+    }
+#else
+    uint64_t MonotonicClock::nowNanos()
+    {
+        timespec now_;
+        clock_gettime(CLOCK_MONOTONIC, &now_);
+        return now_.tv_sec * 1000000000ull + now_.tv_nsec;
+    }
+
+    void MonotonicClock::sleepUntil(uint64_t nanos)
+    {
+        timespec deadline_;
+        deadline_.tv_sec = nanos / 1000000000ull;
+        deadline_.tv_nsec = nanos % 1000000000ull;
+
+        // the deadline is absolute, a signal in between doesn't stretch the sleep
+        while (EINTR == clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline_, NULL))
+        {
+        }
+    }
+#endif
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace eds
+{
+    // The system's monotonic clock in nanoseconds, wall clock changes don't
+    // move it. clock_gettime/clock_nanosleep on CLOCK_MONOTONIC, and
+    // mach_absolute_time/mach_wait_until on OS X.
+    class MonotonicClock
+    {
+    public:
+        static uint64_t nowNanos();
+        // Absolute, the time spent before the call and early wake-ups don't add up
+        static void sleepUntil(uint64_t nanos);
+    };
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace eds
+{
+    // Bounded multi-producer/single-consumer queue. Producers claim a slot
+    // with one compare-and-swap on the tail and hand it over by bumping the
+    // slot's sequence number, so push() never blocks, never allocates and
+    // fails instead of waiting when the queue is full. Only one thread may
+    // pop(). Capacity is rounded up to a power of two.
+    template <typename T>
+    class MpscQueue
+    {
+    public:
+        explicit MpscQueue(size_t capacity)
+        : mMask(roundUp(capacity) - 1)
+        , mSlots(new Slot[mMask + 1])
+        , mTail(0)
+        , mHead(0)
+        {
+            for (size_t i = 0; i <= mMask; ++i)
+            {
+                mSlots[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        // Any thread, returns false if the queue is full
+        bool push(const T& value)
+        {
+            size_t position_ = mTail.load(std::memory_order_relaxed);
+            Slot* slot_ = NULL;
+
+            while (true)
+            {
+                slot_ = &mSlots[position_ & mMask];
+                size_t sequence_ = slot_->sequence.load(std::memory_order_acquire);
+                intptr_t difference_ = (intptr_t)sequence_ - (intptr_t)position_;
+
+                if (0 == difference_)
+                {
+                    if (mTail.compare_exchange_weak(position_, position_ + 1, std::memory_order_relaxed))
+                    {
+                        break;
+                    }
+                }
+                else if (difference_ < 0)
+                {
+                    // the consumer hasn't freed this slot yet
+                    return false;
+                }
+                else
+                {
+                    position_ = mTail.load(std::memory_order_relaxed);
+                }
+            }
+
+            slot_->value = value;
+            slot_->sequence.store(position_ + 1, std::memory_order_release);
+
+            return true;
+        }
+
+        // Consumer thread only, returns false if nothing is ready
+        bool pop(T& value)
+        {
+            Slot& slot_ = mSlots[mHead & mMask];
+
+            if (mHead + 1 != slot_.sequence.load(std::memory_order_acquire))
+            {
+                return false;
+            }
+
+            value = slot_.value;
+            slot_.sequence.store(mHead + mMask + 1, std::memory_order_release);
+            ++mHead;
+
+            return true;
+        }
+
+        size_t capacity() const
+        {
+            return mMask + 1;
+        }
+
+    private:
+        struct Slot
+        {
+            std::atomic<size_t> sequence;
+            T value;
+        };
+
+        MpscQueue(const MpscQueue&);
+        MpscQueue& operator=(const MpscQueue&);
+
+        static size_t roundUp(size_t capacity)
+        {
+            size_t size_ = 2;
+
+            while (size_ < capacity)
+            {
+                size_ <<= 1;
+            }
+
+            return size_;
+        }
+
+        const size_t mMask;
+        std::unique_ptr<Slot[]> mSlots;
+        std::atomic<size_t> mTail;
+        size_t mHead;
+    };
+}
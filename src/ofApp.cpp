@@ -1,58 +1,16 @@
 #include "ofApp.h"
 
-const EdsImageQuality imageQualities[] =
-{
-    EdsImageQuality_LJF,	/* Jpeg Large Fine - 5760x3240 */
-    EdsImageQuality_LJN,	/* Jpeg Large Normal - 5760x3240 */
-    EdsImageQuality_MJF,	/* Jpeg Middle Fine - 3840x2160 */
-    EdsImageQuality_MJN,	/* Jpeg Middle Normal - 3840x2160 */
-    EdsImageQuality_S1JF,	/* Jpeg Small1 Fine - 2880x1624 */
-    EdsImageQuality_S1JN,	/* Jpeg Small1 Normal - 2880x1624 */
-    EdsImageQuality_S2JF,	/* Jpeg Small2 - 1920x1080 */
-    EdsImageQuality_S3JF,	/* Jpeg Small3 - 720x400 */ }
-;
-
-const EdsEvfAFMode evfAFModes[] =
-{
-    Evf_AFMode_Quick,
-    Evf_AFMode_Live,
-    Evf_AFMode_LiveFace,
-    Evf_AFMode_LiveMulti
-};
-
-const EdsUInt32 ISOSpeeds[] =
-{
-    0x00000000, // Auto
-    0x00000040, // 50
-    0x00000048, // 100
-    0x0000004b, // 125
-    0x0000004d, // 160
-    0x00000050, // 200
-    0x00000053, // 250
-    0x00000055, // 320
-    0x00000058, // 400
-    0x0000005b, // 500
-    0x0000005d, // 640
-    0x00000060, // 800
-    0x00000063, // 1000
-    0x00000065, // 1250
-    0x00000068, // 1600
-    0x0000006b, // 2000
-    0x0000006d, // 2500
-    0x00000070, // 3200
-    0x00000073, // 4000
-    0x00000075, // 5000
-    0x00000078, // 6400
-    0x0000007b, // 8000
-    0x0000007d, // 10000
-    0x00000080, // 12800
-    0x00000088, // 25600
-    0x00000090, // 51200
-    0x00000098  // 102400
-};
-
 int enumIndex = 0;
 
+//--------------------------------------------------------------
+ofApp::ofApp()
+: mCameraManager(mEventBus)
+, mTriggerEngine(mCameraManager)
+, mReconnectManager(mCameraManager)
+, mBulbController(mCameraManager)
+{
+}
+
 //--------------------------------------------------------------
 void ofApp::setup()
 {
@@ -60,55 +18,185 @@ void ofApp::setup()
     ofSetLogLevel(OF_LOG_VERBOSE);
     
     EdsError error_ = EDS_ERR_OK;
-    mCamera = NULL;
     
     bSdkInitialized = false;
     bIsReady = false;
-    bSessionOpened = false;
     bLiveviewStarted = false;
-    bExecuteBulbShooting = false;
     mEvfImageWidth = 0.f;
     mEvfImageHeight = 0.f;
     mEvfScaleRatioX = 1.f;
     mEvfScaleRatioY = 1.f;
     bytesPerFrame = 0.f;
+    mLiveviewCacheHits = 0;
+    mLiveviewStartTime = 0.f;
+    mDroppedEvents = 0;
+    mPendingDownloadCount = 0;
+    mSelectedCamera = 0;
+    mTriggerShots = 0;
+    mBulbMillis = 2000.0;
+    bBulbCancelled = false;
+    mTimelapseMillis = 10000.0;
+    mStartupFirstFrame = 0;
+    bStartupReported = true;
     mFocusRect.set(0, 0, 0, 0);
-
+    
+    // decode liveview frames at a reduced DCT scale when the window is smaller than the frame
+    mEvfDecoder.setTargetSize(ofGetWidth(), ofGetHeight());
+    
+    mManifest.open(ofToDataPath("manifest.jsonl"));
+    
+    // switching between these between shots only sends what changed
+    mStillProfile.set<kEdsPropID_DriveMode>(EDS_DRIVE_MODE_SINGLE_FRAME);
+    mStillProfile.set<kEdsPropID_ISOSpeed>(0x00000048); // 100
+    mStillProfile.set<kEdsPropID_ImageQuality>(EdsImageQuality_LJF);
+    
+    mActionProfile.set<kEdsPropID_DriveMode>(EDS_DRIVE_MODE_HIGH_SPEED_CONTINUOUS_SHOOTING);
+    mActionProfile.set<kEdsPropID_ISOSpeed>(0x00000060); // 800
+    mActionProfile.set<kEdsPropID_ImageQuality>(EdsImageQuality_S2JF);
+    
+    subscribeEvents();
     initialize();
 }
 
 //--------------------------------------------------------------
 void ofApp::update()
 {
-    if (bLiveviewStarted)
+    // SDK callbacks only queue their events, they are handled here
+    mEventBus.dispatch();
+    flushPendingDownloads(false);
+    
+    // a lost property change would leave a stale value in the cache forever
+    if (mDroppedEvents != mEventBus.getDroppedCount())
     {
-        downloadEvfData();
+        mDroppedEvents = mEventBus.getDroppedCount();
+        ofLogWarning() << "SDK events dropped: " << mDroppedEvents;
         
-        if (0 < mMiddleStreamBuffers.at(mReadIndex)->size())
+        for (unsigned int i = 0; i < mCameraManager.getSessionCount(); ++i)
         {
-            std::swap(mFrontStreamBuffer, mMiddleStreamBuffers.at(mReadIndex));
-            ofBuffer* buf_ = new ofBuffer();
-            buf_->set(mFrontStreamBuffer->getBinaryBuffer(), mFrontStreamBuffer->size());
-
-            mImages.at(mImageIndex).get()->loadImage(*buf_);
-            
-            mEvfImageWidth = mImages.at(mImageIndex).get()->getWidth();
-            mEvfImageHeight = mImages.at(mImageIndex).get()->getHeight();
-            mEvfScaleRatioX = mEvfImageCoord.width / mEvfImageWidth;
-            mEvfScaleRatioY = mEvfImageCoord.height / mEvfImageHeight;
-            
-            ++mImageIndex %= mImages.size();
-            ++mReadIndex %= mMiddleStreamBuffers.size();
+            mCameraManager.getSession(i)->getPropertyCache().invalidateAll();
         }
     }
+    
+    // replugged cameras come back with their settings, liveview returns to the one that had it
+    std::vector<eds::ReconnectManager::Reconnect> reconnects_ = mReconnectManager.update();
+    
+    for (size_t i = 0; i < reconnects_.size(); ++i)
+    {
+        const eds::ReconnectManager::Reconnect& reconnect_ = reconnects_[i];
+        
+        ofLog() << mCameraManager.getSession(reconnect_.index)->getName() << ": reconnected in " << reconnect_.openMillis << " ms, "
+                << reconnect_.replayed << " of " << reconnect_.snapshotSize << " settings restored in " << reconnect_.replayMillis << " ms";
+        
+        bIsReady = true;
+        
+        if (reconnect_.bLiveview || !bLiveviewStarted)
+        {
+            selectCamera(reconnect_.index);
+        }
+    }
+    
+    // the trigger engine records a shot once every camera sent its shutter command
+    if (mTriggerShots != mTriggerEngine.getShotCount())
+    {
+        mTriggerShots = mTriggerEngine.getShotCount();
+        
+        std::vector<uint64_t> offsets_ = mTriggerEngine.getLastOffsetsMicros();
+        std::string text_;
+        
+        for (size_t i = 0; i < offsets_.size(); ++i)
+        {
+            text_ += " " + ofToString(offsets_[i]);
+        }
+        
+        ofLog() << "trigger skew: " << mTriggerEngine.getLastSkewMicros() << " us, per camera offsets (us):" << text_;
+    }
+    
+    // cancel() only asks, the shutters are closed once no exposure is left running
+    if (bBulbCancelled && !mBulbController.isExposing())
+    {
+        bBulbCancelled = false;
+        ofLog() << "bulb: shutters closed";
+    }
+    
+    // cold start breakdown, once the last phase is done
+    if (!bStartupReported && mStartup.isComplete())
+    {
+        bStartupReported = true;
+        
+        std::vector<eds::PhaseTimer::Phase> phases_ = mStartup.getPhases();
+        
+        ofLog() << "startup: first liveview frame after " << phases_[mStartupFirstFrame].endMillis << " ms";
+        
+        for (size_t i = 0; i < phases_.size(); ++i)
+        {
+            ofLog() << "    " << phases_[i].name << ": " << phases_[i].beginMillis << " - " << phases_[i].endMillis << " ms"
+                    << " (" << phases_[i].endMillis - phases_[i].beginMillis << " ms)";
+        }
+    }
+    
+    eds::CameraSession* session_ = getSelectedSession();
+    
+    if (!bLiveviewStarted || NULL == session_)
+    {
+        return;
+    }
+    
+    // Everything below reuses storage set up in startLiveview(), after warm-up it shouldn't allocate
+    mEvfAllocationProbe.begin();
+    
+    unsigned int updated_ = mEvfDecoder.update(session_->getEvfCapture(), mDecodedFrame);
+    
+    if (updated_ & eds::EvfDecoder::kUpdate_Submitted)
+    {
+        bytesPerFrame = ofLerp(bytesPerFrame, session_->getEvfCapture().front().jpeg.size, 0.01);
+        
+        if (mReconnectManager.markFirstFrame(mSelectedCamera))
+        {
+            ofLog() << session_->getName() << ": first liveview frame " << mReconnectManager.getLastFirstFrameMillis() << " ms after it was plugged back in";
+        }
+    }
+    
+    if (updated_ & eds::EvfDecoder::kUpdate_Decoded)
+    {
+        if (!bStartupReported)
+        {
+            mStartup.end(mStartupFirstFrame);
+        }
+        
+        mEvfImageCoord = mDecodedFrame.coordinateSystem;
+        mEvfZoomRect = mDecodedFrame.zoomRect;
+        
+        const ofPixels& pixels_ = mDecodedFrame.pixels;
+        
+        // only reallocate the texture when the decoded size changes (window resize, DCT scale)
+        if (!mEvfTexture.isAllocated() || pixels_.getWidth() != mEvfTexture.getWidth() || pixels_.getHeight() != mEvfTexture.getHeight())
+        {
+            mEvfTexture.allocate(pixels_);
+        }
+        
+        mEvfTexture.loadData(pixels_);
+        
+        mEvfImageWidth = pixels_.getWidth();
+        mEvfImageHeight = pixels_.getHeight();
+        mEvfScaleRatioX = mEvfImageCoord.width / mEvfImageWidth;
+        mEvfScaleRatioY = mEvfImageCoord.height / mEvfImageHeight;
+        
+        updateFocusRect();
+    }
+    
+    // every pass is a probe frame, a pass without a new frame must not allocate either
+    if (0 < mEvfAllocationProbe.end() && mEvfAllocationProbe.isWarmedUp() && 1 == mEvfAllocationProbe.getFramesWithAllocations())
+    {
+        ofLogWarning() << "liveview frame " << mEvfAllocationProbe.getFirstFrameWithAllocations() << " allocated on the heap after warm-up";
+    }
 }
 
 //--------------------------------------------------------------
 void ofApp::draw()
 {
-    if (!mImages.empty() && mImages.at(mImageIndex).get()->isAllocated())
+    if (mEvfTexture.isAllocated())
     {
-        mImages.at(mImageIndex).get()->draw(0, 0);
+        mEvfTexture.draw(0, 0);
     }
     
     ofPushStyle();
@@ -132,6 +220,20 @@ void ofApp::draw()
         
         ofFill();
         ofCircle(ofGetMouseX(), ofGetMouseY(), 3);
+        
+        // one line per running download, 'x' cancels them
+        float y_ = 20.f;
+        
+        for (unsigned int i = 0; i < mCameraManager.getSessionCount(); ++i)
+        {
+            std::vector<EdsUInt32> progress_ = mCameraManager.getSession(i)->getDownloadManager().getProgress();
+            
+            for (size_t j = 0; j < progress_.size(); ++j)
+            {
+                ofDrawBitmapString("camera #" + ofToString(i) + " download " + ofToString(progress_[j]) + "%", 10.f, y_);
+                y_ += 15.f;
+            }
+        }
     }
     ofPopStyle();
 }
@@ -140,9 +242,20 @@ void ofApp::draw()
 void ofApp::exit()
 {
     finalize();
+    mManifest.close();
     
     EdsSetCameraAddedHandler(NULL, this);
     
+    ofLog() << "SDK events posted: " << mEventBus.getPostedCount()
+            << ", dropped: " << mEventBus.getDroppedCount()
+            << ", overflowed: " << mEventBus.getOverflowCount()
+            << ", callback time average: " << mEventBus.getPostMicrosAverage() << " us"
+            << ", max: " << mEventBus.getPostMicrosMax() << " us"
+            << ", delivery average: " << mEventBus.getDeliveryMillisAverage() << " ms";
+    
+    // queued object events hold references, they have to go before the SDK does
+    mEventBus.clear();
+    
     if (bSdkInitialized)
     {
         EdsTerminateSDK();
@@ -156,31 +269,108 @@ void ofApp::keyPressed(int key)
 {
     if ('0' == key) // set drive mode to single frame
     {
-        setDriveMode(EDS_DRIVE_MODE_SINGLE_FRAME);
+        setProperty<kEdsPropID_DriveMode>(EDS_DRIVE_MODE_SINGLE_FRAME);
     }
     else if ('1' == key) // set drive mode to high-speed continuous shooting
     {
-        setDriveMode(EDS_DRIVE_MODE_HIGH_SPEED_CONTINUOUS_SHOOTING);
+        setProperty<kEdsPropID_DriveMode>(EDS_DRIVE_MODE_HIGH_SPEED_CONTINUOUS_SHOOTING);
     }
-    else if ('2' == key)
+    else if ('2' == key) // still profile, only what differs is sent
     {
-        
+        applyProfile(mStillProfile);
     }
-    else if ('3' == key)
+    else if ('3' == key) // action profile
     {
+        applyProfile(mActionProfile);
     }
     else if ('4' == key)
     {
 
+    }
+    else if ('t' == key) // half-press every camera so the next shot only has to release them
+    {
+        if (mTriggerEngine.isArmed())
+        {
+            mTriggerEngine.disarm();
+        }
+        else
+        {
+            ofLog() << "trigger armed on " << mTriggerEngine.arm() << " cameras";
+        }
+    }
+    else if ('c' == key) // next camera of the rig in liveview
+    {
+        selectCamera(mSelectedCamera + 1);
     }
     else if (' ' == key) // take photo
     {
         takePhoto();
     }
-    else if ('b' == key)
+    else if ('x' == key) // cancel the running downloads, the images stay on the card
+    {
+        unsigned int cancelled_ = 0;
+        
+        for (unsigned int i = 0; i < mCameraManager.getSessionCount(); ++i)
+        {
+            cancelled_ += mCameraManager.getSession(i)->getDownloadManager().cancel();
+        }
+        
+        ofLog() << "cancelled " << cancelled_ << " running downloads";
+    }
+    else if ('b' == key) // timed bulb exposure, or close the shutters early
+    {
+        if (mBulbController.isExposing())
+        {
+            mBulbController.cancel();
+            bBulbCancelled = true;
+            ofLog() << "bulb: closing the shutters";
+        }
+        else
+        {
+            ofLog() << "bulb: " << mBulbMillis << " ms on " << mBulbController.expose(mBulbMillis) << " cameras";
+        }
+    }
+    else if ('[' == key) // halve the bulb time
+    {
+        mBulbMillis = std::max(1.0, mBulbMillis * 0.5);
+        ofLog() << "bulb time: " << mBulbMillis << " ms";
+    }
+    else if (']' == key) // double the bulb time
     {
-        bExecuteBulbShooting = true;
-        pressShutterButton();
+        mBulbMillis *= 2.0;
+        ofLog() << "bulb time: " << mBulbMillis << " ms";
+    }
+    else if ('l' == key || 'L' == key) // timelapse, 'l' skips a frame due while a download is in flight, 'L' takes it late
+    {
+        if (mIntervalometer.isRunning())
+        {
+            mIntervalometer.stop();
+            ofLog() << "timelapse stopped after " << mIntervalometer.getFiredCount() << " frames";
+        }
+        else
+        {
+            eds::Intervalometer::Settings settings_;
+            settings_.intervalMillis = mTimelapseMillis;
+            settings_.policy = 'l' == key ? eds::kIntervalPolicy_Skip : eds::kIntervalPolicy_Queue;
+            settings_.fire = [this]() { takePhoto(); };
+            settings_.busy = [this]() { return 0 < mCameraManager.getInFlightCount() || 0 < mPendingDownloadCount; };
+            settings_.keepAlive = [this]() { extendShutDownTimer(); };
+            
+            if (mIntervalometer.start(settings_))
+            {
+                ofLog() << "timelapse: every " << mTimelapseMillis << " ms";
+            }
+        }
+    }
+    else if (',' == key) // halve the timelapse interval, from the next start
+    {
+        mTimelapseMillis = std::max(100.0, mTimelapseMillis * 0.5);
+        ofLog() << "timelapse interval: " << mTimelapseMillis << " ms";
+    }
+    else if ('.' == key) // double the timelapse interval
+    {
+        mTimelapseMillis *= 2.0;
+        ofLog() << "timelapse interval: " << mTimelapseMillis << " ms";
     }
     else if (OF_KEY_UP == key)
     {
@@ -192,8 +382,9 @@ void ofApp::keyPressed(int key)
     }
     else if ('i' == key)
     {
-        setIsoSpeed(ISOSpeeds[enumIndex]);
-        ++enumIndex %= (sizeof(ISOSpeeds) / sizeof(ISOSpeeds[0]));
+        const eds::PropertyValues& isoSpeeds_ = eds::PropertyTraits<kEdsPropID_ISOSpeed>::getDescriptor().values;
+        setProperty<kEdsPropID_ISOSpeed>(isoSpeeds_[enumIndex]);
+        ++enumIndex %= isoSpeeds_.count;
     }
     else if ('h' == key)
     {
@@ -233,12 +424,7 @@ void ofApp::keyPressed(int key)
 //--------------------------------------------------------------
 void ofApp::keyReleased(int key)
 {
-    if ('b' == key)
-    {
-        bExecuteBulbShooting = false;
-        releaseShutterButton();
-    }
-    else if ('h' == key)
+    if ('h' == key)
     {
         releaseShutterButton();
     }
@@ -272,7 +458,7 @@ void ofApp::mouseReleased(int x, int y, int button)
 //--------------------------------------------------------------
 void ofApp::windowResized(int w, int h)
 {
-
+    mEvfDecoder.setTargetSize(w, h);
 }
 
 //--------------------------------------------------------------
@@ -287,17 +473,111 @@ void ofApp::dragEvent(ofDragInfo dragInfo)
 
 }
 
+//--------------------------------------------------------------
+void ofApp::subscribeEvents()
+{
+    mEventBus.subscribe(eds::kEventType_CameraAdded, [this](const eds::Event&)
+    {
+        ofLogVerbose() << "camera added";
+        
+        // a body that dropped out is reopened in the background, the rest of the rig keeps running
+        if (!mReconnectManager.reconnect() && !bIsReady)
+        {
+            initialize();
+        }
+    });
+    
+    // every other event is routed to the session of the camera that sent it
+    mEventBus.subscribe(eds::kEventType_Object, kEdsObjectEvent_DirItemCreated, [this](const eds::Event& event_)
+    {
+        eds::CameraSession* session_ = mCameraManager.getSession(event_.camera);
+        
+        if (session_)
+        {
+            ofLogVerbose() << session_->getName() << ": dir item created";
+            downloadImage(*session_, event_.object);
+        }
+    });
+    
+    // the only place cached values are dropped, the next read fetches the new value
+    mEventBus.subscribe(eds::kEventType_Property, [this](const eds::Event& event_)
+    {
+        eds::CameraSession* session_ = mCameraManager.getSession(event_.camera);
+        
+        if (session_ && kEdsPropertyEvent_PropertyChanged == event_.event)
+        {
+            session_->getPropertyCache().invalidate(event_.code);
+        }
+    });
+    
+    mEventBus.subscribe(eds::kEventType_Property, kEdsPropID_ImageQuality, [this](const eds::Event& event_)
+    {
+        eds::CameraSession* session_ = mCameraManager.getSession(event_.camera);
+        EdsUInt32 prop_ = 0;
+        
+        if (session_ && EDS_ERR_OK == session_->getPropertyCache().get<kEdsPropID_ImageQuality>(prop_))
+        {
+            ofLogVerbose() << session_->getName() << ": image quality changed: " << ofToHex(prop_);
+        }
+    });
+    
+    mEventBus.subscribe(eds::kEventType_Property, kEdsPropID_AvailableShots, [](const eds::Event& event_)
+    {
+        ofLogVerbose() << "camera #" << event_.camera << ": available shots: " << event_.param;
+    });
+    
+    mEventBus.subscribe(eds::kEventType_State, kEdsStateEvent_WillSoonShutDown, [this](const eds::Event& event_)
+    {
+        eds::CameraSession* session_ = mCameraManager.getSession(event_.camera);
+        
+        if (session_)
+        {
+            ofLogVerbose() << session_->getName() << ": will soon shutdown";
+            session_->sendCommand(eds::kCommandClass_Property, kEdsCameraCommand_ExtendShutDownTimer, 0);
+        }
+    });
+    
+    mEventBus.subscribe(eds::kEventType_State, kEdsStateEvent_Shutdown, [this](const eds::Event& event_)
+    {
+        ofLogVerbose() << "camera #" << event_.camera << ": shutdown";
+        
+        bool selected_ = bLiveviewStarted && event_.camera == mSelectedCamera;
+        
+        if (selected_)
+        {
+            endLiveview();
+        }
+        
+        // keeps what the cache knew about the camera for when it's plugged back in
+        mReconnectManager.drop(event_.camera, selected_);
+        bIsReady = (0 < mCameraManager.getOpenCount());
+        
+        // liveview moves on to the next camera still connected
+        if (selected_ && bIsReady)
+        {
+            selectCamera(event_.camera + 1);
+        }
+    });
+}
+
 //--------------------------------------------------------------
 void ofApp::initialize()
 {
-    std::cout << "initialize" << std::endl;
+    ofLogVerbose() << "initialize";
     
     EdsError error_ = EDS_ERR_OK;
     
+    // Only the SDK, the sessions and liveview have to come one after the other,
+    // everything else overlaps with them. Each phase is timed from here.
+    mStartup.reset();
+    bStartupReported = true;
+    
     // initialize SDK
     if (!bSdkInitialized)
     {
+        size_t phase_ = mStartup.begin("SDK");
         error_ = EdsInitializeSDK();
+        mStartup.end(phase_);
         
         if (EDS_ERR_OK == error_)
         {
@@ -305,139 +585,251 @@ void ofApp::initialize()
         }
         else
         {
-            std::cout << "couldn't initilize SDK, exit" << std::endl;
+            ofLogError() << "couldn't initialize SDK, exit";
             std::exit(-1);
         }
     }
     
-    // Get first camera
-    if (EDS_ERR_OK == error_)
+    // everything read regularly is cached from here on, the property events keep it current
+    const EdsPropertyID properties_[] =
     {
-        std::cout << "getFirstCamera" << std::endl;
-        error_ = getFirstCamera(&mCamera);
-        
-        if (EDS_ERR_DEVICE_NOT_FOUND == error_)
-        {
-            std::cout << std::hex << "device not found" << std::endl;
-            EdsSetCameraAddedHandler(onCameraAdded, this);
-            return;
-        }
-    }
+        kEdsPropID_SaveTo,
+        kEdsPropID_ImageQuality,
+        kEdsPropID_AEModeSelect,
+        kEdsPropID_DriveMode,
+        kEdsPropID_ISOSpeed,
+        kEdsPropID_Av,
+        kEdsPropID_Tv,
+        kEdsPropID_AvailableShots,
+        kEdsPropID_Evf_OutputDevice,
+        kEdsPropID_Evf_Zoom
+    };
+    
+    eds::CameraSession::Settings settings_;
+    settings_.prefetch.assign(properties_, properties_ + sizeof(properties_) / sizeof(properties_[0]));
+    
+    // stream downloads straight to their files, only one chunk per worker stays in memory
+    settings_.writer = &mPersistWriter;
+    settings_.path = [this](eds::CameraSession& session_, const EdsDirectoryItemInfo& info_) { return getCapturePath(session_, info_); };
+    settings_.persist = [this](eds::CameraSession& session_, const eds::Download& download_) { return persistImage(session_, download_); };
+    
+    // FreeImage and the decode workers come up while the cameras open
+    size_t decoder_ = mStartup.begin("decoder warm-up");
+    std::thread warmUp_([this, decoder_]() { mEvfDecoder.start(); mStartup.end(decoder_); });
+    
+    // Open a session on every connected camera, in parallel. Dropped cameras belong to the sessions that go away.
+    mIntervalometer.stop();
+    mReconnectManager.stop();
+    
+    size_t open_ = mStartup.begin("open sessions");
+    error_ = mCameraManager.open(settings_);
+    mStartup.end(open_);
     
-    // Set object event handler
-    if (EDS_ERR_OK == error_)
+    warmUp_.join();
+    
+    if (EDS_ERR_DEVICE_NOT_FOUND == error_)
     {
-        std::cout << "set object event handler" << std::endl;
-        error_ = EdsSetObjectEventHandler(mCamera, kEdsObjectEvent_All, onObjectEvent, this);
-        std::cout << std::hex << "error: " << error_ << std::endl;
+        mEvfDecoder.stop();
+        ofLogNotice() << "device not found, waiting for a camera";
+        EdsSetCameraAddedHandler(onCameraAdded, this);
+        return;
     }
     
-    // Set property event handler
-    if (EDS_ERR_OK == error_)
+    ofLog() << "opened " << mCameraManager.getOpenCount() << " of " << mCameraManager.getSessionCount() << " cameras"
+            << " in " << mCameraManager.getOpenMillis() << " ms (slowest " << mCameraManager.getSlowestOpenMillis() << " ms)";
+    
+    for (unsigned int i = 0; i < mCameraManager.getSessionCount(); ++i)
     {
-        std::cout << "set prop event handler" << std::endl;
-        error_ = EdsSetPropertyEventHandler(mCamera, kEdsPropertyEvent_All, onPropertyEvent, this);
-        std::cout << std::hex << "error: " << error_ << std::endl;
+        eds::CameraSession* session_ = mCameraManager.getSession(i);
+        
+        if (session_->isOpen())
+        {
+            ofLog() << session_->getName() << ", serial " << session_->getSerialNumber() << ": opened in " << session_->getOpenMillis() << " ms";
+        }
     }
     
-    // Set state event handler
-    if (EDS_ERR_OK == error_)
+    if (0 == mCameraManager.getOpenCount())
     {
-        std::cout << "set state event handler" << std::endl;
-        error_ = EdsSetCameraStateEventHandler(mCamera, kEdsStateEvent_All, onStateEvent, this);
-        std::cout << std::hex << "error: " << error_ << std::endl;
+        mEvfDecoder.stop();
+        return;
     }
     
-    // Open session with found camera
-    if (EDS_ERR_OK == error_)
+    // Queued behind the prefetch on every command thread, they go out while liveview negotiates.
+    // The phase ends when the last camera got to its marker.
+    size_t writes_ = mStartup.begin("prefetch and property writes", (unsigned int)mCameraManager.getOpenCount());
+    
+    setProperty<kEdsPropID_ImageQuality>(EdsImageQuality_S2JF);
+    extendShutDownTimer();
+    
+    for (unsigned int i = 0; i < mCameraManager.getSessionCount(); ++i)
     {
-        error_ = EdsOpenSession(mCamera);
+        eds::CameraSession* session_ = mCameraManager.getSession(i);
         
-        if (EDS_ERR_OK == error_)
+        if (session_->isOpen())
         {
-            std::cout << "session opened" << std::endl;
-            bSessionOpened = true;
-            setImageQuality(EdsImageQuality_S2JF);
-            extendShutDownTimer();
-            startLiveview();
-            updateFocusRect();
-            bIsReady = true;
+            session_->getCommandExecutor().post(eds::kCommandClass_Property, [this, writes_]() { mStartup.end(writes_); return EDS_ERR_OK; });
         }
-        
-        std::cout << std::hex << "bSessionOpened: " << bSessionOpened << std::endl;
     }
+    
+    // liveview shows one camera at a time, 'c' steps through the rig
+    size_t liveview_ = mStartup.begin("liveview start");
+    mSelectedCamera = mCameraManager.getSessionCount();
+    selectCamera(0);
+    mStartup.end(liveview_);
+    
+    mStartupFirstFrame = mStartup.begin("first frame");
+    bStartupReported = !bLiveviewStarted;
+    bIsReady = true;
 }
 
 //--------------------------------------------------------------
 void ofApp::finalize()
 {
-    EdsSetObjectEventHandler(mCamera, kEdsObjectEvent_All, NULL, this);
-    EdsSetPropertyEventHandler(mCamera, kEdsPropertyEvent_All, NULL, this);
-    EdsSetCameraStateEventHandler(mCamera, kEdsStateEvent_All, NULL, this);
+    // a reconnect still running would reopen a session behind close(), a bulb exposure would keep its shutter open.
+    // close() drains the command executors, so the cancelled exposures release before the sessions go.
+    mIntervalometer.stop();
+    mReconnectManager.stop();
+    mBulbController.cancel();
     
     if (bLiveviewStarted)
     {
         endLiveview();
     }
     
-    if (bSessionOpened)
+    // every session finishes its queued commands and downloads before it closes, waiting for a slot is fine here
+    flushPendingDownloads(true);
+    mCameraManager.close();
+    
+    for (unsigned int i = 0; i < mCameraManager.getSessionCount(); ++i)
     {
-        EdsCloseSession(mCamera);
+        eds::CameraSession* session_ = mCameraManager.getSession(i);
+        eds::CommandExecutor& executor_ = session_->getCommandExecutor();
+        eds::DownloadManager& downloads_ = session_->getDownloadManager();
+        eds::PropertyCache& cache_ = session_->getPropertyCache();
+        
+        for (auto j = 0; j < eds::kCommandClass_Count; ++j)
+        {
+            eds::CommandClass class_ = (eds::CommandClass)j;
+            
+            ofLog() << session_->getName() << ": " << eds::CommandExecutor::getClassName(class_) << " commands: " << executor_.getExecutedCount(class_)
+                    << ", failed: " << executor_.getFailedCount(class_)
+                    << ", coalesced: " << executor_.getCoalescedCount(class_)
+                    << ", queue latency average: " << executor_.getLatencyMillisAverage(class_) << " ms"
+                    << ", max: " << executor_.getLatencyMillisMax(class_) << " ms";
+        }
+        
+        ofLog() << session_->getName() << ": downloads completed: " << downloads_.getCompletedCount()
+                << ", failed: " << downloads_.getFailedCount()
+                << ", cancelled: " << downloads_.getCancelledCount()
+                << ", queue high water mark: " << downloads_.getQueueHighWaterMark() << "/" << downloads_.getCapacity()
+                << ", callback blocked: " << downloads_.getBlockedCount();
+        ofLog() << session_->getName() << ": download average queued: " << downloads_.getQueuedMillisAverage() << " ms"
+                << ", transfer: " << downloads_.getTransferMillisAverage() << " ms"
+                << " (" << downloads_.getTransferMegabytesPerSecond() << " MB/s)"
+                << ", persist: " << downloads_.getPersistMillisAverage() << " ms"
+                << ", hash: " << downloads_.getHashMillisAverage() << " ms"
+                << " (" << (int)(downloads_.getHashOverhead() * 100.0) << "% of transfer)";
+        ofLog() << session_->getName() << ": property cache hits: " << cache_.getHitCount()
+                << ", misses: " << cache_.getMissCount()
+                << ", SDK calls: " << cache_.getSdkCallCount();
     }
     
-    if (NULL != mCamera)
+    if (0 < mCameraManager.getSessionCount())
     {
-        EdsRelease(mCamera);
+        mPersistWriter.flush();
+        
+        ofLog() << "saved files: " << mPersistWriter.getFileCount()
+                << ", average: " << mPersistWriter.getMillisAverage() << " ms"
+                << ", " << mPersistWriter.getMegabytesPerSecond() << " MB/s";
+        std::vector<uint64_t> histogram_ = mTriggerEngine.getSkewHistogram();
+        std::string buckets_;
+        
+        for (size_t i = 0; i < histogram_.size(); ++i)
+        {
+            buckets_ += (i < eds::TriggerEngine::kBucketCount - 1 ? " <=" + ofToString(eds::TriggerEngine::kBucketLimits[i]) : " >" + ofToString(eds::TriggerEngine::kBucketLimits[i - 1])) + "us: " + ofToString(histogram_[i]);
+        }
+        
+        ofLog() << "trigger shots: " << mTriggerEngine.getShotCount()
+                << ", barrier timeouts: " << mTriggerEngine.getBarrierTimeoutCount()
+                << ", skew average: " << mTriggerEngine.getSkewMicrosAverage() << " us"
+                << ", max: " << mTriggerEngine.getSkewMicrosMax() << " us";
+        ofLog() << "trigger skew histogram:" << buckets_;
+        ofLog() << "bulb exposures: " << mBulbController.getExposureCount()
+                << ", last: " << mBulbController.getLastAchievedMillis() << " of " << mBulbController.getLastRequestedMillis() << " ms"
+                << ", error average: " << mBulbController.getErrorMicrosAverage() << " us"
+                << ", max: " << mBulbController.getErrorMicrosMax() << " us";
+        ofLog() << "timelapse frames: " << mIntervalometer.getFiredCount()
+                << ", skipped: " << mIntervalometer.getSkippedCount()
+                << ", queued: " << mIntervalometer.getQueuedCount()
+                << ", keep-alives: " << mIntervalometer.getKeepAliveCount()
+                << ", jitter average: " << mIntervalometer.getJitterMicrosAverage() << " us"
+                << ", std dev: " << mIntervalometer.getJitterMicrosStdDev() << " us"
+                << ", max: " << mIntervalometer.getJitterMicrosMax() << " us";
+        ofLog() << "reconnects: " << mReconnectManager.getReconnectCount()
+                << ", settings restored: " << mReconnectManager.getReplayedCount()
+                << ", unknown cameras: " << mReconnectManager.getUnknownCount()
+                << ", time to first frame average: " << mReconnectManager.getFirstFrameMillisAverage() << " ms"
+                << ", max: " << mReconnectManager.getFirstFrameMillisMax() << " ms";
+        ofLog() << "rig of " << mCameraManager.getSessionCount() << " cameras: " << mCameraManager.getCompletedCount() << " downloads"
+                << ", " << mCameraManager.getFailedCount() << " failed"
+                << ", " << mCameraManager.getCommandCount() << " commands"
+                << ", " << mCameraManager.getMegabytesPerSecond() << " MB/s since open";
     }
     
     bIsReady = false;
 }
 
 //--------------------------------------------------------------
-EdsError ofApp::getFirstCamera(EdsCameraRef *camera)
+eds::CameraSession* ofApp::getSelectedSession() const
 {
-    EdsError error_ = EDS_ERR_OK;
-    EdsCameraListRef cameraList_ = NULL;
-    EdsUInt32 count_ = 0;
-    
-    // Get camera list
-    error_ = EdsGetCameraList(&cameraList_);
+    eds::CameraSession* session_ = mCameraManager.getSession(mSelectedCamera);
+    return session_ && session_->isOpen() ? session_ : NULL;
+}
+
+//--------------------------------------------------------------
+void ofApp::selectCamera(unsigned int index)
+{
+    size_t count_ = mCameraManager.getSessionCount();
     
-    // Get number of cameras
-    if (EDS_ERR_OK == error_)
+    // the next open session from index on, wrapping around
+    for (size_t i = 0; i < count_; ++i)
     {
-        error_ = EdsGetChildCount(cameraList_, &count_);
-        if (0 == count_)
+        unsigned int candidate_ = (index + i) % count_;
+        eds::CameraSession* session_ = mCameraManager.getSession(candidate_);
+        
+        if (!session_->isOpen())
         {
-            error_ = EDS_ERR_DEVICE_NOT_FOUND;
+            continue;
         }
+        
+        if (candidate_ == mSelectedCamera && bLiveviewStarted)
+        {
+            return;
+        }
+        
+        if (bLiveviewStarted)
+        {
+            endLiveview();
+        }
+        
+        mSelectedCamera = candidate_;
+        ofLog() << "liveview: " << session_->getName();
+        
+        startLiveview();
+        updateFocusRect();
+        return;
     }
-    
-    // Get first camera retrieved
-    if (EDS_ERR_OK == error_)
-    {
-        error_ = EdsGetChildAtIndex(cameraList_, 0, camera);
-    }
-    
-    // Release camera list
-    if (NULL != cameraList_)
-    {
-        EdsRelease(cameraList_);
-        cameraList_ = NULL;
-    }
-    
-    return error_;
 }
 
 //--------------------------------------------------------------
 EdsUInt32 ofApp::getPropertyData(EdsPropertyID property, EdsUInt32 inParam)
 {
-    EdsUInt32 value_;
-    EdsError error_ = EdsGetPropertyData(mCamera, property, inParam, sizeof(value_), &value_);
+    eds::CameraSession* session_ = getSelectedSession();
+    EdsUInt32 value_ = 0;
     
-    if (EDS_ERR_OK == error_)
+    if (session_ && EDS_ERR_OK == session_->getPropertyCache().get(property, value_, inParam))
     {
-        std::cout << std::hex << "property: " << property << ", value: " << value_ << std::endl;
+        ofLogVerbose() << "property: " << ofToHex(property) << ", value: " << ofToHex(value_);
     }
     
     return value_;
@@ -446,10 +838,12 @@ EdsUInt32 ofApp::getPropertyData(EdsPropertyID property, EdsUInt32 inParam)
 //--------------------------------------------------------------
 void ofApp::updateFocusRect()
 {
+    eds::CameraSession* session_ = getSelectedSession();
+    
+    // called every liveview frame, only goes to the camera after a FocusInfo change event
     EdsFocusInfo info_;
-    EdsError error_ = EdsGetPropertyData(mCamera, kEdsPropID_FocusInfo, 0, sizeof(info_), &info_);
     
-    if (EDS_ERR_OK == error_)
+    if (session_ && EDS_ERR_OK == session_->getPropertyCache().get<kEdsPropID_FocusInfo>(info_))
     {
         auto ratioX_ = mEvfImageWidth / mEvfImageCoord.width;
         auto ratioY_ = mEvfImageHeight / mEvfImageCoord.height;
@@ -466,53 +860,40 @@ void ofApp::updateFocusRect()
 #pragma mark - Property setters
 
 //--------------------------------------------------------------
-void ofApp::setSaveTo(EdsUInt32 value)
-{
-    EdsSetPropertyData(mCamera, kEdsPropID_SaveTo, 0, sizeof(value), &value);
-}
-
-//--------------------------------------------------------------
-void ofApp::setAEMode(EdsUInt32 value)
-{
-    EdsSetPropertyData(mCamera, kEdsPropID_AEModeSelect, 0, sizeof(value), &value);
-}
-
-//--------------------------------------------------------------
-void ofApp::setDriveMode(EdsUInt32 value)
+void ofApp::applyProfile(const eds::PropertyProfile& profile)
 {
-    EdsSetPropertyData(mCamera, kEdsPropID_DriveMode, 0, sizeof(value), &value);
-}
-
-//--------------------------------------------------------------
-void ofApp::setIsoSpeed(EdsUInt32 value)
-{
-    EdsSetPropertyData(mCamera, kEdsPropID_ISOSpeed, 0, sizeof(value), &value);
-}
-
-//--------------------------------------------------------------
-void ofApp::setEvfZoom(EdsUInt32 value)
-{
-    EdsSetPropertyData(mCamera, kEdsPropID_Evf_Zoom, 0, sizeof(value), &value);
-}
-
-//--------------------------------------------------------------
-void ofApp::setImageQuality(EdsUInt32 value)
-{
-    EdsSetPropertyData(mCamera, kEdsPropID_ImageQuality, 0, sizeof(value), &value);
+    for (unsigned int i = 0; i < mCameraManager.getSessionCount(); ++i)
+    {
+        eds::CameraSession* session_ = mCameraManager.getSession(i);
+        
+        if (!session_->isOpen())
+        {
+            continue;
+        }
+        
+        session_->getCommandExecutor().post(eds::kCommandClass_Property, [session_, profile]()
+        {
+            auto start_ = ofGetElapsedTimeMicros();
+            size_t sent_ = 0;
+            EdsError error_ = session_->getPropertyCache().apply(profile, &sent_);
+            
+            ofLog() << session_->getName() << ": profile applied: " << sent_ << " of " << profile.getEntries().size() << " values sent in "
+                    << (ofGetElapsedTimeMicros() - start_) / 1000.f << " ms, " << session_->getPropertyCache().getSkippedWriteCount() << " writes skipped so far";
+            
+            return error_;
+        });
+    }
 }
 
 //--------------------------------------------------------------
 void ofApp::setZoomPosition(EdsPoint &position)
 {
-    EdsError error_ = EdsSetPropertyData(mCamera, kEdsPropID_Evf_ZoomPosition, 0, sizeof(position), &position);
+    eds::CameraSession* session_ = getSelectedSession();
     
-    if (EDS_ERR_OK == error_)
-    {
-        updateFocusRect();
-    }
-    else
+    // the focus rect follows through the FocusInfo change event and update(), no read back here
+    if (session_)
     {
-        std::cout << std::hex << "error occured at setZoomPosition(): " << error_ << std::endl;
+        session_->setProperty<kEdsPropID_Evf_ZoomPosition>(position);
     }
 }
 
@@ -521,367 +902,323 @@ void ofApp::setZoomPosition(EdsPoint &position)
 //--------------------------------------------------------------
 void ofApp::extendShutDownTimer()
 {
-    if (!bSessionOpened)
-    {
-        return;
-    }
-    
-    EdsSendCommand(mCamera, kEdsCameraCommand_ExtendShutDownTimer, 0);
+    sendCommand(eds::kCommandClass_Property, kEdsCameraCommand_ExtendShutDownTimer, 0);
 }
 
 //--------------------------------------------------------------
 void ofApp::takePhoto()
 {
-    EdsSendCommand(mCamera, kEdsCameraCommand_TakePicture, 0);
+    // the whole rig fires together, released from each camera's command thread at once
+    mTriggerEngine.fire();
 }
 
 //--------------------------------------------------------------
 void ofApp::pressShutterButton(bool halfway)
 {
-    if (halfway)
-    {
-        EdsSendCommand(mCamera, kEdsCameraCommand_PressShutterButton, kEdsCameraCommand_ShutterButton_Halfway);
-    }
-    else
-    {
-        EdsSendCommand(mCamera, kEdsCameraCommand_PressShutterButton, kEdsCameraCommand_ShutterButton_Completely);
-    }
-    
-    std::cout << std::hex << "press shutter button" << std::endl;
+    sendCommand(eds::kCommandClass_Shutter, kEdsCameraCommand_PressShutterButton, halfway ? kEdsCameraCommand_ShutterButton_Halfway : kEdsCameraCommand_ShutterButton_Completely);
+    ofLogVerbose() << "press shutter button";
 }
 
 //--------------------------------------------------------------
 void ofApp::releaseShutterButton()
 {
-    EdsSendCommand(mCamera, kEdsCameraCommand_PressShutterButton, kEdsCameraCommand_ShutterButton_OFF);
-    std::cout << std::hex << "release shutter button" << std::endl;
+    sendCommand(eds::kCommandClass_Shutter, kEdsCameraCommand_PressShutterButton, kEdsCameraCommand_ShutterButton_OFF);
+    ofLogVerbose() << "release shutter button";
 }
 
 //--------------------------------------------------------------
 void ofApp::doEvfAutoFocus(EdsEvfAFMode mode)
 {
-    EdsSendCommand(mCamera, kEdsCameraCommand_DoEvfAf, mode);
+    eds::CameraSession* session_ = getSelectedSession();
+    
+    // only the latest AF request matters
+    if (session_)
+    {
+        session_->sendCommand(eds::kCommandClass_Lens, kEdsCameraCommand_DoEvfAf, mode, kEdsCameraCommand_DoEvfAf);
+    }
 }
 
 //--------------------------------------------------------------
 void ofApp::driveLensEvf(EdsEvfDriveLens value)
 {
-    EdsSendCommand(mCamera, kEdsCameraCommand_DriveLensEvf, value);
+    eds::CameraSession* session_ = getSelectedSession();
+    
+    if (session_)
+    {
+        session_->sendCommand(eds::kCommandClass_Lens, kEdsCameraCommand_DriveLensEvf, value);
+    }
 }
 
 //--------------------------------------------------------------
-void ofApp::downloadImage(EdsDirectoryItemRef itemRef)
+void ofApp::sendCommand(eds::CommandClass commandClass, EdsCameraCommand command, EdsInt32 param)
 {
-    std::cout << "start downloading image" << std::endl;
-    
-    EdsError error_ = EDS_ERR_OK;
-    EdsStreamRef stream_ = NULL;
-    
-    EdsDirectoryItemInfo itemInfo_;
-    error_ = EdsGetDirectoryItemInfo(itemRef, &itemInfo_);
-    
-    std::cout << std::hex << "EdsGetDirectoryItemInfo: " << error_ << std::endl;
-    
-    if (EDS_ERR_OK == error_)
-    {
-        error_ = EdsCreateMemoryStream(0, &stream_);
-        std::cout << std::hex << "EdsCreateMemoryStream: " << error_ << std::endl;
-    }
-    
-    if (EDS_ERR_OK == error_)
-    {
-        error_ = EdsDownload(itemRef, itemInfo_.size, stream_);
-        std::cout << std::hex << "EdsDownload: " << error_ << std::endl;
-    }
-    
-    if (EDS_ERR_OK == error_)
+    for (unsigned int i = 0; i < mCameraManager.getSessionCount(); ++i)
     {
-        error_ = EdsDownloadComplete(itemRef);
-        std::cout << std::hex << "EdsDownloadComplete: " << error_ << std::endl;
-    }
-    
-    if (NULL != stream_)
-    {
-        EdsUInt32 length_;
-        EdsGetLength(stream_, &length_);
-        
-        char* streamPtr_;
-        EdsGetPointer(stream_, (EdsVoid**)&streamPtr_);
-        mDownloadImageBuffer.set(streamPtr_, length_);
-        ofLog() << "downloaded item: " << (int) (mDownloadImageBuffer.size() / 1024) << " KB";
-        ofLog() << itemInfo_.format;
+        eds::CameraSession* session_ = mCameraManager.getSession(i);
         
-        if (14337 == itemInfo_.format)
+        if (session_->isOpen())
         {
-            ofLog() << "load complete";
-            
-            ofBuffer buf_;
-            buf_.set(mDownloadImageBuffer.getBinaryBuffer(), mDownloadImageBuffer.size());
-            
-            ofPixels pix_;
-            ofLog() << ofLoadImage(pix_, buf_);
-//            pix_.rotate90(orientationMode);
-            
-            ofImage img_(pix_);
-            img_.saveImage(ofToDataPath(ofGetTimestampString() + ".jpg"));
+            session_->sendCommand(commandClass, command, param);
         }
-        
-        EdsDeleteDirectoryItem(itemRef);
-        
-        EdsRelease(stream_);
-        stream_ = NULL;
     }
 }
 
-
-#pragma mark - Liveview
-
 //--------------------------------------------------------------
-EdsError ofApp::startLiveview()
+void ofApp::downloadImage(eds::CameraSession& session, EdsDirectoryItemRef itemRef)
 {
-    if (!bSessionOpened)
+    // Only retains the item, the transfer runs on the session's download workers. A full queue
+    // would block this thread, so the item waits in mPendingDownloads until a slot frees up.
+    if (mPendingDownloads.empty() && session.getDownloadManager().tryEnqueue(itemRef))
     {
+        ofLogVerbose() << session.getName() << ": queued image download";
         return;
     }
     
-    EdsError error_ = EDS_ERR_OK;
-    
-    EdsUInt32 device_;
-    error_ = EdsGetPropertyData(mCamera, kEdsPropID_Evf_OutputDevice, 0, sizeof(device_), &device_);
-    
-    std::cout << "current output device: " << device_ << std::endl;
+    if (!session.getDownloadManager().isRunning())
+    {
+        ofLogError() << "download manager is not running";
+        return;
+    }
     
-    if (EDS_ERR_OK == error_)
+    // the bus releases its reference after this handler
+    EdsRetain(itemRef);
+    mPendingDownloads.push_back(std::make_pair(session.getIndex(), itemRef));
+    mPendingDownloadCount = mPendingDownloads.size();
+}
+
+//--------------------------------------------------------------
+void ofApp::flushPendingDownloads(bool wait)
+{
+    // in arrival order, a camera whose queue is still full holds the ones behind it
+    while (!mPendingDownloads.empty())
     {
-        device_ |= kEdsEvfOutputDevice_PC;
-        error_ = EdsSetPropertyData(mCamera, kEdsPropID_Evf_OutputDevice, 0, sizeof(device_), &device_);
+        eds::CameraSession* session_ = mCameraManager.getSession(mPendingDownloads.front().first);
+        EdsDirectoryItemRef itemRef_ = mPendingDownloads.front().second;
         
-        if (EDS_ERR_OK == error_)
+        if (NULL == session_ || !session_->getDownloadManager().isRunning())
         {
-            bLiveviewStarted = true;
-            
-            mFrontStreamBuffer = new eds::Buffer();
-            mBackStreamBuffer = new eds::Buffer();
-            
-            for (auto i = 0; i < 2; ++i)
-            {
-                mMiddleStreamBuffers.push_back(new eds::Buffer());
-            }
-            
-            mReadIndex = 0;
-            mWriteIndex = 0;
-            
-            mImages.push_back(ofPtr<ofImage>(new ofImage()));
-            mImages.push_back(ofPtr<ofImage>(new ofImage()));
-            mImageIndex = 0;
+            ofLogError() << "camera #" << mPendingDownloads.front().first << " closed before its download could be queued";
+        }
+        else if (!(wait ? session_->getDownloadManager().enqueue(itemRef_) : session_->getDownloadManager().tryEnqueue(itemRef_)))
+        {
+            break;
         }
+        
+        EdsRelease(itemRef_);
+        mPendingDownloads.pop_front();
     }
+    
+    mPendingDownloadCount = mPendingDownloads.size();
 }
 
 //--------------------------------------------------------------
-EdsError ofApp::downloadEvfData()
+bool ofApp::persistImage(eds::CameraSession& session, const eds::Download& download)
 {
-    if (!bLiveviewStarted)
-    {
-        return;
-    }
+    // Called on a download worker of the camera's session
+    ofLog() << session.getName() << ": downloaded item: " << (int) (download.info.size / 1024) << " KB";
     
-    EdsError error_ = EDS_ERR_OK;
-    
-    EdsStreamRef stream_ = NULL;
-    EdsEvfImageRef evfImage_ = NULL;
+    eds::BufferSlice image_ = download.data;
+    std::string path_ = download.path;
+    double writeMillis_ = download.writeMillis;
     
-    // Create memory stream
-    error_ = EdsCreateMemoryStream(0, &stream_);
-    
-    // Create EvfImageRef
-    if (EDS_ERR_OK == error_)
+    if (!path_.empty())
     {
-        error_ = EdsCreateEvfImageRef(stream_, &evfImage_);
-    }
-    
-    // Download live view image data
-    if (EDS_ERR_OK == error_)
-    {
-        error_ = EdsDownloadEvfImage(mCamera, evfImage_);
+        // streamed, already on disk. Map it so a preview can still be decoded without reading it into memory
+        eds::Buffer mapped_;
+        
+        if (mapped_.map(download.path))
+        {
+            image_ = eds::BufferSlice(mapped_.share());
+        }
     }
-    
-    // Get the incidental data of the image
-    if (EDS_ERR_OK == error_)
+    else
     {
-        EdsGetPropertyData(evfImage_, kEdsPropID_Evf_CoordinateSystem, 0, sizeof(mEvfImageCoord), &mEvfImageCoord);
-        EdsGetPropertyData(evfImage_, kEdsPropID_Evf_ZoomRect, 0, sizeof(mEvfZoomRect), &mEvfZoomRect);
+        // The camera's bytes go to disk as they are, no decode and re-encode
+        path_ = getCapturePath(session, download.info);
         
-        updateFocusRect();
+        if (!mPersistWriter.write(path_, image_.view(), &writeMillis_))
+        {
+            ofLogError() << "could not write " << path_;
+            return false;
+        }
     }
     
-    // Display image
-    EdsUInt32 length_;
-    EdsGetLength(stream_, &length_);
-    
-    char* streamPtr_;
-    EdsGetPointer(stream_, (EdsVoid **)&streamPtr_);
+    ofLog() << "saved " << download.info.szFileName << " in " << writeMillis_ << " ms"
+            << " (" << mPersistWriter.getMegabytesPerSecond() << " MB/s average)";
     
-    mBackStreamBuffer->set(streamPtr_, length_);
+    // the hash was taken over the downloaded bytes, nothing is read back
+    if (!mManifest.append(path_, download.info, download.hash))
+    {
+        ofLogError() << "could not add " << path_ << " to the manifest";
+    }
     
-    bytesPerFrame = ofLerp(bytesPerFrame, mBackStreamBuffer->size(), 0.01);
+    // RAW files carry a full size JPEG, review that instead of decoding the RAW
+    eds::ImageFormat format_ = eds::detectImageFormat(image_.view());
+    size_t previewOffset_ = 0;
+    size_t previewLength_ = 0;
     
-    std::swap(mBackStreamBuffer, mMiddleStreamBuffers.at(mWriteIndex));
+    auto start_ = ofGetElapsedTimeMicros();
+    bool hasPreview_ = eds::findEmbeddedJpeg(image_.view(), previewOffset_, previewLength_);
+    auto micros_ = ofGetElapsedTimeMicros() - start_;
     
-    ++mWriteIndex %= mMiddleStreamBuffers.size();
+    ofLog() << download.info.szFileName << ": " << eds::getImageFormatName(format_) << " (format " << download.info.format << ")"
+            << ", preview: " << (hasPreview_ ? ofToString(previewLength_ / 1024) + " KB" : "none")
+            << ", found in " << micros_ << " us";
     
-    mBackStreamBuffer->clear();
+    // exposure metadata for the catalog, read in place from the downloaded bytes
+    eds::ExifReader exif_;
+    start_ = ofGetElapsedTimeMicros();
     
-    // Release stream
-    if (NULL != stream_)
+    if (exif_.open(image_.view()))
     {
-        EdsRelease(stream_);
-        stream_ = NULL;
+        std::string model_, dateTime_, serial_;
+        uint32_t iso_ = 0;
+        double tv_ = 0.0;
+        double av_ = 0.0;
+        
+        exif_.getModel(model_);
+        exif_.getSerialNumber(serial_);
+        exif_.getDateTimeOriginal(dateTime_);
+        exif_.getIso(iso_);
+        exif_.getExposureTime(tv_);
+        exif_.getFNumber(av_);
+        
+        micros_ = ofGetElapsedTimeMicros() - start_;
+        
+        ofLog() << download.info.szFileName << ": " << model_ << " #" << serial_ << ", " << dateTime_
+                << ", ISO " << iso_ << ", " << tv_ << " s, f/" << av_
+                << " (" << exif_.getLookupCount() << " tags in " << micros_ << " us)";
     }
     
-    // Release iamge ref
-    if (NULL != evfImage_)
+    if (!hasPreview_)
     {
-        EdsRelease(evfImage_);
-        evfImage_ = NULL;
+        return true;
     }
+    
+    std::lock_guard<std::mutex> lock_(mLastCaptureMutex);
+    mLastCapture = ofPtr<eds::LazyImage>(new eds::LazyImage(image_.slice(previewOffset_, previewLength_)));
+    
+    return true;
 }
 
 //--------------------------------------------------------------
-EdsError ofApp::endLiveview()
+std::string ofApp::getCapturePath(eds::CameraSession& session, const EdsDirectoryItemInfo& info)
 {
-    EdsError error_ = EDS_ERR_OK;
+    // keep the camera's file name (and with it the extension), RAW and JPEG of one shot share a prefix.
+    // Every body numbers its files on its own, the camera index keeps a rig's IMG_0001s apart.
+    char camera_[8];
+    snprintf(camera_, sizeof(camera_), "cam%02u", session.getIndex());
     
-    // Get the output device for the live view image
-    EdsUInt32 device_;
-    error_ = EdsGetPropertyData(mCamera, kEdsPropID_Evf_OutputDevice, 0, sizeof(device_), &device_);
+    bool paired_ = false;
+    std::string name_ = session.getCaptureGrouper().group(info, ofGetTimestampString() + "-" + camera_ + "-" + eds::CaptureGrouper::getBaseName(info.szFileName), &paired_);
     
-    // PC live view ends if the PC is disconnected from the live view image output device
-    if (EDS_ERR_OK == error_)
+    if (paired_)
     {
-        device_ &= ~kEdsEvfOutputDevice_PC;
-        error_ = EdsSetPropertyData(mCamera, kEdsPropID_Evf_OutputDevice, 0, sizeof(device_), &device_);
-        
-        mBackStreamBuffer = NULL;
-        delete mBackStreamBuffer;
-        
-        for (auto i = 0; i < mMiddleStreamBuffers.size(); ++i)
-        {
-            mMiddleStreamBuffers.at(i)->clear();
-            mMiddleStreamBuffers.at(i) = NULL;
-            delete mMiddleStreamBuffers.at(i);
-        }
+        ofLog() << info.szFileName << " belongs to capture " << name_;
     }
+    
+    return ofToDataPath(name_ + eds::CaptureGrouper::getExtension(info.szFileName));
 }
 
-#pragma mark - Callbacks
-
 //--------------------------------------------------------------
-EdsError EDSCALLBACK ofApp::onCameraAdded(EdsVoid *context)
+bool ofApp::getLastCapturePixels(ofPixels& pixels)
 {
-    std::cout << "camera added" << std::endl;
+    ofPtr<eds::LazyImage> capture_;
     
-    if (!((ofApp*)context)->bIsReady)
     {
-        ((ofApp*)context)->initialize();
+        std::lock_guard<std::mutex> lock_(mLastCaptureMutex);
+        capture_ = mLastCapture;
     }
+    
+    return capture_ && capture_->getPixels(pixels);
 }
 
+
+#pragma mark - Liveview
+
 //--------------------------------------------------------------
-EdsError EDSCALLBACK ofApp::onObjectEvent(EdsObjectEvent event, EdsBaseRef object, EdsVoid *context)
+EdsError ofApp::startLiveview()
 {
-    switch (event)
+    eds::CameraSession* session_ = getSelectedSession();
+    
+    if (NULL == session_)
     {
-        case kEdsObjectEvent_DirItemRequestTransfer:
-            break;
-            
-        case kEdsObjectEvent_DirItemCreated:
-            std::cout << "dir item created" << std::endl;
-            ((ofApp*)context)->downloadImage(object);
-            break;
-            
-        default:
-            EdsRelease(object);
-            break;
+        return EDS_ERR_SESSION_NOT_OPEN;
     }
     
-    // オブジェクトをリリースする
-    if (object)
+    mEvfAllocationProbe = eds::AllocationProbe();
+    mLiveviewCacheHits = session_->getPropertyCache().getHitCount();
+    mLiveviewStartTime = ofGetElapsedTimef();
+    
+    mEvfDecoder.start();
+    EdsError error_ = session_->startLiveview();
+    bLiveviewStarted = (EDS_ERR_OK == error_);
+    
+    if (!bLiveviewStarted)
     {
-        EdsRelease(object);
+        mEvfDecoder.stop();
     }
     
-    return EDS_ERR_OK;
+    return error_;
 }
 
 //--------------------------------------------------------------
-EdsError EDSCALLBACK ofApp::onPropertyEvent(EdsPropertyEvent event, EdsPropertyID property, EdsUInt32 param, EdsVoid *context)
+EdsError ofApp::endLiveview()
 {
-    switch (property)
+    EdsError error_ = EDS_ERR_OK;
+    eds::CameraSession* session_ = mCameraManager.getSession(mSelectedCamera);
+    
+    bLiveviewStarted = false;
+    
+    if (NULL == session_)
     {
-        case kEdsPropID_Evf_OutputDevice:
-            std::cout << std::hex << "EVF output device changed: " << param << std::endl;
-            break;
-            
-        case kEdsPropID_DriveMode:
-            std::cout << std::hex << "drive mode changed: " << param << std::endl;
-            break;
-            
-        case kEdsPropID_AvailableShots:
-            std::cout << std::hex << "available shots: " << param << std::endl;
-            break;
-            
-        case kEdsPropID_ImageQuality:
-        {
-            EdsUInt32 prop_;
-            EdsGetPropertyData(((ofApp*)context)->mCamera, kEdsPropID_ImageQuality, 0, sizeof(prop_), &prop_);
-            std::cout << std::hex << "image quality changed: " << prop_ << std::endl;
-        }
-            break;
-            
-        case kEdsPropID_FocusInfo:
-            break;
-            
-        default:
-            std::cout << std::hex << "property changed - property: " << property << ", param: " << param << std::endl;
-            break;
+        mEvfDecoder.stop();
+        return error_;
     }
     
-    return EDS_ERR_OK;
-}
-
-//--------------------------------------------------------------
-EdsError EDSCALLBACK ofApp::onStateEvent(EdsStateEvent event, EdsUInt32 parameter, EdsVoid *context)
-{
-    std::cout << std::hex << "onStateEvent: " << event << std::endl;
+    // Stops the capture thread before the output device goes away
+    error_ = session_->endLiveview();
+    mEvfDecoder.stop();
+    
+    eds::EvfCapture& capture_ = session_->getEvfCapture();
     
-    switch (event)
+    ofLog() << session_->getName() << ": liveview frames published: " << capture_.getPublishedCount()
+            << ", displayed: " << capture_.getAcquiredCount()
+            << ", dropped: " << capture_.getDroppedCount()
+            << ", SDK allocations: " << capture_.getAllocationCount();
+    ofLog() << "liveview frames decoded: " << mEvfDecoder.getDecodedCount()
+            << " on " << mEvfDecoder.getThreadCount() << " threads"
+            << ", average decode: " << mEvfDecoder.getDecodeMillisAverage() << " ms"
+            << ", dropped: " << mEvfDecoder.getDroppedCount()
+            << ", discarded out of order: " << mEvfDecoder.getDiscardedCount();
+    
+    // every cache hit is an EdsGetPropertyData round trip that didn't happen
+    eds::PropertyCache& cache_ = session_->getPropertyCache();
+    auto seconds_ = ofGetElapsedTimef() - mLiveviewStartTime;
+    
+    if (0.f < seconds_)
     {
-        case kEdsStateEvent_WillSoonShutDown:
-            std::cout << std::hex << "will soon shutdown" << std::endl;
-            ((ofApp*)context)->extendShutDownTimer();
-            break;
-            
-        case kEdsStateEvent_ShutDownTimerUpdate:
-            std::cout << std::hex << "shutdown timer uppdated" << std::endl;
-            break;
-            
-        case kEdsStateEvent_Shutdown:
-            std::cout << std::hex << "shutdown" << std::endl;
-            ((ofApp*)context)->finalize();
-            break;
-            
-        default:
-            break;
+        ofLog() << "property reads served from cache during liveview: " << (cache_.getHitCount() - mLiveviewCacheHits) / seconds_ << "/s"
+                << " (FocusInfo hits: " << cache_.getHitCount(kEdsPropID_FocusInfo)
+                << ", misses: " << cache_.getMissCount(kEdsPropID_FocusInfo) << ")";
     }
     
-    return EDS_ERR_OK;
+    if (eds::AllocationCounter::isEnabled())
+    {
+        ofLog() << "liveview frames with heap allocations after warm-up: " << mEvfAllocationProbe.getFramesWithAllocations()
+                << " of " << mEvfAllocationProbe.getFrameCount()
+                << " (" << mEvfAllocationProbe.getAllocationsAfterWarmUp() << " allocations)";
+    }
+    
+    return error_;
 }
 
+#pragma mark - Callbacks
+
 //--------------------------------------------------------------
-EdsError EDSCALLBACK ofApp::onProgressEvent(EdsUInt32 percent, EdsVoid *context, EdsBool *cancel)
+EdsError EDSCALLBACK ofApp::onCameraAdded(EdsVoid *context)
 {
-    std::cout << "percent: " << percent << std::endl;
-    
+    // the SDK callbacks only queue the event, subscribeEvents() has the handlers
+    ((ofApp*)context)->mEventBus.postCameraAdded();
     return EDS_ERR_OK;
-}
\ No newline at end of file
+}
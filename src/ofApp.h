@@ -1,41 +1,53 @@
 #pragma once
 
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+
 #include "ofMain.h"
 #include "EDSDK.h"
 #include "EDSDKErrors.h"
 #include "EDSDKTypes.h"
 
+#include "alloc_counter.h"
 #include "buffer.h"
+#include "buffer_pool.h"
+#include "buffer_slice.h"
+#include "bulb_controller.h"
+#include "camera_manager.h"
+#include "camera_session.h"
+#include "capture_grouper.h"
+#include "capture_manifest.h"
+#include "command_executor.h"
+#include "download_manager.h"
+#include "event_bus.h"
+#include "evf_capture.h"
+#include "evf_decoder.h"
+#include "exif_reader.h"
+#include "image_container.h"
+#include "intervalometer.h"
+#include "lazy_image.h"
+#include "persist_writer.h"
+#include "phase_timer.h"
+#include "property_cache.h"
+#include "reconnect_manager.h"
+#include "trigger_engine.h"
 
 #pragma mark - AE mode
 
 // Note: For some models, the value of the property cannot be retrieved as kEdsPropID_AEMode. In this case, Bulb is retrieved as the value of the shutter speed (kEdsPropID_Tv) property.
 // Note: Bulb is designed so that it cannot be set on cameras from a computer by means of SetPropertyData.
 
-#pragma mark - Drive mode
-
-#define EDS_DRIVE_MODE_SINGLE_FRAME 0x00000000L
-#define EDS_DRIVE_MODE_CONTINUOUS_SHOOTING 0x00000001L
-#define EDS_DRIVE_MODE_VIDEO 0x00000002L
-#define EDS_DRIVE_MODE_HIGH_SPEED_CONTINUOUS_SHOOTING 0x00000004L
-#define EDS_DRIVE_MODE_LOW_SPEED_CONTINUOUS_SHOOTING 0x00000005L
-#define EDS_DRIVE_MODE_SILENT_SINGLE_SHOOTING 0x00000006L
-#define EDS_DRIVE_MODE_10SEC_SELF_TIMER_AND_CONTINUOUS_SHOOTING 0x00000007L
-#define EDS_DRIVE_MODE_10SEC_SELF_TIMER 0x00000010L
-#define EDS_DRIVE_MODE_2SEC_SELF_TIMER 0x00000011L
-
 #pragma mark - ofApp
 
 class ofApp : public ofBaseApp
 {
 public:
-    EdsCameraRef mCamera;
     EdsPoint mFocusPoint;
     bool bSdkInitialized;
     bool bIsReady;
-    bool bSessionOpened;
     bool bLiveviewStarted;
-    bool bExecuteBulbShooting;
     
     float mEvfImageWidth;
     float mEvfImageHeight;
@@ -44,20 +56,48 @@ public:
     EdsSize mEvfImageCoord;
     EdsRect mEvfZoomRect;
     
-    eds::Buffer * mFrontStreamBuffer;
-    eds::Buffer * mBackStreamBuffer;
-    std::vector<eds::Buffer*> mMiddleStreamBuffers;
-    int mReadIndex;
-    int mWriteIndex;
+    eds::EvfDecoder mEvfDecoder;
+    eds::DecodedFrame mDecodedFrame;
     
-    std::vector< ofPtr<ofImage> > mImages;
-    int mImageIndex;
+    ofTexture mEvfTexture;
+    eds::AllocationProbe mEvfAllocationProbe;
     float bytesPerFrame;
     
-    eds::Buffer mDownloadImageBuffer;
+    eds::EventBus mEventBus;
+    uint64_t mDroppedEvents;
+    eds::CameraManager mCameraManager;
+    unsigned int mSelectedCamera;
+    eds::TriggerEngine mTriggerEngine;
+    uint64_t mTriggerShots;
+    eds::ReconnectManager mReconnectManager;
+    eds::BulbController mBulbController;
+    double mBulbMillis;
+    bool bBulbCancelled;
+    eds::Intervalometer mIntervalometer;
+    double mTimelapseMillis;
+    eds::PropertyProfile mStillProfile;
+    eds::PropertyProfile mActionProfile;
+    eds::PhaseTimer mStartup;
+    size_t mStartupFirstFrame;
+    bool bStartupReported;
+    uint64_t mLiveviewCacheHits;
+    float mLiveviewStartTime;
+    
+    // DirItemCreated items waiting for a free download slot, by session index. update() never waits for one.
+    std::deque<std::pair<unsigned int, EdsDirectoryItemRef> > mPendingDownloads;
+    std::atomic<size_t> mPendingDownloadCount;
+    
+    eds::PersistWriter mPersistWriter;
+    eds::CaptureManifest mManifest;
+    
+    // Most recent capture, decoded only if someone asks for its pixels
+    ofPtr<eds::LazyImage> mLastCapture;
+    std::mutex mLastCaptureMutex;
     
     ofRectangle mFocusRect;
     
+    ofApp();
+    
     void setup();
     void update();
     void draw();
@@ -73,19 +113,31 @@ public:
     void dragEvent(ofDragInfo dragInfo);
     void gotMessage(ofMessage msg);
 		
+    void subscribeEvents();
     void initialize();
     void finalize();
-    EdsError getFirstCamera(EdsCameraRef * camera);
+    eds::CameraSession* getSelectedSession() const;
+    void selectCamera(unsigned int index);
     EdsUInt32 getPropertyData(EdsPropertyID property, EdsUInt32 inParam);
     
     void updateFocusRect();
     
-    void setSaveTo(EdsUInt32 value);
-    void setAEMode(EdsUInt32 value);
-    void setDriveMode(EdsUInt32 value);
-    void setIsoSpeed(EdsUInt32 value);
-    void setEvfZoom(EdsUInt32 value);
-    void setImageQuality(EdsUInt32 value);
+    // Every camera of the rig, on their command executors. A newer value for the same property replaces one still queued.
+    template<EdsPropertyID Property>
+    void setProperty(const typename eds::PropertyTraits<Property>::Type& value)
+    {
+        for (unsigned int i = 0; i < mCameraManager.getSessionCount(); ++i)
+        {
+            eds::CameraSession* session_ = mCameraManager.getSession(i);
+            
+            if (session_->isOpen())
+            {
+                session_->setProperty<Property>(value);
+            }
+        }
+    }
+    
+    void applyProfile(const eds::PropertyProfile& profile);
     void setZoomPosition(EdsPoint& position);
     
     void extendShutDownTimer();
@@ -94,16 +146,16 @@ public:
     void releaseShutterButton();
     void doEvfAutoFocus(EdsEvfAFMode mode);
     void driveLensEvf(EdsEvfDriveLens value);
-    void downloadImage(EdsDirectoryItemRef itemRef);
+    void sendCommand(eds::CommandClass commandClass, EdsCameraCommand command, EdsInt32 param);
+    void downloadImage(eds::CameraSession& session, EdsDirectoryItemRef itemRef);
+    void flushPendingDownloads(bool wait);
+    bool persistImage(eds::CameraSession& session, const eds::Download& download);
+    std::string getCapturePath(eds::CameraSession& session, const EdsDirectoryItemInfo& info);
+    bool getLastCapturePixels(ofPixels& pixels);
     
     // Liveview
     EdsError startLiveview();
-    EdsError downloadEvfData();
     EdsError endLiveview();
     
     static EdsError EDSCALLBACK onCameraAdded(EdsVoid* context);
-    static EdsError EDSCALLBACK onObjectEvent(EdsObjectEvent event, EdsBaseRef object, EdsVoid * context);
-    static EdsError EDSCALLBACK onPropertyEvent(EdsPropertyEvent event, EdsPropertyID property, EdsUInt32 parameter, EdsVoid * context);
-    static EdsError EDSCALLBACK onStateEvent(EdsStateEvent event, EdsUInt32 parameter, EdsVoid * context);
-    static EdsError EDSCALLBACK onProgressEvent(EdsUInt32 percent, EdsVoid* context, EdsBool* cancel);
 };
@@ -0,0 +1,253 @@
+#include "persist_writer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace
+{
+    // multiple of the file system block size, so every write but the last
+    // starts and ends on a block boundary
+    const size_t kWriteChunkSize = 4 * 1024 * 1024;
+
+    uint64_t elapsedMicros(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+namespace eds
+{
+    PersistWriter::PersistWriter(SyncPolicy policy, unsigned int batchSize)
+    : mPolicy(policy)
+    , mBatchSize(std::max(1u, batchSize))
+    , mFiles(0)
+    , mBytes(0)
+    , mMicros(0)
+    {
+    }
+
+    PersistWriter::~PersistWriter()
+    {
+        flush();
+    }
+
+    void PersistWriter::setSyncPolicy(SyncPolicy policy, unsigned int batchSize)
+    {
+        flush();
+
+        std::lock_guard<std::mutex> lock_(mMutex);
+        mPolicy = policy;
+        mBatchSize = std::max(1u, batchSize);
+    }
+
+    bool PersistWriter::write(const std::string& path, const BufferView& data, double* millis)
+    {
+        File file_;
+
+        if (!open(file_, path, data.size))
+        {
+            return false;
+        }
+
+        if (!append(file_, data))
+        {
+            discard(file_);
+            return false;
+        }
+
+        bool committed_ = commit(file_);
+
+        if (NULL != millis)
+        {
+            *millis = file_.micros / 1000.0;
+        }
+
+        return committed_;
+    }
+
+    bool PersistWriter::open(File& file, const std::string& path, size_t expectedSize)
+    {
+        auto start_ = std::chrono::steady_clock::now();
+
+        file.fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        file.path = path;
+        file.size = 0;
+        file.micros = 0;
+
+        if (file.fd < 0)
+        {
+            return false;
+        }
+
+#if defined(__APPLE__)
+        // the file is not read back, don't let it push everything else out of the page cache
+        fcntl(file.fd, F_NOCACHE, 1);
+#elif defined(__linux__)
+        // reserve the extents up front so the file isn't fragmented by concurrent writers
+        if (0 < expectedSize)
+        {
+            posix_fallocate(file.fd, 0, expectedSize);
+        }
+#endif
+
+        file.micros += elapsedMicros(start_);
+
+        return true;
+    }
+
+    bool PersistWriter::append(File& file, const BufferView& data)
+    {
+        auto start_ = std::chrono::steady_clock::now();
+        size_t offset_ = 0;
+
+        while (offset_ < data.size)
+        {
+            ssize_t result_ = ::write(file.fd, data.data + offset_, std::min(kWriteChunkSize, data.size - offset_));
+
+            if (result_ < 0)
+            {
+                if (EINTR == errno)
+                {
+                    continue;
+                }
+
+                return false;
+            }
+
+            offset_ += result_;
+        }
+
+        file.size += data.size;
+        file.micros += elapsedMicros(start_);
+
+        return true;
+    }
+
+    bool PersistWriter::commit(File& file)
+    {
+        auto start_ = std::chrono::steady_clock::now();
+
+#if defined(__linux__)
+        // preallocation may have reserved more than arrived
+        if (0 != ftruncate(file.fd, file.size))
+        {
+            discard(file);
+            return false;
+        }
+#endif
+
+        bool synced_ = true;
+        std::vector<int> batch_;
+
+        {
+            std::lock_guard<std::mutex> lock_(mMutex);
+
+            if (kSyncPolicy_Batched == mPolicy)
+            {
+                mUnsynced.push_back(file.fd);
+                file.fd = -1;
+
+                if (mBatchSize <= mUnsynced.size())
+                {
+                    batch_.swap(mUnsynced);
+                }
+            }
+            else if (kSyncPolicy_EveryFile == mPolicy)
+            {
+                synced_ = sync(file.fd);
+            }
+        }
+
+        if (0 <= file.fd)
+        {
+            ::close(file.fd);
+            file.fd = -1;
+        }
+
+        // the batch is synced outside the lock, other workers keep writing meanwhile
+        for (size_t i = 0; i < batch_.size(); ++i)
+        {
+            synced_ = sync(batch_[i]) && synced_;
+            ::close(batch_[i]);
+        }
+
+        file.micros += elapsedMicros(start_);
+
+        ++mFiles;
+        mBytes += file.size;
+        mMicros += file.micros;
+
+        return synced_;
+    }
+
+    void PersistWriter::discard(File& file)
+    {
+        if (0 <= file.fd)
+        {
+            ::close(file.fd);
+            file.fd = -1;
+        }
+
+        if (!file.path.empty())
+        {
+            unlink(file.path.c_str());
+        }
+    }
+
+    bool PersistWriter::flush()
+    {
+        std::vector<int> batch_;
+
+        {
+            std::lock_guard<std::mutex> lock_(mMutex);
+            batch_.swap(mUnsynced);
+        }
+
+        bool synced_ = true;
+
+        for (size_t i = 0; i < batch_.size(); ++i)
+        {
+            synced_ = sync(batch_[i]) && synced_;
+            ::close(batch_[i]);
+        }
+
+        return synced_;
+    }
+
+    uint64_t PersistWriter::getFileCount() const
+    {
+        return mFiles;
+    }
+
+    uint64_t PersistWriter::getByteCount() const
+    {
+        return mBytes;
+    }
+
+    double PersistWriter::getMillisAverage() const
+    {
+        uint64_t files_ = mFiles;
+        return 0 < files_ ? mMicros / 1000.0 / files_ : 0.0;
+    }
+
+    double PersistWriter::getMegabytesPerSecond() const
+    {
+        uint64_t micros_ = mMicros;
+        return 0 < micros_ ? (mBytes / (1024.0 * 1024.0)) / (micros_ / 1000000.0) : 0.0;
+    }
+
+    bool PersistWriter::sync(int fd)
+    {
+#if defined(__APPLE__)
+        // fsync on OS X doesn't flush the drive's cache
+        if (0 == fcntl(fd, F_FULLFSYNC))
+        {
+            return true;
+        }
+#endif
+        return 0 == fsync(fd);
+    }
+}
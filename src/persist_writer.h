@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "buffer.h"
+
+namespace eds
+{
+    enum SyncPolicy
+    {
+        // leave it to the OS
+        kSyncPolicy_None,
+        // fsync every file before write() returns
+        kSyncPolicy_EveryFile,
+        // keep files open and fsync them together every batch
+        kSyncPolicy_Batched
+    };
+
+    // Writes the camera's bytes to disk unchanged. Large, block aligned writes
+    // straight from the download buffer, so nothing is decoded or re-encoded
+    // and nothing is copied through a stdio buffer.
+    // write() may be called from several download workers at once.
+    class PersistWriter
+    {
+    public:
+        // A file being written piece by piece, see open()
+        struct File
+        {
+            File() : fd(-1), size(0), micros(0) {}
+
+            int fd;
+            std::string path;
+            size_t size;
+            uint64_t micros;
+        };
+
+        PersistWriter(SyncPolicy policy = kSyncPolicy_Batched, unsigned int batchSize = 8);
+        ~PersistWriter();
+
+        void setSyncPolicy(SyncPolicy policy, unsigned int batchSize = 8);
+
+        // millis, if given, gets the time spent on this file
+        bool write(const std::string& path, const BufferView& data, double* millis = NULL);
+
+        // Streaming writes: open, append chunks while they arrive, then commit()
+        // to apply the sync policy or discard() to remove the partial file.
+        // Only the time spent in here counts towards the statistics, and
+        // towards file.micros, the time spent on this file.
+        bool open(File& file, const std::string& path, size_t expectedSize = 0);
+        bool append(File& file, const BufferView& data);
+        bool commit(File& file);
+        void discard(File& file);
+
+        // Syncs and closes everything still waiting for a batched fsync
+        bool flush();
+
+        uint64_t getFileCount() const;
+        uint64_t getByteCount() const;
+        double getMillisAverage() const;
+        double getMegabytesPerSecond() const;
+
+    private:
+        PersistWriter(const PersistWriter&);
+        PersistWriter& operator=(const PersistWriter&);
+
+        static bool sync(int fd);
+
+        SyncPolicy mPolicy;
+        unsigned int mBatchSize;
+        std::vector<int> mUnsynced;
+        std::mutex mMutex;
+
+        std::atomic<uint64_t> mFiles;
+        std::atomic<uint64_t> mBytes;
+        std::atomic<uint64_t> mMicros;
+    };
+}
@@ -0,0 +1,79 @@
+#include "phase_timer.h"
+
+namespace eds
+{
+    PhaseTimer::PhaseTimer()
+    : mStart(std::chrono::steady_clock::now())
+    {
+    }
+
+    void PhaseTimer::reset()
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+
+        mStart = std::chrono::steady_clock::now();
+        mPhases.clear();
+    }
+
+    size_t PhaseTimer::begin(const std::string& name, unsigned int parties)
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+
+        Phase phase_;
+        phase_.name = name;
+        phase_.beginMillis = getMillis();
+        phase_.pending = parties;
+        phase_.endMillis = (0 == parties) ? phase_.beginMillis : -1.0;
+
+        mPhases.push_back(phase_);
+        return mPhases.size() - 1;
+    }
+
+    void PhaseTimer::end(size_t phase)
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+
+        // unknown index, or more end() calls than parties
+        if (mPhases.size() <= phase || 0 == mPhases[phase].pending)
+        {
+            return;
+        }
+
+        if (0 == --mPhases[phase].pending)
+        {
+            mPhases[phase].endMillis = getMillis();
+        }
+    }
+
+    bool PhaseTimer::isComplete() const
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+
+        for (size_t i = 0; i < mPhases.size(); ++i)
+        {
+            if (0 < mPhases[i].pending)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    std::vector<PhaseTimer::Phase> PhaseTimer::getPhases() const
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+        return mPhases;
+    }
+
+    double PhaseTimer::getElapsedMillis() const
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+        return getMillis();
+    }
+
+    double PhaseTimer::getMillis() const
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - mStart).count() / 1000.0;
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace eds
+{
+    // Timeline of phases that may overlap and may end on other threads, all
+    // measured from the same reset(). A phase begun with several parties
+    // ends when the last of them calls end(), e.g. one per camera for work
+    // queued on every command thread.
+    class PhaseTimer
+    {
+    public:
+        struct Phase
+        {
+            std::string name;
+            double beginMillis;
+            // -1 while it's still running
+            double endMillis;
+            unsigned int pending;
+        };
+
+        PhaseTimer();
+
+        void reset();
+
+        // Returns the phase index for end()
+        size_t begin(const std::string& name, unsigned int parties = 1);
+        void end(size_t phase);
+
+        // Every phase begun so far has ended
+        bool isComplete() const;
+        std::vector<Phase> getPhases() const;
+        double getElapsedMillis() const;
+
+    private:
+        PhaseTimer(const PhaseTimer&);
+        PhaseTimer& operator=(const PhaseTimer&);
+
+        double getMillis() const;
+
+        mutable std::mutex mMutex;
+        std::chrono::steady_clock::time_point mStart;
+        std::vector<Phase> mPhases;
+    };
+}
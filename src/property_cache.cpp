@@ -0,0 +1,303 @@
+#include "property_cache.h"
+
+#include <cstring>
+
+namespace eds
+{
+    void PropertyProfile::set(EdsPropertyID property, EdsInt32 param, const void* data, EdsUInt32 size)
+    {
+        const char* begin_ = (const char*)data;
+
+        // a second set() of the same property replaces the value but keeps its place
+        for (size_t i = 0; i < mEntries.size(); ++i)
+        {
+            if (property == mEntries[i].property && param == mEntries[i].param)
+            {
+                mEntries[i].value.assign(begin_, begin_ + size);
+                return;
+            }
+        }
+
+        Entry entry_;
+        entry_.property = property;
+        entry_.param = param;
+        entry_.value.assign(begin_, begin_ + size);
+        mEntries.push_back(entry_);
+    }
+
+    void PropertyProfile::clear()
+    {
+        mEntries.clear();
+    }
+
+    const std::vector<PropertyProfile::Entry>& PropertyProfile::getEntries() const
+    {
+        return mEntries;
+    }
+
+    PropertyCache::PropertyCache()
+    : mCamera(NULL)
+    , mHits(0)
+    , mMisses(0)
+    , mSdkCalls(0)
+    , mSkippedWrites(0)
+    {
+    }
+
+    void PropertyCache::attach(EdsCameraRef camera)
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+
+        mCamera = camera;
+
+        for (EntryMap::iterator it_ = mEntries.begin(); it_ != mEntries.end(); ++it_)
+        {
+            it_->second.bValid = false;
+            ++it_->second.generation;
+        }
+    }
+
+    void PropertyCache::detach()
+    {
+        attach(NULL);
+    }
+
+    void PropertyCache::prefetch(const EdsPropertyID* properties, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            EdsDataType type_ = kEdsDataType_Unknown;
+            EdsUInt32 size_ = 0;
+
+            // not every body has every property
+            if (EDS_ERR_OK != EdsGetPropertySize(mCamera, properties[i], 0, &type_, &size_) || 0 == size_)
+            {
+                continue;
+            }
+
+            std::vector<char> value_(size_);
+            get(properties[i], 0, &value_[0], size_);
+        }
+    }
+
+    EdsError PropertyCache::get(EdsPropertyID property, EdsInt32 param, void* data, EdsUInt32 size)
+    {
+        uint64_t key_ = makeKey(property, param);
+        uint64_t generation_ = 0;
+        EdsCameraRef camera_ = NULL;
+
+        {
+            std::lock_guard<std::mutex> lock_(mMutex);
+
+            Entry& entry_ = mEntries[key_];
+
+            if (entry_.bValid && entry_.value.size() == size)
+            {
+                memcpy(data, &entry_.value[0], size);
+                ++entry_.hits;
+                ++mHits;
+                return EDS_ERR_OK;
+            }
+
+            ++entry_.misses;
+            ++mMisses;
+            ++mSdkCalls;
+            generation_ = entry_.generation;
+            camera_ = mCamera;
+        }
+
+        // not under the lock, the SDK may deliver property events from inside the call
+        EdsError error_ = EdsGetPropertyData(camera_, property, param, size, data);
+
+        if (EDS_ERR_OK == error_)
+        {
+            std::lock_guard<std::mutex> lock_(mMutex);
+
+            Entry& entry_ = mEntries[key_];
+
+            // resize() only allocates the first time, or if the size changes
+            entry_.value.resize(size);
+            memcpy(&entry_.value[0], data, size);
+            entry_.bValid = (generation_ == entry_.generation);
+        }
+
+        return error_;
+    }
+
+    EdsError PropertyCache::set(EdsPropertyID property, EdsInt32 param, const void* data, EdsUInt32 size)
+    {
+        EdsCameraRef camera_ = NULL;
+
+        {
+            std::lock_guard<std::mutex> lock_(mMutex);
+            ++mSdkCalls;
+            camera_ = mCamera;
+        }
+
+        EdsError error_ = EdsSetPropertyData(camera_, property, param, size, data);
+
+        std::lock_guard<std::mutex> lock_(mMutex);
+
+        Entry& entry_ = mEntries[makeKey(property, param)];
+
+        // a read that was already on its way has the old value, it mustn't be cached over this one
+        ++entry_.generation;
+
+        if (EDS_ERR_OK == error_)
+        {
+            entry_.value.resize(size);
+            memcpy(&entry_.value[0], data, size);
+            entry_.bValid = true;
+        }
+        else
+        {
+            // the camera may have applied part of it, read it back next time
+            entry_.bValid = false;
+        }
+
+        return error_;
+    }
+
+    EdsError PropertyCache::apply(const PropertyProfile& profile, size_t* sent)
+    {
+        const std::vector<PropertyProfile::Entry>& entries_ = profile.getEntries();
+        std::vector<char> current_;
+        size_t sent_ = 0;
+        EdsError error_ = EDS_ERR_OK;
+
+        for (size_t i = 0; i < entries_.size() && EDS_ERR_OK == error_; ++i)
+        {
+            const PropertyProfile::Entry& entry_ = entries_[i];
+            EdsUInt32 size_ = (EdsUInt32)entry_.value.size();
+
+            // usually a cache hit, a failed read just means the value is sent
+            current_.resize(size_);
+
+            if (0 < size_ && EDS_ERR_OK == get(entry_.property, entry_.param, &current_[0], size_) && current_ == entry_.value)
+            {
+                std::lock_guard<std::mutex> lock_(mMutex);
+                ++mSkippedWrites;
+                continue;
+            }
+
+            error_ = set(entry_.property, entry_.param, entry_.value.data(), size_);
+
+            if (EDS_ERR_OK == error_)
+            {
+                ++sent_;
+            }
+        }
+
+        if (sent)
+        {
+            *sent = sent_;
+        }
+
+        return error_;
+    }
+
+    size_t PropertyCache::snapshot(const EdsPropertyID* properties, size_t count, PropertyProfile& profile) const
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+
+        size_t added_ = 0;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            EntryMap::const_iterator it_ = mEntries.find(makeKey(properties[i], 0));
+
+            if (mEntries.end() != it_ && it_->second.bValid && !it_->second.value.empty())
+            {
+                profile.set(properties[i], 0, it_->second.value.data(), (EdsUInt32)it_->second.value.size());
+                ++added_;
+            }
+        }
+
+        return added_;
+    }
+
+    void PropertyCache::invalidate(EdsPropertyID property)
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+
+        // every parameter of the property
+        EntryMap::iterator it_ = mEntries.lower_bound(makeKey(property, 0));
+
+        for (; it_ != mEntries.end() && (it_->first >> 32) == property; ++it_)
+        {
+            it_->second.bValid = false;
+            ++it_->second.generation;
+        }
+    }
+
+    void PropertyCache::invalidateAll()
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+
+        for (EntryMap::iterator it_ = mEntries.begin(); it_ != mEntries.end(); ++it_)
+        {
+            it_->second.bValid = false;
+            ++it_->second.generation;
+        }
+    }
+
+    uint64_t PropertyCache::getHitCount(EdsPropertyID property) const
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+
+        uint64_t hits_ = 0;
+        EntryMap::const_iterator it_ = mEntries.lower_bound(makeKey(property, 0));
+
+        for (; it_ != mEntries.end() && (it_->first >> 32) == property; ++it_)
+        {
+            hits_ += it_->second.hits;
+        }
+
+        return hits_;
+    }
+
+    uint64_t PropertyCache::getMissCount(EdsPropertyID property) const
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+
+        uint64_t misses_ = 0;
+        EntryMap::const_iterator it_ = mEntries.lower_bound(makeKey(property, 0));
+
+        for (; it_ != mEntries.end() && (it_->first >> 32) == property; ++it_)
+        {
+            misses_ += it_->second.misses;
+        }
+
+        return misses_;
+    }
+
+    uint64_t PropertyCache::getHitCount() const
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+        return mHits;
+    }
+
+    uint64_t PropertyCache::getMissCount() const
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+        return mMisses;
+    }
+
+    uint64_t PropertyCache::getSdkCallCount() const
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+        return mSdkCalls;
+    }
+
+    uint64_t PropertyCache::getSkippedWriteCount() const
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+        return mSkippedWrites;
+    }
+
+    uint64_t PropertyCache::makeKey(EdsPropertyID property, EdsInt32 param)
+    {
+        // the parameter is an index (custom functions, picture styles), never negative in practice
+        return (uint64_t)property << 32 | (uint32_t)param;
+    }
+}
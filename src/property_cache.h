@@ -0,0 +1,143 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <stdint.h>
+#include <vector>
+
+#include "EDSDK.h"
+#include "EDSDKErrors.h"
+#include "EDSDKTypes.h"
+
+#include "property_traits.h"
+
+namespace eds
+{
+    // Target values for a set of properties, applied in the order they were
+    // added (AE mode before Tv/Av/ISO, the camera rejects them otherwise)
+    class PropertyProfile
+    {
+    public:
+        struct Entry
+        {
+            EdsPropertyID property;
+            EdsInt32 param;
+            std::vector<char> value;
+        };
+
+        template<EdsPropertyID Property>
+        void set(const typename PropertyTraits<Property>::Type& value, EdsInt32 param = 0)
+        {
+            set(Property, param, &value, PropertyTraits<Property>::kSize);
+        }
+
+        void set(EdsPropertyID property, EdsInt32 param, const void* data, EdsUInt32 size);
+        void clear();
+
+        const std::vector<Entry>& getEntries() const;
+
+    private:
+        std::vector<Entry> mEntries;
+    };
+
+    // Camera properties as last read from the SDK, keyed by EdsPropertyID and
+    // parameter. A value stays valid until onPropertyEvent reports it changed,
+    // so steady state reads (FocusInfo every liveview frame) are a memory
+    // lookup instead of a USB round trip. Values are kept as raw bytes and
+    // read back through get<T>(), any POD property type works.
+    class PropertyCache
+    {
+    public:
+        PropertyCache();
+
+        void attach(EdsCameraRef camera);
+        void detach();
+
+        // Reads the properties into the cache, typically right after the session opened
+        void prefetch(const EdsPropertyID* properties, size_t count);
+
+        template<typename T>
+        EdsError get(EdsPropertyID property, T& value, EdsInt32 param = 0)
+        {
+            return get(property, param, &value, sizeof(T));
+        }
+
+        // Writes through to the camera and the cache
+        template<typename T>
+        EdsError set(EdsPropertyID property, const T& value, EdsInt32 param = 0)
+        {
+            return set(property, param, &value, sizeof(T));
+        }
+
+        // Typed access through PropertyTraits, set() refuses values outside the legal set
+        template<EdsPropertyID Property>
+        EdsError get(typename PropertyTraits<Property>::Type& value, EdsInt32 param = 0)
+        {
+            return get(Property, param, &value, PropertyTraits<Property>::kSize);
+        }
+
+        template<EdsPropertyID Property>
+        EdsError set(const typename PropertyTraits<Property>::Type& value, EdsInt32 param = 0)
+        {
+            if (!isLegalPropertyValue(PropertyTraits<Property>::getDescriptor().values, value))
+            {
+                return EDS_ERR_INVALID_PARAMETER;
+            }
+
+            return set(Property, param, &value, PropertyTraits<Property>::kSize);
+        }
+
+        EdsError get(EdsPropertyID property, EdsInt32 param, void* data, EdsUInt32 size);
+        EdsError set(EdsPropertyID property, EdsInt32 param, const void* data, EdsUInt32 size);
+
+        // Sends only the profile values that differ from the cached state,
+        // stops at the first error. sent is the number of values written.
+        EdsError apply(const PropertyProfile& profile, size_t* sent = NULL);
+
+        // Adds the cached values of the properties to the profile, in that
+        // order. Nothing goes to the camera, what isn't cached is left out.
+        // Returns the number of values added.
+        size_t snapshot(const EdsPropertyID* properties, size_t count, PropertyProfile& profile) const;
+
+        // From onPropertyEvent, the next read goes to the camera
+        void invalidate(EdsPropertyID property);
+        void invalidateAll();
+
+        uint64_t getHitCount(EdsPropertyID property) const;
+        uint64_t getMissCount(EdsPropertyID property) const;
+        uint64_t getHitCount() const;
+        uint64_t getMissCount() const;
+        // Every EdsGetPropertyData/EdsSetPropertyData the cache made
+        uint64_t getSdkCallCount() const;
+        // Profile values apply() didn't have to send
+        uint64_t getSkippedWriteCount() const;
+
+    private:
+        struct Entry
+        {
+            Entry() : bValid(false), generation(0), hits(0), misses(0) {}
+
+            std::vector<char> value;
+            bool bValid;
+            // bumped by invalidate(), a read that raced with an event isn't cached
+            uint64_t generation;
+            uint64_t hits;
+            uint64_t misses;
+        };
+
+        typedef std::map<uint64_t, Entry> EntryMap;
+
+        PropertyCache(const PropertyCache&);
+        PropertyCache& operator=(const PropertyCache&);
+
+        static uint64_t makeKey(EdsPropertyID property, EdsInt32 param);
+
+        EdsCameraRef mCamera;
+        EntryMap mEntries;
+        uint64_t mHits;
+        uint64_t mMisses;
+        uint64_t mSdkCalls;
+        uint64_t mSkippedWrites;
+        mutable std::mutex mMutex;
+    };
+}
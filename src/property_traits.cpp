@@ -0,0 +1,180 @@
+#include "property_traits.h"
+
+namespace
+{
+    const EdsUInt32 kSaveTo[] =
+    {
+        kEdsSaveTo_Camera,
+        kEdsSaveTo_Host,
+        kEdsSaveTo_Both
+    };
+
+    const EdsUInt32 kImageQualities[] =
+    {
+        EdsImageQuality_LJF,	/* Jpeg Large Fine - 5760x3240 */
+        EdsImageQuality_LJN,	/* Jpeg Large Normal - 5760x3240 */
+        EdsImageQuality_MJF,	/* Jpeg Middle Fine - 3840x2160 */
+        EdsImageQuality_MJN,	/* Jpeg Middle Normal - 3840x2160 */
+        EdsImageQuality_S1JF,	/* Jpeg Small1 Fine - 2880x1624 */
+        EdsImageQuality_S1JN,	/* Jpeg Small1 Normal - 2880x1624 */
+        EdsImageQuality_S2JF,	/* Jpeg Small2 - 1920x1080 */
+        EdsImageQuality_S3JF,	/* Jpeg Small3 - 720x400 */
+        EdsImageQuality_LR,		/* RAW */
+        EdsImageQuality_LRLJF	/* RAW + Jpeg Large Fine */
+    };
+
+    const EdsUInt32 kDriveModes[] =
+    {
+        EDS_DRIVE_MODE_SINGLE_FRAME,
+        EDS_DRIVE_MODE_CONTINUOUS_SHOOTING,
+        EDS_DRIVE_MODE_VIDEO,
+        EDS_DRIVE_MODE_HIGH_SPEED_CONTINUOUS_SHOOTING,
+        EDS_DRIVE_MODE_LOW_SPEED_CONTINUOUS_SHOOTING,
+        EDS_DRIVE_MODE_SILENT_SINGLE_SHOOTING,
+        EDS_DRIVE_MODE_10SEC_SELF_TIMER_AND_CONTINUOUS_SHOOTING,
+        EDS_DRIVE_MODE_10SEC_SELF_TIMER,
+        EDS_DRIVE_MODE_2SEC_SELF_TIMER
+    };
+
+    const EdsUInt32 kIsoSpeeds[] =
+    {
+        0x00000000, // Auto
+        0x00000040, // 50
+        0x00000048, // 100
+        0x0000004b, // 125
+        0x0000004d, // 160
+        0x00000050, // 200
+        0x00000053, // 250
+        0x00000055, // 320
+        0x00000058, // 400
+        0x0000005b, // 500
+        0x0000005d, // 640
+        0x00000060, // 800
+        0x00000063, // 1000
+        0x00000065, // 1250
+        0x00000068, // 1600
+        0x0000006b, // 2000
+        0x0000006d, // 2500
+        0x00000070, // 3200
+        0x00000073, // 4000
+        0x00000075, // 5000
+        0x00000078, // 6400
+        0x0000007b, // 8000
+        0x0000007d, // 10000
+        0x00000080, // 12800
+        0x00000088, // 25600
+        0x00000090, // 51200
+        0x00000098  // 102400
+    };
+
+    const EdsUInt32 kOutputDevices[] =
+    {
+        0,
+        kEdsEvfOutputDevice_TFT,
+        kEdsEvfOutputDevice_PC,
+        kEdsEvfOutputDevice_TFT | kEdsEvfOutputDevice_PC
+    };
+
+    const EdsUInt32 kEvfAFModes[] =
+    {
+        Evf_AFMode_Quick,
+        Evf_AFMode_Live,
+        Evf_AFMode_LiveFace,
+        Evf_AFMode_LiveMulti
+    };
+
+    const EdsUInt32 kEvfZooms[] =
+    {
+        kEdsEvfZoom_Fit,
+        kEdsEvfZoom_x5,
+        kEdsEvfZoom_x10
+    };
+
+#define EDS_VALUES(VALUES) { VALUES, sizeof(VALUES) / sizeof(VALUES[0]) }
+#define EDS_ANY_VALUE { NULL, 0 }
+
+    // one row per PropertyTraits specialization, in the same order
+    const eds::PropertyDescriptor kDescriptors[] =
+    {
+        { kEdsPropID_SaveTo, "SaveTo", sizeof(EdsUInt32), EDS_VALUES(kSaveTo) },
+        { kEdsPropID_ImageQuality, "ImageQuality", sizeof(EdsUInt32), EDS_VALUES(kImageQualities) },
+        { kEdsPropID_AEModeSelect, "AEModeSelect", sizeof(EdsUInt32), EDS_ANY_VALUE },
+        { kEdsPropID_DriveMode, "DriveMode", sizeof(EdsUInt32), EDS_VALUES(kDriveModes) },
+        { kEdsPropID_ISOSpeed, "ISOSpeed", sizeof(EdsUInt32), EDS_VALUES(kIsoSpeeds) },
+        { kEdsPropID_Av, "Av", sizeof(EdsUInt32), EDS_ANY_VALUE },
+        { kEdsPropID_Tv, "Tv", sizeof(EdsUInt32), EDS_ANY_VALUE },
+        { kEdsPropID_AvailableShots, "AvailableShots", sizeof(EdsUInt32), EDS_ANY_VALUE },
+        { kEdsPropID_FocusInfo, "FocusInfo", sizeof(EdsFocusInfo), EDS_ANY_VALUE },
+        { kEdsPropID_Evf_OutputDevice, "Evf_OutputDevice", sizeof(EdsUInt32), EDS_VALUES(kOutputDevices) },
+        { kEdsPropID_Evf_AFMode, "Evf_AFMode", sizeof(EdsUInt32), EDS_VALUES(kEvfAFModes) },
+        { kEdsPropID_Evf_Zoom, "Evf_Zoom", sizeof(EdsUInt32), EDS_VALUES(kEvfZooms) },
+        { kEdsPropID_Evf_ZoomPosition, "Evf_ZoomPosition", sizeof(EdsPoint), EDS_ANY_VALUE }
+    };
+
+#undef EDS_VALUES
+#undef EDS_ANY_VALUE
+
+    const size_t kDescriptorCount = sizeof(kDescriptors) / sizeof(kDescriptors[0]);
+}
+
+#define EDS_PROPERTY(PROPERTY)                                                          \
+    const PropertyDescriptor& PropertyTraits<PROPERTY>::getDescriptor()                 \
+    {                                                                                   \
+        static const PropertyDescriptor* descriptor_ = findPropertyDescriptor(PROPERTY); \
+        return *descriptor_;                                                            \
+    }
+
+namespace eds
+{
+    bool PropertyValues::isEmpty() const
+    {
+        return 0 == count;
+    }
+
+    bool PropertyValues::contains(EdsUInt32 value) const
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (value == values[i])
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    EdsUInt32 PropertyValues::operator[](size_t index) const
+    {
+        return values[index];
+    }
+
+    const PropertyDescriptor* findPropertyDescriptor(EdsPropertyID property)
+    {
+        for (size_t i = 0; i < kDescriptorCount; ++i)
+        {
+            if (property == kDescriptors[i].property)
+            {
+                return &kDescriptors[i];
+            }
+        }
+
+        return NULL;
+    }
+
+    EDS_PROPERTY(kEdsPropID_SaveTo)
+    EDS_PROPERTY(kEdsPropID_ImageQuality)
+    EDS_PROPERTY(kEdsPropID_AEModeSelect)
+    EDS_PROPERTY(kEdsPropID_DriveMode)
+    EDS_PROPERTY(kEdsPropID_ISOSpeed)
+    EDS_PROPERTY(kEdsPropID_Av)
+    EDS_PROPERTY(kEdsPropID_Tv)
+    EDS_PROPERTY(kEdsPropID_AvailableShots)
+    EDS_PROPERTY(kEdsPropID_FocusInfo)
+    EDS_PROPERTY(kEdsPropID_Evf_OutputDevice)
+    EDS_PROPERTY(kEdsPropID_Evf_AFMode)
+    EDS_PROPERTY(kEdsPropID_Evf_Zoom)
+    EDS_PROPERTY(kEdsPropID_Evf_ZoomPosition)
+}
+
+#undef EDS_PROPERTY
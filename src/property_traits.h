@@ -0,0 +1,90 @@
+#pragma once
+
+#include <stddef.h>
+
+#include "EDSDK.h"
+#include "EDSDKErrors.h"
+#include "EDSDKTypes.h"
+
+#pragma mark - Drive mode
+
+#define EDS_DRIVE_MODE_SINGLE_FRAME 0x00000000L
+#define EDS_DRIVE_MODE_CONTINUOUS_SHOOTING 0x00000001L
+#define EDS_DRIVE_MODE_VIDEO 0x00000002L
+#define EDS_DRIVE_MODE_HIGH_SPEED_CONTINUOUS_SHOOTING 0x00000004L
+#define EDS_DRIVE_MODE_LOW_SPEED_CONTINUOUS_SHOOTING 0x00000005L
+#define EDS_DRIVE_MODE_SILENT_SINGLE_SHOOTING 0x00000006L
+#define EDS_DRIVE_MODE_10SEC_SELF_TIMER_AND_CONTINUOUS_SHOOTING 0x00000007L
+#define EDS_DRIVE_MODE_10SEC_SELF_TIMER 0x00000010L
+#define EDS_DRIVE_MODE_2SEC_SELF_TIMER 0x00000011L
+
+namespace eds
+{
+    // Legal values of an EdsUInt32 property, empty if the camera decides
+    // (Av and Tv depend on the lens and the AE mode)
+    struct PropertyValues
+    {
+        const EdsUInt32* values;
+        size_t count;
+
+        bool isEmpty() const;
+        bool contains(EdsUInt32 value) const;
+        EdsUInt32 operator[](size_t index) const;
+    };
+
+    // Everything known about a property at runtime, for code that only has the ID
+    struct PropertyDescriptor
+    {
+        EdsPropertyID property;
+        const char* name;
+        EdsUInt32 size;
+        PropertyValues values;
+    };
+
+    // Compile time description of a camera property. Only the specializations
+    // below exist, so get<kEdsPropID_X>() on an undescribed property or with
+    // the wrong value type doesn't compile.
+    template<EdsPropertyID Property>
+    struct PropertyTraits;
+
+#define EDS_PROPERTY(PROPERTY, TYPE)                                    \
+    template<>                                                          \
+    struct PropertyTraits<PROPERTY>                                     \
+    {                                                                   \
+        typedef TYPE Type;                                              \
+        static const EdsPropertyID kProperty = PROPERTY;                \
+        static const EdsUInt32 kSize = sizeof(TYPE);                    \
+        static const PropertyDescriptor& getDescriptor();               \
+    };
+
+    EDS_PROPERTY(kEdsPropID_SaveTo, EdsUInt32)
+    EDS_PROPERTY(kEdsPropID_ImageQuality, EdsUInt32)
+    EDS_PROPERTY(kEdsPropID_AEModeSelect, EdsUInt32)
+    EDS_PROPERTY(kEdsPropID_DriveMode, EdsUInt32)
+    EDS_PROPERTY(kEdsPropID_ISOSpeed, EdsUInt32)
+    EDS_PROPERTY(kEdsPropID_Av, EdsUInt32)
+    EDS_PROPERTY(kEdsPropID_Tv, EdsUInt32)
+    EDS_PROPERTY(kEdsPropID_AvailableShots, EdsUInt32)
+    EDS_PROPERTY(kEdsPropID_FocusInfo, EdsFocusInfo)
+    EDS_PROPERTY(kEdsPropID_Evf_OutputDevice, EdsUInt32)
+    EDS_PROPERTY(kEdsPropID_Evf_AFMode, EdsUInt32)
+    EDS_PROPERTY(kEdsPropID_Evf_Zoom, EdsUInt32)
+    EDS_PROPERTY(kEdsPropID_Evf_ZoomPosition, EdsPoint)
+
+#undef EDS_PROPERTY
+
+    // Descriptor of any property above, NULL for the others
+    const PropertyDescriptor* findPropertyDescriptor(EdsPropertyID property);
+
+    // Only EdsUInt32 properties have value sets, everything else is taken as is
+    inline bool isLegalPropertyValue(const PropertyValues& values, EdsUInt32 value)
+    {
+        return values.isEmpty() || values.contains(value);
+    }
+
+    template<typename T>
+    inline bool isLegalPropertyValue(const PropertyValues&, const T&)
+    {
+        return true;
+    }
+}
@@ -0,0 +1,439 @@
+#include "reconnect_manager.h"
+
+#include <algorithm>
+
+#include "ofMain.h"
+
+namespace
+{
+    // AE mode isn't in here, on most bodies it follows the mode dial and can't be written
+    const EdsPropertyID kSettingsProperties[] =
+    {
+        kEdsPropID_SaveTo,
+        kEdsPropID_ImageQuality,
+        kEdsPropID_DriveMode,
+        kEdsPropID_ISOSpeed,
+        kEdsPropID_Av,
+        kEdsPropID_Tv
+    };
+
+    const EdsPropertyID kEvfProperties[] =
+    {
+        kEdsPropID_Evf_AFMode,
+        kEdsPropID_Evf_Zoom,
+        kEdsPropID_Evf_ZoomPosition
+    };
+
+    double millisSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() / 1000.0;
+    }
+}
+
+namespace eds
+{
+    ReconnectManager::ReconnectManager(CameraManager& cameras)
+    : mCameras(cameras)
+    , bRunning(false)
+    , bRescan(false)
+    , mUnknown(0)
+    , mReconnects(0)
+    , mReplayed(0)
+    , mFirstFrames(0)
+    , mLastFirstFrameMillis(0.0)
+    , mFirstFrameMillisSum(0.0)
+    , mFirstFrameMillisMax(0.0)
+    {
+    }
+
+    ReconnectManager::~ReconnectManager()
+    {
+        stop();
+    }
+
+    void ReconnectManager::drop(unsigned int index, bool liveview)
+    {
+        CameraSession* session_ = mCameras.getSession(index);
+
+        if (NULL == session_ || !session_->isOpen())
+        {
+            return;
+        }
+
+        Dropped dropped_;
+        dropped_.index = index;
+        dropped_.bLiveview = liveview;
+        dropped_.serialNumber = session_->getSerialNumber();
+        dropped_.portName = session_->getPortName();
+
+        // the camera is already gone, only what's cached can be saved
+        PropertyCache& cache_ = session_->getPropertyCache();
+        cache_.snapshot(kSettingsProperties, sizeof(kSettingsProperties) / sizeof(kSettingsProperties[0]), dropped_.settings);
+        cache_.snapshot(kEvfProperties, sizeof(kEvfProperties) / sizeof(kEvfProperties[0]), dropped_.evf);
+
+        mCameras.close(index);
+
+        std::lock_guard<std::mutex> lock_(mMutex);
+
+        for (size_t i = 0; i < mDropped.size(); ++i)
+        {
+            if (index == mDropped[i].index)
+            {
+                mDropped[i] = dropped_;
+                return;
+            }
+        }
+
+        mDropped.push_back(dropped_);
+    }
+
+    bool ReconnectManager::hasDropped() const
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+        return !mDropped.empty();
+    }
+
+    bool ReconnectManager::reconnect()
+    {
+        {
+            std::lock_guard<std::mutex> lock_(mMutex);
+
+            if (mDropped.empty())
+            {
+                return false;
+            }
+
+            mRequested = std::chrono::steady_clock::now();
+
+            // the running scan goes over the camera list once more when it's done
+            if (bRunning)
+            {
+                bRescan = true;
+                return true;
+            }
+
+            bRunning = true;
+            bRescan = false;
+        }
+
+        if (mThread.joinable())
+        {
+            mThread.join();
+        }
+
+        mThread = std::thread(&ReconnectManager::threadedFunction, this);
+        return true;
+    }
+
+    void ReconnectManager::stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock_(mMutex);
+            bRescan = false;
+        }
+
+        if (mThread.joinable())
+        {
+            mThread.join();
+        }
+
+        std::lock_guard<std::mutex> lock_(mMutex);
+
+        mDropped.clear();
+        mFinished.clear();
+        mAwaitingFrame.clear();
+    }
+
+    std::vector<ReconnectManager::Reconnect> ReconnectManager::update()
+    {
+        std::vector<Reconnect> finished_;
+
+        {
+            std::lock_guard<std::mutex> lock_(mMutex);
+
+            if (mFinished.empty())
+            {
+                return finished_;
+            }
+
+            finished_.swap(mFinished);
+        }
+
+        for (size_t i = 0; i < finished_.size(); ++i)
+        {
+            ++mReconnects;
+            mReplayed += finished_[i].replayed;
+            mAwaitingFrame[finished_[i].index] = finished_[i].requested;
+        }
+
+        return finished_;
+    }
+
+    bool ReconnectManager::markFirstFrame(unsigned int index)
+    {
+        if (mAwaitingFrame.empty())
+        {
+            return false;
+        }
+
+        std::map<unsigned int, std::chrono::steady_clock::time_point>::iterator it_ = mAwaitingFrame.find(index);
+
+        if (mAwaitingFrame.end() == it_)
+        {
+            return false;
+        }
+
+        mLastFirstFrameMillis = millisSince(it_->second);
+        mFirstFrameMillisSum += mLastFirstFrameMillis;
+        mFirstFrameMillisMax = std::max(mFirstFrameMillisMax, mLastFirstFrameMillis);
+        ++mFirstFrames;
+
+        mAwaitingFrame.erase(it_);
+        return true;
+    }
+
+    uint64_t ReconnectManager::getReconnectCount() const
+    {
+        return mReconnects;
+    }
+
+    uint64_t ReconnectManager::getUnknownCount() const
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+        return mUnknown;
+    }
+
+    uint64_t ReconnectManager::getReplayedCount() const
+    {
+        return mReplayed;
+    }
+
+    double ReconnectManager::getLastFirstFrameMillis() const
+    {
+        return mLastFirstFrameMillis;
+    }
+
+    double ReconnectManager::getFirstFrameMillisAverage() const
+    {
+        return 0 == mFirstFrames ? 0.0 : mFirstFrameMillisSum / mFirstFrames;
+    }
+
+    double ReconnectManager::getFirstFrameMillisMax() const
+    {
+        return mFirstFrameMillisMax;
+    }
+
+    void ReconnectManager::threadedFunction()
+    {
+        for (;;)
+        {
+            scan();
+
+            std::lock_guard<std::mutex> lock_(mMutex);
+
+            if (!bRescan || mDropped.empty())
+            {
+                bRunning = false;
+                return;
+            }
+
+            bRescan = false;
+        }
+    }
+
+    void ReconnectManager::scan()
+    {
+        EdsCameraListRef cameraList_ = NULL;
+        EdsUInt32 count_ = 0;
+
+        if (EDS_ERR_OK != EdsGetCameraList(&cameraList_))
+        {
+            return;
+        }
+
+        EdsGetChildCount(cameraList_, &count_);
+
+        for (EdsUInt32 i = 0; i < count_ && hasDropped(); ++i)
+        {
+            EdsCameraRef camera_ = NULL;
+
+            if (EDS_ERR_OK != EdsGetChildAtIndex(cameraList_, i, &camera_))
+            {
+                continue;
+            }
+
+            // the device info doesn't need a session, cameras still open are skipped without one
+            EdsDeviceInfo info_;
+            std::string port_;
+
+            if (EDS_ERR_OK == EdsGetDeviceInfo(camera_, &info_))
+            {
+                info_.szPortName[EDS_MAX_NAME - 1] = '\0';
+                port_ = info_.szPortName;
+            }
+
+            if (port_.empty() || isPortOpen(port_))
+            {
+                EdsRelease(camera_);
+                continue;
+            }
+
+            restore(camera_, port_);
+        }
+
+        EdsRelease(cameraList_);
+    }
+
+    bool ReconnectManager::restore(EdsCameraRef camera, const std::string& portName)
+    {
+        Dropped dropped_;
+
+        {
+            std::lock_guard<std::mutex> lock_(mMutex);
+
+            if (mDropped.empty())
+            {
+                EdsRelease(camera);
+                return false;
+            }
+
+            // a body usually comes back on the port it left from
+            size_t candidate_ = 0;
+
+            for (size_t i = 0; i < mDropped.size(); ++i)
+            {
+                if (portName == mDropped[i].portName)
+                {
+                    candidate_ = i;
+                    break;
+                }
+            }
+
+            dropped_ = mDropped[candidate_];
+        }
+
+        auto start_ = std::chrono::steady_clock::now();
+        const CameraSession::Settings& settings_ = mCameras.getSettings();
+        CameraSession* session_ = mCameras.getSession(dropped_.index);
+
+        // the session takes the reference, a second try needs one of its own
+        EdsRetain(camera);
+
+        if (EDS_ERR_OK != session_->reopen(camera, settings_))
+        {
+            ofLogError("eds::ReconnectManager") << "camera on " << portName << " could not be opened";
+            EdsRelease(camera);
+            return false;
+        }
+
+        // replugged into another port, or another dropped body took this one's port
+        if (!dropped_.serialNumber.empty() && session_->getSerialNumber() != dropped_.serialNumber)
+        {
+            std::string serialNumber_ = session_->getSerialNumber();
+            session_->close();
+
+            bool found_ = false;
+
+            {
+                std::lock_guard<std::mutex> lock_(mMutex);
+
+                for (size_t i = 0; i < mDropped.size() && !found_; ++i)
+                {
+                    if (serialNumber_ == mDropped[i].serialNumber)
+                    {
+                        dropped_ = mDropped[i];
+                        found_ = true;
+                    }
+                }
+
+                if (!found_)
+                {
+                    ++mUnknown;
+                }
+            }
+
+            if (!found_)
+            {
+                ofLogWarning("eds::ReconnectManager") << "camera " << serialNumber_ << " on " << portName << " wasn't part of the rig";
+                EdsRelease(camera);
+                return false;
+            }
+
+            session_ = mCameras.getSession(dropped_.index);
+
+            if (EDS_ERR_OK != session_->reopen(camera, settings_))
+            {
+                ofLogError("eds::ReconnectManager") << "camera " << serialNumber_ << " could not be opened";
+                return false;
+            }
+        }
+        else
+        {
+            EdsRelease(camera);
+        }
+
+        Reconnect reconnect_;
+        reconnect_.index = dropped_.index;
+        reconnect_.bLiveview = dropped_.bLiveview;
+        reconnect_.replayed = 0;
+        reconnect_.snapshotSize = dropped_.settings.getEntries().size() + dropped_.evf.getEntries().size();
+        reconnect_.openMillis = millisSince(start_);
+
+        start_ = std::chrono::steady_clock::now();
+
+        // queued behind the prefetch of open(), which read the current values, so only the differences are written
+        PropertyCache& cache_ = session_->getPropertyCache();
+        CommandExecutor& executor_ = session_->getCommandExecutor();
+        EdsError error_ = executor_.execute(kCommandClass_Property, [&cache_, &dropped_, &reconnect_]() { return cache_.apply(dropped_.settings, &reconnect_.replayed); });
+
+        if (dropped_.bLiveview && EDS_ERR_OK == error_)
+        {
+            size_t replayed_ = 0;
+            error_ = session_->startLiveview();
+
+            if (EDS_ERR_OK == error_)
+            {
+                error_ = executor_.execute(kCommandClass_Property, [&cache_, &dropped_, &replayed_]() { return cache_.apply(dropped_.evf, &replayed_); });
+                reconnect_.replayed += replayed_;
+            }
+        }
+
+        if (EDS_ERR_OK != error_)
+        {
+            ofLogError("eds::ReconnectManager") << session_->getName() << ": settings could not be restored: " << std::hex << error_;
+        }
+
+        reconnect_.replayMillis = millisSince(start_);
+
+        std::lock_guard<std::mutex> lock_(mMutex);
+
+        reconnect_.requested = mRequested;
+
+        for (size_t i = 0; i < mDropped.size(); ++i)
+        {
+            if (dropped_.index == mDropped[i].index)
+            {
+                mDropped.erase(mDropped.begin() + i);
+                break;
+            }
+        }
+
+        mFinished.push_back(reconnect_);
+        return true;
+    }
+
+    bool ReconnectManager::isPortOpen(const std::string& portName) const
+    {
+        for (unsigned int i = 0; i < mCameras.getSessionCount(); ++i)
+        {
+            CameraSession* session_ = mCameras.getSession(i);
+
+            if (session_->isOpen() && portName == session_->getPortName())
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "EDSDK.h"
+#include "EDSDKErrors.h"
+#include "EDSDKTypes.h"
+
+#include "camera_manager.h"
+#include "property_cache.h"
+
+namespace eds
+{
+    // Brings a replugged body back without reopening the whole rig. drop()
+    // snapshots what the property cache knows about a camera that shut down
+    // and closes its session. reconnect() then looks for it on a background
+    // thread: a camera on a port no open session uses is reopened in the
+    // dropped session's slot (matched by body serial number), only the
+    // snapshot values that differ from what the camera came back with are
+    // written, and liveview is restarted if the body had it.
+    //
+    // update() hands finished reconnects to the UI thread. Time to first
+    // frame runs from reconnect() to markFirstFrame().
+    class ReconnectManager
+    {
+    public:
+        struct Reconnect
+        {
+            unsigned int index;
+            bool bLiveview;
+            // values written back, the others already matched the snapshot
+            size_t replayed;
+            size_t snapshotSize;
+            double openMillis;
+            double replayMillis;
+            std::chrono::steady_clock::time_point requested;
+        };
+
+        explicit ReconnectManager(CameraManager& cameras);
+        ~ReconnectManager();
+
+        // Has to come before anything else closes the session, the cache is cleared after that
+        void drop(unsigned int index, bool liveview);
+        bool hasDropped() const;
+        // From the camera added event. Returns false if there is nothing to look for.
+        bool reconnect();
+        // Waits for a running reconnect and forgets every dropped body
+        void stop();
+
+        // UI thread only
+        std::vector<Reconnect> update();
+        // Returns true for the first frame after a reconnect
+        bool markFirstFrame(unsigned int index);
+
+        uint64_t getReconnectCount() const;
+        // Cameras that showed up without having been dropped, left alone
+        uint64_t getUnknownCount() const;
+        uint64_t getReplayedCount() const;
+        double getLastFirstFrameMillis() const;
+        double getFirstFrameMillisAverage() const;
+        double getFirstFrameMillisMax() const;
+
+    private:
+        struct Dropped
+        {
+            unsigned int index;
+            bool bLiveview;
+            std::string serialNumber;
+            std::string portName;
+            PropertyProfile settings;
+            // only accepted with liveview running
+            PropertyProfile evf;
+        };
+
+        ReconnectManager(const ReconnectManager&);
+        ReconnectManager& operator=(const ReconnectManager&);
+
+        void threadedFunction();
+        void scan();
+        bool restore(EdsCameraRef camera, const std::string& portName);
+        bool isPortOpen(const std::string& portName) const;
+
+        CameraManager& mCameras;
+        std::thread mThread;
+
+        mutable std::mutex mMutex;
+        bool bRunning;
+        bool bRescan;
+        std::chrono::steady_clock::time_point mRequested;
+        std::vector<Dropped> mDropped;
+        std::vector<Reconnect> mFinished;
+        uint64_t mUnknown;
+
+        std::map<unsigned int, std::chrono::steady_clock::time_point> mAwaitingFrame;
+        uint64_t mReconnects;
+        uint64_t mReplayed;
+        uint64_t mFirstFrames;
+        double mLastFirstFrameMillis;
+        double mFirstFrameMillisSum;
+        double mFirstFrameMillisMax;
+    };
+}
@@ -0,0 +1,314 @@
+#include "tiff_reader.h"
+
+namespace eds
+{
+    TiffReader::TiffReader()
+    : mHeader(NULL)
+    , mHeaderOffset(0)
+    , mSize(0)
+    , bLittleEndian(true)
+    , mFirstIfd(0)
+    {
+    }
+
+    bool TiffReader::open(const BufferView& data, size_t header)
+    {
+        mData = data;
+        mHeader = NULL;
+        mHeaderOffset = header;
+        mSize = 0;
+        mFirstIfd = 0;
+
+        if (data.size < header + 8)
+        {
+            return false;
+        }
+
+        const unsigned char* header_ = (const unsigned char*)data.data + header;
+
+        if ('I' == header_[0] && 'I' == header_[1])
+        {
+            bLittleEndian = true;
+        }
+        else if ('M' == header_[0] && 'M' == header_[1])
+        {
+            bLittleEndian = false;
+        }
+        else
+        {
+            return false;
+        }
+
+        mHeader = header_;
+        mSize = data.size - header;
+
+        uint16_t magic_ = 0;
+
+        if (!read16(2, magic_) || 42 != magic_ || !read32(4, mFirstIfd))
+        {
+            mHeader = NULL;
+            return false;
+        }
+
+        return true;
+    }
+
+    bool TiffReader::isOpen() const
+    {
+        return NULL != mHeader;
+    }
+
+    bool TiffReader::isLittleEndian() const
+    {
+        return bLittleEndian;
+    }
+
+    uint32_t TiffReader::getFirstIfd() const
+    {
+        return mFirstIfd;
+    }
+
+    uint32_t TiffReader::getNextIfd(uint32_t ifd) const
+    {
+        uint32_t next_ = 0;
+        read32(ifd + 2 + getEntryCount(ifd) * 12, next_);
+
+        // a loop back would never end
+        return ifd < next_ ? next_ : 0;
+    }
+
+    uint16_t TiffReader::getEntryCount(uint32_t ifd) const
+    {
+        uint16_t count_ = 0;
+
+        if (0 == ifd || !read16(ifd, count_) || !contains(ifd + 2, count_ * 12))
+        {
+            return 0;
+        }
+
+        return count_;
+    }
+
+    bool TiffReader::getEntry(uint32_t ifd, uint16_t index, TiffEntry& entry) const
+    {
+        if (getEntryCount(ifd) <= index)
+        {
+            return false;
+        }
+
+        uint32_t offset_ = ifd + 2 + index * 12;
+
+        read16(offset_, entry.tag);
+        read16(offset_ + 2, entry.type);
+        read32(offset_ + 4, entry.count);
+
+        uint64_t size_ = (uint64_t)getTypeSize(entry.type) * entry.count;
+
+        if (size_ <= 4)
+        {
+            entry.valueOffset = offset_ + 8;
+            return true;
+        }
+
+        return read32(offset_ + 8, entry.valueOffset) && size_ <= 0xFFFFFFFF && contains(entry.valueOffset, (uint32_t)size_);
+    }
+
+    bool TiffReader::findEntry(uint32_t ifd, uint16_t tag, TiffEntry& entry) const
+    {
+        uint16_t count_ = getEntryCount(ifd);
+
+        // entries are sorted by tag, but not every writer gets that right
+        for (uint16_t i = 0; i < count_; ++i)
+        {
+            uint16_t tag_ = 0;
+            read16(ifd + 2 + i * 12, tag_);
+
+            if (tag == tag_)
+            {
+                return getEntry(ifd, i, entry);
+            }
+        }
+
+        return false;
+    }
+
+    bool TiffReader::getUInt(const TiffEntry& entry, uint32_t& value, uint32_t index) const
+    {
+        if (entry.count <= index)
+        {
+            return false;
+        }
+
+        if (kTiffType_Short == entry.type)
+        {
+            uint16_t short_ = 0;
+
+            if (!read16(entry.valueOffset + index * 2, short_))
+            {
+                return false;
+            }
+
+            value = short_;
+            return true;
+        }
+
+        if (kTiffType_Long == entry.type || kTiffType_SLong == entry.type)
+        {
+            return read32(entry.valueOffset + index * 4, value);
+        }
+
+        if (kTiffType_Byte == entry.type || kTiffType_Undefined == entry.type)
+        {
+            if (!contains(entry.valueOffset + index, 1))
+            {
+                return false;
+            }
+
+            value = mHeader[entry.valueOffset + index];
+            return true;
+        }
+
+        return false;
+    }
+
+    bool TiffReader::getRational(const TiffEntry& entry, int64_t& numerator, int64_t& denominator, uint32_t index) const
+    {
+        if (entry.count <= index || (kTiffType_Rational != entry.type && kTiffType_SRational != entry.type))
+        {
+            return false;
+        }
+
+        uint32_t numerator_ = 0;
+        uint32_t denominator_ = 0;
+
+        if (!read32(entry.valueOffset + index * 8, numerator_) || !read32(entry.valueOffset + index * 8 + 4, denominator_))
+        {
+            return false;
+        }
+
+        if (kTiffType_SRational == entry.type)
+        {
+            numerator = (int32_t)numerator_;
+            denominator = (int32_t)denominator_;
+        }
+        else
+        {
+            numerator = numerator_;
+            denominator = denominator_;
+        }
+
+        return true;
+    }
+
+    bool TiffReader::getString(const TiffEntry& entry, BufferView& value) const
+    {
+        if (kTiffType_Ascii != entry.type || !getBytes(entry, value))
+        {
+            return false;
+        }
+
+        // stop at the first 0, counts usually include it and sometimes padding after it
+        for (size_t i = 0; i < value.size; ++i)
+        {
+            if (0 == value.data[i])
+            {
+                value.size = i;
+                break;
+            }
+        }
+
+        return true;
+    }
+
+    bool TiffReader::getBytes(const TiffEntry& entry, BufferView& value) const
+    {
+        uint64_t size_ = (uint64_t)getTypeSize(entry.type) * entry.count;
+
+        if (0 == size_ || 0xFFFFFFFF < size_ || !contains(entry.valueOffset, (uint32_t)size_))
+        {
+            return false;
+        }
+
+        value = BufferView((const char*)mHeader + entry.valueOffset, (size_t)size_);
+        return true;
+    }
+
+    bool TiffReader::read16(uint32_t offset, uint16_t& value) const
+    {
+        if (!contains(offset, 2))
+        {
+            return false;
+        }
+
+        const unsigned char* p_ = mHeader + offset;
+        value = bLittleEndian ? (p_[0] | p_[1] << 8) : (p_[0] << 8 | p_[1]);
+
+        return true;
+    }
+
+    bool TiffReader::read32(uint32_t offset, uint32_t& value) const
+    {
+        if (!contains(offset, 4))
+        {
+            return false;
+        }
+
+        const unsigned char* p_ = mHeader + offset;
+
+        if (bLittleEndian)
+        {
+            value = (uint32_t)p_[0] | (uint32_t)p_[1] << 8 | (uint32_t)p_[2] << 16 | (uint32_t)p_[3] << 24;
+        }
+        else
+        {
+            value = (uint32_t)p_[0] << 24 | (uint32_t)p_[1] << 16 | (uint32_t)p_[2] << 8 | (uint32_t)p_[3];
+        }
+
+        return true;
+    }
+
+    size_t TiffReader::getHeaderOffset() const
+    {
+        return mHeaderOffset;
+    }
+
+    const BufferView& TiffReader::getData() const
+    {
+        return mData;
+    }
+
+    uint32_t TiffReader::getTypeSize(uint16_t type)
+    {
+        switch (type)
+        {
+            case kTiffType_Byte:
+            case kTiffType_Ascii:
+            case kTiffType_Undefined:
+            case 6: // SBYTE
+                return 1;
+
+            case kTiffType_Short:
+            case 8: // SSHORT
+                return 2;
+
+            case kTiffType_Long:
+            case kTiffType_SLong:
+            case 11: // FLOAT
+            case 13: // IFD
+                return 4;
+
+            case kTiffType_Rational:
+            case kTiffType_SRational:
+            case 12: // DOUBLE
+                return 8;
+
+            default:
+                return 0;
+        }
+    }
+
+    bool TiffReader::contains(uint32_t offset, uint32_t size) const
+    {
+        return NULL != mHeader && offset <= mSize && size <= mSize - offset;
+    }
+}
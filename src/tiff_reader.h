@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "buffer.h"
+
+namespace eds
+{
+    enum TiffType
+    {
+        kTiffType_Byte = 1,
+        kTiffType_Ascii = 2,
+        kTiffType_Short = 3,
+        kTiffType_Long = 4,
+        kTiffType_Rational = 5,
+        kTiffType_Undefined = 7,
+        kTiffType_SLong = 9,
+        kTiffType_SRational = 10
+    };
+
+    // One IFD entry. valueOffset is where the value bytes are, relative to
+    // the TIFF header: inside the entry itself when they fit in 4 bytes.
+    struct TiffEntry
+    {
+        TiffEntry() : tag(0), type(0), count(0), valueOffset(0) {}
+
+        uint16_t tag;
+        uint16_t type;
+        uint32_t count;
+        uint32_t valueOffset;
+    };
+
+    // Reads TIFF structures (CR2 files, EXIF blocks) in place. Nothing is
+    // copied or parsed up front, every accessor reads straight from the
+    // underlying bytes and checks its bounds, so a truncated or corrupt file
+    // makes it return false rather than read past the end.
+    class TiffReader
+    {
+    public:
+        TiffReader();
+
+        // header is where "II*\0" or "MM\0*" starts, offsets in the file are relative to it
+        bool open(const BufferView& data, size_t header = 0);
+        bool isOpen() const;
+        bool isLittleEndian() const;
+
+        uint32_t getFirstIfd() const;
+        // 0 when there is none
+        uint32_t getNextIfd(uint32_t ifd) const;
+        uint16_t getEntryCount(uint32_t ifd) const;
+        bool getEntry(uint32_t ifd, uint16_t index, TiffEntry& entry) const;
+        bool findEntry(uint32_t ifd, uint16_t tag, TiffEntry& entry) const;
+
+        // SHORT or LONG values
+        bool getUInt(const TiffEntry& entry, uint32_t& value, uint32_t index = 0) const;
+        bool getRational(const TiffEntry& entry, int64_t& numerator, int64_t& denominator, uint32_t index = 0) const;
+        // ASCII values without the terminating 0, still pointing into the file
+        bool getString(const TiffEntry& entry, BufferView& value) const;
+        // Raw value bytes, for UNDEFINED blocks such as the maker note
+        bool getBytes(const TiffEntry& entry, BufferView& value) const;
+
+        bool read16(uint32_t offset, uint16_t& value) const;
+        bool read32(uint32_t offset, uint32_t& value) const;
+
+        // Offset of the TIFF header in the data passed to open()
+        size_t getHeaderOffset() const;
+        const BufferView& getData() const;
+
+        static uint32_t getTypeSize(uint16_t type);
+
+    private:
+        bool contains(uint32_t offset, uint32_t size) const;
+
+        BufferView mData;
+        const unsigned char* mHeader;
+        size_t mHeaderOffset;
+        size_t mSize;
+        bool bLittleEndian;
+        uint32_t mFirstIfd;
+    };
+}
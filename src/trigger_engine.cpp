@@ -0,0 +1,302 @@
+#include "trigger_engine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <thread>
+
+namespace
+{
+    uint64_t nowNanos()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+namespace eds
+{
+    const uint64_t TriggerEngine::kBucketLimits[kBucketCount - 1] = { 50, 100, 250, 500, 1000, 2000, 5000, 10000 };
+
+    TriggerEngine::Shot::Shot(size_t cameraCount, unsigned int participants)
+    : arrived(0)
+    , finished(0)
+    , bReleased(false)
+    , bTimedOut(false)
+    , participants(participants)
+    , deadlineNanos(0)
+    , sendNanos(cameraCount, 0)
+    , returnNanos(cameraCount, 0)
+    {
+    }
+
+    TriggerEngine::TriggerEngine(CameraManager& cameras)
+    : mCameras(cameras)
+    , bArmed(false)
+    , mShots(0)
+    , mBarrierTimeouts(0)
+    , mLastSkew(0)
+    , mSkewSum(0)
+    , mSkewMax(0)
+    , mHistogram(kBucketCount, 0)
+    {
+    }
+
+    size_t TriggerEngine::arm()
+    {
+        size_t armed_ = 0;
+
+        for (unsigned int i = 0; i < mCameras.getSessionCount(); ++i)
+        {
+            CameraSession* session_ = mCameras.getSession(i);
+
+            if (session_->isOpen() && session_->sendCommand(kCommandClass_Shutter, kEdsCameraCommand_PressShutterButton, kEdsCameraCommand_ShutterButton_Halfway))
+            {
+                ++armed_;
+            }
+        }
+
+        bArmed = (0 < armed_);
+        return armed_;
+    }
+
+    void TriggerEngine::disarm()
+    {
+        for (unsigned int i = 0; i < mCameras.getSessionCount(); ++i)
+        {
+            CameraSession* session_ = mCameras.getSession(i);
+
+            if (session_->isOpen())
+            {
+                session_->sendCommand(kCommandClass_Shutter, kEdsCameraCommand_PressShutterButton, kEdsCameraCommand_ShutterButton_OFF);
+            }
+        }
+
+        bArmed = false;
+    }
+
+    bool TriggerEngine::isArmed() const
+    {
+        return bArmed;
+    }
+
+    size_t TriggerEngine::fire(unsigned int barrierTimeoutMillis)
+    {
+        std::vector<CameraSession*> sessions_;
+
+        for (unsigned int i = 0; i < mCameras.getSessionCount(); ++i)
+        {
+            CameraSession* session_ = mCameras.getSession(i);
+
+            if (session_->isOpen())
+            {
+                sessions_.push_back(session_);
+            }
+        }
+
+        if (sessions_.empty())
+        {
+            return 0;
+        }
+
+        // shared with the command threads, a straggler may still hold it after the others are done
+        std::shared_ptr<Shot> shot_(new Shot(mCameras.getSessionCount(), (unsigned int)sessions_.size()));
+        shot_->deadlineNanos = nowNanos() + barrierTimeoutMillis * 1000000ull;
+
+        size_t posted_ = 0;
+
+        for (size_t i = 0; i < sessions_.size(); ++i)
+        {
+            CameraSession* session_ = sessions_[i];
+
+            if (session_->getCommandExecutor().post(kCommandClass_Shutter, [this, shot_, session_]() { return trigger(shot_, session_); }))
+            {
+                ++posted_;
+            }
+        }
+
+        // A session closed while the shot was being set up, the intervalometer fires off the UI thread.
+        // Stand in for it at the barrier and at the end, so the others don't wait for the timeout and the shot is still recorded.
+        for (size_t i = posted_; 0 < posted_ && i < sessions_.size(); ++i)
+        {
+            arrive(*shot_);
+            finish(*shot_);
+        }
+
+        bArmed = false;
+        return posted_;
+    }
+
+    uint64_t TriggerEngine::getShotCount() const
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+        return mShots;
+    }
+
+    uint64_t TriggerEngine::getBarrierTimeoutCount() const
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+        return mBarrierTimeouts;
+    }
+
+    uint64_t TriggerEngine::getLastSkewMicros() const
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+        return mLastSkew;
+    }
+
+    double TriggerEngine::getSkewMicrosAverage() const
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+        return 0 == mShots ? 0.0 : (double)mSkewSum / mShots;
+    }
+
+    uint64_t TriggerEngine::getSkewMicrosMax() const
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+        return mSkewMax;
+    }
+
+    std::vector<uint64_t> TriggerEngine::getSkewHistogram() const
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+        return mHistogram;
+    }
+
+    std::vector<uint64_t> TriggerEngine::getLastOffsetsMicros() const
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+        return mLastOffsets;
+    }
+
+    std::vector<uint64_t> TriggerEngine::getLastSendMicros() const
+    {
+        std::lock_guard<std::mutex> lock_(mMutex);
+        return mLastSends;
+    }
+
+    EdsError TriggerEngine::trigger(const std::shared_ptr<Shot>& shot, CameraSession* session)
+    {
+        Shot& shot_ = *shot;
+
+        arrive(shot_);
+
+        // spin, the wake up latency of a condition variable is the skew we're trying to avoid
+        uint64_t spinUntil_ = std::min(nowNanos() + kSpinMicros * 1000, shot_.deadlineNanos);
+
+        for (unsigned int spins_ = 0; !shot_.bReleased; ++spins_)
+        {
+            if (0 == (spins_ & 0xFF))
+            {
+                if (spinUntil_ < nowNanos())
+                {
+                    break;
+                }
+
+                std::this_thread::yield();
+            }
+        }
+
+        if (!shot_.bReleased)
+        {
+            std::unique_lock<std::mutex> lock_(shot_.mutex);
+            std::chrono::steady_clock::time_point deadline_(std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(shot_.deadlineNanos)));
+
+            if (!shot_.released.wait_until(lock_, deadline_, [&shot_]() { return (bool)shot_.bReleased; }))
+            {
+                shot_.bTimedOut = true;
+            }
+        }
+
+        unsigned int index_ = session->getIndex();
+        EdsCameraRef camera_ = session->getCamera();
+
+        shot_.sendNanos[index_] = nowNanos();
+        EdsError error_ = EdsSendCommand(camera_, kEdsCameraCommand_PressShutterButton, kEdsCameraCommand_ShutterButton_Completely);
+        shot_.returnNanos[index_] = nowNanos();
+
+        EdsSendCommand(camera_, kEdsCameraCommand_PressShutterButton, kEdsCameraCommand_ShutterButton_OFF);
+
+        finish(shot_);
+        return error_;
+    }
+
+    void TriggerEngine::arrive(Shot& shot)
+    {
+        // the last camera to arrive releases everyone
+        if (shot.participants == ++shot.arrived)
+        {
+            // under the lock, a camera between its check and the wait would miss the notification
+            {
+                std::lock_guard<std::mutex> lock_(shot.mutex);
+                shot.bReleased = true;
+            }
+
+            shot.released.notify_all();
+        }
+    }
+
+    void TriggerEngine::finish(Shot& shot)
+    {
+        // the last one done has everybody's timestamps
+        if (shot.participants == ++shot.finished)
+        {
+            record(shot);
+        }
+    }
+
+    void TriggerEngine::record(const Shot& shot)
+    {
+        uint64_t first_ = std::numeric_limits<uint64_t>::max();
+        uint64_t last_ = 0;
+
+        for (size_t i = 0; i < shot.sendNanos.size(); ++i)
+        {
+            if (0 != shot.sendNanos[i] && shot.sendNanos[i] < first_)
+            {
+                first_ = shot.sendNanos[i];
+            }
+
+            if (last_ < shot.sendNanos[i])
+            {
+                last_ = shot.sendNanos[i];
+            }
+        }
+
+        uint64_t skew_ = (last_ - first_) / 1000;
+        size_t bucket_ = 0;
+
+        while (bucket_ < kBucketCount - 1 && kBucketLimits[bucket_] < skew_)
+        {
+            ++bucket_;
+        }
+
+        std::lock_guard<std::mutex> lock_(mMutex);
+
+        ++mShots;
+        ++mHistogram[bucket_];
+        mLastSkew = skew_;
+        mSkewSum += skew_;
+
+        if (mSkewMax < skew_)
+        {
+            mSkewMax = skew_;
+        }
+
+        if (shot.bTimedOut)
+        {
+            ++mBarrierTimeouts;
+        }
+
+        mLastOffsets.assign(shot.sendNanos.size(), 0);
+        mLastSends.assign(shot.sendNanos.size(), 0);
+
+        for (size_t i = 0; i < shot.sendNanos.size(); ++i)
+        {
+            if (0 != shot.sendNanos[i])
+            {
+                mLastOffsets[i] = (shot.sendNanos[i] - first_) / 1000;
+                mLastSends[i] = (shot.returnNanos[i] - shot.sendNanos[i]) / 1000;
+            }
+        }
+    }
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <vector>
+
+#include "EDSDK.h"
+#include "EDSDKErrors.h"
+#include "EDSDKTypes.h"
+
+#include "camera_manager.h"
+
+namespace eds
+{
+    // Fires every open camera of the rig at the same moment. arm() half-presses
+    // all shutters so AF and metering are done ahead of time. fire() queues a
+    // shutter command on each camera's command thread; the threads park on a
+    // shared barrier and the last one to arrive releases them all, so the full
+    // presses go out within microseconds of each other instead of one USB
+    // round trip apart. fire() returns right away.
+    //
+    // The barrier spins for kSpinMicros, which covers an idle rig, then
+    // sleeps on a condition variable so a camera stuck behind slow commands
+    // doesn't hold a core until the others arrive. Its wake-up latency
+    // shows up in the skew of that shot.
+    //
+    // The moment each camera's EdsSendCommand started is recorded, the spread
+    // between the first and the last one of a shot is its trigger skew.
+    class TriggerEngine
+    {
+    public:
+        // Upper bounds of the skew histogram buckets in microseconds, the last bucket is open
+        static const size_t kBucketCount = 9;
+        static const uint64_t kBucketLimits[kBucketCount - 1];
+        static const uint64_t kSpinMicros = 500;
+
+        explicit TriggerEngine(CameraManager& cameras);
+
+        // Returns the number of cameras armed
+        size_t arm();
+        // Lets go of the half-press without shooting
+        void disarm();
+        bool isArmed() const;
+
+        // Cameras that don't reach the barrier in time fire on their own when they get there
+        size_t fire(unsigned int barrierTimeoutMillis = 1000);
+
+        uint64_t getShotCount() const;
+        uint64_t getBarrierTimeoutCount() const;
+        uint64_t getLastSkewMicros() const;
+        double getSkewMicrosAverage() const;
+        uint64_t getSkewMicrosMax() const;
+        std::vector<uint64_t> getSkewHistogram() const;
+        // Offset of each camera's send from the first one in the last shot, by session index
+        std::vector<uint64_t> getLastOffsetsMicros() const;
+        // How long EdsSendCommand took on each camera in the last shot
+        std::vector<uint64_t> getLastSendMicros() const;
+
+    private:
+        struct Shot
+        {
+            Shot(size_t cameraCount, unsigned int participants);
+
+            std::atomic<unsigned int> arrived;
+            std::atomic<unsigned int> finished;
+            std::atomic<bool> bReleased;
+            std::mutex mutex;
+            std::condition_variable released;
+            std::atomic<bool> bTimedOut;
+            unsigned int participants;
+            uint64_t deadlineNanos;
+            // by session index, 0 for cameras that didn't take part
+            std::vector<uint64_t> sendNanos;
+            std::vector<uint64_t> returnNanos;
+        };
+
+        TriggerEngine(const TriggerEngine&);
+        TriggerEngine& operator=(const TriggerEngine&);
+
+        EdsError trigger(const std::shared_ptr<Shot>& shot, CameraSession* session);
+        void arrive(Shot& shot);
+        void finish(Shot& shot);
+        void record(const Shot& shot);
+
+        CameraManager& mCameras;
+        std::atomic<bool> bArmed;
+
+        mutable std::mutex mMutex;
+        uint64_t mShots;
+        uint64_t mBarrierTimeouts;
+        uint64_t mLastSkew;
+        uint64_t mSkewSum;
+        uint64_t mSkewMax;
+        std::vector<uint64_t> mHistogram;
+        std::vector<uint64_t> mLastOffsets;
+        std::vector<uint64_t> mLastSends;
+    };
+}
@@ -0,0 +1,188 @@
+#include "xxhash64.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+    const uint64_t kPrime1 = 11400714785074694791ULL;
+    const uint64_t kPrime2 = 14029467366897019727ULL;
+    const uint64_t kPrime3 = 1609587929392839161ULL;
+    const uint64_t kPrime4 = 9650029242287828579ULL;
+    const uint64_t kPrime5 = 2870177450012600261ULL;
+
+    inline uint64_t rotateLeft(uint64_t value, int bits)
+    {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    // XXH64 is defined on little endian words, which is what every machine we build for uses
+    inline uint64_t read64(const unsigned char* data)
+    {
+        uint64_t value_;
+        memcpy(&value_, data, sizeof(value_));
+        return value_;
+    }
+
+    inline uint32_t read32(const unsigned char* data)
+    {
+        uint32_t value_;
+        memcpy(&value_, data, sizeof(value_));
+        return value_;
+    }
+
+    inline uint64_t round(uint64_t accumulator, uint64_t input)
+    {
+        accumulator += input * kPrime2;
+        accumulator = rotateLeft(accumulator, 31);
+        return accumulator * kPrime1;
+    }
+
+    inline uint64_t mergeRound(uint64_t accumulator, uint64_t value)
+    {
+        accumulator ^= round(0, value);
+        return accumulator * kPrime1 + kPrime4;
+    }
+
+    // four independent lanes per 32 byte stripe, the compiler keeps them all in registers
+    inline const unsigned char* consumeStripes(uint64_t* accumulators, const unsigned char* data, const unsigned char* end)
+    {
+        uint64_t v1_ = accumulators[0];
+        uint64_t v2_ = accumulators[1];
+        uint64_t v3_ = accumulators[2];
+        uint64_t v4_ = accumulators[3];
+
+        while (data + 32 <= end)
+        {
+            v1_ = round(v1_, read64(data));
+            v2_ = round(v2_, read64(data + 8));
+            v3_ = round(v3_, read64(data + 16));
+            v4_ = round(v4_, read64(data + 24));
+            data += 32;
+        }
+
+        accumulators[0] = v1_;
+        accumulators[1] = v2_;
+        accumulators[2] = v3_;
+        accumulators[3] = v4_;
+
+        return data;
+    }
+}
+
+namespace eds
+{
+    XXHash64::XXHash64(uint64_t seed)
+    {
+        reset(seed);
+    }
+
+    void XXHash64::reset(uint64_t seed)
+    {
+        mSeed = seed;
+        mAccumulators[0] = seed + kPrime1 + kPrime2;
+        mAccumulators[1] = seed + kPrime2;
+        mAccumulators[2] = seed;
+        mAccumulators[3] = seed - kPrime1;
+        mTotalSize = 0;
+        mPendingSize = 0;
+    }
+
+    void XXHash64::update(const void* data, size_t size)
+    {
+        const unsigned char* input_ = (const unsigned char*)data;
+        const unsigned char* end_ = input_ + size;
+
+        mTotalSize += size;
+
+        // not enough for a stripe yet
+        if (mPendingSize + size < 32)
+        {
+            memcpy(mPending + mPendingSize, input_, size);
+            mPendingSize += size;
+            return;
+        }
+
+        // complete the stripe left over from the previous chunk
+        if (0 < mPendingSize)
+        {
+            size_t fill_ = 32 - mPendingSize;
+            memcpy(mPending + mPendingSize, input_, fill_);
+            consumeStripes(mAccumulators, mPending, mPending + 32);
+            input_ += fill_;
+            mPendingSize = 0;
+        }
+
+        input_ = consumeStripes(mAccumulators, input_, end_);
+
+        mPendingSize = end_ - input_;
+        memcpy(mPending, input_, mPendingSize);
+    }
+
+    uint64_t XXHash64::digest() const
+    {
+        uint64_t hash_ = 0;
+
+        if (32 <= mTotalSize)
+        {
+            hash_ = rotateLeft(mAccumulators[0], 1) + rotateLeft(mAccumulators[1], 7) + rotateLeft(mAccumulators[2], 12) + rotateLeft(mAccumulators[3], 18);
+
+            for (auto i = 0; i < 4; ++i)
+            {
+                hash_ = mergeRound(hash_, mAccumulators[i]);
+            }
+        }
+        else
+        {
+            hash_ = mSeed + kPrime5;
+        }
+
+        hash_ += mTotalSize;
+
+        const unsigned char* data_ = mPending;
+        const unsigned char* end_ = mPending + mPendingSize;
+
+        while (data_ + 8 <= end_)
+        {
+            hash_ ^= round(0, read64(data_));
+            hash_ = rotateLeft(hash_, 27) * kPrime1 + kPrime4;
+            data_ += 8;
+        }
+
+        if (data_ + 4 <= end_)
+        {
+            hash_ ^= read32(data_) * kPrime1;
+            hash_ = rotateLeft(hash_, 23) * kPrime2 + kPrime3;
+            data_ += 4;
+        }
+
+        while (data_ < end_)
+        {
+            hash_ ^= (*data_) * kPrime5;
+            hash_ = rotateLeft(hash_, 11) * kPrime1;
+            ++data_;
+        }
+
+        hash_ ^= hash_ >> 33;
+        hash_ *= kPrime2;
+        hash_ ^= hash_ >> 29;
+        hash_ *= kPrime3;
+        hash_ ^= hash_ >> 32;
+
+        return hash_;
+    }
+
+    uint64_t XXHash64::hash(const void* data, size_t size, uint64_t seed)
+    {
+        XXHash64 hasher_(seed);
+        hasher_.update(data, size);
+        return hasher_.digest();
+    }
+
+    std::string XXHash64::toHex(uint64_t hash)
+    {
+        char text_[17];
+        snprintf(text_, sizeof(text_), "%016llx", (unsigned long long)hash);
+        return text_;
+    }
+}
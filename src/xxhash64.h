@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+namespace eds
+{
+    // Streaming XXH64. Chunks can be fed as they arrive from the camera, the
+    // digest is the same as hashing the whole file in one go.
+    class XXHash64
+    {
+    public:
+        XXHash64(uint64_t seed = 0);
+
+        void reset(uint64_t seed = 0);
+        void update(const void* data, size_t size);
+        uint64_t digest() const;
+
+        static uint64_t hash(const void* data, size_t size, uint64_t seed = 0);
+        static std::string toHex(uint64_t hash);
+
+    private:
+        uint64_t mAccumulators[4];
+        uint64_t mSeed;
+        uint64_t mTotalSize;
+        unsigned char mPending[32];
+        size_t mPendingSize;
+    };
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "monotonic_clock.h"
+
+// The benchmarks are plain executables printing one table each. Run them by
+// hand on a Release build for numbers; ctest only runs them with --quick, a
+// short pass that keeps them building and running.
+namespace bench
+{
+    inline bool hasFlag(int argc, char** argv, const char* flag)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            if (0 == strcmp(flag, argv[i]))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    inline bool isQuick(int argc, char** argv)
+    {
+        return hasFlag(argc, argv, "--quick");
+    }
+
+    // "--name 1,2,4" as a list of numbers, defaults when the option isn't there
+    inline std::vector<double> getList(int argc, char** argv, const char* name, const std::vector<double>& defaults)
+    {
+        for (int i = 1; i + 1 < argc; ++i)
+        {
+            if (0 != strcmp(name, argv[i]))
+            {
+                continue;
+            }
+
+            std::vector<double> values_;
+            const char* pos_ = argv[i + 1];
+            char* end_ = NULL;
+
+            for (double value_ = strtod(pos_, &end_); end_ != pos_; value_ = strtod(pos_, &end_))
+            {
+                values_.push_back(value_);
+                pos_ = (',' == *end_) ? end_ + 1 : end_;
+            }
+
+            return values_.empty() ? defaults : values_;
+        }
+
+        return defaults;
+    }
+
+    inline double getValue(int argc, char** argv, const char* name, double fallback)
+    {
+        std::vector<double> values_ = getList(argc, argv, name, std::vector<double>(1, fallback));
+        return values_[0];
+    }
+
+    // Seconds since a MonotonicClock::nowNanos() reading
+    inline double getSecondsSince(uint64_t startNanos)
+    {
+        return (eds::MonotonicClock::nowNanos() - startNanos) / 1e9;
+    }
+}
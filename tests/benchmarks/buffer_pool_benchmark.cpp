@@ -0,0 +1,134 @@
+#include "buffer_pool.h"
+
+#include <random>
+
+#include "alloc_counter.h"
+#include "benchmark.h"
+
+// BufferPool against a fresh Buffer per frame, on a capture trace: liveview
+// at 30 frames per second, and every two seconds a JPEG + RAW shot from each
+// camera of the rig. Every frame is one copy out of an SDK stream, like
+// DownloadManager does, and is dropped right after.
+//
+//   buffer_pool_benchmark [--seconds 60] [--cameras 4]
+
+namespace
+{
+    enum
+    {
+        kEvfPerSecond = 30,
+        kShotEverySeconds = 2
+    };
+
+    struct Frame
+    {
+        eds::FrameClass frameClass;
+        long size;
+    };
+
+    std::vector<Frame> makeTrace(unsigned int seconds, unsigned int cameras)
+    {
+        std::mt19937 random_(7);
+        std::vector<Frame> trace_;
+
+        for (unsigned int i = 0; i < seconds * kEvfPerSecond; ++i)
+        {
+            Frame evf_ = { eds::kFrameClass_Evf, 90 * 1024 + (long)(random_() % (20 * 1024)) };
+            trace_.push_back(evf_);
+
+            if (0 == i % (kShotEverySeconds * kEvfPerSecond))
+            {
+                for (unsigned int j = 0; j < cameras; ++j)
+                {
+                    Frame jpeg_ = { eds::kFrameClass_Jpeg, 8 * 1024 * 1024 + (long)(random_() % (4 * 1024 * 1024)) };
+                    Frame raw_ = { eds::kFrameClass_Raw, 30 * 1024 * 1024 + (long)(random_() % (15 * 1024 * 1024)) };
+                    trace_.push_back(jpeg_);
+                    trace_.push_back(raw_);
+                }
+            }
+        }
+
+        return trace_;
+    }
+
+    struct Result
+    {
+        double micros[eds::kFrameClass_Count];
+        unsigned int frames[eds::kFrameClass_Count];
+        double seconds;
+        uint64_t allocations;
+        uint64_t allocatedBytes;
+    };
+
+    template <typename Copy>
+    Result replay(const std::vector<Frame>& trace, const std::vector<char>& stream, Copy copy)
+    {
+        Result result_ = {};
+        uint64_t allocations_ = eds::AllocationCounter::getThreadCount();
+        uint64_t bytes_ = eds::AllocationCounter::getThreadBytes();
+        uint64_t start_ = eds::MonotonicClock::nowNanos();
+
+        for (size_t i = 0; i < trace.size(); ++i)
+        {
+            uint64_t frameStart_ = eds::MonotonicClock::nowNanos();
+            copy(&stream[0], trace[i].size);
+
+            result_.micros[trace[i].frameClass] += (eds::MonotonicClock::nowNanos() - frameStart_) / 1000.0;
+            ++result_.frames[trace[i].frameClass];
+        }
+
+        result_.seconds = bench::getSecondsSince(start_);
+        result_.allocations = eds::AllocationCounter::getThreadCount() - allocations_;
+        result_.allocatedBytes = eds::AllocationCounter::getThreadBytes() - bytes_;
+
+        return result_;
+    }
+
+    void print(const char* name, const Result& result)
+    {
+        printf("%-8s", name);
+
+        for (int i = 0; i < eds::kFrameClass_Count; ++i)
+        {
+            printf(" %11.1f", 0 < result.frames[i] ? result.micros[i] / result.frames[i] : 0.0);
+        }
+
+        printf(" %9.2f %12llu %12.1f\n", result.seconds, (unsigned long long)result.allocations, result.allocatedBytes / (1024.0 * 1024.0));
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool quick_ = bench::isQuick(argc, argv);
+    unsigned int seconds_ = (unsigned int)bench::getValue(argc, argv, "--seconds", quick_ ? 4 : 60);
+    unsigned int cameras_ = (unsigned int)bench::getValue(argc, argv, "--cameras", quick_ ? 1 : 4);
+
+    std::vector<Frame> trace_ = makeTrace(seconds_, cameras_);
+    std::vector<char> stream_(eds::BufferPool::getCapacity(eds::kFrameClass_Raw), 'x');
+
+    printf("%u s of capture, %u cameras, %u frames\n", seconds_, cameras_, (unsigned int)trace_.size());
+    printf("%-8s %11s %11s %11s %9s %12s %12s\n", "", "evf us", "jpeg us", "raw us", "total s", "allocations", "allocated MB");
+
+    // the buffer is gone after every frame, so is its storage
+    Result adHoc_ = replay(trace_, stream_, [](const char* data_, long size_)
+    {
+        eds::Buffer buffer_;
+        buffer_.set(data_, size_);
+    });
+
+    print("ad-hoc", adHoc_);
+
+    eds::BufferPool pool_;
+
+    // the storage comes back to the pool and is reused by the next frame of its class
+    Result pooled_ = replay(trace_, stream_, [&pool_](const char* data_, long size_)
+    {
+        eds::BufferPool::Handle buffer_ = pool_.acquire(size_);
+        buffer_->set(data_, size_);
+    });
+
+    print("pool", pooled_);
+    printf("pool hits %llu, misses %llu\n", (unsigned long long)pool_.getHitCount(), (unsigned long long)pool_.getMissCount());
+
+    return 0;
+}
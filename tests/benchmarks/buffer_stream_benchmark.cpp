@@ -0,0 +1,203 @@
+#include "buffer.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <streambuf>
+
+#include "benchmark.h"
+
+// Buffer::set(std::istream&) on files from 100 KB to 100 MB against the 1 KB
+// chunk loop it used to be, once on a seekable file, where set() makes one
+// sized read, and once on a stream that can't seek (a pipe), where it fills
+// growing chunks.
+// The files are written to --dir and removed afterwards, the first read of
+// each warms the page cache so every reader sees the same cached file.
+//
+//   buffer_stream_benchmark [--dir .] [--repeat 5]
+
+namespace
+{
+    // Reads a file through 64 KB underflows and can't seek, like a pipe
+    class UnsizedFileBuf : public std::streambuf
+    {
+    public:
+        explicit UnsizedFileBuf(const std::string& path)
+        : mFile(fopen(path.c_str(), "rb"))
+        , mBuffer(64 * 1024)
+        {
+        }
+
+        ~UnsizedFileBuf()
+        {
+            if (NULL != mFile)
+            {
+                fclose(mFile);
+            }
+        }
+
+    protected:
+        int_type underflow()
+        {
+            size_t read_ = NULL != mFile ? fread(&mBuffer[0], 1, mBuffer.size(), mFile) : 0;
+
+            if (0 == read_)
+            {
+                return traits_type::eof();
+            }
+
+            setg(&mBuffer[0], &mBuffer[0], &mBuffer[0] + read_);
+            return traits_type::to_int_type(mBuffer[0]);
+        }
+
+    private:
+        UnsizedFileBuf(const UnsizedFileBuf&);
+        UnsizedFileBuf& operator=(const UnsizedFileBuf&);
+
+        FILE* mFile;
+        std::vector<char> mBuffer;
+    };
+
+    // Buffer::set(std::istream&) before the sized read. Its clear() shrank the
+    // storage, so every read started from an empty vector.
+    size_t readInSmallChunks(std::istream& stream)
+    {
+        std::vector<char> buffer_;
+        char temp_[1024];
+        size_t size_ = 0;
+
+        stream.read(temp_, 1024);
+
+        auto n_ = stream.gcount();
+
+        while (n_ > 0)
+        {
+            buffer_.resize(size_ + n_ + 1, 0);
+            memcpy(&buffer_[0] + size_, temp_, n_);
+
+            size_ += n_;
+
+            if (stream)
+            {
+                stream.read(temp_, 1024);
+                n_ = stream.gcount();
+            }
+            else
+            {
+                n_ = 0;
+            }
+        }
+
+        return size_;
+    }
+
+    bool writeFile(const std::string& path, size_t size)
+    {
+        std::ofstream file_(path.c_str(), std::ios::binary);
+        std::vector<char> chunk_(1024 * 1024);
+
+        for (size_t i = 0; i < chunk_.size(); ++i)
+        {
+            chunk_[i] = (char)(i * 31);
+        }
+
+        for (size_t written_ = 0; written_ < size && file_; written_ += chunk_.size())
+        {
+            file_.write(&chunk_[0], std::min(chunk_.size(), size - written_));
+        }
+
+        return (bool)file_;
+    }
+
+    // Best of repeat, read() returns the number of bytes it got
+    template <typename Read>
+    double best(unsigned int repeat, size_t size, Read read)
+    {
+        double best_ = 0.0;
+
+        for (unsigned int i = 0; i < repeat; ++i)
+        {
+            uint64_t start_ = eds::MonotonicClock::nowNanos();
+
+            if (size != read())
+            {
+                fprintf(stderr, "short read\n");
+                exit(1);
+            }
+
+            double seconds_ = bench::getSecondsSince(start_);
+            best_ = (0 == i) ? seconds_ : std::min(best_, seconds_);
+        }
+
+        return best_;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool quick_ = bench::isQuick(argc, argv);
+    std::vector<double> sizes_ = quick_ ? std::vector<double>{ 0.1, 1 } : std::vector<double>{ 0.1, 1, 10, 40, 100 };
+    unsigned int repeat_ = (unsigned int)bench::getValue(argc, argv, "--repeat", quick_ ? 1 : 5);
+    std::string dir_ = ".";
+
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        if (0 == strcmp("--dir", argv[i]))
+        {
+            dir_ = argv[i + 1];
+        }
+    }
+
+    printf("MB/s, best of %u\n", repeat_);
+    printf("%10s %14s %14s %14s %14s\n", "size MB", "file, 1 KB", "file, set()", "pipe, 1 KB", "pipe, set()");
+
+    for (size_t i = 0; i < sizes_.size(); ++i)
+    {
+        size_t size_ = (size_t)(sizes_[i] * 1024 * 1024);
+        std::string path_ = dir_ + "/buffer_stream_benchmark.bin";
+
+        if (!writeFile(path_, size_))
+        {
+            fprintf(stderr, "can't write %s\n", path_.c_str());
+            return 1;
+        }
+
+        eds::Buffer buffer_;
+
+        double chunks_ = best(repeat_ + 1, size_, [&]()
+        {
+            std::ifstream file_(path_.c_str(), std::ios::binary);
+            return readInSmallChunks(file_);
+        });
+
+        double unsizedChunks_ = best(repeat_, size_, [&]()
+        {
+            UnsizedFileBuf fileBuf_(path_);
+            std::istream stream_(&fileBuf_);
+            return readInSmallChunks(stream_);
+        });
+
+        double sized_ = best(repeat_, size_, [&]()
+        {
+            std::ifstream file_(path_.c_str(), std::ios::binary);
+            buffer_.set(file_);
+            return (size_t)buffer_.size();
+        });
+
+        double unsized_ = best(repeat_, size_, [&]()
+        {
+            UnsizedFileBuf fileBuf_(path_);
+            std::istream stream_(&fileBuf_);
+            buffer_.set(stream_);
+            return (size_t)buffer_.size();
+        });
+
+        double megabytes_ = size_ / (1024.0 * 1024.0);
+
+        printf("%10.1f %14.1f %14.1f %14.1f %14.1f\n", megabytes_, megabytes_ / chunks_, megabytes_ / sized_, megabytes_ / unsizedChunks_, megabytes_ / unsized_);
+
+        std::remove(path_.c_str());
+    }
+
+    return 0;
+}
@@ -0,0 +1,169 @@
+#include "camera_manager.h"
+
+#include <algorithm>
+
+#include "benchmark.h"
+#include "stub_sdk.h"
+
+// A burst of UI input replayed against a stub body: held w/a/s/d keys and
+// clicks moving the zoom position, arrow keys driving the lens, AF clicks
+// and the odd shutter press, at --keys inputs per second like key repeat.
+// The same burst runs twice, the way ofApp sends it (zoom writes and AF
+// coalesced) and with every input sent on its own. Per command class: what
+// the UI posted, what reached the camera, and post -> start of execution.
+// Settle is the time from the last input until the camera has done all of
+// it, which is how long the liveview lags behind the keys.
+//
+//   command_executor_benchmark [--keys 30] [--seconds 3] [--command-ms 20] [--property-ms 40]
+
+namespace
+{
+    enum Input
+    {
+        kInput_ShutterPress,
+        kInput_ShutterRelease,
+        kInput_Af,
+        kInput_Lens,
+        kInput_Zoom
+    };
+
+    // Every 40 inputs: a zoom key held for 20 repeats, an arrow key held
+    // for 12, a double click AF, a shutter press and release, then 4 clicks
+    // moving the zoom position
+    Input getInput(unsigned int index)
+    {
+        unsigned int step_ = index % 40;
+
+        if (20 > step_)
+        {
+            return kInput_Zoom;
+        }
+        else if (32 > step_)
+        {
+            return kInput_Lens;
+        }
+        else if (34 > step_)
+        {
+            return kInput_Af;
+        }
+        else if (36 > step_)
+        {
+            return 34 == step_ ? kInput_ShutterPress : kInput_ShutterRelease;
+        }
+
+        return kInput_Zoom;
+    }
+
+    void run(const char* name, bool coalesce, double keysPerSecond, double seconds, double commandMillis, double propertyMillis)
+    {
+        stub::reset(1);
+        stub::getConfig(0).commandMicros = (uint64_t)(commandMillis * 1000);
+        stub::getConfig(0).propertyMicros = (uint64_t)(propertyMillis * 1000);
+
+        eds::EventBus bus_;
+        eds::CameraManager manager_(bus_);
+
+        if (EDS_ERR_OK != manager_.open(eds::CameraSession::Settings()))
+        {
+            fprintf(stderr, "can't open the stub rig\n");
+            exit(1);
+        }
+
+        eds::CameraSession* session_ = manager_.getSession(0);
+        eds::CommandExecutor& executor_ = session_->getCommandExecutor();
+        eds::PropertyCache* cache_ = &session_->getPropertyCache();
+
+        uint64_t posted_[eds::kCommandClass_Count] = {};
+        uint64_t postMicrosMax_ = 0;
+        unsigned int inputs_ = (unsigned int)(keysPerSecond * seconds);
+        uint64_t period_ = (uint64_t)(1e9 / keysPerSecond);
+        uint64_t start_ = eds::MonotonicClock::nowNanos();
+        EdsPoint position_ = { 0, 0 };
+
+        for (unsigned int i = 0; i < inputs_; ++i)
+        {
+            eds::MonotonicClock::sleepUntil(start_ + i * period_);
+
+            Input input_ = getInput(i);
+            uint64_t post_ = eds::MonotonicClock::nowNanos();
+
+            if (kInput_ShutterPress == input_)
+            {
+                session_->sendCommand(eds::kCommandClass_Shutter, kEdsCameraCommand_PressShutterButton, kEdsCameraCommand_ShutterButton_Completely);
+                ++posted_[eds::kCommandClass_Shutter];
+            }
+            else if (kInput_ShutterRelease == input_)
+            {
+                session_->sendCommand(eds::kCommandClass_Shutter, kEdsCameraCommand_PressShutterButton, kEdsCameraCommand_ShutterButton_OFF);
+                ++posted_[eds::kCommandClass_Shutter];
+            }
+            else if (kInput_Af == input_)
+            {
+                session_->sendCommand(eds::kCommandClass_Lens, kEdsCameraCommand_DoEvfAf, Evf_AFMode_Live, coalesce ? kEdsCameraCommand_DoEvfAf : 0);
+                ++posted_[eds::kCommandClass_Lens];
+            }
+            else if (kInput_Lens == input_)
+            {
+                session_->sendCommand(eds::kCommandClass_Lens, kEdsCameraCommand_DriveLensEvf, 0 == i % 2 ? kEdsEvfDriveLens_Far1 : kEdsEvfDriveLens_Near1);
+                ++posted_[eds::kCommandClass_Lens];
+            }
+            else
+            {
+                position_.x = (position_.x + 5) % 1000;
+                position_.y = (position_.y + 3) % 600;
+
+                if (coalesce)
+                {
+                    session_->setProperty<kEdsPropID_Evf_ZoomPosition>(position_);
+                }
+                else
+                {
+                    EdsPoint value_ = position_;
+                    executor_.post(eds::kCommandClass_Property, [cache_, value_]() { return cache_->set<kEdsPropID_Evf_ZoomPosition>(value_); });
+                }
+
+                ++posted_[eds::kCommandClass_Property];
+            }
+
+            postMicrosMax_ = std::max(postMicrosMax_, (eds::MonotonicClock::nowNanos() - post_) / 1000);
+
+            // the property change events the writes raise
+            bus_.dispatch();
+        }
+
+        uint64_t lastInput_ = eds::MonotonicClock::nowNanos();
+
+        // close() runs what is still queued
+        manager_.close();
+        double settleMillis_ = (eds::MonotonicClock::nowNanos() - lastInput_) / 1e6;
+
+        printf("%s: %u inputs, settled %.0f ms after the last one, a post took at most %llu us\n",
+            name, inputs_, settleMillis_, (unsigned long long)postMicrosMax_);
+
+        for (int i = 0; i < eds::kCommandClass_Count; ++i)
+        {
+            eds::CommandClass class_ = (eds::CommandClass)i;
+
+            printf("  %-10s %8llu %10llu %10llu %12.1f %12.1f\n", eds::CommandExecutor::getClassName(class_),
+                (unsigned long long)posted_[i], (unsigned long long)executor_.getExecutedCount(class_), (unsigned long long)executor_.getCoalescedCount(class_),
+                executor_.getLatencyMillisAverage(class_), executor_.getLatencyMillisMax(class_));
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool quick_ = bench::isQuick(argc, argv);
+    double keys_ = bench::getValue(argc, argv, "--keys", 30);
+    double seconds_ = bench::getValue(argc, argv, "--seconds", quick_ ? 1.4 : 3);
+    double commandMillis_ = bench::getValue(argc, argv, "--command-ms", 20);
+    double propertyMillis_ = bench::getValue(argc, argv, "--property-ms", 40);
+
+    printf("%.0f inputs/s for %.1f s, commands take %.0f ms, property writes %.0f ms\n", keys_, seconds_, commandMillis_, propertyMillis_);
+    printf("  %-10s %8s %10s %10s %12s %12s\n", "class", "posted", "executed", "coalesced", "latency ms", "max ms");
+
+    run("coalesced", true, keys_, seconds_, commandMillis_, propertyMillis_);
+    run("one by one", false, keys_, seconds_, commandMillis_, propertyMillis_);
+
+    return 0;
+}
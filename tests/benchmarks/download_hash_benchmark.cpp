@@ -0,0 +1,132 @@
+#include "camera_manager.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#include "benchmark.h"
+#include "capture_manifest.h"
+#include "stub_sdk.h"
+#include "xxhash64.h"
+
+// What hashing every capture while it downloads costs. First XXH64 against
+// a plain copy of the same bytes, then whole downloads from one stub camera
+// over links of --links MB/s (0 is as fast as memory goes): the transfer
+// rate the worker gets, the hash time per shot and its share of the
+// transfer, and the manifest line every shot appends.
+//
+//   download_hash_benchmark [--links 0,40,100] [--shots 20] [--megabytes 8] [--dir .]
+
+namespace
+{
+    template <typename Pass>
+    double getMegabytesPerSecond(size_t size, unsigned int repeat, Pass pass)
+    {
+        double best_ = 0.0;
+
+        for (unsigned int i = 0; i < repeat; ++i)
+        {
+            uint64_t start_ = eds::MonotonicClock::nowNanos();
+            pass();
+            best_ = std::max(best_, size / (1024.0 * 1024.0) / bench::getSecondsSince(start_));
+        }
+
+        return best_;
+    }
+
+    void printInMemory(size_t size, unsigned int repeat)
+    {
+        std::vector<char> source_(size, 'x');
+        std::vector<char> copy_(size);
+        volatile uint64_t hash_ = 0;
+
+        double copyRate_ = getMegabytesPerSecond(size, repeat, [&]() { memcpy(&copy_[0], &source_[0], size); });
+        double hashRate_ = getMegabytesPerSecond(size, repeat, [&]() { hash_ = eds::XXHash64::hash(&source_[0], size); });
+
+        printf("in memory, %.0f MB: copy %.0f MB/s, XXH64 %.0f MB/s, a hash takes %.2fx the time of a copy\n",
+            size / (1024.0 * 1024.0), copyRate_, hashRate_, copyRate_ / hashRate_);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool quick_ = bench::isQuick(argc, argv);
+    std::vector<double> links_ = bench::getList(argc, argv, "--links", quick_ ? std::vector<double>{ 0 } : std::vector<double>{ 0, 40, 100 });
+    unsigned int shots_ = (unsigned int)bench::getValue(argc, argv, "--shots", quick_ ? 4 : 20);
+    double megabytes_ = bench::getValue(argc, argv, "--megabytes", quick_ ? 1 : 8);
+    std::string dir_ = ".";
+
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        if (0 == strcmp("--dir", argv[i]))
+        {
+            dir_ = argv[i + 1];
+        }
+    }
+
+    printInMemory((size_t)(megabytes_ * 1024 * 1024), quick_ ? 1 : 5);
+
+    printf("%u downloads of %.1f MB, one worker\n", shots_, megabytes_);
+    printf("%10s %14s %10s %10s %12s\n", "link MB/s", "transfer MB/s", "hash ms", "overhead", "manifest us");
+
+    std::string manifestPath_ = dir_ + "/download_hash_benchmark.jsonl";
+
+    for (size_t i = 0; i < links_.size(); ++i)
+    {
+        stub::reset(1);
+        stub::getConfig(0).transferMegabytesPerSecond = links_[i];
+
+        eds::CaptureManifest manifest_;
+        std::atomic<uint64_t> manifestMicros_(0);
+
+        if (!manifest_.open(manifestPath_))
+        {
+            fprintf(stderr, "can't open %s\n", manifestPath_.c_str());
+            return 1;
+        }
+
+        {
+            eds::EventBus bus_;
+            eds::CameraManager cameras_(bus_);
+
+            eds::CameraSession::Settings settings_;
+            settings_.downloadThreads = 1;
+            settings_.persist = [&](eds::CameraSession&, const eds::Download& download_)
+            {
+                uint64_t start_ = eds::MonotonicClock::nowNanos();
+                bool appended_ = manifest_.append(std::string(download_.info.szFileName), download_.info, download_.hash);
+                manifestMicros_ += (eds::MonotonicClock::nowNanos() - start_) / 1000;
+                return appended_;
+            };
+
+            if (EDS_ERR_OK != cameras_.open(settings_))
+            {
+                fprintf(stderr, "can't open the stub rig\n");
+                return 1;
+            }
+
+            bus_.subscribe(eds::kEventType_Object, kEdsObjectEvent_DirItemCreated, [&cameras_](const eds::Event& event_)
+            {
+                cameras_.getSession(event_.camera)->getDownloadManager().enqueue(event_.object);
+            });
+
+            for (unsigned int j = 0; j < shots_; ++j)
+            {
+                stub::emitItemCreated(0, "IMG_" + std::to_string(j) + ".JPG", (EdsUInt32)(megabytes_ * 1024 * 1024));
+                bus_.dispatch();
+            }
+
+            cameras_.close();
+
+            eds::DownloadManager& downloads_ = cameras_.getSession(0)->getDownloadManager();
+
+            printf("%10.0f %14.1f %10.2f %9.1f%% %12.1f\n", links_[i], downloads_.getTransferMegabytesPerSecond(), downloads_.getHashMillisAverage(),
+                100.0 * downloads_.getHashOverhead(), (double)manifestMicros_ / std::max<uint64_t>(1, downloads_.getCompletedCount()));
+        }
+
+        manifest_.close();
+        std::remove(manifestPath_.c_str());
+    }
+
+    return 0;
+}
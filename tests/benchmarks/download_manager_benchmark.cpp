@@ -0,0 +1,140 @@
+#include "camera_manager.h"
+
+#include <algorithm>
+
+#include "benchmark.h"
+#include "stub_sdk.h"
+
+// Sustained download throughput of a rig shooting continuously. One thread
+// plays the SDK callback thread: it emits kEdsObjectEvent_DirItemCreated for
+// every camera in turn at --rates shots per second per camera and hands them
+// to the download managers the way the app does, through the bus. Each body
+// transfers at --link MB/s; the stub paces every download on its own, so a
+// camera's link isn't shared between its workers like on a real body.
+//
+// Callback lag is how far behind schedule the callback thread ended up,
+// which is the time enqueue() held it back once a queue was full.
+//
+//   download_manager_benchmark [--rates 2,8,16,32] [--cameras 4] [--megabytes 6]
+//                              [--link 40] [--threads 2] [--seconds 5]
+
+namespace
+{
+    struct Result
+    {
+        double offeredMegabytesPerSecond;
+        double megabytesPerSecond;
+        double queuedMillis;
+        double transferMillis;
+        unsigned int highWaterMark;
+        uint64_t blocked;
+        double lagMillis;
+    };
+
+    Result run(unsigned int cameras, double shotsPerSecond, EdsUInt32 shotBytes, double linkMegabytesPerSecond, unsigned int threads, double seconds)
+    {
+        Result result_ = {};
+
+        stub::reset(cameras);
+
+        for (unsigned int i = 0; i < cameras; ++i)
+        {
+            stub::getConfig(i).transferMegabytesPerSecond = linkMegabytesPerSecond;
+        }
+
+        eds::EventBus bus_;
+        eds::CameraManager manager_(bus_);
+
+        eds::CameraSession::Settings settings_;
+        settings_.downloadThreads = threads;
+        settings_.persist = [](eds::CameraSession&, const eds::Download&) { return true; };
+
+        if (EDS_ERR_OK != manager_.open(settings_))
+        {
+            fprintf(stderr, "can't open the stub rig\n");
+            exit(1);
+        }
+
+        bus_.subscribe(eds::kEventType_Object, kEdsObjectEvent_DirItemCreated, [&manager_](const eds::Event& event_)
+        {
+            manager_.getSession(event_.camera)->getDownloadManager().enqueue(event_.object);
+        });
+
+        uint64_t shots_ = (uint64_t)(seconds * shotsPerSecond);
+        uint64_t period_ = (uint64_t)(1e9 / shotsPerSecond / cameras);
+        uint64_t start_ = eds::MonotonicClock::nowNanos();
+        uint64_t lag_ = 0;
+
+        for (uint64_t i = 0; i < shots_ * cameras; ++i)
+        {
+            uint64_t due_ = start_ + i * period_;
+            eds::MonotonicClock::sleepUntil(due_);
+            lag_ = std::max(lag_, eds::MonotonicClock::nowNanos() - due_);
+
+            unsigned int camera_ = (unsigned int)(i % cameras);
+
+            stub::emitItemCreated(camera_, "IMG_" + std::to_string(i) + ".JPG", shotBytes);
+            bus_.dispatch();
+        }
+
+        for (unsigned int i = 0; i < cameras; ++i)
+        {
+            eds::DownloadManager& downloads_ = manager_.getSession(i)->getDownloadManager();
+
+            result_.highWaterMark = std::max(result_.highWaterMark, downloads_.getQueueHighWaterMark());
+            result_.blocked += downloads_.getBlockedCount();
+        }
+
+        // the backlog counts, the rig kept up only if it is gone by the end
+        manager_.close();
+
+        double elapsed_ = bench::getSecondsSince(start_);
+        double megabytes_ = manager_.getTransferredBytes() / (1024.0 * 1024.0);
+        double queuedMillis_ = 0.0;
+        double transferMillis_ = 0.0;
+
+        for (unsigned int i = 0; i < cameras; ++i)
+        {
+            queuedMillis_ += manager_.getSession(i)->getDownloadManager().getQueuedMillisAverage() / cameras;
+            transferMillis_ += manager_.getSession(i)->getDownloadManager().getTransferMillisAverage() / cameras;
+        }
+
+        result_.offeredMegabytesPerSecond = shotsPerSecond * cameras * shotBytes / (1024.0 * 1024.0);
+        result_.megabytesPerSecond = megabytes_ / elapsed_;
+        result_.queuedMillis = queuedMillis_;
+        result_.transferMillis = transferMillis_;
+        result_.lagMillis = lag_ / 1e6;
+
+        if (shots_ * cameras != manager_.getCompletedCount())
+        {
+            fprintf(stderr, "%llu of %llu shots downloaded\n", (unsigned long long)manager_.getCompletedCount(), (unsigned long long)(shots_ * cameras));
+            exit(1);
+        }
+
+        return result_;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool quick_ = bench::isQuick(argc, argv);
+    std::vector<double> rates_ = bench::getList(argc, argv, "--rates", quick_ ? std::vector<double>{ 10 } : std::vector<double>{ 2, 8, 16, 32 });
+    unsigned int cameras_ = (unsigned int)bench::getValue(argc, argv, "--cameras", quick_ ? 2 : 4);
+    double megabytes_ = bench::getValue(argc, argv, "--megabytes", quick_ ? 1 : 6);
+    double link_ = bench::getValue(argc, argv, "--link", 40);
+    unsigned int threads_ = (unsigned int)bench::getValue(argc, argv, "--threads", 2);
+    double seconds_ = bench::getValue(argc, argv, "--seconds", quick_ ? 0.5 : 5);
+
+    printf("%u cameras, %.1f MB shots, %.0f MB/s links, %u workers per camera\n", cameras_, megabytes_, link_, threads_);
+    printf("%10s %12s %12s %10s %12s %8s %8s %12s\n", "shots/s", "offered MB/s", "MB/s", "queued ms", "transfer ms", "queue", "blocked", "cb lag ms");
+
+    for (size_t i = 0; i < rates_.size(); ++i)
+    {
+        Result result_ = run(cameras_, rates_[i], (EdsUInt32)(megabytes_ * 1024 * 1024), link_, threads_, seconds_);
+
+        printf("%10.1f %12.1f %12.1f %10.1f %12.1f %8u %8llu %12.1f\n", rates_[i], result_.offeredMegabytesPerSecond, result_.megabytesPerSecond,
+            result_.queuedMillis, result_.transferMillis, result_.highWaterMark, (unsigned long long)result_.blocked, result_.lagMillis);
+    }
+
+    return 0;
+}
@@ -0,0 +1,128 @@
+#include "camera_manager.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include "benchmark.h"
+#include "stub_sdk.h"
+
+// How long the SDK callback thread spends in the property handler during a
+// kEdsPropID_AvailableShots storm, the event a body fires for every frame
+// of a burst. One thread per camera calls the handler back to back, --events
+// times each, while the main thread plays update(): every --frame-ms it
+// dispatches the bus to a subscriber that invalidates the cached value.
+// Callback latency is the time of each whole handler call as the SDK sees
+// it; post is the part spent in EventBus::post(). A full queue drops the
+// events it can't take, the table counts them. On fewer cores than
+// cameras the max is mostly a callback thread losing the CPU mid-call.
+//
+//   event_bus_benchmark [--cameras 1,2,4] [--events 200000] [--frame-ms 16] [--capacity 1024]
+
+namespace
+{
+    double getPercentile(const std::vector<uint32_t>& sorted, double percentile)
+    {
+        return sorted.empty() ? 0.0 : sorted[std::min(sorted.size() - 1, (size_t)(sorted.size() * percentile / 100.0))] / 1000.0;
+    }
+
+    void run(unsigned int cameras, unsigned int events, double frameMillis, size_t capacity)
+    {
+        stub::reset(cameras);
+
+        eds::EventBus bus_(capacity);
+        eds::CameraManager manager_(bus_);
+
+        if (EDS_ERR_OK != manager_.open(eds::CameraSession::Settings()))
+        {
+            fprintf(stderr, "can't open the stub rig\n");
+            exit(1);
+        }
+
+        bus_.subscribe(eds::kEventType_Property, kEdsPropID_AvailableShots, [&manager_](const eds::Event& event_)
+        {
+            manager_.getSession(event_.camera)->getPropertyCache().invalidate(event_.code);
+        });
+
+        // opening raised events of its own
+        bus_.dispatch();
+
+        uint64_t droppedBefore_ = bus_.getDroppedCount();
+        uint64_t dispatchedBefore_ = bus_.getDispatchedCount();
+        std::vector< std::vector<uint32_t> > nanos_(cameras);
+        std::vector<std::thread> threads_;
+        std::atomic<unsigned int> running_(cameras);
+        uint64_t start_ = eds::MonotonicClock::nowNanos();
+
+        for (unsigned int i = 0; i < cameras; ++i)
+        {
+            nanos_[i].reserve(events);
+
+            threads_.push_back(std::thread([i, events, &nanos_, &running_]()
+            {
+                for (unsigned int j = 0; j < events; ++j)
+                {
+                    uint64_t call_ = stub::nowNanos();
+                    stub::emitPropertyEvent(i, kEdsPropertyEvent_PropertyChanged, kEdsPropID_AvailableShots, events - j);
+                    nanos_[i].push_back((uint32_t)std::min<uint64_t>(stub::nowNanos() - call_, UINT32_MAX));
+                }
+
+                --running_;
+            }));
+        }
+
+        for (uint64_t frame_ = 1; 0 < running_; ++frame_)
+        {
+            eds::MonotonicClock::sleepUntil(start_ + (uint64_t)(frame_ * frameMillis * 1e6));
+            bus_.dispatch();
+        }
+
+        for (size_t i = 0; i < threads_.size(); ++i)
+        {
+            threads_[i].join();
+        }
+
+        double seconds_ = bench::getSecondsSince(start_);
+
+        bus_.dispatch();
+
+        std::vector<uint32_t> all_;
+
+        for (unsigned int i = 0; i < cameras; ++i)
+        {
+            all_.insert(all_.end(), nanos_[i].begin(), nanos_[i].end());
+        }
+
+        std::sort(all_.begin(), all_.end());
+
+        uint64_t delivered_ = bus_.getDispatchedCount() - dispatchedBefore_;
+        uint64_t dropped_ = bus_.getDroppedCount() - droppedBefore_;
+
+        printf("%8u %12.0f %10llu %10llu %10.2f %10.2f %10.2f %10.1f %10.2f %10.1f %12.2f\n", cameras, all_.size() / seconds_,
+            (unsigned long long)delivered_, (unsigned long long)dropped_,
+            getPercentile(all_, 50), getPercentile(all_, 99), getPercentile(all_, 99.9), all_.empty() ? 0.0 : all_.back() / 1000.0,
+            bus_.getPostMicrosAverage(), bus_.getPostMicrosMax(), bus_.getDeliveryMillisAverage());
+
+        manager_.close();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool quick_ = bench::isQuick(argc, argv);
+    std::vector<double> cameras_ = bench::getList(argc, argv, "--cameras", quick_ ? std::vector<double>{ 2 } : std::vector<double>{ 1, 2, 4 });
+    unsigned int events_ = (unsigned int)bench::getValue(argc, argv, "--events", quick_ ? 20000 : 200000);
+    double frameMillis_ = bench::getValue(argc, argv, "--frame-ms", 16);
+    size_t capacity_ = (size_t)bench::getValue(argc, argv, "--capacity", 1024);
+
+    printf("%u AvailableShots events per camera, dispatched every %.0f ms, queue of %u\n", events_, frameMillis_, (unsigned int)capacity_);
+    printf("%8s %12s %10s %10s %10s %10s %10s %10s %10s %10s %12s\n", "cameras", "events/s", "delivered", "dropped",
+        "p50 us", "p99 us", "p99.9 us", "max us", "post us", "post max", "delivery ms");
+
+    for (size_t i = 0; i < cameras_.size(); ++i)
+    {
+        run((unsigned int)cameras_[i], events_, frameMillis_, capacity_);
+    }
+
+    return 0;
+}
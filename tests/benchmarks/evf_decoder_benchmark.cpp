@@ -0,0 +1,106 @@
+#include "evf_decoder.h"
+
+#include <thread>
+
+#include "benchmark.h"
+#include "stub_sdk.h"
+
+// Frames per second of the EvfDecoder pool by thread count, at full size and
+// with 1/2 and 1/4 DCT scaling. The frames are liveview sized stub jpegs, the
+// stub FreeImage spends --decode-ns per output pixel on each, about what
+// libjpeg-turbo takes for a 960x640 EVF frame by default.
+//
+//   evf_decoder_benchmark [--threads 1,2,4] [--seconds 3] [--decode-ns 8]
+
+namespace
+{
+    const int kEvfWidth = 960;
+    const int kEvfHeight = 640;
+    const size_t kEvfBytes = 80 * 1024;
+    const unsigned int kFrameCount = 16;
+
+    struct Result
+    {
+        double decodedPerSecond;
+        double deliveredPerSecond;
+        double decodeMillis;
+        int scaleDenominator;
+    };
+
+    // The capture thread offers a new frame every millisecond, faster than
+    // any pool keeps up with, and the render thread picks up whatever is ready
+    Result run(const std::vector<eds::Buffer>& jpegs, unsigned int threadCount, int targetWidth, int targetHeight, double seconds)
+    {
+        eds::EvfDecoder decoder_;
+        eds::EvfFrame frame_;
+        eds::DecodedFrame decoded_;
+        Result result_ = { 0.0, 0.0, 0.0, 1 };
+
+        decoder_.setTargetSize(targetWidth, targetHeight);
+        decoder_.start(threadCount);
+
+        uint64_t start_ = eds::MonotonicClock::nowNanos();
+
+        while (bench::getSecondsSince(start_) < seconds)
+        {
+            const eds::Buffer& jpeg_ = jpegs[frame_.sequence % jpegs.size()];
+
+            frame_.jpeg = jpeg_.view();
+            ++frame_.sequence;
+            decoder_.submit(frame_);
+
+            if (decoder_.popLatest(decoded_))
+            {
+                result_.scaleDenominator = decoded_.scaleDenominator;
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        double elapsed_ = bench::getSecondsSince(start_);
+
+        result_.decodedPerSecond = decoder_.getDecodedCount() / elapsed_;
+        result_.deliveredPerSecond = decoder_.getDeliveredCount() / elapsed_;
+        result_.decodeMillis = decoder_.getDecodeMillisAverage();
+
+        decoder_.stop();
+
+        return result_;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool quick_ = bench::isQuick(argc, argv);
+    std::vector<double> threads_ = bench::getList(argc, argv, "--threads", quick_ ? std::vector<double>{ 1, 2 } : std::vector<double>{ 1, 2, 4 });
+    double seconds_ = bench::getValue(argc, argv, "--seconds", quick_ ? 0.2 : 3.0);
+
+    stub::setDecodeNanosPerPixel(bench::getValue(argc, argv, "--decode-ns", 8.0));
+
+    std::vector<eds::Buffer> jpegs_(kFrameCount);
+
+    for (unsigned int i = 0; i < kFrameCount; ++i)
+    {
+        jpegs_[i].allocate(kEvfBytes);
+        stub::makeJpeg(jpegs_[i].getBinaryBuffer(), kEvfBytes, kEvfWidth, kEvfHeight, kEvfBytes, i);
+    }
+
+    // full size, then a window half and a quarter the size of the frame
+    const int targets_[][2] = { { 0, 0 }, { kEvfWidth / 2, kEvfHeight / 2 }, { kEvfWidth / 4, kEvfHeight / 4 } };
+
+    printf("%d x %d frames, %u hardware threads\n", kEvfWidth, kEvfHeight, std::thread::hardware_concurrency());
+    printf("%8s %6s %12s %14s %11s\n", "threads", "scale", "decoded/s", "delivered/s", "decode ms");
+
+    for (size_t i = 0; i < threads_.size(); ++i)
+    {
+        for (size_t j = 0; j < sizeof(targets_) / sizeof(targets_[0]); ++j)
+        {
+            Result result_ = run(jpegs_, (unsigned int)threads_[i], targets_[j][0], targets_[j][1], seconds_);
+
+            printf("%8u %4s%-2d %12.1f %14.1f %11.2f\n", (unsigned int)threads_[i], "1/", result_.scaleDenominator,
+                result_.decodedPerSecond, result_.deliveredPerSecond, result_.decodeMillis);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,329 @@
+#include "exif_reader.h"
+
+#include <cstring>
+#include <dirent.h>
+#include <memory>
+
+#include "benchmark.h"
+
+// Tags per second of ExifReader over a corpus, reading what the catalog
+// wants from every shot: make, model, date, serial, orientation, ISO, Tv, Av
+// and focal length. Pass --corpus with a directory of JPEG, CR2 or CR3
+// captures, they are mapped rather than loaded. Without one the corpus is
+// generated: JPEGs and CR2s in both byte orders, half of them with the body
+// serial only in the Canon maker note, like older bodies write it.
+//
+//   exif_reader_benchmark [--corpus dir] [--seconds 3]
+
+namespace
+{
+    // Assembles a TIFF structure in either byte order, IFD by IFD
+    class TiffBuilder
+    {
+    public:
+        struct Entry
+        {
+            uint16_t tag;
+            uint16_t type;
+            uint32_t count;
+            // value bytes, already in the file's byte order
+            std::string value;
+            // set when the value is already somewhere in the file
+            uint32_t offset;
+        };
+
+        TiffBuilder(bool littleEndian, bool cr2)
+        : bLittleEndian(littleEndian)
+        {
+            mData = littleEndian ? std::string("II*\0", 4) : std::string("MM\0*", 4);
+            mData += get32(0);
+
+            // CR2 has "CR", its version and the RAW IFD offset between the header and the first IFD
+            if (cr2)
+            {
+                mData += std::string("CR\x02\0", 4) + get32(0);
+            }
+        }
+
+        std::string get16(uint16_t value) const
+        {
+            char bytes_[2] = { (char)(value >> 8), (char)value };
+            return bLittleEndian ? std::string(1, bytes_[1]) + bytes_[0] : std::string(bytes_, 2);
+        }
+
+        std::string get32(uint32_t value) const
+        {
+            return bLittleEndian ? get16((uint16_t)value) + get16((uint16_t)(value >> 16)) : get16((uint16_t)(value >> 16)) + get16((uint16_t)value);
+        }
+
+        Entry makeAscii(uint16_t tag, const std::string& text) const
+        {
+            Entry entry_ = { tag, 2, (uint32_t)text.size() + 1, text + '\0', 0 };
+            return entry_;
+        }
+
+        Entry makeShort(uint16_t tag, uint16_t value) const
+        {
+            Entry entry_ = { tag, 3, 1, get16(value), 0 };
+            return entry_;
+        }
+
+        Entry makeLong(uint16_t tag, uint32_t value) const
+        {
+            Entry entry_ = { tag, 4, 1, get32(value), 0 };
+            return entry_;
+        }
+
+        Entry makeRational(uint16_t tag, uint32_t numerator, uint32_t denominator) const
+        {
+            Entry entry_ = { tag, 5, 1, get32(numerator) + get32(denominator), 0 };
+            return entry_;
+        }
+
+        // Appends an IFD and its out of line values, entries sorted by tag. Returns its offset.
+        uint32_t addIfd(const std::vector<Entry>& entries)
+        {
+            align();
+
+            uint32_t ifd_ = (uint32_t)mData.size();
+            uint32_t values_ = ifd_ + 2 + 12 * (uint32_t)entries.size() + 4;
+            std::string outOfLine_;
+
+            mData += get16((uint16_t)entries.size());
+
+            for (size_t i = 0; i < entries.size(); ++i)
+            {
+                const Entry& entry_ = entries[i];
+
+                mData += get16(entry_.tag) + get16(entry_.type) + get32(entry_.count);
+
+                if (0 != entry_.offset)
+                {
+                    mData += get32(entry_.offset);
+                }
+                else if (entry_.value.size() <= 4)
+                {
+                    mData += entry_.value + std::string(4 - entry_.value.size(), '\0');
+                }
+                else
+                {
+                    mData += get32(values_ + (uint32_t)outOfLine_.size());
+                    outOfLine_ += entry_.value;
+
+                    if (outOfLine_.size() % 2)
+                    {
+                        outOfLine_ += '\0';
+                    }
+                }
+            }
+
+            mData += get32(0) + outOfLine_;
+
+            return ifd_;
+        }
+
+        void setFirstIfd(uint32_t offset)
+        {
+            mData.replace(4, 4, get32(offset));
+        }
+
+        const std::string& getData() const
+        {
+            return mData;
+        }
+
+    private:
+        void align()
+        {
+            if (mData.size() % 2)
+            {
+                mData += '\0';
+            }
+        }
+
+        bool bLittleEndian;
+        std::string mData;
+    };
+
+    std::string makeTiff(unsigned int shot, bool littleEndian, bool cr2)
+    {
+        static const uint16_t kIsos[] = { 100, 200, 400, 800, 1600, 3200, 6400, 65535 };
+
+        TiffBuilder tiff_(littleEndian, cr2);
+        bool bodySerial_ = 0 == shot % 2;
+
+        // the maker note IFD goes first, so the EXIF IFD knows where it is
+        std::vector<TiffBuilder::Entry> makerNote_;
+        makerNote_.push_back(tiff_.makeAscii(0x0006, "Canon EOS 5D Mark IV"));
+        makerNote_.push_back(tiff_.makeAscii(0x0007, "Firmware Version 1.2.3"));
+
+        if (!bodySerial_)
+        {
+            makerNote_.push_back(tiff_.makeLong(0x000C, 2100000000 + shot));
+        }
+
+        size_t makerStart_ = tiff_.getData().size() + tiff_.getData().size() % 2;
+        uint32_t makerIfd_ = tiff_.addIfd(makerNote_);
+        uint32_t makerSize_ = (uint32_t)(tiff_.getData().size() - makerStart_);
+
+        std::vector<TiffBuilder::Entry> exif_;
+        exif_.push_back(tiff_.makeRational(0x829A, 1, 250));
+        exif_.push_back(tiff_.makeRational(0x829D, 56, 10));
+        exif_.push_back(tiff_.makeShort(0x8827, kIsos[shot % 8]));
+        exif_.push_back(tiff_.makeLong(0x8832, 102400));
+        exif_.push_back(tiff_.makeAscii(0x9003, "2024:05:01 12:00:00"));
+        exif_.push_back(tiff_.makeRational(0x920A, 50, 1));
+
+        TiffBuilder::Entry makerNoteEntry_ = { 0x927C, 7, makerSize_, std::string(), makerIfd_ };
+        exif_.push_back(makerNoteEntry_);
+
+        if (bodySerial_)
+        {
+            exif_.push_back(tiff_.makeAscii(0xA431, "0123456789" + std::to_string(shot)));
+        }
+
+        uint32_t exifIfd_ = tiff_.addIfd(exif_);
+
+        std::vector<TiffBuilder::Entry> primary_;
+        primary_.push_back(tiff_.makeAscii(0x010F, "Canon"));
+        primary_.push_back(tiff_.makeAscii(0x0110, "Canon EOS 5D Mark IV"));
+        primary_.push_back(tiff_.makeShort(0x0112, 1));
+        primary_.push_back(tiff_.makeLong(0x8769, exifIfd_));
+
+        tiff_.setFirstIfd(tiff_.addIfd(primary_));
+
+        return tiff_.getData();
+    }
+
+    // The metadata of a shot, then imageBytes standing in for the image data
+    std::string makeCapture(unsigned int shot, size_t imageBytes)
+    {
+        bool littleEndian_ = 0 == (shot / 2) % 2;
+
+        if (0 == shot % 3)
+        {
+            return makeTiff(shot, littleEndian_, true) + std::string(imageBytes, '\0');
+        }
+
+        std::string tiff_ = makeTiff(shot, littleEndian_, false);
+        size_t length_ = 2 + 6 + tiff_.size();
+        std::string jpeg_("\xFF\xD8\xFF\xE1", 4);
+
+        jpeg_ += (char)(length_ >> 8);
+        jpeg_ += (char)length_;
+        jpeg_ += std::string("Exif\0\0", 6) + tiff_;
+        jpeg_ += std::string("\xFF\xDA\x00\x02", 4) + std::string(imageBytes, '\0') + "\xFF\xD9";
+
+        return jpeg_;
+    }
+
+    // Everything the catalog reads, returns the number of tags found
+    unsigned int readShot(const eds::ExifReader& exif)
+    {
+        std::string text_;
+        uint32_t number_ = 0;
+        double value_ = 0.0;
+        unsigned int found_ = 0;
+
+        found_ += exif.getMake(text_);
+        found_ += exif.getModel(text_);
+        found_ += exif.getDateTimeOriginal(text_);
+        found_ += exif.getSerialNumber(text_);
+        found_ += exif.getOrientation(number_);
+        found_ += exif.getIso(number_);
+        found_ += exif.getExposureTime(value_);
+        found_ += exif.getFNumber(value_);
+        found_ += exif.getFocalLength(value_);
+
+        return found_;
+    }
+
+    void loadCorpus(const std::string& dir, std::vector< std::unique_ptr<eds::Buffer> >& corpus)
+    {
+        DIR* handle_ = opendir(dir.c_str());
+
+        if (NULL == handle_)
+        {
+            return;
+        }
+
+        for (struct dirent* entry_ = readdir(handle_); NULL != entry_; entry_ = readdir(handle_))
+        {
+            std::unique_ptr<eds::Buffer> buffer_(new eds::Buffer());
+
+            if ('.' != entry_->d_name[0] && buffer_->map(dir + "/" + entry_->d_name))
+            {
+                corpus.push_back(std::move(buffer_));
+            }
+        }
+
+        closedir(handle_);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool quick_ = bench::isQuick(argc, argv);
+    double seconds_ = bench::getValue(argc, argv, "--seconds", quick_ ? 0.2 : 3);
+    std::vector< std::unique_ptr<eds::Buffer> > corpus_;
+
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        if (0 == strcmp("--corpus", argv[i]))
+        {
+            loadCorpus(argv[i + 1], corpus_);
+
+            if (corpus_.empty())
+            {
+                fprintf(stderr, "nothing to read in %s\n", argv[i + 1]);
+                return 1;
+            }
+        }
+    }
+
+    if (corpus_.empty())
+    {
+        for (unsigned int i = 0; i < 96; ++i)
+        {
+            corpus_.push_back(std::unique_ptr<eds::Buffer>(new eds::Buffer(makeCapture(i, 64 * 1024))));
+        }
+    }
+
+    eds::ExifReader exif_;
+    uint64_t files_ = 0;
+    uint64_t lookups_ = 0;
+    uint64_t found_ = 0;
+    uint64_t unreadable_ = 0;
+    uint64_t start_ = eds::MonotonicClock::nowNanos();
+
+    // a fresh reader state for every shot, like the download path
+    while (bench::getSecondsSince(start_) < seconds_)
+    {
+        for (size_t i = 0; i < corpus_.size(); ++i)
+        {
+            if (!exif_.open(corpus_[i]->view()))
+            {
+                ++unreadable_;
+                continue;
+            }
+
+            found_ += readShot(exif_);
+            lookups_ += exif_.getLookupCount();
+            ++files_;
+        }
+    }
+
+    double elapsed_ = bench::getSecondsSince(start_);
+
+    printf("%u files, %llu reads\n", (unsigned int)corpus_.size(), (unsigned long long)(files_ + unreadable_));
+    printf("%14s %14s %14s %12s %12s\n", "files/s", "tags/s", "lookups/s", "us/file", "tags/file");
+    printf("%14.0f %14.0f %14.0f %12.2f %12.2f\n", files_ / elapsed_, found_ / elapsed_, lookups_ / elapsed_,
+        0 < files_ ? elapsed_ * 1e6 / files_ : 0.0, 0 < files_ ? (double)found_ / files_ : 0.0);
+
+    if (0 < unreadable_)
+    {
+        printf("%llu reads found no metadata\n", (unsigned long long)unreadable_);
+    }
+
+    return 0 < files_ ? 0 : 1;
+}
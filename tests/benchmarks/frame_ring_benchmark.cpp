@@ -0,0 +1,112 @@
+#include "frame_ring.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include "benchmark.h"
+
+// FrameRing with a producer publishing as fast as it can and a consumer
+// acquiring at --consumer-fps, the way EvfCapture and the UI thread share
+// liveview frames. Every frame is --frame-kb of payload written whole by the
+// producer, stamped with its sequence number at both ends; the consumer
+// checks the stamps of what it acquires, a torn or reordered frame fails the
+// run. Overwritten are the frames published over one nobody acquired.
+//
+//   frame_ring_benchmark [--frame-kb 0,64,1024] [--consumer-fps 60] [--seconds 2]
+
+namespace
+{
+    struct Frame
+    {
+        Frame() : sequence(0) {}
+
+        uint64_t sequence;
+        std::vector<uint64_t> payload;
+    };
+
+    void run(size_t frameBytes, double consumerFps, double seconds)
+    {
+        eds::FrameRing<Frame> ring_;
+
+        for (unsigned int i = 0; i < ring_.size(); ++i)
+        {
+            ring_.at(i).payload.assign(std::max<size_t>(2, frameBytes / sizeof(uint64_t)), 0);
+        }
+
+        std::atomic<bool> bRunning_(true);
+        uint64_t start_ = eds::MonotonicClock::nowNanos();
+
+        std::thread producer_([&ring_, &bRunning_]()
+        {
+            for (uint64_t sequence_ = 1; bRunning_.load(std::memory_order_relaxed); ++sequence_)
+            {
+                Frame& frame_ = ring_.back();
+
+                frame_.sequence = sequence_;
+                std::fill(frame_.payload.begin(), frame_.payload.end(), sequence_);
+                ring_.publish();
+            }
+        });
+
+        uint64_t period_ = (uint64_t)(1e9 / consumerFps);
+        uint64_t consumed_ = 0;
+        uint64_t empty_ = 0;
+        uint64_t bad_ = 0;
+        uint64_t last_ = 0;
+
+        for (uint64_t tick_ = 1; bench::getSecondsSince(start_) < seconds; ++tick_)
+        {
+            eds::MonotonicClock::sleepUntil(start_ + tick_ * period_);
+
+            if (!ring_.acquire())
+            {
+                ++empty_;
+                continue;
+            }
+
+            const Frame& frame_ = ring_.front();
+
+            if (frame_.sequence <= last_ || frame_.sequence != frame_.payload.front() || frame_.sequence != frame_.payload.back())
+            {
+                ++bad_;
+            }
+
+            last_ = frame_.sequence;
+            ++consumed_;
+        }
+
+        bRunning_ = false;
+        producer_.join();
+
+        double elapsed_ = bench::getSecondsSince(start_);
+
+        printf("%10u %14.0f %12.1f %14llu %10llu %10llu\n", (unsigned int)(frameBytes / 1024),
+            ring_.getPublishedCount() / elapsed_, consumed_ / elapsed_,
+            (unsigned long long)ring_.getDroppedCount(), (unsigned long long)empty_, (unsigned long long)bad_);
+
+        if (0 < bad_)
+        {
+            fprintf(stderr, "%llu frames acquired torn or out of order\n", (unsigned long long)bad_);
+            exit(1);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool quick_ = bench::isQuick(argc, argv);
+    std::vector<double> frameKilobytes_ = bench::getList(argc, argv, "--frame-kb", quick_ ? std::vector<double>{ 0, 64 } : std::vector<double>{ 0, 64, 1024 });
+    double consumerFps_ = bench::getValue(argc, argv, "--consumer-fps", 60);
+    double seconds_ = bench::getValue(argc, argv, "--seconds", quick_ ? 0.25 : 2);
+
+    printf("consumer at %.0f fps, %.2f s per frame size\n", consumerFps_, seconds_);
+    printf("%10s %14s %12s %14s %10s %10s\n", "frame KB", "published/s", "consumed/s", "overwritten", "empty", "torn");
+
+    for (size_t i = 0; i < frameKilobytes_.size(); ++i)
+    {
+        run((size_t)(frameKilobytes_[i] * 1024), consumerFps_, seconds_);
+    }
+
+    return 0;
+}
@@ -0,0 +1,176 @@
+#include "line_reader.h"
+
+#include <random>
+
+#include "benchmark.h"
+
+// Line iteration over a large text dump, the way sidecar and metadata dumps
+// are parsed: the byte by byte reader Buffer::getNextLine() used to be, the
+// current getNextLine() on top of the line scanner, and Buffer::lines().
+// Lines are 0 to 200 characters, with LF, CRLF and the odd CR endings.
+//
+//   line_reader_benchmark [--megabytes 256] [--repeat 3]
+
+namespace
+{
+    struct Result
+    {
+        uint64_t lines;
+        uint64_t bytes;
+        double seconds;
+    };
+
+    std::string makeText(size_t size)
+    {
+        static const char* kEndings[] = { "\n", "\n", "\n", "\r\n", "\r\n", "\r" };
+
+        std::mt19937 random_(3);
+        std::string text_;
+        text_.reserve(size + 256);
+
+        while (text_.size() < size)
+        {
+            size_t length_ = random_() % 201;
+
+            for (size_t i = 0; i < length_; ++i)
+            {
+                text_ += (char)(' ' + random_() % 95);
+            }
+
+            text_ += kEndings[random_() % 6];
+        }
+
+        return text_;
+    }
+
+    // Buffer::getNextLine() before the line scanner, on its storage with the terminating 0
+    Result readByteByByte(const std::vector<char>& buffer)
+    {
+        Result result_ = {};
+        int next_ = 0;
+
+        while (!buffer.empty() && (int)(buffer.size() - 1) != next_)
+        {
+            auto current_ = next_;
+            auto lineEndWasCR_ = false;
+
+            while (next_ < (int)buffer.size() - 1 && buffer[next_] != '\n')
+            {
+                if (buffer[next_] != '\r')
+                {
+                    next_++;
+                }
+                else
+                {
+                    lineEndWasCR_ = true;
+                    break;
+                }
+            }
+
+            std::string line_(&buffer[0] + current_, next_ - current_);
+
+            if (next_ < (int)(buffer.size() - 1))
+            {
+                next_++;
+            }
+
+            if (lineEndWasCR_ && next_ < (int)(buffer.size() - 1) && buffer[next_] == '\n')
+            {
+                next_++;
+            }
+
+            ++result_.lines;
+            result_.bytes += line_.size();
+        }
+
+        return result_;
+    }
+
+    Result readNextLine(eds::Buffer& buffer)
+    {
+        Result result_ = {};
+
+        buffer.resetLineReader();
+
+        while (!buffer.isLastLine())
+        {
+            std::string line_ = buffer.getNextLine();
+
+            ++result_.lines;
+            result_.bytes += line_.size();
+        }
+
+        return result_;
+    }
+
+    Result readLines(const eds::Buffer& buffer)
+    {
+        Result result_ = {};
+
+        for (const eds::BufferView& line_ : buffer.lines())
+        {
+            ++result_.lines;
+            result_.bytes += line_.size;
+        }
+
+        return result_;
+    }
+
+    template <typename Read>
+    Result best(unsigned int repeat, Read read)
+    {
+        Result best_ = {};
+
+        for (unsigned int i = 0; i < repeat; ++i)
+        {
+            uint64_t start_ = eds::MonotonicClock::nowNanos();
+            Result result_ = read();
+            result_.seconds = bench::getSecondsSince(start_);
+
+            if (0 == i || result_.seconds < best_.seconds)
+            {
+                best_ = result_;
+            }
+        }
+
+        return best_;
+    }
+
+    void print(const char* name, const Result& result, size_t size)
+    {
+        printf("%-22s %12llu %10.3f %10.1f\n", name, (unsigned long long)result.lines, result.seconds, size / (1024.0 * 1024.0) / result.seconds);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool quick_ = bench::isQuick(argc, argv);
+    size_t size_ = (size_t)(bench::getValue(argc, argv, "--megabytes", quick_ ? 4 : 256) * 1024 * 1024);
+    unsigned int repeat_ = (unsigned int)bench::getValue(argc, argv, "--repeat", quick_ ? 1 : 3);
+
+    eds::Buffer buffer_(makeText(size_));
+
+    std::vector<char> old_(buffer_.getBinaryBuffer(), buffer_.getBinaryBuffer() + buffer_.size());
+    old_.push_back(0);
+
+    printf("%.1f MB of text, best of %u\n", buffer_.size() / (1024.0 * 1024.0), repeat_);
+    printf("%-22s %12s %10s %10s\n", "", "lines", "s", "MB/s");
+
+    Result byteByByte_ = best(repeat_, [&old_]() { return readByteByByte(old_); });
+    print("byte by byte", byteByByte_, buffer_.size());
+
+    Result next_ = best(repeat_, [&buffer_]() { return readNextLine(buffer_); });
+    print("getNextLine()", next_, buffer_.size());
+
+    Result lines_ = best(repeat_, [&buffer_]() { return readLines(buffer_); });
+    print("lines()", lines_, buffer_.size());
+
+    // all three split the text the same way
+    if (byteByByte_.lines != next_.lines || byteByByte_.lines != lines_.lines || byteByByte_.bytes != next_.bytes || byteByByte_.bytes != lines_.bytes)
+    {
+        fprintf(stderr, "the readers disagree on the lines\n");
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,180 @@
+#include "buffer.h"
+
+#include <cstring>
+#include <fstream>
+
+#include "benchmark.h"
+#include "xxhash64.h"
+
+// Resident memory of a large capture processed three ways: loaded into the
+// heap with Buffer::set(), read through Buffer::map(), and written into a
+// Buffer::mapAnonymous() scratch buffer. Processing is one XXH64 pass over
+// the bytes. RSS is split into anonymous (heap), file backed (page cache the
+// kernel can drop) and shared memory (memfd) pages, read from
+// /proc/self/status, so the split is only there on Linux.
+//
+//   mapped_buffer_benchmark [--megabytes 512] [--dir .]
+
+namespace
+{
+    struct Rss
+    {
+        double anonymousMegabytes;
+        double fileMegabytes;
+        double sharedMegabytes;
+    };
+
+    Rss getRss()
+    {
+        Rss rss_ = { 0.0, 0.0, 0.0 };
+        std::ifstream status_("/proc/self/status");
+        std::string line_;
+
+        while (std::getline(status_, line_))
+        {
+            double* field_ = NULL;
+
+            if (0 == line_.compare(0, 8, "RssAnon:"))
+            {
+                field_ = &rss_.anonymousMegabytes;
+            }
+            else if (0 == line_.compare(0, 8, "RssFile:"))
+            {
+                field_ = &rss_.fileMegabytes;
+            }
+            else if (0 == line_.compare(0, 9, "RssShmem:"))
+            {
+                field_ = &rss_.sharedMegabytes;
+            }
+
+            if (NULL != field_)
+            {
+                *field_ = strtod(line_.c_str() + line_.find(':') + 1, NULL) / 1024.0;
+            }
+        }
+
+        return rss_;
+    }
+
+    void print(const char* name, const Rss& before, const Rss& after, double seconds, double megabytes)
+    {
+        printf("%-26s %10.1f %10.1f %10.1f", name,
+            after.anonymousMegabytes - before.anonymousMegabytes,
+            after.fileMegabytes - before.fileMegabytes,
+            after.sharedMegabytes - before.sharedMegabytes);
+
+        if (0.0 < seconds)
+        {
+            printf(" %10.1f", megabytes / seconds);
+        }
+
+        printf("\n");
+    }
+
+    uint64_t process(const eds::Buffer& buffer, double& seconds)
+    {
+        uint64_t start_ = eds::MonotonicClock::nowNanos();
+        uint64_t hash_ = eds::XXHash64::hash(buffer.getBinaryBuffer(), buffer.size());
+        seconds = bench::getSecondsSince(start_);
+        return hash_;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool quick_ = bench::isQuick(argc, argv);
+    size_t size_ = (size_t)(bench::getValue(argc, argv, "--megabytes", quick_ ? 32 : 512) * 1024 * 1024);
+    double megabytes_ = size_ / (1024.0 * 1024.0);
+    std::string dir_ = ".";
+
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        if (0 == strcmp("--dir", argv[i]))
+        {
+            dir_ = argv[i + 1];
+        }
+    }
+
+    std::string path_ = dir_ + "/mapped_buffer_benchmark.bin";
+
+    {
+        std::ofstream file_(path_.c_str(), std::ios::binary);
+        std::vector<char> chunk_(1024 * 1024);
+
+        for (size_t written_ = 0; written_ < size_ && file_; written_ += chunk_.size())
+        {
+            memset(&chunk_[0], (int)(written_ >> 20), chunk_.size());
+            file_.write(&chunk_[0], std::min(chunk_.size(), size_ - written_));
+        }
+
+        if (!file_)
+        {
+            fprintf(stderr, "can't write %s\n", path_.c_str());
+            return 1;
+        }
+    }
+
+    printf("%.0f MB capture, RSS growth in MB\n", megabytes_);
+    printf("%-26s %10s %10s %10s %10s\n", "", "anonymous", "file", "memfd", "hash MB/s");
+
+    double seconds_ = 0.0;
+    uint64_t heapHash_ = 0;
+    uint64_t mappedHash_ = 0;
+
+    {
+        Rss before_ = getRss();
+        eds::Buffer buffer_;
+        std::ifstream file_(path_.c_str(), std::ios::binary);
+
+        buffer_.set(file_);
+        print("heap, loaded", before_, getRss(), 0.0, megabytes_);
+
+        heapHash_ = process(buffer_, seconds_);
+        print("heap, processed", before_, getRss(), seconds_, megabytes_);
+    }
+
+    {
+        Rss before_ = getRss();
+        eds::Buffer buffer_;
+
+        if (!buffer_.map(path_))
+        {
+            fprintf(stderr, "can't map %s\n", path_.c_str());
+            return 1;
+        }
+
+        print("mapped, opened", before_, getRss(), 0.0, megabytes_);
+
+        mappedHash_ = process(buffer_, seconds_);
+        print("mapped, processed", before_, getRss(), seconds_, megabytes_);
+    }
+
+    {
+        Rss before_ = getRss();
+        eds::Buffer buffer_;
+
+        if (!buffer_.mapAnonymous(size_))
+        {
+            fprintf(stderr, "can't create a %.0f MB anonymous mapping\n", megabytes_);
+            return 1;
+        }
+
+        print("memfd, created", before_, getRss(), 0.0, megabytes_);
+
+        memset(buffer_.getBinaryBuffer(), 0x5A, size_);
+        print("memfd, written", before_, getRss(), 0.0, megabytes_);
+
+        process(buffer_, seconds_);
+        print("memfd, processed", before_, getRss(), seconds_, megabytes_);
+    }
+
+    std::remove(path_.c_str());
+
+    if (heapHash_ != mappedHash_)
+    {
+        fprintf(stderr, "the mapping doesn't read back what the heap copy has\n");
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,142 @@
+#include "persist_writer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#include "benchmark.h"
+
+// Per-shot save latency and MB/s of PersistWriter with each sync policy,
+// whole files and streamed in 1 MB chunks like a download arrives, against
+// a plain std::ofstream write of the same bytes. The files go to --dir and
+// are removed afterwards; point it at the disk the captures go to.
+//
+//   persist_writer_benchmark [--dir .] [--shots 32] [--megabytes 8]
+
+namespace
+{
+    struct Result
+    {
+        double medianMillis;
+        double maxMillis;
+        double megabytesPerSecond;
+    };
+
+    std::string getPath(const std::string& dir, unsigned int shot)
+    {
+        return dir + "/persist_writer_benchmark_" + std::to_string(shot) + ".jpg";
+    }
+
+    // save(path, data) returns the time spent on that shot in ms
+    template <typename Save>
+    Result run(const std::string& dir, unsigned int shots, const eds::Buffer& data, Save save, eds::PersistWriter* writer)
+    {
+        std::vector<double> millis_;
+        uint64_t start_ = eds::MonotonicClock::nowNanos();
+
+        for (unsigned int i = 0; i < shots; ++i)
+        {
+            millis_.push_back(save(getPath(dir, i), data.view()));
+        }
+
+        // the last batch is part of the run
+        if (NULL != writer)
+        {
+            writer->flush();
+        }
+
+        double seconds_ = bench::getSecondsSince(start_);
+
+        for (unsigned int i = 0; i < shots; ++i)
+        {
+            std::remove(getPath(dir, i).c_str());
+        }
+
+        std::sort(millis_.begin(), millis_.end());
+
+        Result result_ = { millis_[millis_.size() / 2], millis_.back(), shots * data.size() / (1024.0 * 1024.0) / seconds_ };
+        return result_;
+    }
+
+    void print(const char* name, const Result& result)
+    {
+        printf("%-28s %10.2f %10.2f %10.1f\n", name, result.medianMillis, result.maxMillis, result.megabytesPerSecond);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool quick_ = bench::isQuick(argc, argv);
+    unsigned int shots_ = (unsigned int)bench::getValue(argc, argv, "--shots", quick_ ? 4 : 32);
+    double megabytes_ = bench::getValue(argc, argv, "--megabytes", quick_ ? 1 : 8);
+    std::string dir_ = ".";
+
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        if (0 == strcmp("--dir", argv[i]))
+        {
+            dir_ = argv[i + 1];
+        }
+    }
+
+    eds::Buffer data_;
+    data_.allocate((long)(megabytes_ * 1024 * 1024));
+
+    for (long i = 0; i < data_.size(); ++i)
+    {
+        data_.getBinaryBuffer()[i] = (char)(i * 13);
+    }
+
+    printf("%u shots of %.1f MB to %s\n", shots_, megabytes_, dir_.c_str());
+    printf("%-28s %10s %10s %10s\n", "", "median ms", "max ms", "MB/s");
+
+    print("std::ofstream", run(dir_, shots_, data_, [](const std::string& path_, const eds::BufferView& view_)
+    {
+        uint64_t start_ = eds::MonotonicClock::nowNanos();
+        std::ofstream file_(path_.c_str(), std::ios::binary);
+        file_.write(view_.data, view_.size);
+        file_.close();
+        return bench::getSecondsSince(start_) * 1000.0;
+    }, NULL));
+
+    const struct
+    {
+        const char* name;
+        eds::SyncPolicy policy;
+    } policies_[] =
+    {
+        { "no sync", eds::kSyncPolicy_None },
+        { "fsync every file", eds::kSyncPolicy_EveryFile },
+        { "fsync every 8", eds::kSyncPolicy_Batched }
+    };
+
+    for (size_t i = 0; i < sizeof(policies_) / sizeof(policies_[0]); ++i)
+    {
+        eds::PersistWriter writer_(policies_[i].policy, 8);
+
+        print((std::string(policies_[i].name) + ", write()").c_str(), run(dir_, shots_, data_, [&writer_](const std::string& path_, const eds::BufferView& view_)
+        {
+            double millis_ = 0.0;
+            writer_.write(path_, view_, &millis_);
+            return millis_;
+        }, &writer_));
+
+        print((std::string(policies_[i].name) + ", streamed").c_str(), run(dir_, shots_, data_, [&writer_](const std::string& path_, const eds::BufferView& view_)
+        {
+            const size_t kChunkSize = 1024 * 1024;
+
+            eds::PersistWriter::File file_;
+            writer_.open(file_, path_, view_.size);
+
+            for (size_t offset_ = 0; offset_ < view_.size; offset_ += kChunkSize)
+            {
+                writer_.append(file_, eds::BufferView(view_.data + offset_, std::min(kChunkSize, view_.size - offset_)));
+            }
+
+            writer_.commit(file_);
+            return file_.micros / 1000.0;
+        }, &writer_));
+    }
+
+    return 0;
+}
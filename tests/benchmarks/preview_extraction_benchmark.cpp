@@ -0,0 +1,132 @@
+#include "image_container.h"
+
+#include <cstring>
+#include <dirent.h>
+#include <memory>
+
+#include "benchmark.h"
+#include "image_fixtures.h"
+
+// Time findEmbeddedJpeg() takes per file, the review image of a RAW without
+// decoding it. The generated files have a --preview-kb JPEG and --raw-mb of
+// sensor data the lookup never touches: CR2 in both byte orders, CR3 with the
+// preview length in the stsz sample size and in its table. Pass --corpus
+// with a directory of real captures instead, they are mapped rather than
+// loaded and reported as one row.
+//
+//   preview_extraction_benchmark [--corpus dir] [--preview-kb 2048] [--raw-mb 24] [--seconds 1]
+
+namespace
+{
+    struct Sample
+    {
+        std::string name;
+        std::vector< std::unique_ptr<eds::Buffer> > files;
+    };
+
+    void loadCorpus(const std::string& dir, std::vector< std::unique_ptr<eds::Buffer> >& corpus)
+    {
+        DIR* handle_ = opendir(dir.c_str());
+
+        if (NULL == handle_)
+        {
+            return;
+        }
+
+        for (struct dirent* entry_ = readdir(handle_); NULL != entry_; entry_ = readdir(handle_))
+        {
+            std::unique_ptr<eds::Buffer> buffer_(new eds::Buffer());
+
+            if ('.' != entry_->d_name[0] && buffer_->map(dir + "/" + entry_->d_name))
+            {
+                corpus.push_back(std::move(buffer_));
+            }
+        }
+
+        closedir(handle_);
+    }
+
+    void run(const Sample& sample, double seconds)
+    {
+        uint64_t files_ = 0;
+        uint64_t found_ = 0;
+        uint64_t previewBytes_ = 0;
+        uint64_t fileBytes_ = 0;
+        uint64_t start_ = eds::MonotonicClock::nowNanos();
+
+        while (bench::getSecondsSince(start_) < seconds)
+        {
+            for (size_t i = 0; i < sample.files.size(); ++i)
+            {
+                size_t offset_ = 0;
+                size_t length_ = 0;
+                eds::BufferView view_ = sample.files[i]->view();
+
+                if (eds::findEmbeddedJpeg(view_, offset_, length_))
+                {
+                    ++found_;
+                    previewBytes_ += length_;
+                }
+
+                fileBytes_ += view_.size;
+                ++files_;
+            }
+        }
+
+        double elapsed_ = bench::getSecondsSince(start_);
+
+        printf("%-16s %10.1f %12.0f %12.3f %10.0f %10.0f\n", sample.name.c_str(), fileBytes_ / 1024.0 / 1024.0 / files_,
+            files_ / elapsed_, elapsed_ * 1e6 / files_, 0 < found_ ? previewBytes_ / 1024.0 / found_ : 0.0, 100.0 * found_ / files_);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool quick_ = bench::isQuick(argc, argv);
+    size_t previewBytes_ = (size_t)(bench::getValue(argc, argv, "--preview-kb", quick_ ? 256 : 2048) * 1024);
+    size_t rawBytes_ = (size_t)(bench::getValue(argc, argv, "--raw-mb", quick_ ? 1 : 24) * 1024 * 1024);
+    double seconds_ = bench::getValue(argc, argv, "--seconds", quick_ ? 0.1 : 1);
+    std::vector<Sample> samples_;
+
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        if (0 == strcmp("--corpus", argv[i]))
+        {
+            samples_.push_back(Sample());
+            samples_.back().name = "corpus";
+            loadCorpus(argv[i + 1], samples_.back().files);
+
+            if (samples_.back().files.empty())
+            {
+                fprintf(stderr, "nothing to read in %s\n", argv[i + 1]);
+                return 1;
+            }
+        }
+    }
+
+    if (samples_.empty())
+    {
+        const char* kNames[] = { "JPEG", "CR2 II", "CR2 MM", "CR3", "CR3 stsz table" };
+
+        for (int i = 0; i < 5; ++i)
+        {
+            samples_.push_back(Sample());
+            samples_.back().name = kNames[i];
+        }
+
+        samples_[0].files.push_back(std::unique_ptr<eds::Buffer>(new eds::Buffer(fixtures::makeJpeg(previewBytes_))));
+        samples_[1].files.push_back(std::unique_ptr<eds::Buffer>(new eds::Buffer(fixtures::makeCr2(previewBytes_, rawBytes_, true))));
+        samples_[2].files.push_back(std::unique_ptr<eds::Buffer>(new eds::Buffer(fixtures::makeCr2(previewBytes_, rawBytes_, false))));
+        samples_[3].files.push_back(std::unique_ptr<eds::Buffer>(new eds::Buffer(fixtures::makeCr3(previewBytes_, rawBytes_, false))));
+        samples_[4].files.push_back(std::unique_ptr<eds::Buffer>(new eds::Buffer(fixtures::makeCr3(previewBytes_, rawBytes_, true))));
+    }
+
+    printf("%-16s %10s %12s %12s %10s %10s\n", "file", "MB", "files/s", "us/file", "preview KB", "found %");
+
+    for (size_t i = 0; i < samples_.size(); ++i)
+    {
+        run(samples_[i], seconds_);
+    }
+
+    return 0;
+}
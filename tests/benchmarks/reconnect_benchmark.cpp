@@ -0,0 +1,196 @@
+#include "reconnect_manager.h"
+
+#include <algorithm>
+#include <thread>
+
+#include "benchmark.h"
+#include "stub_sdk.h"
+
+// Time to the first liveview frame of a body that was unplugged and plugged
+// back in: drop() when it shut down, reconnect() from the camera added
+// event, markFirstFrame() on the first frame the UI thread picks up. Against
+// it, a cold start of the whole rig the way ofApp::initialize() does one:
+// every session opened in parallel with the prefetch, the image quality
+// written to each body, liveview on the first camera, its first frame.
+//
+// Bodies take --open-ms to open a session and --property-ms for every
+// property write. --changed settings differ on the body when it comes back,
+// those are the only ones the reconnect writes.
+//
+//   reconnect_benchmark [--cameras 4] [--open-ms 400] [--property-ms 30] [--changed 2] [--rounds 5]
+
+namespace
+{
+    const EdsPropertyID kPrefetch[] =
+    {
+        kEdsPropID_SaveTo,
+        kEdsPropID_ImageQuality,
+        kEdsPropID_AEModeSelect,
+        kEdsPropID_DriveMode,
+        kEdsPropID_ISOSpeed,
+        kEdsPropID_Av,
+        kEdsPropID_Tv,
+        kEdsPropID_AvailableShots,
+        kEdsPropID_Evf_OutputDevice,
+        kEdsPropID_Evf_AFMode,
+        kEdsPropID_Evf_Zoom,
+        kEdsPropID_Evf_ZoomPosition
+    };
+
+    // settings a body can come back with, other than what it left with
+    const EdsPropertyID kChangeable[] =
+    {
+        kEdsPropID_ISOSpeed,
+        kEdsPropID_Av,
+        kEdsPropID_Tv,
+        kEdsPropID_DriveMode
+    };
+
+    struct Stats
+    {
+        Stats() : sum(0.0), max(0.0), count(0) {}
+
+        void add(double value)
+        {
+            sum += value;
+            max = std::max(max, value);
+            ++count;
+        }
+
+        double getAverage() const
+        {
+            return 0 == count ? 0.0 : sum / count;
+        }
+
+        double sum;
+        double max;
+        unsigned int count;
+    };
+
+    void waitForFrame(eds::CameraSession& session)
+    {
+        uint64_t deadline_ = eds::MonotonicClock::nowNanos() + 10000000000ull;
+
+        // the UI thread looks once a millisecond
+        while (!session.getEvfCapture().acquire())
+        {
+            if (deadline_ < eds::MonotonicClock::nowNanos())
+            {
+                fprintf(stderr, "%s: no liveview frame\n", session.getName().c_str());
+                exit(1);
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    void print(const char* name, const Stats& stats)
+    {
+        printf("%-26s %10.1f %10.1f\n", name, stats.getAverage(), stats.max);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool quick_ = bench::isQuick(argc, argv);
+    unsigned int cameras_ = (unsigned int)bench::getValue(argc, argv, "--cameras", quick_ ? 2 : 4);
+    double openMillis_ = bench::getValue(argc, argv, "--open-ms", quick_ ? 50 : 400);
+    double propertyMillis_ = bench::getValue(argc, argv, "--property-ms", quick_ ? 5 : 30);
+    unsigned int changed_ = std::min((unsigned int)bench::getValue(argc, argv, "--changed", 2), (unsigned int)(sizeof(kChangeable) / sizeof(kChangeable[0])));
+    unsigned int rounds_ = (unsigned int)bench::getValue(argc, argv, "--rounds", quick_ ? 1 : 5);
+
+    Stats cold_;
+    Stats coldOpen_;
+    Stats reconnect_;
+    Stats reconnectOpen_;
+    Stats replay_;
+    size_t replayed_ = 0;
+    size_t snapshotSize_ = 0;
+
+    for (unsigned int i = 0; i < rounds_; ++i)
+    {
+        stub::reset(cameras_);
+
+        for (unsigned int j = 0; j < cameras_; ++j)
+        {
+            stub::getConfig(j).openMicros = (uint64_t)(openMillis_ * 1000);
+            stub::getConfig(j).propertyMicros = (uint64_t)(propertyMillis_ * 1000);
+        }
+
+        eds::EventBus bus_;
+        eds::CameraManager manager_(bus_);
+        eds::ReconnectManager reconnects_(manager_);
+
+        eds::CameraSession::Settings settings_;
+        settings_.prefetch.assign(kPrefetch, kPrefetch + sizeof(kPrefetch) / sizeof(kPrefetch[0]));
+
+        uint64_t start_ = eds::MonotonicClock::nowNanos();
+
+        if (EDS_ERR_OK != manager_.open(settings_) || cameras_ != manager_.getOpenCount())
+        {
+            fprintf(stderr, "can't open the stub rig\n");
+            return 1;
+        }
+
+        for (unsigned int j = 0; j < cameras_; ++j)
+        {
+            manager_.getSession(j)->setProperty<kEdsPropID_ImageQuality>(EdsImageQuality_S2JF);
+        }
+
+        eds::CameraSession* session_ = manager_.getSession(0);
+        session_->startLiveview();
+        waitForFrame(*session_);
+
+        cold_.add(bench::getSecondsSince(start_) * 1000.0);
+        coldOpen_.add(manager_.getOpenMillis());
+
+        // the shutdown event: liveview ends, the cache is kept, the body is unplugged
+        session_->endLiveview();
+        reconnects_.drop(0, true);
+
+        for (unsigned int j = 0; j < changed_; ++j)
+        {
+            stub::setPropertyValue(0, kChangeable[j], stub::getPropertyValue(0, kChangeable[j]) + 8);
+        }
+
+        // the camera added event
+        reconnects_.reconnect();
+
+        std::vector<eds::ReconnectManager::Reconnect> finished_;
+
+        while (finished_.empty())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            finished_ = reconnects_.update();
+        }
+
+        waitForFrame(*session_);
+
+        if (!reconnects_.markFirstFrame(0))
+        {
+            fprintf(stderr, "the reconnect wasn't waiting for a frame\n");
+            return 1;
+        }
+
+        reconnect_.add(reconnects_.getLastFirstFrameMillis());
+        reconnectOpen_.add(finished_[0].openMillis);
+        replay_.add(finished_[0].replayMillis);
+        replayed_ = finished_[0].replayed;
+        snapshotSize_ = finished_[0].snapshotSize;
+
+        reconnects_.stop();
+        manager_.close();
+    }
+
+    printf("%u cameras, sessions open in %.0f ms, property writes take %.0f ms, %u rounds\n", cameras_, openMillis_, propertyMillis_, rounds_);
+    printf("%-26s %10s %10s\n", "to first frame", "avg ms", "max ms");
+    print("cold start", cold_);
+    print("  open sessions", coldOpen_);
+    print("reconnect", reconnect_);
+    print("  open session", reconnectOpen_);
+    print("  replay settings", replay_);
+    printf("the reconnect wrote %u of %u snapshot values, the other %u cameras kept running, a cold start closes all %u\n",
+        (unsigned int)replayed_, (unsigned int)snapshotSize_, cameras_ - 1, cameras_);
+
+    return 0;
+}
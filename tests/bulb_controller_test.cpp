@@ -0,0 +1,271 @@
+#include "bulb_controller.h"
+
+#include <cmath>
+#include <functional>
+#include <thread>
+
+#include "check.h"
+#include "ofMain.h"
+#include "stub_sdk.h"
+
+namespace
+{
+    const unsigned int kCameraCount = 4;
+
+    bool waitFor(const std::function<bool()>& done, unsigned int timeoutMillis = 5000)
+    {
+        uint64_t deadline_ = stub::nowNanos() + timeoutMillis * 1000000ull;
+
+        while (!done())
+        {
+            if (deadline_ < stub::nowNanos())
+            {
+                return false;
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        return true;
+    }
+
+    // The rig's view of the last exposure of a camera, taking the body to act halfway through each command
+    double getRigExposureMillis(unsigned int camera)
+    {
+        std::vector<stub::CommandRecord> commands_ = stub::getCommands(camera);
+        uint64_t opened_ = 0;
+        uint64_t closed_ = 0;
+
+        for (size_t i = 0; i < commands_.size(); ++i)
+        {
+            uint64_t acted_ = commands_[i].startNanos + (commands_[i].endNanos - commands_[i].startNanos) / 2;
+
+            if (kEdsCameraCommand_ShutterButton_Completely_NonAF == commands_[i].param)
+            {
+                opened_ = acted_;
+            }
+            else if (kEdsCameraCommand_ShutterButton_OFF == commands_[i].param && 0 != opened_)
+            {
+                closed_ = acted_;
+            }
+        }
+
+        CHECK(0 != opened_ && opened_ < closed_);
+        return (closed_ - opened_) / 1000000.0;
+    }
+
+    // Press round trip of pressMicros, release round trip of releaseMicros
+    void reset(uint64_t pressMicros, uint64_t releaseMicros)
+    {
+        stub::reset(kCameraCount);
+
+        for (unsigned int i = 0; i < kCameraCount; ++i)
+        {
+            stub::getConfig(i).commandDelay = [pressMicros, releaseMicros](EdsCameraCommand, EdsInt32 param_)
+            {
+                return kEdsCameraCommand_ShutterButton_OFF == param_ ? releaseMicros : pressMicros;
+            };
+        }
+    }
+
+    void testAchievesRequestedDuration()
+    {
+        const double kRequestedMillis = 200.0;
+        // a few ms of scheduling noise on a loaded single core machine
+        const double kToleranceMillis = 8.0;
+
+        // a slow release, the first exposure only knows the press round trip and comes out about 19 ms long
+        reset(2000, 40000);
+
+        {
+            eds::EventBus bus_;
+            eds::CameraManager cameras_(bus_);
+            eds::BulbController bulb_(cameras_);
+
+            CHECK(EDS_ERR_OK == cameras_.open(eds::CameraSession::Settings()));
+
+            for (int exposure_ = 0; exposure_ < 3; ++exposure_)
+            {
+                stub::clearCommands();
+
+                CHECK(kCameraCount == bulb_.expose(kRequestedMillis));
+                CHECK(bulb_.isExposing());
+                CHECK(waitFor([&bulb_]() { return !bulb_.isExposing(); }));
+
+                CHECK(exposure_ + 1 == (int)bulb_.getExposureCount() / (int)kCameraCount);
+                CHECK(kRequestedMillis == bulb_.getLastRequestedMillis());
+
+                for (unsigned int i = 0; i < kCameraCount; ++i)
+                {
+                    double achieved_ = getRigExposureMillis(i);
+
+                    // once a release has been measured the lead covers it
+                    if (0 < exposure_)
+                    {
+                        CHECK_MESSAGE(std::fabs(achieved_ - kRequestedMillis) < kToleranceMillis, "camera %u, exposure %d: %.3f ms", i, exposure_, achieved_);
+                    }
+                    else
+                    {
+                        CHECK_MESSAGE(kRequestedMillis + 10.0 < achieved_, "camera %u: %.3f ms", i, achieved_);
+                    }
+                }
+
+                // the controller's own estimate agrees with the rig
+                if (0 < exposure_)
+                {
+                    CHECK(std::fabs(bulb_.getLastAchievedMillis() - kRequestedMillis) < kToleranceMillis);
+                }
+            }
+
+            cameras_.close();
+        }
+
+        CHECK(0 == stub::getLiveRefCount());
+    }
+
+    void testCancelClosesEveryShutter()
+    {
+        const uint64_t kReleaseMicros = 300000;
+
+        reset(1000, kReleaseMicros);
+
+        {
+            eds::EventBus bus_;
+            eds::CameraManager cameras_(bus_);
+            eds::BulbController bulb_(cameras_);
+
+            CHECK(EDS_ERR_OK == cameras_.open(eds::CameraSession::Settings()));
+            CHECK(kCameraCount == bulb_.expose(60000.0));
+
+            // nothing else starts while one is running
+            CHECK(0 == bulb_.expose(100.0));
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+            // returns without waiting for the slow release, the caller polls isExposing()
+            uint64_t start_ = stub::nowNanos();
+            bulb_.cancel();
+
+            CHECK((stub::nowNanos() - start_) / 1000 < kReleaseMicros / 2);
+            CHECK(waitFor([&bulb_]() { return !bulb_.isExposing(); }));
+            CHECK((stub::nowNanos() - start_) / 1000 < kReleaseMicros + 500000);
+            CHECK(0 == bulb_.getExposureCount());
+
+            for (unsigned int i = 0; i < kCameraCount; ++i)
+            {
+                std::vector<stub::CommandRecord> commands_ = stub::getCommands(i);
+
+                CHECK(2 == commands_.size());
+                CHECK(kEdsCameraCommand_ShutterButton_Completely_NonAF == commands_[0].param);
+                CHECK(kEdsCameraCommand_ShutterButton_OFF == commands_[1].param);
+            }
+
+            cameras_.close();
+        }
+
+        CHECK(0 == stub::getLiveRefCount());
+    }
+
+    void testDestructorWaitsForTheShutters()
+    {
+        reset(1000, 100000);
+
+        {
+            eds::EventBus bus_;
+            eds::CameraManager cameras_(bus_);
+
+            CHECK(EDS_ERR_OK == cameras_.open(eds::CameraSession::Settings()));
+
+            {
+                eds::BulbController bulb_(cameras_);
+
+                CHECK(kCameraCount == bulb_.expose(60000.0));
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            }
+
+            // the executors must not run into a destroyed controller, every release is back already
+            for (unsigned int i = 0; i < kCameraCount; ++i)
+            {
+                std::vector<stub::CommandRecord> commands_ = stub::getCommands(i);
+
+                CHECK(2 == commands_.size());
+                CHECK(kEdsCameraCommand_ShutterButton_OFF == commands_.back().param);
+            }
+
+            cameras_.close();
+        }
+
+        CHECK(0 == stub::getLiveRefCount());
+    }
+
+    void testRunsInOrderOnTheExecutor()
+    {
+        const uint64_t kLensMicros = 100000;
+
+        stub::reset(kCameraCount);
+
+        for (unsigned int i = 0; i < kCameraCount; ++i)
+        {
+            stub::getConfig(i).commandDelay = [kLensMicros](EdsCameraCommand command_, EdsInt32)
+            {
+                return kEdsCameraCommand_DriveLensEvf == command_ ? kLensMicros : 1000;
+            };
+        }
+
+        {
+            eds::EventBus bus_;
+            eds::CameraManager cameras_(bus_);
+            eds::BulbController bulb_(cameras_);
+
+            CHECK(EDS_ERR_OK == cameras_.open(eds::CameraSession::Settings()));
+
+            // one queued ahead of the exposure, one posted while it runs
+            for (unsigned int i = 0; i < kCameraCount; ++i)
+            {
+                CHECK(cameras_.getSession(i)->sendCommand(eds::kCommandClass_Shutter, kEdsCameraCommand_DriveLensEvf, 1));
+            }
+
+            CHECK(kCameraCount == bulb_.expose(50.0));
+
+            for (unsigned int i = 0; i < kCameraCount; ++i)
+            {
+                CHECK(cameras_.getSession(i)->sendCommand(eds::kCommandClass_Shutter, kEdsCameraCommand_DriveLensEvf, 2));
+            }
+
+            CHECK(waitFor([&bulb_]() { return !bulb_.isExposing(); }));
+            cameras_.close();
+
+            // every camera saw lens, press, release, lens, one at a time
+            for (unsigned int i = 0; i < kCameraCount; ++i)
+            {
+                std::vector<stub::CommandRecord> commands_ = stub::getCommands(i);
+
+                CHECK(4 == commands_.size());
+                CHECK(kEdsCameraCommand_DriveLensEvf == commands_[0].command && 1 == commands_[0].param);
+                CHECK(kEdsCameraCommand_ShutterButton_Completely_NonAF == commands_[1].param);
+                CHECK(kEdsCameraCommand_ShutterButton_OFF == commands_[2].param);
+                CHECK(kEdsCameraCommand_DriveLensEvf == commands_[3].command && 2 == commands_[3].param);
+
+                for (size_t j = 1; j < commands_.size(); ++j)
+                {
+                    CHECK(commands_[j - 1].endNanos <= commands_[j].startNanos);
+                }
+            }
+        }
+
+        CHECK(0 == stub::getLiveRefCount());
+    }
+}
+
+int main()
+{
+    // one line per exposure and camera otherwise
+    ofSetLogLevel(OF_LOG_WARNING);
+
+    RUN_TEST(testAchievesRequestedDuration);
+    RUN_TEST(testCancelClosesEveryShutter);
+    RUN_TEST(testDestructorWaitsForTheShutters);
+    RUN_TEST(testRunsInOrderOnTheExecutor);
+
+    return 0;
+}
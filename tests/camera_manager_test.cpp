@@ -0,0 +1,276 @@
+#include "camera_manager.h"
+
+#include <atomic>
+#include <functional>
+#include <thread>
+
+#include "check.h"
+#include "stub_sdk.h"
+
+namespace
+{
+    const unsigned int kCameraCount = 12;
+    const uint64_t kOpenMicros = 50000;
+
+    bool waitFor(const std::function<bool()>& done, unsigned int timeoutMillis = 5000)
+    {
+        uint64_t deadline_ = stub::nowNanos() + timeoutMillis * 1000000ull;
+
+        while (!done())
+        {
+            if (deadline_ < stub::nowNanos())
+            {
+                return false;
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        return true;
+    }
+
+    void testOpensInParallel()
+    {
+        stub::reset(kCameraCount);
+
+        for (unsigned int i = 0; i < kCameraCount; ++i)
+        {
+            stub::getConfig(i).openMicros = kOpenMicros;
+        }
+
+        {
+            eds::EventBus bus_;
+            eds::CameraManager cameras_(bus_);
+
+            CHECK(EDS_ERR_OK == cameras_.open(eds::CameraSession::Settings()));
+            CHECK(kCameraCount == cameras_.getSessionCount());
+            CHECK(kCameraCount == cameras_.getOpenCount());
+
+            // about the slowest one, not the sum
+            CHECK(kOpenMicros / 1000.0 <= cameras_.getSlowestOpenMillis());
+            CHECK_MESSAGE(cameras_.getOpenMillis() < kCameraCount * kOpenMicros / 1000.0 / 2, "%.1f ms", cameras_.getOpenMillis());
+            CHECK(1 < stub::getMaxConcurrentOpens());
+
+            for (unsigned int i = 0; i < kCameraCount; ++i)
+            {
+                eds::CameraSession* session_ = cameras_.getSession(i);
+
+                CHECK(NULL != session_);
+                CHECK(i == session_->getIndex());
+                CHECK(stub::isSessionOpen(i));
+                CHECK("Canon EOS Stub #" + std::to_string(i) == session_->getName());
+                CHECK("SN" + std::to_string(i) == session_->getSerialNumber());
+                CHECK("usb:" + std::to_string(i) == session_->getPortName());
+            }
+
+            CHECK(NULL == cameras_.getSession(kCameraCount));
+
+            cameras_.close();
+            CHECK(0 == cameras_.getOpenCount());
+
+            for (unsigned int i = 0; i < kCameraCount; ++i)
+            {
+                CHECK(!stub::isSessionOpen(i));
+            }
+        }
+
+        CHECK(0 == stub::getLiveRefCount());
+        CHECK(0 == stub::getBadReleaseCount());
+    }
+
+    void testFailedCamerasKeepTheirSlot()
+    {
+        stub::reset(kCameraCount);
+        stub::getConfig(3).openError = EDS_ERR_DEVICE_BUSY;
+        stub::getConfig(7).openError = EDS_ERR_COMM_DISCONNECTED;
+
+        {
+            eds::EventBus bus_;
+            eds::CameraManager cameras_(bus_);
+
+            CHECK(EDS_ERR_OK == cameras_.open(eds::CameraSession::Settings()));
+            CHECK(kCameraCount == cameras_.getSessionCount());
+            CHECK(kCameraCount - 2 == cameras_.getOpenCount());
+            CHECK(!cameras_.getSession(3)->isOpen());
+            CHECK(!cameras_.getSession(7)->isOpen());
+            CHECK(cameras_.getSession(8)->isOpen());
+            CHECK(8 == cameras_.getSession(8)->getIndex());
+
+            // nothing goes out on a camera that didn't open
+            CHECK(!cameras_.getSession(3)->sendCommand(eds::kCommandClass_Shutter, kEdsCameraCommand_PressShutterButton, kEdsCameraCommand_ShutterButton_Halfway));
+
+            cameras_.close(8);
+            CHECK(!cameras_.getSession(8)->isOpen());
+            CHECK(!stub::isSessionOpen(8));
+            CHECK(kCameraCount - 3 == cameras_.getOpenCount());
+        }
+
+        CHECK(0 == stub::getLiveRefCount());
+        CHECK(0 == stub::getBadReleaseCount());
+    }
+
+    void testNothingToOpen()
+    {
+        {
+            stub::reset(0);
+
+            eds::EventBus bus_;
+            eds::CameraManager cameras_(bus_);
+
+            CHECK(EDS_ERR_DEVICE_NOT_FOUND == cameras_.open(eds::CameraSession::Settings()));
+            CHECK(0 == cameras_.getSessionCount());
+        }
+
+        {
+            stub::reset(4);
+
+            for (unsigned int i = 0; i < 4; ++i)
+            {
+                stub::getConfig(i).openError = EDS_ERR_DEVICE_BUSY;
+            }
+
+            eds::EventBus bus_;
+            eds::CameraManager cameras_(bus_);
+
+            CHECK(EDS_ERR_DEVICE_NOT_FOUND == cameras_.open(eds::CameraSession::Settings()));
+            CHECK(4 == cameras_.getSessionCount());
+            CHECK(0 == cameras_.getOpenCount());
+        }
+
+        CHECK(0 == stub::getLiveRefCount());
+    }
+
+    void testAggregateMetrics()
+    {
+        const unsigned int kShotsPerCamera = 5;
+        const EdsUInt32 kShotSize = 256 * 1024;
+
+        stub::reset(kCameraCount);
+
+        for (unsigned int i = 0; i < kCameraCount; ++i)
+        {
+            stub::getConfig(i).commandMicros = 1000;
+        }
+
+        {
+            eds::EventBus bus_;
+            eds::CameraManager cameras_(bus_);
+            std::atomic<unsigned int> persisted_(0);
+
+            eds::CameraSession::Settings settings_;
+            settings_.persist = [&persisted_](eds::CameraSession&, const eds::Download& download_) { ++persisted_; return 0 < download_.data.size(); };
+
+            CHECK(EDS_ERR_OK == cameras_.open(settings_));
+
+            // the app's wiring: the bus hands captures to the session that saw them
+            bus_.subscribe(eds::kEventType_Object, kEdsObjectEvent_DirItemCreated, [&cameras_](const eds::Event& event_)
+            {
+                CHECK(cameras_.getSession(event_.camera)->getDownloadManager().enqueue(event_.object));
+            });
+
+            for (unsigned int i = 0; i < kCameraCount; ++i)
+            {
+                CHECK(cameras_.getSession(i)->sendCommand(eds::kCommandClass_Shutter, kEdsCameraCommand_PressShutterButton, kEdsCameraCommand_ShutterButton_Completely));
+
+                for (unsigned int j = 0; j < kShotsPerCamera; ++j)
+                {
+                    CHECK(stub::emitItemCreated(i, "IMG_" + std::to_string(i * 100 + j) + ".JPG", kShotSize));
+                }
+            }
+
+            CHECK(kCameraCount * kShotsPerCamera == bus_.dispatch());
+
+            // close() finishes what is queued
+            cameras_.close();
+
+            CHECK(kCameraCount == cameras_.getCommandCount());
+            CHECK(kCameraCount == stub::getCommands().size());
+            CHECK(0 == cameras_.getInFlightCount());
+            CHECK(kCameraCount * kShotsPerCamera == cameras_.getCompletedCount());
+            CHECK(kCameraCount * kShotsPerCamera == persisted_);
+            CHECK(0 == cameras_.getFailedCount());
+            CHECK((uint64_t)kCameraCount * kShotsPerCamera * kShotSize == cameras_.getTransferredBytes());
+            CHECK(0.0 < cameras_.getMegabytesPerSecond());
+            CHECK(kCameraCount * kShotsPerCamera == stub::getDeletedCount());
+
+            for (unsigned int i = 0; i < kCameraCount; ++i)
+            {
+                CHECK(1 == stub::getCommands(i).size());
+                CHECK(kShotsPerCamera == cameras_.getSession(i)->getDownloadManager().getCompletedCount());
+            }
+        }
+
+        CHECK(0 == stub::getLiveRefCount());
+        CHECK(0 == stub::getBadReleaseCount());
+    }
+
+    void testCancelOnlyReachesRunningDownloads()
+    {
+        const EdsUInt32 kShotSize = 256 * 1024;
+
+        stub::reset(1);
+        // a quarter of a second per shot
+        stub::getConfig(0).transferMegabytesPerSecond = 1.0;
+
+        {
+            eds::EventBus bus_;
+            eds::CameraManager cameras_(bus_);
+            std::atomic<unsigned int> persisted_(0);
+
+            eds::CameraSession::Settings settings_;
+            settings_.persist = [&persisted_](eds::CameraSession&, const eds::Download&) { ++persisted_; return true; };
+            settings_.downloadThreads = 2;
+
+            CHECK(EDS_ERR_OK == cameras_.open(settings_));
+
+            eds::DownloadManager& downloads_ = cameras_.getSession(0)->getDownloadManager();
+
+            bus_.subscribe(eds::kEventType_Object, kEdsObjectEvent_DirItemCreated, [&downloads_](const eds::Event& event_)
+            {
+                CHECK(downloads_.enqueue(event_.object));
+            });
+
+            // nothing running, nothing to cancel, and the next download isn't aborted by it
+            CHECK(0 == downloads_.cancel());
+            CHECK(downloads_.getProgress().empty());
+
+            CHECK(stub::emitItemCreated(0, "IMG_0001.JPG", kShotSize));
+            CHECK(1 == bus_.dispatch());
+            CHECK(waitFor([&]() { return 1 == downloads_.getCompletedCount(); }));
+
+            // both workers busy, the third shot waits in the queue
+            for (unsigned int i = 2; i <= 4; ++i)
+            {
+                CHECK(stub::emitItemCreated(0, "IMG_000" + std::to_string(i) + ".JPG", kShotSize));
+            }
+
+            CHECK(3 == bus_.dispatch());
+            CHECK(waitFor([&]() { return 2 == downloads_.getProgress().size(); }));
+            CHECK(2 == downloads_.cancel());
+
+            cameras_.close();
+
+            CHECK(2 == downloads_.getCancelledCount());
+            CHECK(2 == downloads_.getCompletedCount());
+            CHECK(0 == downloads_.getFailedCount());
+            CHECK(2 == persisted_);
+            // the cancelled shots are still on the card
+            CHECK(2 == stub::getDeletedCount());
+            CHECK(downloads_.getProgress().empty());
+        }
+
+        CHECK(0 == stub::getLiveRefCount());
+        CHECK(0 == stub::getBadReleaseCount());
+    }
+}
+
+int main()
+{
+    RUN_TEST(testOpensInParallel);
+    RUN_TEST(testFailedCamerasKeepTheirSlot);
+    RUN_TEST(testNothingToOpen);
+    RUN_TEST(testAggregateMetrics);
+    RUN_TEST(testCancelOnlyReachesRunningDownloads);
+
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include "capture_grouper.h"
+
+#include <cstring>
+
+#include "check.h"
+
+namespace
+{
+    EdsDirectoryItemInfo makeItem(const char* fileName, EdsUInt32 groupID)
+    {
+        EdsDirectoryItemInfo info_;
+        memset(&info_, 0, sizeof(info_));
+        strncpy(info_.szFileName, fileName, sizeof(info_.szFileName) - 1);
+        info_.groupID = groupID;
+
+        return info_;
+    }
+
+    void testPairsByGroupId()
+    {
+        eds::CaptureGrouper grouper_;
+        bool paired_ = true;
+
+        CHECK("shot-1" == grouper_.group(makeItem("IMG_0001.CR3", 7), "shot-1", &paired_));
+        CHECK(!paired_);
+        CHECK("shot-1" == grouper_.group(makeItem("IMG_0001.JPG", 7), "shot-2", &paired_));
+        CHECK(paired_);
+
+        // the groupID decides, whatever the file is called
+        CHECK("shot-1" == grouper_.group(makeItem("IMG_9999.JPG", 7), "shot-3", &paired_));
+        CHECK(paired_);
+        CHECK("shot-4" == grouper_.group(makeItem("IMG_0001.JPG", 8), "shot-4", &paired_));
+        CHECK(!paired_);
+    }
+
+    void testPairsByBaseName()
+    {
+        eds::CaptureGrouper grouper_;
+        bool paired_ = true;
+
+        // bodies that leave the groupID at 0
+        CHECK("shot-1" == grouper_.group(makeItem("IMG_0001.CR2", 0), "shot-1", &paired_));
+        CHECK(!paired_);
+        CHECK("shot-1" == grouper_.group(makeItem("IMG_0001.JPG", 0), "shot-2", &paired_));
+        CHECK(paired_);
+        CHECK("shot-3" == grouper_.group(makeItem("IMG_0002.JPG", 0), "shot-3", &paired_));
+        CHECK(!paired_);
+
+        // a name match doesn't pair an item that has a groupID with one that doesn't
+        CHECK("shot-4" == grouper_.group(makeItem("IMG_0002.CR2", 5), "shot-4", &paired_));
+        CHECK(!paired_);
+
+        // only the last extension is dropped
+        CHECK("shot-5" == grouper_.group(makeItem("IMG_0003.JPG.CR2", 0), "shot-5", &paired_));
+        CHECK("shot-6" == grouper_.group(makeItem("IMG_0003.CR2", 0), "shot-6", &paired_));
+        CHECK(!paired_);
+        CHECK("shot-5" == grouper_.group(makeItem("IMG_0003.JPG.JPG", 0), "shot-7", &paired_));
+        CHECK(paired_);
+
+        // paired is optional
+        CHECK("shot-3" == grouper_.group(makeItem("IMG_0002.CR2", 0), "shot-8"));
+    }
+
+    void testForgetsOldShots()
+    {
+        eds::CaptureGrouper grouper_(2);
+
+        CHECK("shot-1" == grouper_.group(makeItem("IMG_0001.CR2", 1), "shot-1"));
+        CHECK("shot-2" == grouper_.group(makeItem("IMG_0002.CR2", 2), "shot-2"));
+        CHECK("shot-3" == grouper_.group(makeItem("IMG_0003.CR2", 3), "shot-3"));
+
+        // shot 1 fell out of the history, its JPEG starts a new capture
+        bool paired_ = true;
+        CHECK("shot-4" == grouper_.group(makeItem("IMG_0001.JPG", 1), "shot-4", &paired_));
+        CHECK(!paired_);
+        CHECK("shot-3" == grouper_.group(makeItem("IMG_0003.JPG", 3), "shot-5", &paired_));
+        CHECK(paired_);
+    }
+
+    void testSplitsFileNames()
+    {
+        CHECK("IMG_0001" == eds::CaptureGrouper::getBaseName("IMG_0001.CR3"));
+        CHECK(".CR3" == eds::CaptureGrouper::getExtension("IMG_0001.CR3"));
+        CHECK("IMG_0001.JPG" == eds::CaptureGrouper::getBaseName("IMG_0001.JPG.CR2"));
+        CHECK(".CR2" == eds::CaptureGrouper::getExtension("IMG_0001.JPG.CR2"));
+        CHECK("IMG_0001" == eds::CaptureGrouper::getBaseName("IMG_0001"));
+        CHECK("" == eds::CaptureGrouper::getExtension("IMG_0001"));
+        CHECK("" == eds::CaptureGrouper::getBaseName(".JPG"));
+        CHECK(".JPG" == eds::CaptureGrouper::getExtension(".JPG"));
+    }
+}
+
+int main()
+{
+    RUN_TEST(testPairsByGroupId);
+    RUN_TEST(testPairsByBaseName);
+    RUN_TEST(testForgetsOldShots);
+    RUN_TEST(testSplitsFileNames);
+
+    return 0;
+}
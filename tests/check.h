@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+// The tests are plain executables run by ctest: a failed check prints the
+// expression and where it is, and the process exits non-zero.
+
+#define CHECK(condition)                                                                  \
+    do                                                                                    \
+    {                                                                                     \
+        if (!(condition))                                                                 \
+        {                                                                                 \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            exit(1);                                                                      \
+        }                                                                                 \
+    }                                                                                     \
+    while (0)
+
+#define CHECK_MESSAGE(condition, ...)                                                     \
+    do                                                                                    \
+    {                                                                                     \
+        if (!(condition))                                                                 \
+        {                                                                                 \
+            fprintf(stderr, "%s:%d: check failed: %s: ", __FILE__, __LINE__, #condition); \
+            fprintf(stderr, __VA_ARGS__);                                                 \
+            fprintf(stderr, "\n");                                                        \
+            exit(1);                                                                      \
+        }                                                                                 \
+    }                                                                                     \
+    while (0)
+
+#define RUN_TEST(test)                                                                    \
+    do                                                                                    \
+    {                                                                                     \
+        test();                                                                           \
+        printf("ok %s\n", #test);                                                         \
+        fflush(stdout);                                                                   \
+    }                                                                                     \
+    while (0)
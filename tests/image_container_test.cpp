@@ -0,0 +1,358 @@
+#include "image_container.h"
+
+#include <memory>
+#include <vector>
+
+#include "check.h"
+#include "image_fixtures.h"
+#include "tiff_reader.h"
+
+namespace
+{
+    const size_t kPreviewBytes = 600;
+
+    // A copy of data in an allocation of exactly its size, with
+    // -DEDS_SANITIZE=address a read past the end stops the test
+    class Exact
+    {
+    public:
+        Exact(const std::string& data)
+        : mData(new char[std::max<size_t>(1, data.size())])
+        , mSize(data.size())
+        {
+            data.copy(mData.get(), mSize);
+        }
+
+        eds::BufferView view() const
+        {
+            return eds::BufferView(mData.get(), mSize);
+        }
+
+    private:
+        std::unique_ptr<char[]> mData;
+        size_t mSize;
+    };
+
+    // Everything the download path asks of a container, every answer has to lie inside it
+    void readAll(const eds::BufferView& data)
+    {
+        eds::detectImageFormat(data);
+
+        size_t offset_ = 0;
+        size_t length_ = 0;
+
+        if (eds::findEmbeddedJpeg(data, offset_, length_))
+        {
+            CHECK(offset_ <= data.size && length_ <= data.size - offset_);
+            CHECK(2 <= length_ && (char)0xFF == data.data[offset_] && (char)0xD8 == data.data[offset_ + 1]);
+        }
+
+        if (eds::findCr3MetadataBox(data, "CMT1", offset_, length_))
+        {
+            CHECK(offset_ <= data.size && length_ <= data.size - offset_);
+        }
+
+        // every IFD and every value the reader hands out
+        eds::TiffReader reader_;
+
+        if (!reader_.open(data))
+        {
+            return;
+        }
+
+        unsigned int ifds_ = 0;
+
+        for (uint32_t ifd_ = reader_.getFirstIfd(); 0 != ifd_; ifd_ = reader_.getNextIfd(ifd_))
+        {
+            CHECK(++ifds_ < 1000);
+
+            for (uint16_t i = 0; i < reader_.getEntryCount(ifd_); ++i)
+            {
+                eds::TiffEntry entry_;
+                eds::BufferView value_;
+                uint32_t number_ = 0;
+
+                // false when the value lies past the end
+                if (!reader_.getEntry(ifd_, i, entry_))
+                {
+                    continue;
+                }
+
+                reader_.getUInt(entry_, number_, entry_.count - 1);
+
+                if (reader_.getBytes(entry_, value_))
+                {
+                    CHECK(data.data <= value_.data && value_.size <= (size_t)(data.data + data.size - value_.data));
+                }
+            }
+        }
+    }
+
+    std::vector<std::string> makeFixtures()
+    {
+        std::vector<std::string> fixtures_;
+
+        fixtures_.push_back(fixtures::makeJpeg(kPreviewBytes));
+        fixtures_.push_back(fixtures::makeCr2(kPreviewBytes, 64, true));
+        fixtures_.push_back(fixtures::makeCr2(kPreviewBytes, 64, false));
+        fixtures_.push_back(fixtures::makeCr3(kPreviewBytes, 64, false));
+        fixtures_.push_back(fixtures::makeCr3(kPreviewBytes, 64, true));
+
+        return fixtures_;
+    }
+
+    void testFindsThePreview()
+    {
+        const eds::ImageFormat kFormats[] = { eds::kImageFormat_Jpeg, eds::kImageFormat_Cr2, eds::kImageFormat_Cr2, eds::kImageFormat_Cr3, eds::kImageFormat_Cr3 };
+
+        std::vector<std::string> fixtures_ = makeFixtures();
+
+        for (size_t i = 0; i < fixtures_.size(); ++i)
+        {
+            Exact data_(fixtures_[i]);
+            size_t offset_ = 0;
+            size_t length_ = 0;
+
+            CHECK(kFormats[i] == eds::detectImageFormat(data_.view()));
+            CHECK(eds::findEmbeddedJpeg(data_.view(), offset_, length_));
+            CHECK(kPreviewBytes == length_);
+            CHECK(fixtures::makeJpeg(kPreviewBytes) == fixtures_[i].substr(offset_, length_));
+            readAll(data_.view());
+        }
+
+        size_t offset_ = 0;
+        size_t length_ = 0;
+
+        CHECK(eds::findCr3MetadataBox(Exact(fixtures_[3]).view(), "CMT1", offset_, length_));
+        CHECK(0 == fixtures_[3].compare(offset_, 4, "II*\0", 4));
+        CHECK(!eds::findCr3MetadataBox(Exact(fixtures_[3]).view(), "CMT4", offset_, length_));
+        CHECK(!eds::findCr3MetadataBox(Exact(fixtures_[1]).view(), "CMT1", offset_, length_));
+    }
+
+    void testTruncatedContainersStayInside()
+    {
+        std::vector<std::string> fixtures_ = makeFixtures();
+
+        for (size_t i = 0; i < fixtures_.size(); ++i)
+        {
+            size_t previewOffset_ = 0;
+            size_t previewLength_ = 0;
+
+            CHECK(eds::findEmbeddedJpeg(Exact(fixtures_[i]).view(), previewOffset_, previewLength_));
+
+            // cut anywhere: inside the magic, an IFD, a box header, the preview
+            for (size_t size_ = 0; size_ < fixtures_[i].size(); ++size_)
+            {
+                Exact data_(fixtures_[i].substr(0, size_));
+                size_t offset_ = 0;
+                size_t length_ = 0;
+
+                readAll(data_.view());
+
+                // a RAW's preview is only there once all of it is
+                if (0 != i)
+                {
+                    CHECK((previewOffset_ + previewLength_ <= size_) == eds::findEmbeddedJpeg(data_.view(), offset_, length_));
+                }
+            }
+        }
+
+        // magic bytes alone, or not even that
+        const std::string kShort[] =
+        {
+            std::string(),
+            std::string("\xFF\xD8", 2),
+            std::string("II*\0CR", 6),
+            std::string("MM\0*\0\0\0\x08", 8),
+            std::string("\0\0\0\x0C" "ftyp", 8),
+            std::string("\0\0\0\x0C" "ftypcrx", 11)
+        };
+
+        for (size_t i = 0; i < sizeof(kShort) / sizeof(kShort[0]); ++i)
+        {
+            Exact data_(kShort[i]);
+
+            CHECK(eds::kImageFormat_Unknown == eds::detectImageFormat(data_.view()));
+            readAll(data_.view());
+        }
+    }
+
+    void testCorruptTiffStaysInside()
+    {
+        std::string cr2_ = fixtures::makeCr2(kPreviewBytes, 64, true);
+        size_t offset_ = 0;
+        size_t length_ = 0;
+
+        // the first IFD past the end, on its last byte, on the header itself
+        const uint32_t kFirstIfds[] = { 0xFFFFFFFF, 0xFFFFFFFE, (uint32_t)cr2_.size(), (uint32_t)cr2_.size() - 1, 0 };
+
+        for (size_t i = 0; i < sizeof(kFirstIfds) / sizeof(kFirstIfds[0]); ++i)
+        {
+            std::string corrupt_ = cr2_;
+            corrupt_.replace(fixtures::kCr2_FirstIfd, 4, fixtures::get32(kFirstIfds[i], true));
+
+            Exact data_(corrupt_);
+            CHECK(!eds::findEmbeddedJpeg(data_.view(), offset_, length_));
+            readAll(data_.view());
+        }
+
+        // an entry count running past the end of the file
+        {
+            std::string corrupt_ = cr2_;
+            corrupt_.replace(fixtures::kCr2_Ifd0, 2, fixtures::get16(0xFFFF, true));
+
+            Exact data_(corrupt_);
+            CHECK(!eds::findEmbeddedJpeg(data_.view(), offset_, length_));
+            readAll(data_.view());
+        }
+
+        CHECK(eds::findEmbeddedJpeg(Exact(cr2_).view(), offset_, length_));
+
+        // the strip past the end, longer than what's left, wrapping around, too short for SOI
+        const uint32_t kStrips[][2] =
+        {
+            { (uint32_t)cr2_.size(), 2 },
+            { (uint32_t)offset_, (uint32_t)(cr2_.size() - offset_ + 1) },
+            { (uint32_t)offset_, 0xFFFFFFFF },
+            { 0xFFFFFFF0, 0x20 },
+            { (uint32_t)offset_, 1 }
+        };
+
+        for (size_t i = 0; i < sizeof(kStrips) / sizeof(kStrips[0]); ++i)
+        {
+            std::string corrupt_ = cr2_;
+            corrupt_.replace(fixtures::kCr2_StripOffsetValue, 4, fixtures::get32(kStrips[i][0], true));
+            corrupt_.replace(fixtures::kCr2_StripLengthValue, 4, fixtures::get32(kStrips[i][1], true));
+
+            Exact data_(corrupt_);
+            CHECK(!eds::findEmbeddedJpeg(data_.view(), offset_, length_));
+            readAll(data_.view());
+        }
+
+        // IFD1 pointing back at IFD0, and at itself
+        const uint32_t kLoops[] = { fixtures::kCr2_Ifd0, fixtures::kCr2_Ifd1 };
+
+        for (size_t i = 0; i < sizeof(kLoops) / sizeof(kLoops[0]); ++i)
+        {
+            std::string corrupt_ = cr2_;
+            corrupt_.replace(fixtures::kCr2_Ifd1 + 2 + 12, 4, fixtures::get32(kLoops[i], true));
+
+            Exact data_(corrupt_);
+            eds::TiffReader reader_;
+
+            CHECK(reader_.open(data_.view()));
+            CHECK(0 == reader_.getNextIfd(fixtures::kCr2_Ifd1));
+            readAll(data_.view());
+        }
+    }
+
+    void testCorruptCr3StaysInside()
+    {
+        std::string cr3_ = fixtures::makeCr3(kPreviewBytes, 64, false);
+        size_t stsz_ = cr3_.find("stsz") + 4;
+        size_t co64_ = cr3_.find("co64") + 4;
+        size_t offset_ = 0;
+        size_t length_ = 0;
+
+        CHECK(std::string::npos != cr3_.find("stsz") && std::string::npos != cr3_.find("co64"));
+
+        // sample size: larger than the file, 0 with no table after it
+        const uint32_t kSizes[] = { (uint32_t)cr3_.size(), 0xFFFFFFFF, 0 };
+
+        for (size_t i = 0; i < sizeof(kSizes) / sizeof(kSizes[0]); ++i)
+        {
+            std::string corrupt_ = cr3_;
+            corrupt_.replace(stsz_ + 4, 4, fixtures::getBig32(kSizes[i]));
+
+            Exact data_(corrupt_);
+            CHECK(!eds::findEmbeddedJpeg(data_.view(), offset_, length_));
+        }
+
+        // chunk offset: past the end, where offset + size wraps, no entries
+        const uint64_t kOffsets[] = { cr3_.size(), 0xFFFFFFFFFFFFFF00ull, (uint64_t)cr3_.size() - 10 };
+
+        for (size_t i = 0; i < sizeof(kOffsets) / sizeof(kOffsets[0]); ++i)
+        {
+            std::string corrupt_ = cr3_;
+            corrupt_.replace(co64_ + 8, 8, fixtures::getBig64(kOffsets[i]));
+
+            Exact data_(corrupt_);
+            CHECK(!eds::findEmbeddedJpeg(data_.view(), offset_, length_));
+        }
+
+        {
+            std::string corrupt_ = cr3_;
+            corrupt_.replace(co64_ + 4, 4, fixtures::getBig32(0));
+
+            Exact data_(corrupt_);
+            CHECK(!eds::findEmbeddedJpeg(data_.view(), offset_, length_));
+        }
+
+        // box sizes: smaller than a header, past the parent, a 64 bit size past the end, 0 running to the end
+        size_t boxes_[] = { cr3_.find("moov") - 4, stsz_ - 8, co64_ - 8 };
+        const uint32_t kBoxSizes[] = { 4, 0x7FFFFFFF, 1, 0 };
+
+        for (size_t i = 0; i < sizeof(boxes_) / sizeof(boxes_[0]); ++i)
+        {
+            for (size_t j = 0; j < sizeof(kBoxSizes) / sizeof(kBoxSizes[0]); ++j)
+            {
+                std::string corrupt_ = cr3_;
+                corrupt_.replace(boxes_[i], 4, fixtures::getBig32(kBoxSizes[j]));
+
+                Exact data_(corrupt_);
+                readAll(data_.view());
+            }
+        }
+
+        // the field a reader wants next is the one past the end of the file
+        std::string ftyp_ = cr3_.substr(0, cr3_.find("moov") - 4);
+        std::string co64Box_ = fixtures::makeBox("co64", fixtures::getBig32(0) + fixtures::getBig32(1) + fixtures::getBig64(0));
+        std::string stbl_ = fixtures::makeBox("stbl", co64Box_ + fixtures::makeBox("stsz", fixtures::getBig32(0) + fixtures::getBig32(0) + fixtures::getBig32(1)));
+        const std::string kAtTheEnd[] =
+        {
+            // a 64 bit size with no room for it
+            ftyp_ + fixtures::getBig32(1) + "moov",
+            // a sample size of 0 and no table
+            ftyp_ + fixtures::makeBox("moov", fixtures::makeBox("trak", fixtures::makeBox("mdia", fixtures::makeBox("minf", stbl_)))),
+            // Canon's uuid box with half a uuid
+            ftyp_ + fixtures::makeBox("moov", fixtures::makeBox("uuid", std::string(8, '\x85')))
+        };
+
+        for (size_t i = 0; i < sizeof(kAtTheEnd) / sizeof(kAtTheEnd[0]); ++i)
+        {
+            Exact data_(kAtTheEnd[i]);
+
+            CHECK(eds::kImageFormat_Cr3 == eds::detectImageFormat(data_.view()));
+            CHECK(!eds::findEmbeddedJpeg(data_.view(), offset_, length_));
+            readAll(data_.view());
+        }
+
+        // garbage under a valid ftyp, with a fixed seed so a failure repeats
+        uint32_t seed_ = 12345;
+
+        for (unsigned int i = 0; i < 2000; ++i)
+        {
+            std::string corrupt_ = i % 2 ? cr3_ : fixtures::makeCr2(kPreviewBytes, 64, 0 == i % 4);
+
+            for (unsigned int j = 0; j < 8; ++j)
+            {
+                seed_ = seed_ * 1664525 + 1013904223;
+                // keep the magic, it's the structure after it under test
+                size_t at_ = 12 + (seed_ >> 8) % (corrupt_.size() - 12);
+                corrupt_[at_] = (char)(seed_ >> 24);
+            }
+
+            readAll(Exact(corrupt_).view());
+        }
+    }
+}
+
+int main()
+{
+    RUN_TEST(testFindsThePreview);
+    RUN_TEST(testTruncatedContainersStayInside);
+    RUN_TEST(testCorruptTiffStaysInside);
+    RUN_TEST(testCorruptCr3StaysInside);
+
+    return 0;
+}
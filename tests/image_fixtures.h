@@ -0,0 +1,130 @@
+#pragma once
+
+#include <algorithm>
+#include <stdint.h>
+#include <string>
+
+// Synthetic captures for the container tests and the preview benchmark: the
+// structure findEmbeddedJpeg() walks, filler everywhere else. Offsets are
+// laid out by hand so the tests can aim at single fields.
+namespace fixtures
+{
+    inline std::string getBig32(uint32_t value)
+    {
+        char bytes_[4] = { (char)(value >> 24), (char)(value >> 16), (char)(value >> 8), (char)value };
+        return std::string(bytes_, 4);
+    }
+
+    inline std::string getBig64(uint64_t value)
+    {
+        return getBig32((uint32_t)(value >> 32)) + getBig32((uint32_t)value);
+    }
+
+    inline std::string get32(uint32_t value, bool littleEndian)
+    {
+        std::string big_ = getBig32(value);
+        return littleEndian ? std::string(big_.rbegin(), big_.rend()) : big_;
+    }
+
+    inline std::string get16(uint16_t value, bool littleEndian)
+    {
+        char bytes_[2] = { (char)(value >> 8), (char)value };
+        return littleEndian ? std::string(1, bytes_[1]) + bytes_[0] : std::string(bytes_, 2);
+    }
+
+    // SOI, an APP0 segment, filler and EOI, size bytes in all
+    inline std::string makeJpeg(size_t size)
+    {
+        std::string jpeg_("\xFF\xD8\xFF\xE0\x00\x10JFIF\0", 11);
+        jpeg_.resize(std::max<size_t>(size, jpeg_.size() + 2) - 2, '\x55');
+        return jpeg_ + "\xFF\xD9";
+    }
+
+    // CR2 layout, byte offsets into the file
+    enum
+    {
+        kCr2_FirstIfd = 4,
+        kCr2_Ifd0 = 16,
+        kCr2_StripOffsetValue = kCr2_Ifd0 + 2 + 8,
+        kCr2_StripLengthValue = kCr2_Ifd0 + 2 + 12 + 8,
+        kCr2_NextIfd = kCr2_Ifd0 + 2 + 3 * 12,
+        kCr2_Ifd1 = kCr2_NextIfd + 4
+    };
+
+    // TIFF header with "CR" and version 2, IFD0 with the preview as its one
+    // strip and a Make string, IFD1 with a thumbnail pointer, the preview,
+    // then rawBytes standing in for the sensor data
+    inline std::string makeCr2(size_t previewBytes, size_t rawBytes, bool littleEndian = true)
+    {
+        const uint32_t kMakeOffset = kCr2_Ifd1 + 2 + 12 + 4;
+        const uint32_t kPreviewOffset = kMakeOffset + 6;
+
+        std::string cr2_ = littleEndian ? std::string("II*\0", 4) : std::string("MM\0*", 4);
+        cr2_ += get32(kCr2_Ifd0, littleEndian);
+        cr2_ += std::string("CR\x02\0", 4) + get32(0, littleEndian);
+
+        // IFD0: StripOffsets, StripByteCounts, Make
+        cr2_ += get16(3, littleEndian);
+        cr2_ += get16(0x0111, littleEndian) + get16(4, littleEndian) + get32(1, littleEndian) + get32(kPreviewOffset, littleEndian);
+        cr2_ += get16(0x0117, littleEndian) + get16(4, littleEndian) + get32(1, littleEndian) + get32((uint32_t)previewBytes, littleEndian);
+        cr2_ += get16(0x010F, littleEndian) + get16(2, littleEndian) + get32(6, littleEndian) + get32(kMakeOffset, littleEndian);
+        cr2_ += get32(kCr2_Ifd1, littleEndian);
+
+        // IFD1: JPEGInterchangeFormat, the thumbnail is the preview again
+        cr2_ += get16(1, littleEndian);
+        cr2_ += get16(0x0201, littleEndian) + get16(4, littleEndian) + get32(1, littleEndian) + get32(kPreviewOffset, littleEndian);
+        cr2_ += get32(0, littleEndian);
+
+        cr2_ += std::string("Canon\0", 6);
+        cr2_ += makeJpeg(previewBytes);
+        cr2_ += std::string(rawBytes, '\0');
+
+        return cr2_;
+    }
+
+    inline std::string makeBox(const char* type, const std::string& payload)
+    {
+        return getBig32((uint32_t)(8 + payload.size())) + std::string(type, 4) + payload;
+    }
+
+    // ftyp "crx ", moov with Canon's uuid box (CMT1 a small TIFF) and one
+    // trak whose stbl locates the preview in mdat, then rawBytes of sensor
+    // data. perSampleSize puts the length in the stsz table rather than its
+    // sample size field.
+    inline std::string makeCr3(size_t previewBytes, size_t rawBytes, bool perSampleSize = false)
+    {
+        static const char kCanonUuid[16] = { '\x85', '\xC0', '\xB6', '\x87', '\x82', '\x0F', '\x11', '\xE0', '\x81', '\x11', '\xF4', '\xCE', '\x46', '\x2B', '\x6A', '\x48' };
+
+        std::string tiff_("II*\0", 4);
+        tiff_ += get32(8, true) + get16(0, true) + get32(0, true);
+
+        std::string uuid_ = std::string(kCanonUuid, 16) + makeBox("CNCV", "CanonCR3_001/00.09.00/00.00.00") + makeBox("CMT1", tiff_);
+
+        std::string stsz_ = getBig32(0);
+
+        if (perSampleSize)
+        {
+            stsz_ += getBig32(0) + getBig32(1) + getBig32((uint32_t)previewBytes);
+        }
+        else
+        {
+            stsz_ += getBig32((uint32_t)previewBytes) + getBig32(1);
+        }
+
+        std::string ftyp_ = makeBox("ftyp", "crx " + getBig32(1) + "crx isom");
+
+        // the chunk offset depends on the size of moov, which doesn't depend on the offset's value
+        std::string co64_ = getBig32(0) + getBig32(1) + getBig64(0);
+        std::string stbl_ = makeBox("stsz", stsz_) + makeBox("co64", co64_);
+        std::string trak_ = makeBox("trak", makeBox("mdia", makeBox("minf", makeBox("stbl", stbl_))));
+        std::string moov_ = makeBox("moov", makeBox("uuid", uuid_) + trak_);
+
+        uint64_t previewOffset_ = ftyp_.size() + moov_.size() + 8;
+        co64_ = getBig32(0) + getBig32(1) + getBig64(previewOffset_);
+        stbl_ = makeBox("stsz", stsz_) + makeBox("co64", co64_);
+        trak_ = makeBox("trak", makeBox("mdia", makeBox("minf", makeBox("stbl", stbl_))));
+        moov_ = makeBox("moov", makeBox("uuid", uuid_) + trak_);
+
+        return ftyp_ + moov_ + makeBox("mdat", makeJpeg(previewBytes) + std::string(rawBytes, '\0'));
+    }
+}
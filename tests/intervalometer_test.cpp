@@ -0,0 +1,332 @@
+#include "intervalometer.h"
+
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "camera_manager.h"
+#include "check.h"
+#include "ofMain.h"
+#include "stub_sdk.h"
+#include "trigger_engine.h"
+
+namespace
+{
+    const uint64_t kSecond = 1000000000ull;
+
+    // Time only moves when the scheduler sleeps, each sleep overshoots by up
+    // to maxOversleep like a loaded machine would
+    class SimulatedClock
+    {
+    public:
+        explicit SimulatedClock(uint64_t maxOversleep = 0)
+        : mNow(1000)
+        , mMaxOversleep(maxOversleep)
+        , mRandom(1)
+        {
+        }
+
+        uint64_t now()
+        {
+            std::lock_guard<std::mutex> lock_(mMutex);
+            return mNow;
+        }
+
+        void sleepUntil(uint64_t nanos)
+        {
+            std::lock_guard<std::mutex> lock_(mMutex);
+
+            mNow = std::max(mNow, nanos);
+
+            if (0 < mMaxOversleep)
+            {
+                mNow += mRandom() % mMaxOversleep;
+            }
+        }
+
+        eds::Intervalometer::Clock get()
+        {
+            eds::Intervalometer::Clock clock_;
+            clock_.now = [this]() { return now(); };
+            clock_.sleepUntil = [this](uint64_t nanos_) { sleepUntil(nanos_); };
+            return clock_;
+        }
+
+        uint64_t getStart() const
+        {
+            return 1000;
+        }
+
+    private:
+        std::mutex mMutex;
+        uint64_t mNow;
+        uint64_t mMaxOversleep;
+        std::mt19937 mRandom;
+    };
+
+    void waitUntilDone(eds::Intervalometer& intervalometer)
+    {
+        while (intervalometer.isRunning())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        intervalometer.stop();
+    }
+
+    void testNoDriftOverDays()
+    {
+        const uint64_t kFrames = 3 * 24 * 360;
+        const uint64_t kMaxOversleep = 2000000;
+
+        SimulatedClock clock_(kMaxOversleep);
+        eds::Intervalometer intervalometer_(clock_.get());
+        std::vector<uint64_t> fired_;
+        unsigned int keepAlives_ = 0;
+
+        eds::Intervalometer::Settings settings_;
+        settings_.intervalMillis = 10000.0;
+        settings_.frameCount = kFrames;
+        settings_.fire = [&]() { fired_.push_back(clock_.now()); };
+        settings_.keepAlive = [&]() { ++keepAlives_; };
+
+        CHECK(intervalometer_.start(settings_));
+        CHECK(!intervalometer_.start(settings_));
+        waitUntilDone(intervalometer_);
+
+        CHECK(kFrames == fired_.size());
+        CHECK(kFrames == intervalometer_.getFiredCount());
+        CHECK(0 == intervalometer_.getSkippedCount());
+        CHECK(0 == keepAlives_);
+
+        // three days in, the last frame is as late as any single sleep, not the sum of them
+        for (size_t i = 0; i < fired_.size(); ++i)
+        {
+            uint64_t due_ = clock_.getStart() + i * 10 * kSecond;
+            CHECK(due_ <= fired_[i] && fired_[i] - due_ < kMaxOversleep);
+        }
+
+        CHECK(intervalometer_.getJitterMicrosMax() < kMaxOversleep / 1000.0);
+        CHECK(0.0 < intervalometer_.getJitterMicrosStdDev());
+    }
+
+    void testKeepAliveBetweenLongIntervals()
+    {
+        SimulatedClock clock_;
+        eds::Intervalometer intervalometer_(clock_.get());
+        unsigned int keepAlives_ = 0;
+
+        eds::Intervalometer::Settings settings_;
+        settings_.intervalMillis = 5 * 60000.0;
+        settings_.frameCount = 10;
+        settings_.keepAliveMillis = 60000.0;
+        settings_.fire = []() {};
+        settings_.keepAlive = [&keepAlives_]() { ++keepAlives_; };
+
+        CHECK(intervalometer_.start(settings_));
+        waitUntilDone(intervalometer_);
+
+        // at 1, 2, 3 and 4 minutes into each of the 9 gaps
+        CHECK(10 == intervalometer_.getFiredCount());
+        CHECK(9 * 4 == keepAlives_);
+        CHECK(keepAlives_ == intervalometer_.getKeepAliveCount());
+    }
+
+    // A download keeps the rig busy for 25 s after every frame of a 10 s schedule
+    void runBusySchedule(eds::IntervalPolicy policy, std::vector<uint64_t>& fired, eds::Intervalometer& intervalometer, SimulatedClock& clock)
+    {
+        uint64_t busyUntil_ = 0;
+
+        eds::Intervalometer::Settings settings_;
+        settings_.intervalMillis = 10000.0;
+        settings_.frameCount = 30;
+        settings_.policy = policy;
+        settings_.keepAliveMillis = 0.0;
+        settings_.fire = [&]() { fired.push_back(clock.now()); busyUntil_ = clock.now() + 25 * kSecond; };
+        settings_.busy = [&]() { return clock.now() < busyUntil_; };
+
+        CHECK(intervalometer.start(settings_));
+        waitUntilDone(intervalometer);
+
+        CHECK(30 == intervalometer.getFiredCount() + intervalometer.getSkippedCount());
+
+        // never two frames in a burst after a wait
+        for (size_t i = 1; i < fired.size(); ++i)
+        {
+            CHECK(25 * kSecond <= fired[i] - fired[i - 1]);
+        }
+    }
+
+    void testSkipPolicy()
+    {
+        SimulatedClock clock_;
+        eds::Intervalometer intervalometer_(clock_.get());
+        std::vector<uint64_t> fired_;
+
+        runBusySchedule(eds::kIntervalPolicy_Skip, fired_, intervalometer_, clock_);
+
+        // every third deadline is free, the frames taken are on time
+        CHECK(10 == intervalometer_.getFiredCount());
+        CHECK(20 == intervalometer_.getSkippedCount());
+        CHECK(0 == intervalometer_.getQueuedCount());
+
+        for (size_t i = 0; i < fired_.size(); ++i)
+        {
+            CHECK(clock_.getStart() + i * 30 * kSecond == fired_[i]);
+        }
+
+        CHECK(0.0 == intervalometer_.getJitterMicrosMax());
+    }
+
+    void testQueuePolicy()
+    {
+        SimulatedClock clock_;
+        eds::Intervalometer intervalometer_(clock_.get());
+        std::vector<uint64_t> fired_;
+
+        runBusySchedule(eds::kIntervalPolicy_Queue, fired_, intervalometer_, clock_);
+
+        // the frame due at 10 s waits for the download and is taken at 25 s, and so on
+        CHECK(0 < intervalometer_.getQueuedCount());
+        CHECK(intervalometer_.getFiredCount() > 10);
+        CHECK(25 * kSecond + clock_.getStart() <= fired_[1] && fired_[1] < 26 * kSecond + clock_.getStart());
+    }
+
+    void testStopsRightAway()
+    {
+        eds::Intervalometer intervalometer_;
+
+        eds::Intervalometer::Settings settings_;
+        settings_.intervalMillis = 100000.0;
+        settings_.fire = []() {};
+
+        CHECK(intervalometer_.start(settings_));
+
+        // the first frame is due right away, the second in 100 s
+        while (0 == intervalometer_.getFiredCount())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        uint64_t start_ = stub::nowNanos();
+        intervalometer_.stop();
+
+        CHECK(!intervalometer_.isRunning());
+        CHECK((stub::nowNanos() - start_) / 1000000 < 500);
+        CHECK(1 == intervalometer_.getFiredCount());
+    }
+
+    // The app's wiring on a stub rig: every frame fires the trigger engine,
+    // the cameras hand over a file each, and the schedule waits for them
+    void testDrivesTheRig()
+    {
+        const unsigned int kCameraCount = 3;
+        const uint64_t kFrames = 12;
+
+        stub::reset(kCameraCount);
+
+        for (unsigned int i = 0; i < kCameraCount; ++i)
+        {
+            stub::getConfig(i).transferMegabytesPerSecond = 20.0;
+        }
+
+        {
+            eds::EventBus bus_;
+            eds::CameraManager cameras_(bus_);
+            eds::TriggerEngine trigger_(cameras_);
+            SimulatedClock clock_;
+            eds::Intervalometer intervalometer_(clock_.get());
+            unsigned int shots_ = 0;
+
+            CHECK(EDS_ERR_OK == cameras_.open(eds::CameraSession::Settings()));
+
+            bus_.subscribe(eds::kEventType_Object, kEdsObjectEvent_DirItemCreated, [&cameras_](const eds::Event& event_)
+            {
+                CHECK(cameras_.getSession(event_.camera)->getDownloadManager().tryEnqueue(event_.object));
+            });
+
+            eds::Intervalometer::Settings settings_;
+            settings_.intervalMillis = 10000.0;
+            settings_.frameCount = kFrames;
+            settings_.policy = eds::kIntervalPolicy_Queue;
+            settings_.keepAliveMillis = 4000.0;
+
+            settings_.fire = [&]()
+            {
+                CHECK(0 == cameras_.getInFlightCount());
+                CHECK(kCameraCount == trigger_.fire());
+
+                // the files show up on the bus, the app hands them over from update()
+                for (unsigned int i = 0; i < kCameraCount; ++i)
+                {
+                    CHECK(stub::emitItemCreated(i, "IMG_" + std::to_string(shots_ * 10 + i) + ".JPG", 1024 * 1024));
+                }
+
+                bus_.dispatch();
+                ++shots_;
+            };
+
+            settings_.busy = [&cameras_]() { return 0 < cameras_.getInFlightCount(); };
+
+            settings_.keepAlive = [&cameras_]()
+            {
+                for (unsigned int i = 0; i < cameras_.getSessionCount(); ++i)
+                {
+                    cameras_.getSession(i)->sendCommand(eds::kCommandClass_Property, kEdsCameraCommand_ExtendShutDownTimer, 0);
+                }
+            };
+
+            CHECK(intervalometer_.start(settings_));
+            waitUntilDone(intervalometer_);
+            cameras_.close();
+
+            uint64_t fired_ = intervalometer_.getFiredCount();
+
+            CHECK(kFrames == fired_ + intervalometer_.getSkippedCount());
+            CHECK(0 < fired_ && shots_ == fired_);
+            CHECK(fired_ == trigger_.getShotCount());
+            CHECK(fired_ * kCameraCount == cameras_.getCompletedCount());
+            CHECK(0 < intervalometer_.getKeepAliveCount());
+
+            for (unsigned int i = 0; i < kCameraCount; ++i)
+            {
+                std::vector<stub::CommandRecord> commands_ = stub::getCommands(i);
+                uint64_t presses_ = 0;
+                uint64_t keepAlives_ = 0;
+
+                for (size_t j = 0; j < commands_.size(); ++j)
+                {
+                    if (kEdsCameraCommand_ExtendShutDownTimer == commands_[j].command)
+                    {
+                        ++keepAlives_;
+                    }
+                    else if (kEdsCameraCommand_ShutterButton_Completely == commands_[j].param)
+                    {
+                        ++presses_;
+                    }
+                }
+
+                CHECK(fired_ == presses_);
+                CHECK(intervalometer_.getKeepAliveCount() == keepAlives_);
+            }
+        }
+
+        CHECK(0 == stub::getLiveRefCount());
+        CHECK(0 == stub::getBadReleaseCount());
+    }
+}
+
+int main()
+{
+    ofSetLogLevel(OF_LOG_WARNING);
+
+    RUN_TEST(testNoDriftOverDays);
+    RUN_TEST(testKeepAliveBetweenLongIntervals);
+    RUN_TEST(testSkipPolicy);
+    RUN_TEST(testQueuePolicy);
+    RUN_TEST(testStopsRightAway);
+    RUN_TEST(testDrivesTheRig);
+
+    return 0;
+}
@@ -0,0 +1,140 @@
+#include "alloc_counter.h"
+
+#include <thread>
+#include <vector>
+
+#include "camera_manager.h"
+#include "check.h"
+#include "evf_decoder.h"
+#include "stub_sdk.h"
+
+namespace
+{
+    void testProbeCatchesAnAllocatingFrame()
+    {
+        eds::AllocationProbe probe_(2);
+        std::vector<int> kept_;
+
+        CHECK(eds::AllocationCounter::isEnabled());
+
+        // warm-up frames may allocate
+        probe_.begin();
+        kept_.reserve(16);
+        CHECK(0 < probe_.end());
+
+        for (int i = 0; i < 3; ++i)
+        {
+            probe_.begin();
+            kept_.push_back(i);
+            CHECK(0 == probe_.end());
+        }
+
+        CHECK(probe_.isWarmedUp());
+        CHECK(0 == probe_.getFramesWithAllocations());
+        CHECK(-1 == probe_.getFirstFrameWithAllocations());
+
+        probe_.begin();
+        kept_.reserve(1024);
+        CHECK(0 < probe_.end());
+
+        CHECK(1 == probe_.getFramesWithAllocations());
+        CHECK(4 == probe_.getFirstFrameWithAllocations());
+    }
+
+    // Runs the liveview pass of ofApp::update() once every 5 ms until the
+    // decoder has delivered frames more frames
+    void runFrames(eds::EvfDecoder& decoder, eds::EvfCapture& capture, eds::DecodedFrame& decoded, uint64_t frames)
+    {
+        uint64_t until_ = decoder.getDeliveredCount() + frames;
+        uint64_t deadline_ = stub::nowNanos() + 20 * 1000000000ull;
+
+        while (decoder.getDeliveredCount() < until_)
+        {
+            CHECK(stub::nowNanos() < deadline_);
+
+            if (decoder.update(capture, decoded) & eds::EvfDecoder::kUpdate_Decoded)
+            {
+                CHECK(0 < decoded.pixels.getWidth());
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+
+    // The app's liveview path on a stub camera, counted across the whole
+    // process: the EvfCapture thread downloading, the EvfDecoder workers and
+    // this thread making the same update() calls ofApp::update() makes.
+    void testLiveviewFramesDontAllocate()
+    {
+        const uint64_t kWarmUpFrames = 60;
+        const uint64_t kFrames = 200;
+
+        stub::reset(1);
+        stub::getConfig(0).evfFramesPerSecond = 100.0;
+
+        {
+            eds::EventBus bus_;
+            eds::CameraManager cameras_(bus_);
+            eds::EvfDecoder decoder_;
+            eds::DecodedFrame decoded_;
+
+            CHECK(EDS_ERR_OK == cameras_.open(eds::CameraSession::Settings()));
+
+            eds::CameraSession* session_ = cameras_.getSession(0);
+            eds::EvfCapture& capture_ = session_->getEvfCapture();
+
+            decoder_.setTargetSize(480, 320);
+            decoder_.start(2);
+            CHECK(EDS_ERR_OK == session_->startLiveview());
+
+            // every ring slot, stream, decoder job and pixel buffer gets its storage
+            runFrames(decoder_, capture_, decoded_, kWarmUpFrames);
+
+            uint64_t allocations_ = eds::AllocationCounter::getCount();
+            uint64_t library_ = stub::getDecodeAllocationCount();
+
+            runFrames(decoder_, capture_, decoded_, kFrames);
+
+            allocations_ = eds::AllocationCounter::getCount() - allocations_;
+            library_ = stub::getDecodeAllocationCount() - library_;
+
+            // FreeImage has no way to decode into an existing bitmap, so every
+            // decode allocates its stream and bitmap inside the library. Those
+            // are all that may be left: the only slack is for the decodes the
+            // two workers had in flight when the counts were read.
+            const uint64_t kInFlight = 2 * 2 * 3;
+            uint64_t ours_ = allocations_ > library_ ? allocations_ - library_ : 0;
+
+            CHECK(0 < library_);
+            CHECK_MESSAGE(ours_ <= kInFlight, "%llu allocations in the process over %llu frames after warm-up, %llu of them outside FreeImage",
+                (unsigned long long)allocations_, (unsigned long long)kFrames, (unsigned long long)ours_);
+
+            // the count sees the other threads: one allocation per download on the capture thread shows up
+            stub::setEvfHook([](unsigned int) { static int* volatile p_; p_ = new int(1); delete p_; });
+
+            allocations_ = eds::AllocationCounter::getCount();
+            runFrames(decoder_, capture_, decoded_, 10);
+            allocations_ = eds::AllocationCounter::getCount() - allocations_;
+
+            stub::setEvfHook(std::function<void(unsigned int)>());
+
+            CHECK_MESSAGE(10 <= allocations_, "%llu allocations counted from the capture thread", (unsigned long long)allocations_);
+
+            CHECK(EDS_ERR_OK == session_->endLiveview());
+            decoder_.stop();
+            cameras_.close();
+
+            CHECK(0 == decoder_.getFailedCount());
+        }
+
+        CHECK(0 == stub::getLiveRefCount());
+    }
+}
+
+int main()
+{
+    RUN_TEST(testProbeCatchesAnAllocatingFrame);
+    RUN_TEST(testLiveviewFramesDontAllocate);
+
+    return 0;
+}
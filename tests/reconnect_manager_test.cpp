@@ -0,0 +1,242 @@
+#include "reconnect_manager.h"
+
+#include <functional>
+#include <map>
+#include <thread>
+
+#include "check.h"
+#include "stub_sdk.h"
+
+namespace
+{
+    // what drop() snapshots, read into the cache the way ofApp prefetches them
+    const EdsPropertyID kPrefetch[] =
+    {
+        kEdsPropID_SaveTo,
+        kEdsPropID_ImageQuality,
+        kEdsPropID_DriveMode,
+        kEdsPropID_ISOSpeed,
+        kEdsPropID_Av,
+        kEdsPropID_Tv,
+        kEdsPropID_Evf_AFMode,
+        kEdsPropID_Evf_Zoom,
+        kEdsPropID_Evf_ZoomPosition
+    };
+
+    const size_t kSnapshotSize = sizeof(kPrefetch) / sizeof(kPrefetch[0]);
+
+    bool waitFor(const std::function<bool()>& done, unsigned int timeoutMillis = 5000)
+    {
+        uint64_t deadline_ = stub::nowNanos() + timeoutMillis * 1000000ull;
+
+        while (!done())
+        {
+            if (deadline_ < stub::nowNanos())
+            {
+                return false;
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        return true;
+    }
+
+    void open(eds::CameraManager& cameras)
+    {
+        eds::CameraSession::Settings settings_;
+        settings_.prefetch.assign(kPrefetch, kPrefetch + kSnapshotSize);
+
+        CHECK(EDS_ERR_OK == cameras.open(settings_));
+
+        // the prefetch runs on the command threads, wait until it's in the caches
+        for (unsigned int i = 0; i < cameras.getSessionCount(); ++i)
+        {
+            if (cameras.getSession(i)->isOpen())
+            {
+                CHECK(EDS_ERR_OK == cameras.getSession(i)->getCommandExecutor().execute(eds::kCommandClass_Property, []() { return EDS_ERR_OK; }));
+            }
+        }
+    }
+
+    // Reconnects handed to the UI thread, by session index
+    std::map<unsigned int, eds::ReconnectManager::Reconnect> waitForReconnects(eds::ReconnectManager& reconnects, size_t count)
+    {
+        std::map<unsigned int, eds::ReconnectManager::Reconnect> finished_;
+
+        CHECK(waitFor([&]()
+        {
+            std::vector<eds::ReconnectManager::Reconnect> update_ = reconnects.update();
+
+            for (size_t i = 0; i < update_.size(); ++i)
+            {
+                finished_[update_[i].index] = update_[i];
+            }
+
+            return count <= finished_.size();
+        }));
+
+        CHECK(count == finished_.size());
+        return finished_;
+    }
+
+    void testReplaysOnlyWhatChanged()
+    {
+        stub::reset(2);
+
+        {
+            eds::EventBus bus_;
+            eds::CameraManager cameras_(bus_);
+            eds::ReconnectManager reconnects_(cameras_);
+
+            open(cameras_);
+
+            reconnects_.drop(0, false);
+            reconnects_.drop(1, true);
+            CHECK(reconnects_.hasDropped());
+            CHECK(!cameras_.getSession(0)->isOpen());
+            CHECK(!cameras_.getSession(1)->isOpen());
+
+            // changed on the bodies while they were unplugged
+            stub::setPropertyValue(0, kEdsPropID_ISOSpeed, 0x58);
+            stub::setPropertyValue(0, kEdsPropID_Av, 0x38);
+            stub::setPropertyValue(0, kEdsPropID_Evf_Zoom, kEdsEvfZoom_x5);
+            stub::setPropertyValue(1, kEdsPropID_Evf_Zoom, kEdsEvfZoom_x10);
+
+            CHECK(reconnects_.reconnect());
+
+            std::map<unsigned int, eds::ReconnectManager::Reconnect> finished_ = waitForReconnects(reconnects_, 2);
+
+            CHECK(!reconnects_.hasDropped());
+            CHECK(2 == reconnects_.getReconnectCount());
+
+            // the evf values only go back to a body that had liveview
+            CHECK(!finished_[0].bLiveview);
+            CHECK(2 == finished_[0].replayed);
+            CHECK(kSnapshotSize == finished_[0].snapshotSize);
+            CHECK(0x48 == stub::getPropertyValue(0, kEdsPropID_ISOSpeed));
+            CHECK(0x30 == stub::getPropertyValue(0, kEdsPropID_Av));
+            CHECK(kEdsEvfZoom_x5 == stub::getPropertyValue(0, kEdsPropID_Evf_Zoom));
+            CHECK(!cameras_.getSession(0)->isLiveviewStarted());
+
+            CHECK(finished_[1].bLiveview);
+            CHECK(1 == finished_[1].replayed);
+            CHECK(kSnapshotSize == finished_[1].snapshotSize);
+            CHECK(kEdsEvfZoom_Fit == stub::getPropertyValue(1, kEdsPropID_Evf_Zoom));
+            CHECK(cameras_.getSession(1)->isLiveviewStarted());
+
+            CHECK(3 == reconnects_.getReplayedCount());
+            CHECK(0 == reconnects_.getUnknownCount());
+
+            // time to first frame is taken once per reconnect
+            CHECK(!reconnects_.markFirstFrame(2));
+            CHECK(waitFor([&]() { return cameras_.getSession(1)->getEvfCapture().acquire(); }));
+            CHECK(reconnects_.markFirstFrame(1));
+            CHECK(!reconnects_.markFirstFrame(1));
+            CHECK(0.0 < reconnects_.getLastFirstFrameMillis());
+            CHECK(reconnects_.getLastFirstFrameMillis() <= reconnects_.getFirstFrameMillisMax());
+
+            // nothing dropped, nothing to look for
+            CHECK(!reconnects_.reconnect());
+
+            reconnects_.stop();
+            cameras_.close();
+        }
+
+        CHECK(0 == stub::getLiveRefCount());
+        CHECK(0 == stub::getBadReleaseCount());
+    }
+
+    void testFindsBodiesOnSwappedPorts()
+    {
+        stub::reset(2);
+
+        {
+            eds::EventBus bus_;
+            eds::CameraManager cameras_(bus_);
+            eds::ReconnectManager reconnects_(cameras_);
+
+            open(cameras_);
+
+            reconnects_.drop(0, false);
+            reconnects_.drop(1, false);
+
+            // SN0 is found first and the port points to the slot of SN1, the serial number puts it back in its own
+            stub::setPortName(0, "usb:1");
+            stub::setPortName(1, "usb:0");
+            stub::setPropertyValue(0, kEdsPropID_Tv, 0x68);
+
+            CHECK(reconnects_.reconnect());
+
+            std::map<unsigned int, eds::ReconnectManager::Reconnect> finished_ = waitForReconnects(reconnects_, 2);
+
+            CHECK(0 == reconnects_.getUnknownCount());
+
+            for (unsigned int i = 0; i < 2; ++i)
+            {
+                eds::CameraSession* session_ = cameras_.getSession(i);
+
+                CHECK(session_->isOpen());
+                CHECK("SN" + std::to_string(i) == session_->getSerialNumber());
+                CHECK("usb:" + std::to_string(1 - i) == session_->getPortName());
+            }
+
+            // the settings of SN0 went to SN0
+            CHECK(1 == finished_[0].replayed);
+            CHECK(0 == finished_[1].replayed);
+            CHECK(0x60 == stub::getPropertyValue(0, kEdsPropID_Tv));
+
+            reconnects_.stop();
+            cameras_.close();
+        }
+
+        CHECK(0 == stub::getLiveRefCount());
+        CHECK(0 == stub::getBadReleaseCount());
+    }
+
+    void testLeavesUnknownBodiesAlone()
+    {
+        stub::reset(2);
+        stub::getConfig(0).openError = EDS_ERR_DEVICE_BUSY;
+
+        {
+            eds::EventBus bus_;
+            eds::CameraManager cameras_(bus_);
+            eds::ReconnectManager reconnects_(cameras_);
+
+            open(cameras_);
+            CHECK(!cameras_.getSession(0)->isOpen());
+
+            reconnects_.drop(1, false);
+
+            // SN0 opens now and is found first, on a port nobody left from
+            stub::getConfig(0).openError = EDS_ERR_OK;
+
+            CHECK(reconnects_.reconnect());
+
+            std::map<unsigned int, eds::ReconnectManager::Reconnect> finished_ = waitForReconnects(reconnects_, 1);
+
+            CHECK(1 == finished_.count(1));
+            CHECK(1 == reconnects_.getUnknownCount());
+            CHECK(!cameras_.getSession(0)->isOpen());
+            CHECK(cameras_.getSession(1)->isOpen());
+            CHECK("SN1" == cameras_.getSession(1)->getSerialNumber());
+            CHECK(!stub::isSessionOpen(0));
+
+            reconnects_.stop();
+            cameras_.close();
+        }
+
+        CHECK(0 == stub::getLiveRefCount());
+        CHECK(0 == stub::getBadReleaseCount());
+    }
+}
+
+int main()
+{
+    RUN_TEST(testReplaysOnlyWhatChanged);
+    RUN_TEST(testFindsBodiesOnSwappedPorts);
+    RUN_TEST(testLeavesUnknownBodiesAlone);
+
+    return 0;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "EDSDKErrors.h"
+#include "EDSDKTypes.h"
+
+// The EDSDK entry points the sources use, implemented by the virtual rig in
+// stub_sdk.cpp. See stub_sdk.h for driving it from a test.
+
+EdsError EdsInitializeSDK();
+EdsError EdsTerminateSDK();
+
+EdsUInt32 EdsRetain(EdsBaseRef inRef);
+EdsUInt32 EdsRelease(EdsBaseRef inRef);
+
+EdsError EdsGetChildCount(EdsBaseRef inRef, EdsUInt32* outCount);
+EdsError EdsGetChildAtIndex(EdsBaseRef inRef, EdsInt32 inIndex, EdsBaseRef* outRef);
+
+EdsError EdsGetPropertySize(EdsBaseRef inRef, EdsPropertyID inPropertyID, EdsInt32 inParam, EdsDataType* outDataType, EdsUInt32* outSize);
+EdsError EdsGetPropertyData(EdsBaseRef inRef, EdsPropertyID inPropertyID, EdsInt32 inParam, EdsUInt32 inPropertySize, EdsVoid* outPropertyData);
+EdsError EdsSetPropertyData(EdsBaseRef inRef, EdsPropertyID inPropertyID, EdsInt32 inParam, EdsUInt32 inPropertySize, const EdsVoid* inPropertyData);
+
+EdsError EdsGetCameraList(EdsCameraListRef* outCameraListRef);
+EdsError EdsGetDeviceInfo(EdsCameraRef inCameraRef, EdsDeviceInfo* outDeviceInfo);
+EdsError EdsOpenSession(EdsCameraRef inCameraRef);
+EdsError EdsCloseSession(EdsCameraRef inCameraRef);
+EdsError EdsSendCommand(EdsCameraRef inCameraRef, EdsCameraCommand inCommand, EdsInt32 inParam);
+
+EdsError EdsGetDirectoryItemInfo(EdsDirectoryItemRef inDirItemRef, EdsDirectoryItemInfo* outDirItemInfo);
+EdsError EdsDeleteDirectoryItem(EdsDirectoryItemRef inDirItemRef);
+EdsError EdsDownload(EdsDirectoryItemRef inDirItemRef, EdsUInt32 inReadSize, EdsStreamRef outStream);
+EdsError EdsDownloadCancel(EdsDirectoryItemRef inDirItemRef);
+EdsError EdsDownloadComplete(EdsDirectoryItemRef inDirItemRef);
+
+EdsError EdsCreateMemoryStream(EdsUInt32 inBufferSize, EdsStreamRef* outStream);
+EdsError EdsCreateMemoryStreamFromPointer(EdsVoid* inUserBuffer, EdsUInt32 inBufferSize, EdsStreamRef* outStream);
+EdsError EdsGetPointer(EdsStreamRef inStream, EdsVoid** outPointer);
+EdsError EdsSeek(EdsStreamRef inStreamRef, EdsInt32 inSeekOffset, EdsSeekOrigin inSeekOrigin);
+EdsError EdsGetPosition(EdsStreamRef inStreamRef, EdsUInt32* outPosition);
+EdsError EdsGetLength(EdsStreamRef inStreamRef, EdsUInt32* outLength);
+EdsError EdsSetProgressCallback(EdsBaseRef inRef, EdsProgressCallback inProgressCallback, EdsProgressOption inProgressOption, EdsVoid* inContext);
+
+EdsError EdsCreateEvfImageRef(EdsStreamRef inStreamRef, EdsEvfImageRef* outEvfImageRef);
+EdsError EdsDownloadEvfImage(EdsCameraRef inCameraRef, EdsEvfImageRef inEvfImageRef);
+
+EdsError EdsSetPropertyEventHandler(EdsCameraRef inCameraRef, EdsPropertyEvent inEvent, EdsPropertyEventHandler inPropertyEventHandler, EdsVoid* inContext);
+EdsError EdsSetObjectEventHandler(EdsCameraRef inCameraRef, EdsObjectEvent inEvent, EdsObjectEventHandler inObjectEventHandler, EdsVoid* inContext);
+EdsError EdsSetCameraStateEventHandler(EdsCameraRef inCameraRef, EdsStateEvent inEvent, EdsStateEventHandler inStateEventHandler, EdsVoid* inContext);
+EdsError EdsGetEvent();
@@ -0,0 +1,26 @@
+#pragma once
+
+// The subset of the EDSDK error codes the sources use, same values as the SDK
+
+#define EDS_ERR_OK                          0x00000000L
+
+#define EDS_ERR_UNIMPLEMENTED               0x00000001L
+#define EDS_ERR_INTERNAL_ERROR              0x00000002L
+#define EDS_ERR_MEM_ALLOC_FAILED            0x00000003L
+#define EDS_ERR_OPERATION_CANCELLED         0x00000005L
+
+#define EDS_ERR_FILE_OPEN_ERROR             0x00000023L
+#define EDS_ERR_FILE_WRITE_ERROR            0x00000028L
+
+#define EDS_ERR_INVALID_PARAMETER           0x00000060L
+#define EDS_ERR_INVALID_HANDLE              0x00000061L
+#define EDS_ERR_INVALID_POINTER             0x00000062L
+
+#define EDS_ERR_DEVICE_NOT_FOUND            0x00000080L
+#define EDS_ERR_DEVICE_BUSY                 0x00000081L
+#define EDS_ERR_COMM_DISCONNECTED           0x000000C1L
+
+#define EDS_ERR_SESSION_NOT_OPEN            0x00002003L
+#define EDS_ERR_SESSION_ALREADY_OPEN        0x0000201EL
+
+#define EDS_ERR_OBJECT_NOTREADY             0x0000A102L
@@ -0,0 +1,247 @@
+#pragma once
+
+#include <stdint.h>
+
+// The subset of the EDSDK types and constants the sources use, same values
+// as the SDK. The objects behind the refs live in stub_sdk.cpp.
+
+#define EDSCALLBACK
+#define EDS_MAX_NAME 256
+
+typedef void EdsVoid;
+typedef int EdsBool;
+typedef char EdsChar;
+
+typedef int8_t EdsInt8;
+typedef uint8_t EdsUInt8;
+typedef int16_t EdsInt16;
+typedef uint16_t EdsUInt16;
+typedef int32_t EdsInt32;
+typedef uint32_t EdsUInt32;
+typedef int64_t EdsInt64;
+typedef uint64_t EdsUInt64;
+typedef float EdsFloat;
+typedef double EdsDouble;
+
+typedef EdsUInt32 EdsError;
+
+struct __EdsObject;
+typedef struct __EdsObject* EdsBaseRef;
+
+typedef EdsBaseRef EdsCameraListRef;
+typedef EdsBaseRef EdsCameraRef;
+typedef EdsBaseRef EdsVolumeRef;
+typedef EdsBaseRef EdsDirectoryItemRef;
+typedef EdsBaseRef EdsStreamRef;
+typedef EdsBaseRef EdsImageRef;
+typedef EdsBaseRef EdsEvfImageRef;
+
+typedef EdsUInt32 EdsPropertyID;
+typedef EdsUInt32 EdsCameraCommand;
+typedef EdsUInt32 EdsCameraStatusCommand;
+typedef EdsUInt32 EdsPropertyEvent;
+typedef EdsUInt32 EdsObjectEvent;
+typedef EdsUInt32 EdsStateEvent;
+
+typedef enum
+{
+    kEdsDataType_Unknown = 0,
+    kEdsDataType_String = 2,
+    kEdsDataType_UInt32 = 9,
+    kEdsDataType_Point = 21,
+    kEdsDataType_Rect = 22,
+    kEdsDataType_FocusInfo = 101
+} EdsDataType;
+
+enum
+{
+    kEdsPropID_Unknown = 0x0000FFFF,
+    kEdsPropID_ProductName = 0x00000002,
+    kEdsPropID_BodyIDEx = 0x00000015,
+    kEdsPropID_SaveTo = 0x0000000B,
+    kEdsPropID_ImageQuality = 0x00000100,
+    kEdsPropID_FocusInfo = 0x00000104,
+    kEdsPropID_DriveMode = 0x00000401,
+    kEdsPropID_ISOSpeed = 0x00000402,
+    kEdsPropID_Av = 0x00000405,
+    kEdsPropID_Tv = 0x00000406,
+    kEdsPropID_AvailableShots = 0x0000040A,
+    kEdsPropID_AEModeSelect = 0x00000436,
+    kEdsPropID_Evf_OutputDevice = 0x00000500,
+    kEdsPropID_Evf_Mode = 0x00000501,
+    kEdsPropID_Evf_Zoom = 0x00000507,
+    kEdsPropID_Evf_ZoomPosition = 0x00000508,
+    kEdsPropID_Evf_AFMode = 0x0000050E,
+    kEdsPropID_Evf_CoordinateSystem = 0x00000540,
+    kEdsPropID_Evf_ZoomRect = 0x00000541
+};
+
+enum
+{
+    kEdsCameraCommand_TakePicture = 0x00000000,
+    kEdsCameraCommand_ExtendShutDownTimer = 0x00000001,
+    kEdsCameraCommand_PressShutterButton = 0x00000004,
+    kEdsCameraCommand_DoEvfAf = 0x00000102,
+    kEdsCameraCommand_DriveLensEvf = 0x00000103
+};
+
+enum
+{
+    kEdsCameraCommand_ShutterButton_OFF = 0x00000000,
+    kEdsCameraCommand_ShutterButton_Halfway = 0x00000001,
+    kEdsCameraCommand_ShutterButton_Completely = 0x00000003,
+    kEdsCameraCommand_ShutterButton_Halfway_NonAF = 0x00010001,
+    kEdsCameraCommand_ShutterButton_Completely_NonAF = 0x00010003
+};
+
+enum
+{
+    kEdsPropertyEvent_All = 0x00000100,
+    kEdsPropertyEvent_PropertyChanged = 0x00000101,
+    kEdsPropertyEvent_PropertyDescChanged = 0x00000102
+};
+
+enum
+{
+    kEdsObjectEvent_All = 0x00000200,
+    kEdsObjectEvent_VolumeInfoChanged = 0x00000201,
+    kEdsObjectEvent_DirItemCreated = 0x00000204,
+    kEdsObjectEvent_DirItemRemoved = 0x00000205,
+    kEdsObjectEvent_DirItemRequestTransfer = 0x00000208
+};
+
+enum
+{
+    kEdsStateEvent_All = 0x00000300,
+    kEdsStateEvent_Shutdown = 0x00000301,
+    kEdsStateEvent_JobStatusChanged = 0x00000302,
+    kEdsStateEvent_WillSoonShutDown = 0x00000303,
+    kEdsStateEvent_ShutDownTimerUpdate = 0x00000304,
+    kEdsStateEvent_CaptureError = 0x00000305,
+    kEdsStateEvent_InternalError = 0x00000306
+};
+
+enum
+{
+    kEdsSaveTo_Camera = 1,
+    kEdsSaveTo_Host = 2,
+    kEdsSaveTo_Both = 3
+};
+
+enum
+{
+    kEdsEvfOutputDevice_TFT = 1,
+    kEdsEvfOutputDevice_PC = 2
+};
+
+enum
+{
+    kEdsEvfZoom_Fit = 1,
+    kEdsEvfZoom_x5 = 5,
+    kEdsEvfZoom_x10 = 10
+};
+
+typedef enum
+{
+    Evf_AFMode_Quick = 0,
+    Evf_AFMode_Live = 1,
+    Evf_AFMode_LiveFace = 2,
+    Evf_AFMode_LiveMulti = 3
+} EdsEvfAFMode;
+
+typedef enum
+{
+    kEdsEvfDriveLens_Near1 = 0x00000001,
+    kEdsEvfDriveLens_Near2 = 0x00000002,
+    kEdsEvfDriveLens_Near3 = 0x00000003,
+    kEdsEvfDriveLens_Far1 = 0x00008001,
+    kEdsEvfDriveLens_Far2 = 0x00008002,
+    kEdsEvfDriveLens_Far3 = 0x00008003
+} EdsEvfDriveLens;
+
+typedef enum
+{
+    EdsImageQuality_LJF = 0x0013FF0F,
+    EdsImageQuality_LJN = 0x0012FF0F,
+    EdsImageQuality_MJF = 0x0113FF0F,
+    EdsImageQuality_MJN = 0x0112FF0F,
+    EdsImageQuality_S1JF = 0x0E13FF0F,
+    EdsImageQuality_S1JN = 0x0E12FF0F,
+    EdsImageQuality_S2JF = 0x0F13FF0F,
+    EdsImageQuality_S3JF = 0x1013FF0F,
+    EdsImageQuality_LR = 0x0064FF0F,
+    EdsImageQuality_LRLJF = 0x00640013
+} EdsImageQuality;
+
+typedef enum
+{
+    kEdsSeek_Cur = 0,
+    kEdsSeek_Begin,
+    kEdsSeek_End
+} EdsSeekOrigin;
+
+typedef enum
+{
+    kEdsProgressOption_NoReport = 0,
+    kEdsProgressOption_Done,
+    kEdsProgressOption_Periodically
+} EdsProgressOption;
+
+typedef struct
+{
+    EdsInt32 x;
+    EdsInt32 y;
+} EdsPoint;
+
+typedef struct
+{
+    EdsInt32 width;
+    EdsInt32 height;
+} EdsSize;
+
+typedef struct
+{
+    EdsPoint point;
+    EdsSize size;
+} EdsRect;
+
+typedef struct
+{
+    EdsChar szPortName[EDS_MAX_NAME];
+    EdsChar szDeviceDescription[EDS_MAX_NAME];
+    EdsUInt32 deviceSubType;
+    EdsUInt32 reserved;
+} EdsDeviceInfo;
+
+typedef struct
+{
+    EdsUInt32 size;
+    EdsBool isFolder;
+    EdsUInt32 groupID;
+    EdsUInt32 option;
+    EdsChar szFileName[EDS_MAX_NAME];
+    EdsUInt32 format;
+    EdsUInt32 dateTime;
+} EdsDirectoryItemInfo;
+
+typedef struct
+{
+    EdsUInt32 valid;
+    EdsUInt32 selected;
+    EdsUInt32 justFocus;
+    EdsRect rect;
+    EdsUInt32 reserved;
+} EdsFocusPoint;
+
+typedef struct
+{
+    EdsRect imageRect;
+    EdsUInt32 pointNumber;
+    EdsFocusPoint focusPoint[1053];
+    EdsUInt32 executeMode;
+} EdsFocusInfo;
+
+typedef EdsError (EDSCALLBACK *EdsProgressCallback)(EdsUInt32 inPercent, EdsVoid* inContext, EdsBool* outCancel);
+typedef EdsError (EDSCALLBACK *EdsPropertyEventHandler)(EdsPropertyEvent inEvent, EdsPropertyID inPropertyID, EdsUInt32 inParam, EdsVoid* inContext);
+typedef EdsError (EDSCALLBACK *EdsObjectEventHandler)(EdsObjectEvent inEvent, EdsBaseRef inRef, EdsVoid* inContext);
+typedef EdsError (EDSCALLBACK *EdsStateEventHandler)(EdsStateEvent inEvent, EdsUInt32 inEventData, EdsVoid* inContext);
@@ -0,0 +1,41 @@
+#pragma once
+
+// The FreeImage calls the sources use. freeimage_stub.cpp implements them
+// with a stand-in codec that understands the frames stub::makeJpeg() writes:
+// a real SOI/SOF0/SOS header, so the size probing in EvfDecoder works, with
+// a seed instead of entropy coded data. Decoding fills every pixel and
+// burns stub::setDecodeNanosPerPixel() of CPU, so decoder scaling behaves
+// like libjpeg's DCT scaling without linking it.
+
+typedef unsigned char BYTE;
+typedef unsigned int DWORD;
+
+struct FIBITMAP;
+struct FIMEMORY;
+
+enum FREE_IMAGE_FORMAT
+{
+    FIF_UNKNOWN = -1,
+    FIF_JPEG = 2
+};
+
+#define JPEG_FAST 0x0001
+#define JPEG_ACCURATE 0x0002
+
+#define FI_RGBA_RED 2
+#define FI_RGBA_GREEN 1
+#define FI_RGBA_BLUE 0
+
+void FreeImage_Initialise(bool load_local_plugins_only = false);
+void FreeImage_DeInitialise();
+
+FIMEMORY* FreeImage_OpenMemory(BYTE* data = 0, DWORD size_in_bytes = 0);
+void FreeImage_CloseMemory(FIMEMORY* stream);
+FIBITMAP* FreeImage_LoadFromMemory(FREE_IMAGE_FORMAT fif, FIMEMORY* stream, int flags = 0);
+
+unsigned FreeImage_GetBPP(FIBITMAP* dib);
+unsigned FreeImage_GetWidth(FIBITMAP* dib);
+unsigned FreeImage_GetHeight(FIBITMAP* dib);
+BYTE* FreeImage_GetScanLine(FIBITMAP* dib, int scanline);
+FIBITMAP* FreeImage_ConvertTo24Bits(FIBITMAP* dib);
+void FreeImage_Unload(FIBITMAP* dib);
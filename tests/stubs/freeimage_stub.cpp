@@ -0,0 +1,158 @@
+#include "FreeImage.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "stub_sdk.h"
+
+struct FIMEMORY
+{
+    const BYTE* data;
+    DWORD size;
+};
+
+struct FIBITMAP
+{
+    unsigned width;
+    unsigned height;
+    unsigned bpp;
+    std::vector<BYTE> bits;
+};
+
+namespace
+{
+    // What stub::makeJpeg() wrote, false for anything else
+    bool readHeader(const BYTE* data, DWORD size, unsigned& width, unsigned& height, uint32_t& seed)
+    {
+        static const DWORD kHeaderSize = 2 + 19 + 14;
+
+        if (size < kHeaderSize + 4 || 0xFF != data[0] || 0xD8 != data[1] || 0xFF != data[2] || 0xC0 != data[3] || 0xFF != data[21] || 0xDA != data[22])
+        {
+            return false;
+        }
+
+        height = (data[7] << 8) | data[8];
+        width = (data[9] << 8) | data[10];
+        memcpy(&seed, data + kHeaderSize, sizeof(seed));
+
+        return 0 < width && 0 < height;
+    }
+
+    void burn(double nanos)
+    {
+        if (nanos <= 0.0)
+        {
+            return;
+        }
+
+        uint64_t until_ = stub::nowNanos() + (uint64_t)nanos;
+
+        while (stub::nowNanos() < until_)
+        {
+        }
+    }
+}
+
+void FreeImage_Initialise(bool /* load_local_plugins_only */)
+{
+}
+
+void FreeImage_DeInitialise()
+{
+}
+
+FIMEMORY* FreeImage_OpenMemory(BYTE* data, DWORD size_in_bytes)
+{
+    FIMEMORY* memory_ = new FIMEMORY;
+    stub::addDecodeAllocations(1);
+    memory_->data = data;
+    memory_->size = size_in_bytes;
+    return memory_;
+}
+
+void FreeImage_CloseMemory(FIMEMORY* stream)
+{
+    delete stream;
+}
+
+FIBITMAP* FreeImage_LoadFromMemory(FREE_IMAGE_FORMAT fif, FIMEMORY* stream, int flags)
+{
+    unsigned width_ = 0;
+    unsigned height_ = 0;
+    uint32_t seed_ = 0;
+
+    if (FIF_JPEG != fif || NULL == stream || !readHeader(stream->data, stream->size, width_, height_, seed_))
+    {
+        return NULL;
+    }
+
+    // like libjpeg's scale_denom: the smallest output whose larger side still covers the requested size
+    unsigned requested_ = (unsigned)flags >> 16;
+    unsigned denominator_ = 1;
+
+    while (0 < requested_ && denominator_ < 8 && requested_ <= std::max(width_, height_) / (denominator_ * 2))
+    {
+        denominator_ *= 2;
+    }
+
+    FIBITMAP* bitmap_ = new FIBITMAP;
+    bitmap_->width = (width_ + denominator_ - 1) / denominator_;
+    bitmap_->height = (height_ + denominator_ - 1) / denominator_;
+    bitmap_->bpp = 24;
+    bitmap_->bits.resize((size_t)bitmap_->width * bitmap_->height * 3);
+    stub::addDecodeAllocations(2);
+
+    // a gradient that moves with the frame, so consecutive frames differ
+    for (unsigned y = 0; y < bitmap_->height; ++y)
+    {
+        BYTE* row_ = &bitmap_->bits[(size_t)y * bitmap_->width * 3];
+
+        for (unsigned x = 0; x < bitmap_->width; ++x)
+        {
+            row_[x * 3 + FI_RGBA_RED] = (BYTE)(x + seed_);
+            row_[x * 3 + FI_RGBA_GREEN] = (BYTE)(y + seed_);
+            row_[x * 3 + FI_RGBA_BLUE] = (BYTE)seed_;
+        }
+    }
+
+    burn(stub::getDecodeNanosPerPixel() * bitmap_->width * bitmap_->height);
+
+    return bitmap_;
+}
+
+unsigned FreeImage_GetBPP(FIBITMAP* dib)
+{
+    return dib ? dib->bpp : 0;
+}
+
+unsigned FreeImage_GetWidth(FIBITMAP* dib)
+{
+    return dib ? dib->width : 0;
+}
+
+unsigned FreeImage_GetHeight(FIBITMAP* dib)
+{
+    return dib ? dib->height : 0;
+}
+
+BYTE* FreeImage_GetScanLine(FIBITMAP* dib, int scanline)
+{
+    return &dib->bits[(size_t)scanline * dib->width * (dib->bpp / 8)];
+}
+
+FIBITMAP* FreeImage_ConvertTo24Bits(FIBITMAP* dib)
+{
+    if (NULL == dib)
+    {
+        return NULL;
+    }
+
+    stub::addDecodeAllocations(2);
+    return new FIBITMAP(*dib);
+}
+
+void FreeImage_Unload(FIBITMAP* dib)
+{
+    delete dib;
+}
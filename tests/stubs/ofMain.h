@@ -0,0 +1,128 @@
+#pragma once
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+// The few openFrameworks pieces the sources outside ofApp use, implemented
+// in of_stub.cpp. Log lines below the level set with ofSetLogLevel() are
+// dropped, the rest go to stderr.
+
+enum ofLogLevel
+{
+    OF_LOG_VERBOSE,
+    OF_LOG_NOTICE,
+    OF_LOG_WARNING,
+    OF_LOG_ERROR,
+    OF_LOG_FATAL_ERROR,
+    OF_LOG_SILENT
+};
+
+enum ofImageType
+{
+    OF_IMAGE_GRAYSCALE,
+    OF_IMAGE_COLOR,
+    OF_IMAGE_COLOR_ALPHA
+};
+
+void ofSetLogLevel(ofLogLevel level);
+ofLogLevel ofGetLogLevel();
+
+class ofLog
+{
+public:
+    ofLog(ofLogLevel level = OF_LOG_NOTICE, const std::string& module = "");
+    ~ofLog();
+
+    template<class T>
+    ofLog& operator<<(const T& value)
+    {
+        mMessage << value;
+        return *this;
+    }
+
+    ofLog& operator<<(std::ostream& (*manipulator)(std::ostream&))
+    {
+        mMessage << manipulator;
+        return *this;
+    }
+
+    ofLog& operator<<(std::ios_base& (*manipulator)(std::ios_base&))
+    {
+        mMessage << manipulator;
+        return *this;
+    }
+
+private:
+    ofLog(const ofLog&);
+    ofLog& operator=(const ofLog&);
+
+    ofLogLevel mLevel;
+    std::string mModule;
+    std::ostringstream mMessage;
+};
+
+class ofLogVerbose : public ofLog
+{
+public:
+    ofLogVerbose(const std::string& module = "") : ofLog(OF_LOG_VERBOSE, module) {}
+};
+
+class ofLogNotice : public ofLog
+{
+public:
+    ofLogNotice(const std::string& module = "") : ofLog(OF_LOG_NOTICE, module) {}
+};
+
+class ofLogWarning : public ofLog
+{
+public:
+    ofLogWarning(const std::string& module = "") : ofLog(OF_LOG_WARNING, module) {}
+};
+
+class ofLogError : public ofLog
+{
+public:
+    ofLogError(const std::string& module = "") : ofLog(OF_LOG_ERROR, module) {}
+};
+
+class ofPixels
+{
+public:
+    ofPixels();
+
+    // Keeps the storage when the size doesn't change
+    void allocate(int width, int height, ofImageType type);
+    void clear();
+    void swap(ofPixels& other);
+
+    bool isAllocated() const;
+    int getWidth() const;
+    int getHeight() const;
+    int getNumChannels() const;
+    unsigned char* getPixels();
+    const unsigned char* getPixels() const;
+
+private:
+    std::vector<unsigned char> mData;
+    int mWidth;
+    int mHeight;
+    int mChannels;
+};
+
+class ofBuffer
+{
+public:
+    void set(const char* data, size_t size);
+    void clear();
+
+    char* getBinaryBuffer();
+    const char* getBinaryBuffer() const;
+    size_t size() const;
+
+private:
+    std::vector<char> mData;
+};
+
+// Decodes through FreeImage.h, the stub one in the test build
+bool ofLoadImage(ofPixels& pixels, const ofBuffer& buffer);
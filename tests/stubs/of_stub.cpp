@@ -0,0 +1,188 @@
+#include "ofMain.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+#include "FreeImage.h"
+
+namespace
+{
+    std::atomic<int> sLogLevel(OF_LOG_NOTICE);
+
+    const char* getLevelName(ofLogLevel level)
+    {
+        switch (level)
+        {
+            case OF_LOG_VERBOSE: return "verbose";
+            case OF_LOG_NOTICE: return "notice";
+            case OF_LOG_WARNING: return "warning";
+            case OF_LOG_ERROR: return "error";
+            case OF_LOG_FATAL_ERROR: return "fatal";
+            default: return "";
+        }
+    }
+}
+
+void ofSetLogLevel(ofLogLevel level)
+{
+    sLogLevel = level;
+}
+
+ofLogLevel ofGetLogLevel()
+{
+    return (ofLogLevel)sLogLevel.load();
+}
+
+ofLog::ofLog(ofLogLevel level, const std::string& module)
+: mLevel(level)
+, mModule(module)
+{
+}
+
+ofLog::~ofLog()
+{
+    if (mLevel < sLogLevel || OF_LOG_SILENT == mLevel)
+    {
+        return;
+    }
+
+    std::string message_ = mMessage.str();
+
+    if (mModule.empty())
+    {
+        fprintf(stderr, "[%s] %s\n", getLevelName(mLevel), message_.c_str());
+    }
+    else
+    {
+        fprintf(stderr, "[%s] %s: %s\n", getLevelName(mLevel), mModule.c_str(), message_.c_str());
+    }
+}
+
+ofPixels::ofPixels()
+: mWidth(0)
+, mHeight(0)
+, mChannels(0)
+{
+}
+
+void ofPixels::allocate(int width, int height, ofImageType type)
+{
+    int channels_ = (OF_IMAGE_GRAYSCALE == type) ? 1 : (OF_IMAGE_COLOR == type ? 3 : 4);
+
+    if (width == mWidth && height == mHeight && channels_ == mChannels)
+    {
+        return;
+    }
+
+    mData.resize((size_t)width * height * channels_);
+    mWidth = width;
+    mHeight = height;
+    mChannels = channels_;
+}
+
+void ofPixels::clear()
+{
+    std::vector<unsigned char>().swap(mData);
+    mWidth = 0;
+    mHeight = 0;
+    mChannels = 0;
+}
+
+void ofPixels::swap(ofPixels& other)
+{
+    mData.swap(other.mData);
+    std::swap(mWidth, other.mWidth);
+    std::swap(mHeight, other.mHeight);
+    std::swap(mChannels, other.mChannels);
+}
+
+bool ofPixels::isAllocated() const
+{
+    return !mData.empty();
+}
+
+int ofPixels::getWidth() const
+{
+    return mWidth;
+}
+
+int ofPixels::getHeight() const
+{
+    return mHeight;
+}
+
+int ofPixels::getNumChannels() const
+{
+    return mChannels;
+}
+
+unsigned char* ofPixels::getPixels()
+{
+    return mData.empty() ? NULL : &mData[0];
+}
+
+const unsigned char* ofPixels::getPixels() const
+{
+    return mData.empty() ? NULL : &mData[0];
+}
+
+void ofBuffer::set(const char* data, size_t size)
+{
+    mData.assign(data, data + size);
+}
+
+void ofBuffer::clear()
+{
+    mData.clear();
+}
+
+char* ofBuffer::getBinaryBuffer()
+{
+    return mData.empty() ? NULL : &mData[0];
+}
+
+const char* ofBuffer::getBinaryBuffer() const
+{
+    return mData.empty() ? NULL : &mData[0];
+}
+
+size_t ofBuffer::size() const
+{
+    return mData.size();
+}
+
+bool ofLoadImage(ofPixels& pixels, const ofBuffer& buffer)
+{
+    FIMEMORY* memory_ = FreeImage_OpenMemory((BYTE*)buffer.getBinaryBuffer(), (DWORD)buffer.size());
+    FIBITMAP* bitmap_ = FreeImage_LoadFromMemory(FIF_JPEG, memory_, 0);
+    FreeImage_CloseMemory(memory_);
+
+    if (NULL == bitmap_)
+    {
+        return false;
+    }
+
+    unsigned width_ = FreeImage_GetWidth(bitmap_);
+    unsigned height_ = FreeImage_GetHeight(bitmap_);
+
+    pixels.allocate(width_, height_, OF_IMAGE_COLOR);
+
+    for (unsigned y = 0; y < height_; ++y)
+    {
+        const BYTE* src_ = FreeImage_GetScanLine(bitmap_, height_ - 1 - y);
+        unsigned char* dst_ = pixels.getPixels() + (size_t)y * width_ * 3;
+
+        for (unsigned x = 0; x < width_; ++x)
+        {
+            dst_[x * 3 + 0] = src_[x * 3 + FI_RGBA_RED];
+            dst_[x * 3 + 1] = src_[x * 3 + FI_RGBA_GREEN];
+            dst_[x * 3 + 2] = src_[x * 3 + FI_RGBA_BLUE];
+        }
+    }
+
+    FreeImage_Unload(bitmap_);
+
+    return true;
+}
@@ -0,0 +1,1242 @@
+#include "stub_sdk.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+struct __EdsObject
+{
+    enum Kind
+    {
+        kKind_CameraList,
+        kKind_Camera,
+        kKind_Item,
+        kKind_Stream,
+        kKind_EvfImage
+    };
+
+    explicit __EdsObject(Kind kind) : kind(kind), refs(1) {}
+    virtual ~__EdsObject() {}
+
+    const Kind kind;
+    std::atomic<int> refs;
+};
+
+namespace
+{
+    struct Camera : public __EdsObject
+    {
+        Camera(unsigned int index)
+        : __EdsObject(kKind_Camera)
+        , index(index)
+        , bOpen(false)
+        , objectHandler(NULL)
+        , objectContext(NULL)
+        , propertyHandler(NULL)
+        , propertyContext(NULL)
+        , stateHandler(NULL)
+        , stateContext(NULL)
+        , evfFrames(0)
+        , evfNextNanos(0)
+        {
+        }
+
+        unsigned int index;
+        stub::CameraConfig config;
+        std::atomic<bool> bOpen;
+
+        std::mutex mutex;
+        EdsObjectEventHandler objectHandler;
+        EdsVoid* objectContext;
+        EdsPropertyEventHandler propertyHandler;
+        EdsVoid* propertyContext;
+        EdsStateEventHandler stateHandler;
+        EdsVoid* stateContext;
+        std::map<EdsPropertyID, std::vector<char> > properties;
+
+        // only touched by the thread downloading liveview
+        uint64_t evfFrames;
+        uint64_t evfNextNanos;
+    };
+
+    struct CameraList : public __EdsObject
+    {
+        CameraList() : __EdsObject(kKind_CameraList) {}
+    };
+
+    struct Item : public __EdsObject
+    {
+        Item(unsigned int camera, const std::string& name, EdsUInt32 size, uint32_t seed)
+        : __EdsObject(kKind_Item)
+        , camera(camera)
+        , name(name)
+        , size(size)
+        , seed(seed)
+        , offset(0)
+        {
+        }
+
+        unsigned int camera;
+        std::string name;
+        EdsUInt32 size;
+        uint32_t seed;
+        EdsUInt32 offset;
+    };
+
+    struct Stream : public __EdsObject
+    {
+        Stream()
+        : __EdsObject(kKind_Stream)
+        , user(NULL)
+        , capacity(0)
+        , position(0)
+        , length(0)
+        , progress(NULL)
+        , progressContext(NULL)
+        {
+        }
+
+        char* data()
+        {
+            return user ? user : (owned.empty() ? NULL : &owned[0]);
+        }
+
+        // Room for size more bytes at the current position, the SDK grows its own streams
+        bool reserve(size_t size)
+        {
+            if (position + size <= capacity)
+            {
+                return true;
+            }
+
+            if (user)
+            {
+                return false;
+            }
+
+            capacity = position + size;
+            owned.resize(capacity);
+            return true;
+        }
+
+        void wrote(size_t size)
+        {
+            position += size;
+            length = std::max(length, position);
+        }
+
+        std::vector<char> owned;
+        char* user;
+        size_t capacity;
+        size_t position;
+        size_t length;
+        EdsProgressCallback progress;
+        EdsVoid* progressContext;
+    };
+
+    struct EvfImage : public __EdsObject
+    {
+        explicit EvfImage(Stream* stream)
+        : __EdsObject(kKind_EvfImage)
+        , stream(stream)
+        {
+            ++stream->refs;
+            memset(&coordinateSystem, 0, sizeof(coordinateSystem));
+            memset(&zoomRect, 0, sizeof(zoomRect));
+        }
+
+        ~EvfImage()
+        {
+            if (0 == --stream->refs)
+            {
+                delete stream;
+            }
+        }
+
+        Stream* stream;
+        EdsSize coordinateSystem;
+        EdsRect zoomRect;
+    };
+
+    std::mutex sMutex;
+    std::vector<std::unique_ptr<Camera> > sCameras;
+    std::vector<stub::CommandRecord> sCommands;
+    std::function<void(unsigned int)> sEvfHook;
+
+    std::atomic<int64_t> sLiveRefs(0);
+    std::atomic<uint64_t> sBadReleases(0);
+    std::atomic<uint64_t> sDownloaded(0);
+    std::atomic<uint64_t> sDeleted(0);
+    std::atomic<uint64_t> sDownloadedBytes(0);
+    std::atomic<unsigned int> sOpening(0);
+    std::atomic<unsigned int> sOpeningMax(0);
+    std::atomic<uint32_t> sItemSeed(0);
+    std::atomic<double> sDecodeNanosPerPixel(0.0);
+    std::atomic<uint64_t> sDecodeAllocations(0);
+
+    template<typename T>
+    T* cast(EdsBaseRef ref, __EdsObject::Kind kind)
+    {
+        return (NULL != ref && kind == ref->kind) ? static_cast<T*>(ref) : NULL;
+    }
+
+    EdsBaseRef handOut(__EdsObject* object)
+    {
+        ++sLiveRefs;
+        return object;
+    }
+
+    void sleepMicros(uint64_t micros)
+    {
+        if (0 < micros)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(micros));
+        }
+    }
+
+    void sleepUntilNanos(uint64_t nanos)
+    {
+        uint64_t now_ = stub::nowNanos();
+
+        if (now_ < nanos)
+        {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(nanos - now_));
+        }
+    }
+
+    uint64_t mix(uint64_t x)
+    {
+        x += 0x9E3779B97F4A7C15ull;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+
+    // The bytes of an item are a function of its seed and their offset, so a chunked download matches a whole one
+    void fillItem(char* data, const Item& item, EdsUInt32 offset, EdsUInt32 size)
+    {
+        for (EdsUInt32 i = 0; i < size; ++i)
+        {
+            uint64_t position_ = (uint64_t)offset + i;
+            data[i] = (char)(mix(item.seed ^ (position_ >> 3)) >> ((position_ & 7) * 8));
+        }
+    }
+
+    void setProperty(Camera& camera, EdsPropertyID property, const void* data, size_t size)
+    {
+        std::vector<char>& value_ = camera.properties[property];
+        value_.assign((const char*)data, (const char*)data + size);
+    }
+
+    void setUInt32(Camera& camera, EdsPropertyID property, EdsUInt32 value)
+    {
+        setProperty(camera, property, &value, sizeof(value));
+    }
+
+    void setString(Camera& camera, EdsPropertyID property, const std::string& value)
+    {
+        char string_[EDS_MAX_NAME] = { 0 };
+        strncpy(string_, value.c_str(), EDS_MAX_NAME - 1);
+        setProperty(camera, property, string_, sizeof(string_));
+    }
+
+    // On the first EdsGetCameraList after reset(), the config is final by then
+    void setDefaults(Camera& camera)
+    {
+        std::lock_guard<std::mutex> lock_(camera.mutex);
+
+        if (!camera.properties.empty())
+        {
+            return;
+        }
+
+        setString(camera, kEdsPropID_ProductName, camera.config.productName);
+
+        if (!camera.config.serialNumber.empty())
+        {
+            setString(camera, kEdsPropID_BodyIDEx, camera.config.serialNumber);
+        }
+
+        setUInt32(camera, kEdsPropID_SaveTo, kEdsSaveTo_Host);
+        setUInt32(camera, kEdsPropID_ImageQuality, EdsImageQuality_LJF);
+        setUInt32(camera, kEdsPropID_AEModeSelect, 3);
+        setUInt32(camera, kEdsPropID_DriveMode, 0);
+        setUInt32(camera, kEdsPropID_ISOSpeed, 0x48);
+        setUInt32(camera, kEdsPropID_Av, 0x30);
+        setUInt32(camera, kEdsPropID_Tv, 0x60);
+        setUInt32(camera, kEdsPropID_AvailableShots, 1000);
+        setUInt32(camera, kEdsPropID_Evf_OutputDevice, kEdsEvfOutputDevice_TFT);
+        setUInt32(camera, kEdsPropID_Evf_Mode, 1);
+        setUInt32(camera, kEdsPropID_Evf_AFMode, Evf_AFMode_Live);
+        setUInt32(camera, kEdsPropID_Evf_Zoom, kEdsEvfZoom_Fit);
+
+        EdsPoint position_ = { 0, 0 };
+        setProperty(camera, kEdsPropID_Evf_ZoomPosition, &position_, sizeof(position_));
+
+        EdsFocusInfo focus_;
+        memset(&focus_, 0, sizeof(focus_));
+        focus_.imageRect.size.width = camera.config.evfWidth;
+        focus_.imageRect.size.height = camera.config.evfHeight;
+        setProperty(camera, kEdsPropID_FocusInfo, &focus_, sizeof(focus_));
+    }
+
+    Camera* getCamera(unsigned int index)
+    {
+        std::lock_guard<std::mutex> lock_(sMutex);
+        return index < sCameras.size() ? sCameras[index].get() : NULL;
+    }
+}
+
+namespace stub
+{
+    CameraConfig::CameraConfig()
+    : productName("Canon EOS Stub")
+    , openMicros(0)
+    , openError(EDS_ERR_OK)
+    , commandMicros(0)
+    , commandError(EDS_ERR_OK)
+    , propertyMicros(0)
+    , evfWidth(960)
+    , evfHeight(640)
+    , evfBytes(80 * 1024)
+    , evfFramesPerSecond(0.0)
+    , transferMegabytesPerSecond(0.0)
+    {
+    }
+
+    uint64_t nowNanos()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void reset(unsigned int count)
+    {
+        if (0 != sLiveRefs)
+        {
+            fprintf(stderr, "stub::reset: %lld references of the previous rig were never released\n", (long long)sLiveRefs);
+        }
+
+        std::lock_guard<std::mutex> lock_(sMutex);
+
+        sCameras.clear();
+        sCommands.clear();
+        sEvfHook = std::function<void(unsigned int)>();
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            Camera* camera_ = new Camera(i);
+            char name_[32];
+
+            snprintf(name_, sizeof(name_), "SN%u", i);
+            camera_->config.serialNumber = name_;
+            snprintf(name_, sizeof(name_), "usb:%u", i);
+            camera_->config.portName = name_;
+
+            sCameras.push_back(std::unique_ptr<Camera>(camera_));
+        }
+
+        sLiveRefs = 0;
+        sBadReleases = 0;
+        sDownloaded = 0;
+        sDeleted = 0;
+        sDownloadedBytes = 0;
+        sOpening = 0;
+        sOpeningMax = 0;
+    }
+
+    unsigned int getCameraCount()
+    {
+        std::lock_guard<std::mutex> lock_(sMutex);
+        return (unsigned int)sCameras.size();
+    }
+
+    CameraConfig& getConfig(unsigned int camera)
+    {
+        return getCamera(camera)->config;
+    }
+
+    void setPortName(unsigned int camera, const std::string& portName)
+    {
+        Camera* camera_ = getCamera(camera);
+        std::lock_guard<std::mutex> lock_(camera_->mutex);
+        camera_->config.portName = portName;
+    }
+
+    void setPropertyValue(unsigned int camera, EdsPropertyID property, EdsUInt32 value)
+    {
+        Camera* camera_ = getCamera(camera);
+        setDefaults(*camera_);
+
+        std::lock_guard<std::mutex> lock_(camera_->mutex);
+        setUInt32(*camera_, property, value);
+    }
+
+    EdsUInt32 getPropertyValue(unsigned int camera, EdsPropertyID property)
+    {
+        Camera* camera_ = getCamera(camera);
+        EdsUInt32 value_ = 0;
+
+        setDefaults(*camera_);
+
+        std::lock_guard<std::mutex> lock_(camera_->mutex);
+        std::vector<char>& data_ = camera_->properties[property];
+        memcpy(&value_, data_.data(), std::min(data_.size(), sizeof(value_)));
+        return value_;
+    }
+
+    bool isSessionOpen(unsigned int camera)
+    {
+        Camera* camera_ = getCamera(camera);
+        return camera_ && camera_->bOpen;
+    }
+
+    unsigned int getMaxConcurrentOpens()
+    {
+        return sOpeningMax;
+    }
+
+    std::vector<CommandRecord> getCommands()
+    {
+        std::lock_guard<std::mutex> lock_(sMutex);
+        return sCommands;
+    }
+
+    std::vector<CommandRecord> getCommands(unsigned int camera)
+    {
+        std::lock_guard<std::mutex> lock_(sMutex);
+        std::vector<CommandRecord> commands_;
+
+        for (size_t i = 0; i < sCommands.size(); ++i)
+        {
+            if (camera == sCommands[i].camera)
+            {
+                commands_.push_back(sCommands[i]);
+            }
+        }
+
+        return commands_;
+    }
+
+    void clearCommands()
+    {
+        std::lock_guard<std::mutex> lock_(sMutex);
+        sCommands.clear();
+    }
+
+    void setEvfHook(const std::function<void(unsigned int)>& hook)
+    {
+        std::lock_guard<std::mutex> lock_(sMutex);
+        sEvfHook = hook;
+    }
+
+    bool emitItemCreated(unsigned int camera, const std::string& name, EdsUInt32 size)
+    {
+        Camera* camera_ = getCamera(camera);
+
+        if (NULL == camera_)
+        {
+            return false;
+        }
+
+        EdsObjectEventHandler handler_ = NULL;
+        EdsVoid* context_ = NULL;
+
+        {
+            std::lock_guard<std::mutex> lock_(camera_->mutex);
+            handler_ = camera_->objectHandler;
+            context_ = camera_->objectContext;
+        }
+
+        if (NULL == handler_)
+        {
+            return false;
+        }
+
+        EdsBaseRef item_ = handOut(new Item(camera, name, size, ++sItemSeed));
+        handler_(kEdsObjectEvent_DirItemCreated, item_, context_);
+
+        return true;
+    }
+
+    bool emitPropertyEvent(unsigned int camera, EdsPropertyEvent event, EdsPropertyID property, EdsUInt32 param)
+    {
+        Camera* camera_ = getCamera(camera);
+
+        if (NULL == camera_)
+        {
+            return false;
+        }
+
+        EdsPropertyEventHandler handler_ = NULL;
+        EdsVoid* context_ = NULL;
+
+        {
+            std::lock_guard<std::mutex> lock_(camera_->mutex);
+            handler_ = camera_->propertyHandler;
+            context_ = camera_->propertyContext;
+        }
+
+        if (NULL == handler_)
+        {
+            return false;
+        }
+
+        handler_(event, property, param, context_);
+        return true;
+    }
+
+    bool emitStateEvent(unsigned int camera, EdsStateEvent event, EdsUInt32 param)
+    {
+        Camera* camera_ = getCamera(camera);
+
+        if (NULL == camera_)
+        {
+            return false;
+        }
+
+        EdsStateEventHandler handler_ = NULL;
+        EdsVoid* context_ = NULL;
+
+        {
+            std::lock_guard<std::mutex> lock_(camera_->mutex);
+            handler_ = camera_->stateHandler;
+            context_ = camera_->stateContext;
+        }
+
+        if (NULL == handler_)
+        {
+            return false;
+        }
+
+        handler_(event, param, context_);
+        return true;
+    }
+
+    int64_t getLiveRefCount()
+    {
+        return sLiveRefs;
+    }
+
+    uint64_t getBadReleaseCount()
+    {
+        return sBadReleases;
+    }
+
+    uint64_t getDownloadedCount()
+    {
+        return sDownloaded;
+    }
+
+    uint64_t getDeletedCount()
+    {
+        return sDeleted;
+    }
+
+    uint64_t getDownloadedBytes()
+    {
+        return sDownloadedBytes;
+    }
+
+    size_t makeJpeg(char* data, size_t capacity, int width, int height, size_t size, uint32_t seed)
+    {
+        // SOI, SOF0 with three components, SOS, the seed, EOI
+        static const size_t kHeaderSize = 2 + 19 + 14;
+        static const size_t kMinimumSize = kHeaderSize + 4 + 2;
+
+        size = std::max(size, kMinimumSize);
+
+        if (capacity < size)
+        {
+            return 0;
+        }
+
+        const unsigned char header_[kHeaderSize] =
+        {
+            0xFF, 0xD8,
+            0xFF, 0xC0, 0x00, 0x11, 0x08,
+            (unsigned char)(height >> 8), (unsigned char)height, (unsigned char)(width >> 8), (unsigned char)width,
+            0x03, 0x01, 0x22, 0x00, 0x02, 0x11, 0x01, 0x03, 0x11, 0x01,
+            0xFF, 0xDA, 0x00, 0x0C, 0x03, 0x01, 0x00, 0x02, 0x11, 0x03, 0x11, 0x00, 0x3F, 0x00
+        };
+
+        unsigned char* out_ = (unsigned char*)data;
+
+        memcpy(out_, header_, kHeaderSize);
+        memcpy(out_ + kHeaderSize, &seed, sizeof(seed));
+        // the scan data itself is never read, leave whatever was there
+        out_[size - 2] = 0xFF;
+        out_[size - 1] = 0xD9;
+
+        return size;
+    }
+
+    void setDecodeNanosPerPixel(double nanos)
+    {
+        sDecodeNanosPerPixel = nanos;
+    }
+
+    double getDecodeNanosPerPixel()
+    {
+        return sDecodeNanosPerPixel;
+    }
+
+    void addDecodeAllocations(uint64_t count)
+    {
+        sDecodeAllocations += count;
+    }
+
+    uint64_t getDecodeAllocationCount()
+    {
+        return sDecodeAllocations;
+    }
+}
+
+EdsError EdsInitializeSDK()
+{
+    return EDS_ERR_OK;
+}
+
+EdsError EdsTerminateSDK()
+{
+    return EDS_ERR_OK;
+}
+
+EdsUInt32 EdsRetain(EdsBaseRef inRef)
+{
+    if (NULL == inRef)
+    {
+        return 0xFFFFFFFF;
+    }
+
+    ++sLiveRefs;
+    return ++inRef->refs;
+}
+
+EdsUInt32 EdsRelease(EdsBaseRef inRef)
+{
+    if (NULL == inRef)
+    {
+        return 0xFFFFFFFF;
+    }
+
+    // the rig keeps one reference to its cameras
+    int floor_ = (__EdsObject::kKind_Camera == inRef->kind) ? 1 : 0;
+    int refs_ = inRef->refs;
+
+    do
+    {
+        if (refs_ <= floor_)
+        {
+            ++sBadReleases;
+            return 0xFFFFFFFF;
+        }
+    }
+    while (!inRef->refs.compare_exchange_weak(refs_, refs_ - 1));
+
+    --sLiveRefs;
+
+    if (0 == refs_ - 1)
+    {
+        delete inRef;
+    }
+
+    return refs_ - 1;
+}
+
+EdsError EdsGetCameraList(EdsCameraListRef* outCameraListRef)
+{
+    if (NULL == outCameraListRef)
+    {
+        return EDS_ERR_INVALID_POINTER;
+    }
+
+    *outCameraListRef = handOut(new CameraList());
+    return EDS_ERR_OK;
+}
+
+EdsError EdsGetChildCount(EdsBaseRef inRef, EdsUInt32* outCount)
+{
+    if (NULL == cast<CameraList>(inRef, __EdsObject::kKind_CameraList))
+    {
+        return EDS_ERR_INVALID_HANDLE;
+    }
+
+    *outCount = stub::getCameraCount();
+    return EDS_ERR_OK;
+}
+
+EdsError EdsGetChildAtIndex(EdsBaseRef inRef, EdsInt32 inIndex, EdsBaseRef* outRef)
+{
+    if (NULL == cast<CameraList>(inRef, __EdsObject::kKind_CameraList))
+    {
+        return EDS_ERR_INVALID_HANDLE;
+    }
+
+    Camera* camera_ = getCamera((unsigned int)inIndex);
+
+    if (NULL == camera_)
+    {
+        return EDS_ERR_INVALID_PARAMETER;
+    }
+
+    setDefaults(*camera_);
+
+    ++camera_->refs;
+    *outRef = handOut(camera_);
+    return EDS_ERR_OK;
+}
+
+EdsError EdsGetDeviceInfo(EdsCameraRef inCameraRef, EdsDeviceInfo* outDeviceInfo)
+{
+    Camera* camera_ = cast<Camera>(inCameraRef, __EdsObject::kKind_Camera);
+
+    if (NULL == camera_)
+    {
+        return EDS_ERR_INVALID_HANDLE;
+    }
+
+    memset(outDeviceInfo, 0, sizeof(*outDeviceInfo));
+
+    {
+        // the port changes on a replug
+        std::lock_guard<std::mutex> lock_(camera_->mutex);
+        strncpy(outDeviceInfo->szPortName, camera_->config.portName.c_str(), EDS_MAX_NAME - 1);
+    }
+
+    strncpy(outDeviceInfo->szDeviceDescription, camera_->config.productName.c_str(), EDS_MAX_NAME - 1);
+    return EDS_ERR_OK;
+}
+
+EdsError EdsOpenSession(EdsCameraRef inCameraRef)
+{
+    Camera* camera_ = cast<Camera>(inCameraRef, __EdsObject::kKind_Camera);
+
+    if (NULL == camera_)
+    {
+        return EDS_ERR_INVALID_HANDLE;
+    }
+
+    unsigned int opening_ = ++sOpening;
+    unsigned int max_ = sOpeningMax;
+
+    while (max_ < opening_ && !sOpeningMax.compare_exchange_weak(max_, opening_))
+    {
+    }
+
+    sleepMicros(camera_->config.openMicros);
+    --sOpening;
+
+    if (EDS_ERR_OK != camera_->config.openError)
+    {
+        return camera_->config.openError;
+    }
+
+    if (camera_->bOpen.exchange(true))
+    {
+        return EDS_ERR_SESSION_ALREADY_OPEN;
+    }
+
+    return EDS_ERR_OK;
+}
+
+EdsError EdsCloseSession(EdsCameraRef inCameraRef)
+{
+    Camera* camera_ = cast<Camera>(inCameraRef, __EdsObject::kKind_Camera);
+
+    if (NULL == camera_)
+    {
+        return EDS_ERR_INVALID_HANDLE;
+    }
+
+    return camera_->bOpen.exchange(false) ? EDS_ERR_OK : EDS_ERR_SESSION_NOT_OPEN;
+}
+
+EdsError EdsSendCommand(EdsCameraRef inCameraRef, EdsCameraCommand inCommand, EdsInt32 inParam)
+{
+    Camera* camera_ = cast<Camera>(inCameraRef, __EdsObject::kKind_Camera);
+
+    if (NULL == camera_)
+    {
+        return EDS_ERR_INVALID_HANDLE;
+    }
+
+    stub::CommandRecord record_;
+    record_.camera = camera_->index;
+    record_.command = inCommand;
+    record_.param = inParam;
+    record_.startNanos = stub::nowNanos();
+
+    if (!camera_->bOpen)
+    {
+        return EDS_ERR_SESSION_NOT_OPEN;
+    }
+
+    const stub::CameraConfig& config_ = camera_->config;
+    uint64_t micros_ = config_.commandMicros;
+
+    if (config_.commandDelay)
+    {
+        micros_ += config_.commandDelay(inCommand, inParam);
+    }
+
+    sleepMicros(micros_);
+    record_.endNanos = stub::nowNanos();
+
+    {
+        std::lock_guard<std::mutex> lock_(sMutex);
+        sCommands.push_back(record_);
+    }
+
+    return config_.commandError;
+}
+
+EdsError EdsGetPropertySize(EdsBaseRef inRef, EdsPropertyID inPropertyID, EdsInt32 /* inParam */, EdsDataType* outDataType, EdsUInt32* outSize)
+{
+    Camera* camera_ = cast<Camera>(inRef, __EdsObject::kKind_Camera);
+
+    if (NULL == camera_)
+    {
+        return EDS_ERR_INVALID_HANDLE;
+    }
+
+    std::lock_guard<std::mutex> lock_(camera_->mutex);
+    auto found_ = camera_->properties.find(inPropertyID);
+
+    if (camera_->properties.end() == found_)
+    {
+        return EDS_ERR_INVALID_PARAMETER;
+    }
+
+    *outDataType = (sizeof(EdsUInt32) == found_->second.size()) ? kEdsDataType_UInt32 : kEdsDataType_Unknown;
+    *outSize = (EdsUInt32)found_->second.size();
+    return EDS_ERR_OK;
+}
+
+EdsError EdsGetPropertyData(EdsBaseRef inRef, EdsPropertyID inPropertyID, EdsInt32 /* inParam */, EdsUInt32 inPropertySize, EdsVoid* outPropertyData)
+{
+    if (EvfImage* image_ = cast<EvfImage>(inRef, __EdsObject::kKind_EvfImage))
+    {
+        if (kEdsPropID_Evf_CoordinateSystem == inPropertyID && sizeof(EdsSize) <= inPropertySize)
+        {
+            memcpy(outPropertyData, &image_->coordinateSystem, sizeof(EdsSize));
+            return EDS_ERR_OK;
+        }
+
+        if (kEdsPropID_Evf_ZoomRect == inPropertyID && sizeof(EdsRect) <= inPropertySize)
+        {
+            memcpy(outPropertyData, &image_->zoomRect, sizeof(EdsRect));
+            return EDS_ERR_OK;
+        }
+
+        return EDS_ERR_INVALID_PARAMETER;
+    }
+
+    Camera* camera_ = cast<Camera>(inRef, __EdsObject::kKind_Camera);
+
+    if (NULL == camera_)
+    {
+        return EDS_ERR_INVALID_HANDLE;
+    }
+
+    std::lock_guard<std::mutex> lock_(camera_->mutex);
+    auto found_ = camera_->properties.find(inPropertyID);
+
+    if (camera_->properties.end() == found_ || inPropertySize < found_->second.size())
+    {
+        return EDS_ERR_INVALID_PARAMETER;
+    }
+
+    memcpy(outPropertyData, &found_->second[0], found_->second.size());
+    return EDS_ERR_OK;
+}
+
+EdsError EdsSetPropertyData(EdsBaseRef inRef, EdsPropertyID inPropertyID, EdsInt32 /* inParam */, EdsUInt32 inPropertySize, const EdsVoid* inPropertyData)
+{
+    Camera* camera_ = cast<Camera>(inRef, __EdsObject::kKind_Camera);
+
+    if (NULL == camera_)
+    {
+        return EDS_ERR_INVALID_HANDLE;
+    }
+
+    if (!camera_->bOpen)
+    {
+        return EDS_ERR_SESSION_NOT_OPEN;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock_(camera_->mutex);
+        auto found_ = camera_->properties.find(inPropertyID);
+
+        if (camera_->properties.end() == found_ || inPropertySize != found_->second.size())
+        {
+            return EDS_ERR_INVALID_PARAMETER;
+        }
+
+        memcpy(&found_->second[0], inPropertyData, inPropertySize);
+    }
+
+    sleepMicros(camera_->config.propertyMicros);
+
+    // like a body does, from inside the call
+    stub::emitPropertyEvent(camera_->index, kEdsPropertyEvent_PropertyChanged, inPropertyID);
+    return EDS_ERR_OK;
+}
+
+EdsError EdsGetDirectoryItemInfo(EdsDirectoryItemRef inDirItemRef, EdsDirectoryItemInfo* outDirItemInfo)
+{
+    Item* item_ = cast<Item>(inDirItemRef, __EdsObject::kKind_Item);
+
+    if (NULL == item_)
+    {
+        return EDS_ERR_INVALID_HANDLE;
+    }
+
+    memset(outDirItemInfo, 0, sizeof(*outDirItemInfo));
+    outDirItemInfo->size = item_->size;
+    outDirItemInfo->isFolder = false;
+    strncpy(outDirItemInfo->szFileName, item_->name.c_str(), EDS_MAX_NAME - 1);
+    return EDS_ERR_OK;
+}
+
+EdsError EdsDeleteDirectoryItem(EdsDirectoryItemRef inDirItemRef)
+{
+    if (NULL == cast<Item>(inDirItemRef, __EdsObject::kKind_Item))
+    {
+        return EDS_ERR_INVALID_HANDLE;
+    }
+
+    ++sDeleted;
+    return EDS_ERR_OK;
+}
+
+EdsError EdsDownload(EdsDirectoryItemRef inDirItemRef, EdsUInt32 inReadSize, EdsStreamRef outStream)
+{
+    Item* item_ = cast<Item>(inDirItemRef, __EdsObject::kKind_Item);
+    Stream* stream_ = cast<Stream>(outStream, __EdsObject::kKind_Stream);
+
+    if (NULL == item_ || NULL == stream_)
+    {
+        return EDS_ERR_INVALID_HANDLE;
+    }
+
+    Camera* camera_ = getCamera(item_->camera);
+
+    if (NULL == camera_ || !camera_->bOpen)
+    {
+        return EDS_ERR_SESSION_NOT_OPEN;
+    }
+
+    if (item_->size < item_->offset + inReadSize || !stream_->reserve(inReadSize))
+    {
+        return EDS_ERR_INVALID_PARAMETER;
+    }
+
+    uint64_t start_ = stub::nowNanos();
+
+    fillItem(stream_->data() + stream_->position, *item_, item_->offset, inReadSize);
+    stream_->wrote(inReadSize);
+    item_->offset += inReadSize;
+    sDownloadedBytes += inReadSize;
+
+    double rate_ = camera_->config.transferMegabytesPerSecond;
+
+    if (0.0 < rate_)
+    {
+        sleepUntilNanos(start_ + (uint64_t)(inReadSize / (rate_ * 1024.0 * 1024.0) * 1e9));
+    }
+
+    if (NULL != stream_->progress)
+    {
+        EdsBool cancel_ = false;
+        stream_->progress((EdsUInt32)(100.0 * item_->offset / std::max<EdsUInt32>(1, item_->size)), stream_->progressContext, &cancel_);
+
+        if (cancel_)
+        {
+            return EDS_ERR_OPERATION_CANCELLED;
+        }
+    }
+
+    return EDS_ERR_OK;
+}
+
+EdsError EdsDownloadCancel(EdsDirectoryItemRef inDirItemRef)
+{
+    Item* item_ = cast<Item>(inDirItemRef, __EdsObject::kKind_Item);
+
+    if (NULL == item_)
+    {
+        return EDS_ERR_INVALID_HANDLE;
+    }
+
+    item_->offset = 0;
+    return EDS_ERR_OK;
+}
+
+EdsError EdsDownloadComplete(EdsDirectoryItemRef inDirItemRef)
+{
+    Item* item_ = cast<Item>(inDirItemRef, __EdsObject::kKind_Item);
+
+    if (NULL == item_)
+    {
+        return EDS_ERR_INVALID_HANDLE;
+    }
+
+    ++sDownloaded;
+    return EDS_ERR_OK;
+}
+
+EdsError EdsCreateMemoryStream(EdsUInt32 inBufferSize, EdsStreamRef* outStream)
+{
+    Stream* stream_ = new Stream();
+
+    stream_->owned.resize(inBufferSize);
+    stream_->capacity = inBufferSize;
+
+    *outStream = handOut(stream_);
+    return EDS_ERR_OK;
+}
+
+EdsError EdsCreateMemoryStreamFromPointer(EdsVoid* inUserBuffer, EdsUInt32 inBufferSize, EdsStreamRef* outStream)
+{
+    if (NULL == inUserBuffer)
+    {
+        return EDS_ERR_INVALID_POINTER;
+    }
+
+    Stream* stream_ = new Stream();
+
+    stream_->user = (char*)inUserBuffer;
+    stream_->capacity = inBufferSize;
+
+    *outStream = handOut(stream_);
+    return EDS_ERR_OK;
+}
+
+EdsError EdsGetPointer(EdsStreamRef inStream, EdsVoid** outPointer)
+{
+    Stream* stream_ = cast<Stream>(inStream, __EdsObject::kKind_Stream);
+
+    if (NULL == stream_)
+    {
+        return EDS_ERR_INVALID_HANDLE;
+    }
+
+    *outPointer = stream_->data();
+    return EDS_ERR_OK;
+}
+
+EdsError EdsSeek(EdsStreamRef inStreamRef, EdsInt32 inSeekOffset, EdsSeekOrigin inSeekOrigin)
+{
+    Stream* stream_ = cast<Stream>(inStreamRef, __EdsObject::kKind_Stream);
+
+    if (NULL == stream_)
+    {
+        return EDS_ERR_INVALID_HANDLE;
+    }
+
+    int64_t base_ = 0;
+
+    if (kEdsSeek_Cur == inSeekOrigin)
+    {
+        base_ = stream_->position;
+    }
+    else if (kEdsSeek_End == inSeekOrigin)
+    {
+        base_ = stream_->length;
+    }
+
+    int64_t position_ = base_ + inSeekOffset;
+
+    if (position_ < 0 || (int64_t)stream_->length < position_)
+    {
+        return EDS_ERR_INVALID_PARAMETER;
+    }
+
+    stream_->position = (size_t)position_;
+    return EDS_ERR_OK;
+}
+
+EdsError EdsGetPosition(EdsStreamRef inStreamRef, EdsUInt32* outPosition)
+{
+    Stream* stream_ = cast<Stream>(inStreamRef, __EdsObject::kKind_Stream);
+
+    if (NULL == stream_)
+    {
+        return EDS_ERR_INVALID_HANDLE;
+    }
+
+    *outPosition = (EdsUInt32)stream_->position;
+    return EDS_ERR_OK;
+}
+
+EdsError EdsGetLength(EdsStreamRef inStreamRef, EdsUInt32* outLength)
+{
+    Stream* stream_ = cast<Stream>(inStreamRef, __EdsObject::kKind_Stream);
+
+    if (NULL == stream_)
+    {
+        return EDS_ERR_INVALID_HANDLE;
+    }
+
+    *outLength = (EdsUInt32)stream_->length;
+    return EDS_ERR_OK;
+}
+
+EdsError EdsSetProgressCallback(EdsBaseRef inRef, EdsProgressCallback inProgressCallback, EdsProgressOption /* inProgressOption */, EdsVoid* inContext)
+{
+    Stream* stream_ = cast<Stream>(inRef, __EdsObject::kKind_Stream);
+
+    if (NULL == stream_)
+    {
+        return EDS_ERR_INVALID_HANDLE;
+    }
+
+    stream_->progress = inProgressCallback;
+    stream_->progressContext = inContext;
+    return EDS_ERR_OK;
+}
+
+EdsError EdsCreateEvfImageRef(EdsStreamRef inStreamRef, EdsEvfImageRef* outEvfImageRef)
+{
+    Stream* stream_ = cast<Stream>(inStreamRef, __EdsObject::kKind_Stream);
+
+    if (NULL == stream_)
+    {
+        return EDS_ERR_INVALID_HANDLE;
+    }
+
+    *outEvfImageRef = handOut(new EvfImage(stream_));
+    return EDS_ERR_OK;
+}
+
+EdsError EdsDownloadEvfImage(EdsCameraRef inCameraRef, EdsEvfImageRef inEvfImageRef)
+{
+    Camera* camera_ = cast<Camera>(inCameraRef, __EdsObject::kKind_Camera);
+    EvfImage* image_ = cast<EvfImage>(inEvfImageRef, __EdsObject::kKind_EvfImage);
+
+    if (NULL == camera_ || NULL == image_)
+    {
+        return EDS_ERR_INVALID_HANDLE;
+    }
+
+    std::function<void(unsigned int)> hook_;
+
+    {
+        std::lock_guard<std::mutex> lock_(sMutex);
+
+        if (sEvfHook)
+        {
+            // the copy doesn't allocate, the hooks are plain lambdas with a pointer or two
+            hook_ = sEvfHook;
+        }
+    }
+
+    if (hook_)
+    {
+        hook_(camera_->index);
+    }
+
+    if (!camera_->bOpen)
+    {
+        return EDS_ERR_SESSION_NOT_OPEN;
+    }
+
+    EdsUInt32 device_ = 0;
+
+    {
+        std::lock_guard<std::mutex> lock_(camera_->mutex);
+        memcpy(&device_, &camera_->properties[kEdsPropID_Evf_OutputDevice][0], sizeof(device_));
+    }
+
+    if (0 == (device_ & kEdsEvfOutputDevice_PC))
+    {
+        return EDS_ERR_OBJECT_NOTREADY;
+    }
+
+    const stub::CameraConfig& config_ = camera_->config;
+
+    // the body has a new frame every 1 / fps, a faster caller waits for it
+    if (0.0 < config_.evfFramesPerSecond)
+    {
+        uint64_t now_ = stub::nowNanos();
+        camera_->evfNextNanos = std::max(camera_->evfNextNanos, now_);
+        sleepUntilNanos(camera_->evfNextNanos);
+        camera_->evfNextNanos += (uint64_t)(1e9 / config_.evfFramesPerSecond);
+    }
+
+    Stream* stream_ = image_->stream;
+
+    if (!stream_->reserve(config_.evfBytes))
+    {
+        return EDS_ERR_MEM_ALLOC_FAILED;
+    }
+
+    size_t size_ = stub::makeJpeg(stream_->data() + stream_->position, config_.evfBytes, config_.evfWidth, config_.evfHeight, config_.evfBytes, (uint32_t)++camera_->evfFrames);
+    stream_->wrote(size_);
+
+    image_->coordinateSystem.width = config_.evfWidth;
+    image_->coordinateSystem.height = config_.evfHeight;
+    image_->zoomRect.point.x = config_.evfWidth * 2 / 5;
+    image_->zoomRect.point.y = config_.evfHeight * 2 / 5;
+    image_->zoomRect.size.width = config_.evfWidth / 5;
+    image_->zoomRect.size.height = config_.evfHeight / 5;
+
+    return EDS_ERR_OK;
+}
+
+EdsError EdsSetPropertyEventHandler(EdsCameraRef inCameraRef, EdsPropertyEvent /* inEvent */, EdsPropertyEventHandler inPropertyEventHandler, EdsVoid* inContext)
+{
+    Camera* camera_ = cast<Camera>(inCameraRef, __EdsObject::kKind_Camera);
+
+    if (NULL == camera_)
+    {
+        return EDS_ERR_INVALID_HANDLE;
+    }
+
+    std::lock_guard<std::mutex> lock_(camera_->mutex);
+    camera_->propertyHandler = inPropertyEventHandler;
+    camera_->propertyContext = inContext;
+    return EDS_ERR_OK;
+}
+
+EdsError EdsSetObjectEventHandler(EdsCameraRef inCameraRef, EdsObjectEvent /* inEvent */, EdsObjectEventHandler inObjectEventHandler, EdsVoid* inContext)
+{
+    Camera* camera_ = cast<Camera>(inCameraRef, __EdsObject::kKind_Camera);
+
+    if (NULL == camera_)
+    {
+        return EDS_ERR_INVALID_HANDLE;
+    }
+
+    std::lock_guard<std::mutex> lock_(camera_->mutex);
+    camera_->objectHandler = inObjectEventHandler;
+    camera_->objectContext = inContext;
+    return EDS_ERR_OK;
+}
+
+EdsError EdsSetCameraStateEventHandler(EdsCameraRef inCameraRef, EdsStateEvent /* inEvent */, EdsStateEventHandler inStateEventHandler, EdsVoid* inContext)
+{
+    Camera* camera_ = cast<Camera>(inCameraRef, __EdsObject::kKind_Camera);
+
+    if (NULL == camera_)
+    {
+        return EDS_ERR_INVALID_HANDLE;
+    }
+
+    std::lock_guard<std::mutex> lock_(camera_->mutex);
+    camera_->stateHandler = inStateEventHandler;
+    camera_->stateContext = inContext;
+    return EDS_ERR_OK;
+}
+
+EdsError EdsGetEvent()
+{
+    return EDS_ERR_OK;
+}
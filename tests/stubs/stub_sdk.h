@@ -0,0 +1,113 @@
+#pragma once
+
+#include <functional>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "EDSDK.h"
+#include "EDSDKErrors.h"
+#include "EDSDKTypes.h"
+
+// A virtual rig behind the EDSDK entry points, so the sources can be tested
+// and benchmarked without cameras. Bodies have configurable session open
+// time, command and property write latency, liveview frames and transfer
+// rate. Every command is recorded with its timestamps, and every reference
+// handed out is counted so a test can check nothing leaked.
+//
+// Configure the rig between reset() and the next EdsGetCameraList(), it is
+// read without a lock from the SDK calls.
+namespace stub
+{
+    struct CameraConfig
+    {
+        CameraConfig();
+
+        std::string productName;
+        // Reported as kEdsPropID_BodyIDEx, none when empty
+        std::string serialNumber;
+        std::string portName;
+
+        // EdsOpenSession takes this long and then fails with openError
+        uint64_t openMicros;
+        EdsError openError;
+
+        // Runs first in EdsSendCommand, after its start was recorded. Returns
+        // the time the command takes, on top of commandMicros.
+        std::function<uint64_t(EdsCameraCommand command, EdsInt32 param)> commandDelay;
+        uint64_t commandMicros;
+        EdsError commandError;
+        // EdsSetPropertyData takes this long
+        uint64_t propertyMicros;
+
+        // Liveview frames, 0 frames per second hands one out on every call
+        int evfWidth;
+        int evfHeight;
+        size_t evfBytes;
+        double evfFramesPerSecond;
+
+        // EdsDownload pace, 0 is as fast as memory goes
+        double transferMegabytesPerSecond;
+    };
+
+    struct CommandRecord
+    {
+        unsigned int camera;
+        EdsCameraCommand command;
+        EdsInt32 param;
+        uint64_t startNanos;
+        uint64_t endNanos;
+    };
+
+    // Steady clock, the same one the records use
+    uint64_t nowNanos();
+
+    // Replaces the rig with count bodies, "Canon EOS Stub" with serials SN0,
+    // SN1... on usb:0, usb:1... Clears the records and counters.
+    void reset(unsigned int count);
+    unsigned int getCameraCount();
+    CameraConfig& getConfig(unsigned int camera);
+
+    // A body replugged into another port, between closing its session and the next scan
+    void setPortName(unsigned int camera, const std::string& portName);
+    // A setting changed on the body itself, no property event is raised
+    void setPropertyValue(unsigned int camera, EdsPropertyID property, EdsUInt32 value);
+    EdsUInt32 getPropertyValue(unsigned int camera, EdsPropertyID property);
+
+    bool isSessionOpen(unsigned int camera);
+    // Most EdsOpenSession calls that were running at the same time
+    unsigned int getMaxConcurrentOpens();
+
+    std::vector<CommandRecord> getCommands();
+    std::vector<CommandRecord> getCommands(unsigned int camera);
+    void clearCommands();
+
+    // Runs at the start of every EdsDownloadEvfImage, on the calling thread
+    void setEvfHook(const std::function<void(unsigned int camera)>& hook);
+
+    // Calls the handlers the sources registered, on the calling thread, the
+    // way the SDK calls them on its own. The item reference goes to the
+    // handler, false if the camera has none.
+    bool emitItemCreated(unsigned int camera, const std::string& name, EdsUInt32 size);
+    bool emitPropertyEvent(unsigned int camera, EdsPropertyEvent event, EdsPropertyID property, EdsUInt32 param = 0);
+    bool emitStateEvent(unsigned int camera, EdsStateEvent event, EdsUInt32 param = 0);
+
+    // References handed out by the SDK and not released yet
+    int64_t getLiveRefCount();
+    // EdsRelease on something that had no reference left
+    uint64_t getBadReleaseCount();
+    uint64_t getDownloadedCount();
+    uint64_t getDeletedCount();
+    uint64_t getDownloadedBytes();
+
+    // Writes a frame the stub FreeImage decodes as width x height, size bytes long
+    size_t makeJpeg(char* data, size_t capacity, int width, int height, size_t size, uint32_t seed);
+    // CPU time a stub decode spends per output pixel
+    void setDecodeNanosPerPixel(double nanos);
+    double getDecodeNanosPerPixel();
+    // Heap allocations the stub FreeImage made, one per block the real library
+    // allocates too: the memory stream, the bitmap and its pixels
+    void addDecodeAllocations(uint64_t count);
+    uint64_t getDecodeAllocationCount();
+}
@@ -0,0 +1,251 @@
+#include "trigger_engine.h"
+
+#include <algorithm>
+#include <functional>
+#include <thread>
+
+#include "check.h"
+#include "stub_sdk.h"
+
+namespace
+{
+    const unsigned int kCameraCount = 8;
+
+    bool waitFor(const std::function<bool()>& done, unsigned int timeoutMillis = 5000)
+    {
+        uint64_t deadline_ = stub::nowNanos() + timeoutMillis * 1000000ull;
+
+        while (!done())
+        {
+            if (deadline_ < stub::nowNanos())
+            {
+                return false;
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        return true;
+    }
+
+    // Start times of the full presses the rig saw, by camera
+    std::vector<uint64_t> getPressNanos()
+    {
+        std::vector<uint64_t> press_(kCameraCount, 0);
+        std::vector<stub::CommandRecord> commands_ = stub::getCommands();
+
+        for (size_t i = 0; i < commands_.size(); ++i)
+        {
+            if (kEdsCameraCommand_PressShutterButton == commands_[i].command && kEdsCameraCommand_ShutterButton_Completely == commands_[i].param)
+            {
+                CHECK(0 == press_[commands_[i].camera]);
+                press_[commands_[i].camera] = commands_[i].startNanos;
+            }
+        }
+
+        return press_;
+    }
+
+    uint64_t getSpreadMicros(const std::vector<uint64_t>& nanos)
+    {
+        uint64_t first_ = *std::min_element(nanos.begin(), nanos.end());
+        uint64_t last_ = *std::max_element(nanos.begin(), nanos.end());
+        return (last_ - first_) / 1000;
+    }
+
+    // The half-press of camera i takes i * stepMicros, so without the barrier the presses would be that far apart
+    void reset(uint64_t stepMicros)
+    {
+        stub::reset(kCameraCount);
+
+        for (unsigned int i = 0; i < kCameraCount; ++i)
+        {
+            uint64_t delay_ = i * stepMicros;
+
+            stub::getConfig(i).commandDelay = [delay_](EdsCameraCommand command_, EdsInt32 param_)
+            {
+                return (kEdsCameraCommand_PressShutterButton == command_ && kEdsCameraCommand_ShutterButton_Halfway == param_) ? delay_ : 0;
+            };
+        }
+    }
+
+    void testBarrierAlignsSlowCameras()
+    {
+        const uint64_t kStepMicros = 5000;
+        const uint64_t kSkewBoundMicros = 10000;
+
+        reset(kStepMicros);
+
+        {
+            eds::EventBus bus_;
+            eds::CameraManager cameras_(bus_);
+            eds::TriggerEngine trigger_(cameras_);
+
+            CHECK(EDS_ERR_OK == cameras_.open(eds::CameraSession::Settings()));
+            CHECK(kCameraCount == trigger_.arm());
+            CHECK(trigger_.isArmed());
+
+            // fired while the half-presses are still going out
+            CHECK(kCameraCount == trigger_.fire(2000));
+            CHECK(!trigger_.isArmed());
+            CHECK(waitFor([&trigger_]() { return 1 == trigger_.getShotCount(); }));
+
+            std::vector<uint64_t> press_ = getPressNanos();
+
+            for (unsigned int i = 0; i < kCameraCount; ++i)
+            {
+                CHECK(0 != press_[i]);
+            }
+
+            uint64_t spread_ = getSpreadMicros(press_);
+
+            CHECK_MESSAGE(spread_ < kSkewBoundMicros, "%llu us, the half-presses were %llu us apart", (unsigned long long)spread_, (unsigned long long)((kCameraCount - 1) * kStepMicros));
+            CHECK(0 == trigger_.getBarrierTimeoutCount());
+
+            // the engine timestamps right before EdsSendCommand, the rig right after it was entered
+            CHECK(trigger_.getLastSkewMicros() < kSkewBoundMicros);
+            CHECK(kCameraCount == trigger_.getLastOffsetsMicros().size());
+            CHECK(kCameraCount == trigger_.getLastSendMicros().size());
+
+            cameras_.close();
+        }
+
+        CHECK(0 == stub::getLiveRefCount());
+    }
+
+    void testHistogramCountsEveryShot()
+    {
+        const unsigned int kShots = 20;
+
+        reset(0);
+
+        {
+            eds::EventBus bus_;
+            eds::CameraManager cameras_(bus_);
+            eds::TriggerEngine trigger_(cameras_);
+
+            CHECK(EDS_ERR_OK == cameras_.open(eds::CameraSession::Settings()));
+
+            // back to back, every camera's executor runs the shots in order
+            for (unsigned int i = 0; i < kShots; ++i)
+            {
+                CHECK(kCameraCount == trigger_.fire());
+            }
+
+            CHECK(waitFor([&trigger_]() { return kShots == trigger_.getShotCount(); }));
+
+            std::vector<uint64_t> histogram_ = trigger_.getSkewHistogram();
+            uint64_t counted_ = 0;
+
+            CHECK(eds::TriggerEngine::kBucketCount == histogram_.size());
+
+            for (size_t i = 0; i < histogram_.size(); ++i)
+            {
+                counted_ += histogram_[i];
+            }
+
+            CHECK(kShots == counted_);
+            CHECK(trigger_.getSkewMicrosAverage() <= trigger_.getSkewMicrosMax());
+            CHECK(0 == trigger_.getBarrierTimeoutCount());
+
+            cameras_.close();
+            CHECK(kShots * kCameraCount * 2 == stub::getCommands().size());
+        }
+
+        CHECK(0 == stub::getLiveRefCount());
+    }
+
+    void testStragglerFiresAfterTimeout()
+    {
+        const uint64_t kSlowMicros = 300000;
+
+        stub::reset(kCameraCount);
+        stub::getConfig(2).commandDelay = [kSlowMicros](EdsCameraCommand, EdsInt32 param_)
+        {
+            return kEdsCameraCommand_ShutterButton_Halfway == param_ ? kSlowMicros : 0;
+        };
+
+        {
+            eds::EventBus bus_;
+            eds::CameraManager cameras_(bus_);
+            eds::TriggerEngine trigger_(cameras_);
+
+            CHECK(EDS_ERR_OK == cameras_.open(eds::CameraSession::Settings()));
+            CHECK(kCameraCount == trigger_.arm());
+            CHECK(kCameraCount == trigger_.fire(50));
+            CHECK(waitFor([&trigger_]() { return 1 == trigger_.getShotCount(); }));
+
+            CHECK(1 == trigger_.getBarrierTimeoutCount());
+
+            std::vector<uint64_t> press_ = getPressNanos();
+            uint64_t others_ = 0;
+
+            for (unsigned int i = 0; i < kCameraCount; ++i)
+            {
+                CHECK(0 != press_[i]);
+
+                if (2 != i)
+                {
+                    others_ = std::max(others_, press_[i]);
+                }
+            }
+
+            // the others didn't wait for it
+            CHECK(others_ < press_[2]);
+            CHECK(trigger_.getLastSkewMicros() >= (kSlowMicros - 50000) / 2);
+
+            cameras_.close();
+        }
+
+        CHECK(0 == stub::getLiveRefCount());
+    }
+
+    void testShotWithoutEveryCameraIsRecorded()
+    {
+        reset(0);
+
+        {
+            eds::EventBus bus_;
+            eds::CameraManager cameras_(bus_);
+            eds::TriggerEngine trigger_(cameras_);
+
+            CHECK(EDS_ERR_OK == cameras_.open(eds::CameraSession::Settings()));
+
+            // the session still reports open, but its executor turns the post down
+            cameras_.getSession(5)->getCommandExecutor().stop();
+
+            uint64_t start_ = stub::nowNanos();
+
+            CHECK(kCameraCount - 1 == trigger_.fire(5000));
+            CHECK(waitFor([&trigger_]() { return 1 == trigger_.getShotCount(); }));
+
+            // the missing camera doesn't hold the others until the barrier times out
+            CHECK((stub::nowNanos() - start_) / 1000000 < 2500);
+            CHECK(0 == trigger_.getBarrierTimeoutCount());
+
+            std::vector<uint64_t> press_ = getPressNanos();
+            std::vector<uint64_t> offsets_ = trigger_.getLastOffsetsMicros();
+
+            for (unsigned int i = 0; i < kCameraCount; ++i)
+            {
+                CHECK((5 == i) == (0 == press_[i]));
+            }
+
+            CHECK(kCameraCount == offsets_.size());
+
+            cameras_.close();
+        }
+
+        CHECK(0 == stub::getLiveRefCount());
+    }
+}
+
+int main()
+{
+    RUN_TEST(testBarrierAlignsSlowCameras);
+    RUN_TEST(testHistogramCountsEveryShot);
+    RUN_TEST(testStragglerFiresAfterTimeout);
+    RUN_TEST(testShotWithoutEveryCameraIsRecorded);
+
+    return 0;
+}